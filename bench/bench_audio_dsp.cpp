@@ -0,0 +1,197 @@
+// Throughput of the native audio filters against the plugin path.
+//
+//   bench_audio_dsp [channels] [seconds]
+//   bench_audio_dsp [channels] [seconds] <ladspa.so> <label>
+//
+// Without a plugin, the baseline is a scalar per-channel biquad cascade, the
+// same work a mono LADSPA EQ instantiated once per channel performs. With a
+// plugin, that plugin is hosted the way MLT's ladspa filter does it: one
+// instance per channel, planar buffers, controls left at their defaults.
+
+#include "audio/Compressor.h"
+#include "audio/ParametricEq.h"
+
+#include <ladspa.h>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kBlock = 1024;
+constexpr double kRate = 48000.0;
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<float> noise(int channels, int frames)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-0.9f, 0.9f);
+    std::vector<float> samples(size_t(channels) * size_t(frames));
+    for (float &s : samples)
+        s = dist(rng);
+    return samples;
+}
+
+vep::EqBand benchBand(int b)
+{
+    vep::EqBand band;
+    band.enabled = true;
+    band.frequency = 60.0 * std::pow(2.0, b * 1.2);
+    band.gainDb = (b % 2) ? 4.0 : -3.0;
+    band.q = 1.1;
+    return band;
+}
+
+template <typename Fn>
+double timeIt(int frames, Fn &&fn)
+{
+    const auto start = Clock::now();
+    for (int offset = 0; offset + kBlock <= frames; offset += kBlock)
+        fn(offset);
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return (frames / kRate) / seconds; // x realtime
+}
+
+double benchNativeEq(int channels, std::vector<float> audio, int frames)
+{
+    vep::ParametricEq eq(kRate, channels);
+    for (int b = 0; b < vep::ParametricEq::kMaxBands; ++b)
+        eq.setBand(b, benchBand(b));
+    eq.snapToTargets();
+    return timeIt(frames, [&](int offset) {
+        eq.process(audio.data() + size_t(offset) * size_t(channels), kBlock);
+    });
+}
+
+double benchNativeCompressor(int channels, std::vector<float> audio, int frames)
+{
+    vep::Compressor compressor(kRate, channels);
+    return timeIt(frames, [&](int offset) {
+        compressor.process(audio.data() + size_t(offset) * size_t(channels), kBlock);
+    });
+}
+
+double benchScalarEq(int channels, const std::vector<float> &audio, int frames)
+{
+    struct Section
+    {
+        vep::BiquadCoefficients c;
+        float z1 = 0.0f, z2 = 0.0f;
+    };
+    std::vector<std::vector<Section>> perChannel(static_cast<size_t>(channels));
+    for (auto &sections : perChannel) {
+        for (int b = 0; b < vep::ParametricEq::kMaxBands; ++b) {
+            const vep::EqBand band = benchBand(b);
+            sections.push_back({vep::BiquadCoefficients::design(band.shape, kRate, band.frequency,
+                                                                band.gainDb, band.q)});
+        }
+    }
+    std::vector<float> planar(kBlock);
+    return timeIt(frames, [&](int offset) {
+        for (int c = 0; c < channels; ++c) {
+            for (int i = 0; i < kBlock; ++i)
+                planar[size_t(i)] = audio[size_t(offset + i) * size_t(channels) + size_t(c)];
+            for (Section &s : perChannel[size_t(c)]) {
+                for (float &x : planar) {
+                    const float y = s.c.b0 * x + s.z1;
+                    s.z1 = s.c.b1 * x - s.c.a1 * y + s.z2;
+                    s.z2 = s.c.b2 * x - s.c.a2 * y;
+                    x = y;
+                }
+            }
+        }
+    });
+}
+
+double benchLadspa(int channels, const std::vector<float> &audio, int frames, const char *path,
+                   const char *label)
+{
+    void *library = dlopen(path, RTLD_NOW);
+    if (!library) {
+        std::fprintf(stderr, "cannot load %s: %s\n", path, dlerror());
+        return 0.0;
+    }
+    auto descriptorFn = reinterpret_cast<LADSPA_Descriptor_Function>(dlsym(library, "ladspa_descriptor"));
+    const LADSPA_Descriptor *descriptor = nullptr;
+    for (unsigned long i = 0; descriptorFn && (descriptor = descriptorFn(i)); ++i) {
+        if (!std::strcmp(descriptor->Label, label))
+            break;
+    }
+    if (!descriptor) {
+        std::fprintf(stderr, "no plugin labelled %s in %s\n", label, path);
+        dlclose(library);
+        return 0.0;
+    }
+
+    std::vector<LADSPA_Handle> instances;
+    std::vector<std::vector<LADSPA_Data>> controls(static_cast<size_t>(channels));
+    std::vector<float> in(kBlock), out(kBlock);
+    for (int c = 0; c < channels; ++c) {
+        LADSPA_Handle handle = descriptor->instantiate(descriptor, (unsigned long) kRate);
+        controls[size_t(c)].resize(descriptor->PortCount);
+        for (unsigned long p = 0; p < descriptor->PortCount; ++p) {
+            const LADSPA_PortDescriptor port = descriptor->PortDescriptors[p];
+            if (LADSPA_IS_PORT_CONTROL(port)) {
+                const LADSPA_PortRangeHint &hint = descriptor->PortRangeHints[p];
+                LADSPA_Data value = 0.0f;
+                if (LADSPA_IS_HINT_BOUNDED_BELOW(hint.HintDescriptor)
+                    && LADSPA_IS_HINT_BOUNDED_ABOVE(hint.HintDescriptor))
+                    value = 0.5f * (hint.LowerBound + hint.UpperBound);
+                controls[size_t(c)][p] = value;
+                descriptor->connect_port(handle, p, &controls[size_t(c)][p]);
+            } else if (LADSPA_IS_PORT_INPUT(port)) {
+                descriptor->connect_port(handle, p, in.data());
+            } else {
+                descriptor->connect_port(handle, p, out.data());
+            }
+        }
+        if (descriptor->activate)
+            descriptor->activate(handle);
+        instances.push_back(handle);
+    }
+
+    const double speed = timeIt(frames, [&](int offset) {
+        for (int c = 0; c < channels; ++c) {
+            for (int i = 0; i < kBlock; ++i)
+                in[size_t(i)] = audio[size_t(offset + i) * size_t(channels) + size_t(c)];
+            descriptor->run(instances[size_t(c)], kBlock);
+        }
+    });
+
+    for (LADSPA_Handle handle : instances) {
+        if (descriptor->deactivate)
+            descriptor->deactivate(handle);
+        descriptor->cleanup(handle);
+    }
+    dlclose(library);
+    return speed;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const int channels = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2;
+    const double seconds = argc > 2 ? std::max(1.0, std::atof(argv[2])) : 60.0;
+    const int frames = int(seconds * kRate) / kBlock * kBlock;
+    const std::vector<float> audio = noise(channels, frames);
+
+    std::printf("%d channels, %.0f s @ %.0f Hz, %d-frame blocks (x realtime)\n", channels,
+                seconds, kRate, kBlock);
+    std::printf("  native EQ, 8 bands       %10.1f\n", benchNativeEq(channels, audio, frames));
+    std::printf("  scalar per-channel EQ    %10.1f\n", benchScalarEq(channels, audio, frames));
+    std::printf("  native compressor        %10.1f\n", benchNativeCompressor(channels, audio, frames));
+    if (argc > 4)
+        std::printf("  LADSPA %-17s %10.1f\n", argv[4],
+                    benchLadspa(channels, audio, frames, argv[3], argv[4]));
+    return 0;
+}
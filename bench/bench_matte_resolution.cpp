@@ -0,0 +1,104 @@
+// Background-removal cost per frame at 720p against 4K segmented at reduced
+// size, the way filter_vep_bgremove runs it.
+//
+//   bench_matte_resolution <model> [frames] [threads] [resolution]
+//
+// The 720p frame is segmented as it is. The 4K frame is reduced to
+// `resolution` rows (720 by default, the filter's default), segmented, and
+// its matte brought back with guidedUpsample(). The network always sees
+// the same input size, so the difference is the reduction and the
+// upsampling; the run fails (exit 1) if a 4K frame costs more than 1.5
+// times a 720p one.
+
+#include "segmentation/GuidedUpsampler.h"
+#include "segmentation/SegmentationModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr double kMaxRatio = 1.5;
+
+using Clock = std::chrono::steady_clock;
+
+// A lit disc on a graded background, so the network finds a subject and
+// the guided filter has an edge to follow.
+std::vector<uint8_t> scene(int width, int height)
+{
+    std::vector<uint8_t> pixels(size_t(width) * size_t(height) * 4);
+    const double radius = 0.3 * height;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t *p = &pixels[(size_t(y) * size_t(width) + size_t(x)) * 4];
+            const double dx = x - 0.5 * width;
+            const double dy = y - 0.55 * height;
+            const bool subject = dx * dx + dy * dy < radius * radius;
+            p[0] = subject ? 220 : uint8_t(40 + 60 * x / width);
+            p[1] = subject ? 180 : uint8_t(60 + 40 * y / height);
+            p[2] = subject ? 150 : 90;
+            p[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+// Milliseconds per frame for `frames` frames of width x height.
+double msPerFrame(vep::SegmentationModel &model, int width, int height, int frames, int resolution)
+{
+    const std::vector<uint8_t> pixels = scene(width, height);
+    vep::SegmentationInput input;
+    input.pixels = pixels.data();
+    input.width = width;
+    input.height = height;
+    input.stride = width * 4;
+    input.channels = 4;
+    std::vector<uint8_t> mask(size_t(width) * size_t(height));
+    std::vector<uint8_t> storage;
+    std::vector<uint8_t> lowMask;
+
+    const auto start = Clock::now();
+    for (int i = 0; i < frames; ++i) {
+        const vep::SegmentationInput reduced = vep::reduceFrame(input, resolution, storage);
+        if (reduced.pixels == input.pixels) {
+            model.segment(input, mask.data(), width);
+            continue;
+        }
+        lowMask.resize(size_t(reduced.width) * size_t(reduced.height));
+        model.segment(reduced, lowMask.data(), reduced.width);
+        vep::guidedUpsample(reduced, lowMask.data(), reduced.width, input, mask.data(), width);
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <model> [frames] [threads] [resolution]\n", argv[0]);
+        return 2;
+    }
+    const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+    const int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+    const int resolution = argc > 4 ? std::atoi(argv[4]) : 720;
+
+    vep::SegmentationModel model(argv[1], threads);
+    // One untimed frame each, so session warm-up is not charged to 720p.
+    msPerFrame(model, 1280, 720, 1, resolution);
+    msPerFrame(model, 3840, 2160, 1, resolution);
+
+    const double hd = msPerFrame(model, 1280, 720, frames, resolution);
+    const double uhd = msPerFrame(model, 3840, 2160, frames, resolution);
+    const double unreduced = msPerFrame(model, 3840, 2160, std::max(1, frames / 4), 0);
+    std::printf("%s, %d frames, threads %d\n", model.path().c_str(), frames, threads);
+    std::printf("  1280x720             %8.1f ms/frame\n", hd);
+    std::printf("  3840x2160 at %4d    %8.1f ms/frame (%.2fx 720p)\n", resolution, uhd, uhd / hd);
+    std::printf("  3840x2160 unreduced  %8.1f ms/frame (%.2fx 720p)\n", unreduced, unreduced / hd);
+    return uhd <= kMaxRatio * hd ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+"""Reference masks for segmentation_parity.
+
+    make_rembg_refs.py <model> <out-dir> <image>...
+
+Writes <name>.ppm (the image as RGB) and <name>.<model>.pgm (rembg's mask
+for it, only_mask=True, no post-processing) into out-dir.
+"""
+
+import os
+import sys
+
+from PIL import Image
+from rembg import new_session, remove
+
+
+def main():
+    if len(sys.argv) < 4:
+        print(__doc__, file=sys.stderr)
+        return 2
+    model, out_dir, images = sys.argv[1], sys.argv[2], sys.argv[3:]
+    os.makedirs(out_dir, exist_ok=True)
+    session = new_session(model)
+    for path in images:
+        name = os.path.splitext(os.path.basename(path))[0]
+        with Image.open(path) as image:
+            rgb = image.convert("RGB")
+        rgb.save(os.path.join(out_dir, name + ".ppm"))
+        mask = remove(rgb, session=session, only_mask=True)
+        mask.convert("L").save(os.path.join(out_dir, "%s.%s.pgm" % (name, model)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,153 @@
+// Native background-removal masks against rembg's, plus throughput.
+//
+//   segmentation_parity <model> <refs-dir> [threads] [batch]
+//
+// refs-dir holds <name>.ppm images and <name>.<model>.pgm masks written by
+// make_rembg_refs.py with the same model file. For every pair the native
+// mask is compared pixel by pixel; the run fails (exit 1) if any mask
+// differs from rembg's by more than 2 levels on average or in more than
+// 0.5% of its pixels by more than 8 levels. Both sides run the same ONNX
+// graph on the same Pillow-exact input, so differences come only from the
+// float kernels of the two ONNX Runtime builds.
+//
+// ctest runs it as SegmentationParity when the build is configured with
+// VEP_SEGMENTATION_MODEL and VEP_SEGMENTATION_REFS.
+
+#include "segmentation/SegmentationModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr double kMaxMeanDifference = 2.0;
+constexpr double kMaxOutlierShare = 0.005;
+constexpr int kOutlierLevel = 8;
+
+struct Image
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// Binary PPM (P6) or PGM (P5), 8 bits.
+bool readNetpbm(const fs::path &path, Image &image)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int maxValue = 0;
+    in >> magic >> image.width >> image.height >> maxValue;
+    in.get();
+    if (!in || maxValue != 255 || (magic != "P6" && magic != "P5"))
+        return false;
+    image.channels = magic == "P6" ? 3 : 1;
+    image.pixels.resize(size_t(image.width) * size_t(image.height) * size_t(image.channels));
+    in.read(reinterpret_cast<char *>(image.pixels.data()), std::streamsize(image.pixels.size()));
+    return bool(in);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <model> <refs-dir> [threads] [batch]\n", argv[0]);
+        return 2;
+    }
+    const std::string model = argv[1];
+    const fs::path refs = argv[2];
+    const int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+    const int batch = argc > 4 ? std::max(1, std::atoi(argv[4])) : 1;
+
+    vep::SegmentationModel segmenter(model, threads);
+    std::printf("%s: %dx%d input, batch up to %d\n", segmenter.path().c_str(), segmenter.inputSize(),
+                segmenter.inputSize(), segmenter.maxBatch());
+
+    std::vector<Image> images;
+    std::vector<Image> references;
+    std::vector<std::string> names;
+    for (const auto &entry : fs::directory_iterator(refs)) {
+        if (entry.path().extension() != ".ppm")
+            continue;
+        Image image;
+        Image reference;
+        const fs::path maskPath = refs / (entry.path().stem().string() + "." + model + ".pgm");
+        if (!readNetpbm(entry.path(), image) || !readNetpbm(maskPath, reference)) {
+            std::fprintf(stderr, "skipping %s: unreadable image or missing %s\n", entry.path().c_str(),
+                         maskPath.c_str());
+            continue;
+        }
+        images.push_back(std::move(image));
+        references.push_back(std::move(reference));
+        names.push_back(entry.path().stem().string());
+    }
+    if (images.empty()) {
+        std::fprintf(stderr, "no reference pairs in %s\n", refs.c_str());
+        return 2;
+    }
+
+    std::vector<std::vector<uint8_t>> masks(images.size());
+    std::vector<vep::SegmentationInput> inputs;
+    std::vector<uint8_t *> outputs;
+    std::vector<int> strides;
+    for (size_t i = 0; i < images.size(); ++i) {
+        masks[i].resize(size_t(images[i].width) * size_t(images[i].height));
+        vep::SegmentationInput input;
+        input.pixels = images[i].pixels.data();
+        input.width = images[i].width;
+        input.height = images[i].height;
+        input.stride = images[i].width * 3;
+        input.channels = 3;
+        inputs.push_back(input);
+        outputs.push_back(masks[i].data());
+        strides.push_back(images[i].width);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first < inputs.size(); first += size_t(batch)) {
+        const size_t last = std::min(inputs.size(), first + size_t(batch));
+        segmenter.segment({inputs.begin() + ptrdiff_t(first), inputs.begin() + ptrdiff_t(last)},
+                          {outputs.begin() + ptrdiff_t(first), outputs.begin() + ptrdiff_t(last)},
+                          {strides.begin() + ptrdiff_t(first), strides.begin() + ptrdiff_t(last)});
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool passed = true;
+    std::printf("%-24s %10s %10s %10s\n", "image", "mean diff", "max diff", "outliers");
+    for (size_t i = 0; i < images.size(); ++i) {
+        const Image &reference = references[i];
+        if (reference.width != images[i].width || reference.height != images[i].height) {
+            std::printf("%-24s size mismatch\n", names[i].c_str());
+            passed = false;
+            continue;
+        }
+        double total = 0.0;
+        int worst = 0;
+        size_t outliers = 0;
+        for (size_t p = 0; p < masks[i].size(); ++p) {
+            const int difference = std::abs(int(masks[i][p]) - int(reference.pixels[p]));
+            total += difference;
+            worst = std::max(worst, difference);
+            outliers += difference > kOutlierLevel;
+        }
+        const double mean = total / double(masks[i].size());
+        const double share = double(outliers) / double(masks[i].size());
+        const bool ok = mean <= kMaxMeanDifference && share <= kMaxOutlierShare;
+        passed = passed && ok;
+        std::printf("%-24s %10.3f %10d %9.3f%%%s\n", names[i].c_str(), mean, worst, share * 100.0,
+                    ok ? "" : "  FAIL");
+    }
+    std::printf("%zu frames in %.2f s (%.1f frames/s, threads %d, batch %d)\n", images.size(), seconds,
+                double(images.size()) / seconds, threads, batch);
+    return passed ? 0 : 1;
+}
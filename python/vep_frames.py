@@ -0,0 +1,88 @@
+"""Python side of SharedFrameRing (src/workers/SharedFrameRing.h).
+
+Maps a ring the application created and exposes each slot's pixels and
+mask as numpy arrays over the shared pages; see the header for the layout
+and the ownership rules.
+"""
+
+import os
+import struct
+from multiprocessing import resource_tracker, shared_memory
+
+import numpy as np
+
+FREE, WRITING, QUEUED, DONE, FAILED = range(5)
+
+_HEADER = struct.Struct("<8sIIIIIIQQ")
+_HEADER_BYTES = 64
+_DESCRIPTOR = struct.Struct("<IIIIIIqQQ")
+_DESCRIPTOR_BYTES = 64
+
+
+class FrameRing:
+    def __init__(self, name):
+        try:
+            self._shm = shared_memory.SharedMemory(name=name, track=False)
+        except TypeError:  # Python < 3.13 has no track=
+            self._shm = shared_memory.SharedMemory(name=name)
+            # The application owns the region; do not unlink it on exit.
+            resource_tracker.unregister(self._shm._name, "shared_memory")
+        self.name = name
+        magic, version, self.slot_count, self.max_width, self.max_height, self.channels, _, _, _ = \
+            _HEADER.unpack_from(self._shm.buf, 0)
+        if magic != b"VEPRING1" or version != 1:
+            self.close()
+            raise ValueError("not a frame ring: " + name)
+        self._states = np.ndarray((self.slot_count,), dtype="<u4", buffer=self._shm.buf, offset=_HEADER_BYTES,
+                                  strides=(_DESCRIPTOR_BYTES,))
+
+    def close(self):
+        self._states = None
+        self._shm.close()
+
+    def _descriptor(self, slot):
+        if not 0 <= slot < self.slot_count:
+            raise IndexError("slot %d out of range" % slot)
+        return _DESCRIPTOR.unpack_from(self._shm.buf, _HEADER_BYTES + _DESCRIPTOR_BYTES * slot)
+
+    def state(self, slot):
+        return int(self._states[slot])
+
+    def set_state(self, slot, state):
+        self._states[slot] = state
+
+    def frame(self, slot):
+        return self._descriptor(slot)[6]
+
+    def pixels(self, slot):
+        """height x width x channels uint8 view of the slot's frame."""
+        _, width, height, stride, channels, _, _, offset, _ = self._descriptor(slot)
+        return np.ndarray((height, width, channels), dtype=np.uint8, buffer=self._shm.buf, offset=offset,
+                          strides=(stride, channels, 1))
+
+    def mask(self, slot):
+        """height x width uint8 view of the slot's mask."""
+        _, width, height, _, _, mask_stride, _, _, offset = self._descriptor(slot)
+        return np.ndarray((height, width), dtype=np.uint8, buffer=self._shm.buf, offset=offset,
+                          strides=(mask_stride, 1))
+
+
+class RingCache:
+    """Rings a worker has attached, most recent last. Beyond the limit the
+    oldest are closed, as are rings the application has already unlinked
+    (detectable where /dev/shm exists), so their pages can be freed."""
+
+    def __init__(self, limit=2):
+        self._rings = {}
+        self._limit = limit
+
+    def get(self, name):
+        ring = self._rings.pop(name, None) or FrameRing(name)
+        if os.path.isdir("/dev/shm"):
+            for stale in [n for n in self._rings if not os.path.exists("/dev/shm/" + n)]:
+                self._rings.pop(stale).close()
+        self._rings[name] = ring
+        while len(self._rings) > self._limit:
+            oldest = next(iter(self._rings))
+            self._rings.pop(oldest).close()
+        return ring
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""Long-lived analysis worker driven by PythonWorkerPool (src/workers).
+
+Speaks line-delimited JSON on stdin/stdout; see PythonWorkerPool.h for the
+protocol. Models named with --preload are loaded before the worker reports
+ready and stay loaded for every job it runs. Anything libraries print goes
+to stderr, so stdout carries protocol messages only.
+"""
+
+import argparse
+import json
+import os
+import queue
+import sys
+import threading
+import time
+import traceback
+
+# Claim the real stdout for the protocol before any library can write to it.
+_protocol = os.fdopen(os.dup(sys.stdout.fileno()), "w", buffering=1, encoding="utf-8")
+os.dup2(sys.stderr.fileno(), sys.stdout.fileno())
+sys.stdout = sys.stderr
+_send_lock = threading.Lock()
+
+
+def send(message):
+    line = json.dumps(message, separators=(",", ":"))
+    with _send_lock:
+        _protocol.write(line + "\n")
+        _protocol.flush()
+
+
+class Cancelled(Exception):
+    pass
+
+
+class Job:
+    def __init__(self, job_id):
+        self.id = job_id
+        self.cancelled = threading.Event()
+
+    def progress(self, fraction):
+        send({"id": self.id, "progress": float(fraction)})
+
+    def check(self):
+        if self.cancelled.is_set():
+            raise Cancelled()
+
+
+class Models:
+    """Loaded models, keyed like the --preload entries ("rembg:u2net")."""
+
+    def __init__(self):
+        self._loaded = {}
+
+    def names(self):
+        return sorted(self._loaded)
+
+    def rembg(self, name="u2net"):
+        key = "rembg:" + name
+        if key not in self._loaded:
+            from rembg import new_session
+            self._loaded[key] = new_session(name)
+        return self._loaded[key]
+
+    def preload(self, entries):
+        for entry in entries:
+            kind, _, name = entry.partition(":")
+            if kind == "rembg":
+                self.rembg(name or "u2net")
+            elif kind == "aubio":
+                import aubio  # noqa: F401  imported for its start-up cost only
+                self._loaded[entry] = True
+            else:
+                raise ValueError("unknown model " + entry)
+
+
+MODELS = Models()
+RINGS = None  # vep_frames.RingCache, created on first use so numpy stays optional
+STARTED = time.monotonic()
+JOBS_DONE = 0
+
+
+def op_ping(job, args):
+    return {"pid": os.getpid(), "uptime": time.monotonic() - STARTED, "jobs": JOBS_DONE,
+            "models": MODELS.names()}
+
+
+def op_remove_background(job, args):
+    """args: inputs, outputs (image paths, one output per input), model,
+    alphaMatting. Writes RGBA images; returns the number written."""
+    from PIL import Image
+    from rembg import remove
+
+    session = MODELS.rembg(args.get("model", "u2net"))
+    inputs = args["inputs"]
+    outputs = args["outputs"]
+    if len(inputs) != len(outputs):
+        raise ValueError("inputs and outputs differ in length")
+    for index, (source, target) in enumerate(zip(inputs, outputs)):
+        job.check()
+        with Image.open(source) as image:
+            cut = remove(image, session=session, alpha_matting=bool(args.get("alphaMatting", False)))
+        cut.save(target)
+        job.progress((index + 1) / len(inputs))
+    return {"written": len(outputs)}
+
+
+def op_remove_background_frames(job, args):
+    """args: ring, slots, model. Frames come from and masks go back to a
+    SharedFrameRing; each slot is handed back with a "slot" event."""
+    global RINGS
+    import vep_frames
+    from rembg import remove
+
+    if RINGS is None:
+        RINGS = vep_frames.RingCache()
+    ring = RINGS.get(args["ring"])
+    session = MODELS.rembg(args.get("model", "u2net"))
+    slots = args["slots"]
+    frames = args.get("frames")
+
+    def ours(index, slot):
+        # A retry of a job whose first worker died after answering finds its
+        # slot handed back, and maybe queued again for another frame.
+        return ring.state(slot) == vep_frames.QUEUED and (frames is None or ring.frame(slot) == frames[index])
+
+    for index, slot in enumerate(slots):
+        if job.cancelled.is_set():
+            # Give the rest back unprocessed so the application can reuse them.
+            for rest_index, rest in enumerate(slots[index:], index):
+                if ours(rest_index, rest):
+                    ring.set_state(rest, vep_frames.FAILED)
+                send({"id": job.id, "event": "slot", "slot": rest, "ok": False})
+            raise Cancelled()
+        if not ours(index, slot):
+            # Answer anyway; the application ignores a second answer.
+            send({"id": job.id, "event": "slot", "slot": slot, "ok": False})
+            job.progress((index + 1) / len(slots))
+            continue
+        try:
+            pixels = ring.pixels(slot)
+            mask = remove(pixels[..., :3], session=session, only_mask=True)
+            ring.mask(slot)[...] = mask if mask.ndim == 2 else mask[..., 0]
+            ring.set_state(slot, vep_frames.DONE)
+            send({"id": job.id, "event": "slot", "slot": slot, "ok": True})
+        except Exception:
+            ring.set_state(slot, vep_frames.FAILED)
+            send({"id": job.id, "event": "slot", "slot": slot, "ok": False})
+            raise
+        job.progress((index + 1) / len(slots))
+    return {"done": len(slots)}
+
+
+def op_beats(job, args):
+    """args: path, hop (samples). Returns bpm and beat times in seconds."""
+    import aubio
+
+    hop = int(args.get("hop", 512))
+    source = aubio.source(args["path"], 0, hop)
+    tempo = aubio.tempo("default", hop * 2, hop, source.samplerate)
+    duration = max(1, source.duration)
+    beats = []
+    read_total = 0
+    while True:
+        samples, read = source()
+        if tempo(samples)[0]:
+            beats.append(float(tempo.get_last_s()))
+        read_total += read
+        if read_total % (hop * 512) < hop:
+            job.check()
+            job.progress(min(1.0, read_total / duration))
+        if read < hop:
+            break
+    return {"bpm": float(tempo.get_bpm()), "beats": beats}
+
+
+OPS = {
+    "ping": op_ping,
+    "remove_background": op_remove_background,
+    "remove_background_frames": op_remove_background_frames,
+    "beats": op_beats,
+}
+
+
+def read_requests(requests, running):
+    """Feeds requests to the main loop; cancels are applied at once."""
+    for line in sys.stdin:
+        try:
+            message = json.loads(line)
+        except ValueError:
+            continue
+        op = message.get("op")
+        if op == "cancel":
+            job = running.get(message.get("id"))
+            if job:
+                job.cancelled.set()
+            continue
+        if op == "ping":
+            # Answered from this thread so a long job does not fail the
+            # health check.
+            send({"id": message.get("id", 0), "ok": True, "result": op_ping(None, {})})
+            continue
+        if op == "quit":
+            requests.put((None, message))
+            return
+        # Registered here, so a cancel that arrives before the job starts
+        # still finds it.
+        job = Job(message.get("id"))
+        running[job.id] = job
+        requests.put((job, message))
+    requests.put((None, {"op": "quit"}))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--preload", default="", help="comma-separated models, e.g. rembg:u2net")
+    options = parser.parse_args()
+
+    try:
+        MODELS.preload([entry for entry in options.preload.split(",") if entry])
+    except Exception:
+        traceback.print_exc()
+        return 1
+    send({"ready": True, "models": MODELS.names()})
+
+    global JOBS_DONE
+    requests = queue.Queue()
+    running = {}
+    threading.Thread(target=read_requests, args=(requests, running), daemon=True).start()
+    while True:
+        job, message = requests.get()
+        op = message.get("op")
+        if op == "quit":
+            return 0
+        try:
+            job.check()
+            handler = OPS.get(op)
+            if handler is None:
+                raise ValueError("unknown op " + str(op))
+            send({"id": job.id, "ok": True, "result": handler(job, message.get("args", {}))})
+        except Cancelled:
+            send({"id": job.id, "ok": False, "error": "cancelled"})
+        except Exception as error:
+            traceback.print_exc()
+            send({"id": job.id, "ok": False, "error": "%s: %s" % (type(error).__name__, error)})
+        finally:
+            del running[job.id]
+            JOBS_DONE += 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
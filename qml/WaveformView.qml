@@ -0,0 +1,49 @@
+import QtQuick 2.12
+import VideoEditorPro 1.0
+
+// Waveform of one timeline clip. Only the part of the clip inside the
+// timeline viewport is painted, so a zoomed-in hour-long clip costs no more
+// than a short one; the peak level is picked by WaveformItem from the
+// resulting seconds-per-pixel.
+Item {
+    id: root
+
+    // Media file and the source range the clip shows, in seconds.
+    property string source
+    property real sourceIn: 0
+    property real sourceOut: 0
+    // Visible horizontal range, in this item's coordinates.
+    property real viewportX: 0
+    property real viewportWidth: width
+    property alias color: waveform.color
+    property alias rmsColor: waveform.rmsColor
+    readonly property bool available: waveform.available
+
+    readonly property real secondsPerPixel: width > 0 ? (sourceOut - sourceIn) / width : 0
+    readonly property real visibleLeft: Math.max(0, viewportX)
+    readonly property real visibleRight: Math.min(width, viewportX + viewportWidth)
+
+    function reload() {
+        waveform.reload()
+    }
+
+    // The peak file appears when the import of the media finishes.
+    Connections {
+        target: importJob
+        onFileImported: {
+            if (!waveform.available && mediaPath === root.source)
+                waveform.reload()
+        }
+    }
+
+    WaveformItem {
+        id: waveform
+        source: root.source
+        visible: root.visibleRight > root.visibleLeft
+        x: root.visibleLeft
+        width: Math.max(0, root.visibleRight - root.visibleLeft)
+        height: root.height
+        inPoint: root.sourceIn + root.visibleLeft * root.secondsPerPixel
+        outPoint: root.sourceIn + root.visibleRight * root.secondsPerPixel
+    }
+}
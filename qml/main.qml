@@ -0,0 +1,18 @@
+import QtQuick 2.12
+import QtQuick.Window 2.12
+import VideoEditorPro 1.0
+
+// Main window. The native models and jobs are context properties set up
+// in main.cpp (importJob, snapModel, transcriptModel, captionJob,
+// sceneDetectionJob, stabilizationJob, trackingJob, planarTrackingJob).
+// Every file added to the project goes to importJob.importFiles(), and to
+// importJob.placedOnTimeline() when it is dropped on the timeline.
+Window {
+    id: window
+
+    width: 1280
+    height: 800
+    visible: true
+    title: qsTr("Video Editor Pro")
+    color: "#1e1e1e"
+}
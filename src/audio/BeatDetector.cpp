@@ -0,0 +1,88 @@
+#include "audio/BeatDetector.h"
+
+#include <aubio/aubio.h>
+
+#include <stdexcept>
+
+namespace vep {
+
+struct BeatDetector::Aubio
+{
+    aubio_tempo_t *tempo = nullptr;
+    aubio_onset_t *onset = nullptr;
+    fvec_t *hop = nullptr;
+    fvec_t *tempoOut = nullptr;
+    fvec_t *onsetOut = nullptr;
+
+    ~Aubio()
+    {
+        if (tempo)
+            del_aubio_tempo(tempo);
+        if (onset)
+            del_aubio_onset(onset);
+        if (hop)
+            del_fvec(hop);
+        if (tempoOut)
+            del_fvec(tempoOut);
+        if (onsetOut)
+            del_fvec(onsetOut);
+    }
+};
+
+BeatDetector::BeatDetector(int sampleRate, int channels, int hopSize, int windowSize)
+    : m_channels(channels)
+    , m_hopSize(hopSize)
+    , m_aubio(std::make_unique<Aubio>())
+{
+    m_aubio->tempo = new_aubio_tempo("default", uint_t(windowSize), uint_t(hopSize), uint_t(sampleRate));
+    m_aubio->onset = new_aubio_onset("default", uint_t(windowSize), uint_t(hopSize), uint_t(sampleRate));
+    m_aubio->hop = new_fvec(uint_t(hopSize));
+    m_aubio->tempoOut = new_fvec(1);
+    m_aubio->onsetOut = new_fvec(1);
+    if (!m_aubio->tempo || !m_aubio->onset || !m_aubio->hop)
+        throw std::runtime_error("aubio: cannot create beat tracker");
+}
+
+BeatDetector::~BeatDetector() = default;
+
+void BeatDetector::process(const float *interleaved, int frames)
+{
+    const float scale = 1.0f / float(m_channels);
+    smpl_t *hop = m_aubio->hop->data;
+    for (int i = 0; i < frames; ++i) {
+        const float *frame = interleaved + size_t(i) * size_t(m_channels);
+        float mono = 0.0f;
+        for (int c = 0; c < m_channels; ++c)
+            mono += frame[c];
+        hop[m_fill++] = smpl_t(mono * scale);
+        if (m_fill == m_hopSize) {
+            analyseHop();
+            m_fill = 0;
+        }
+    }
+}
+
+void BeatDetector::analyseHop()
+{
+    aubio_tempo_do(m_aubio->tempo, m_aubio->hop, m_aubio->tempoOut);
+    if (m_aubio->tempoOut->data[0] != 0)
+        m_result.beats.push_back(double(aubio_tempo_get_last_s(m_aubio->tempo)));
+    aubio_onset_do(m_aubio->onset, m_aubio->hop, m_aubio->onsetOut);
+    if (m_aubio->onsetOut->data[0] != 0)
+        m_result.onsets.push_back(double(aubio_onset_get_last_s(m_aubio->onset)));
+}
+
+BeatMap BeatDetector::finish()
+{
+    if (m_fill > 0) {
+        for (int i = m_fill; i < m_hopSize; ++i)
+            m_aubio->hop->data[i] = 0;
+        analyseHop();
+        m_fill = 0;
+    }
+    m_result.bpm = double(aubio_tempo_get_bpm(m_aubio->tempo));
+    m_result.confidence = double(aubio_tempo_get_confidence(m_aubio->tempo));
+    return std::move(m_result);
+}
+
+} // namespace vep
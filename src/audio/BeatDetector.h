@@ -0,0 +1,36 @@
+#pragma once
+
+#include "audio/BeatMap.h"
+
+#include <memory>
+
+namespace vep {
+
+// Streaming tempo/onset detection on top of aubio's C API. Audio is pushed
+// in arbitrary block sizes as it is decoded, downmixed to mono and fed to
+// aubio hop by hop, so analysis needs no second pass over the file.
+class BeatDetector
+{
+public:
+    BeatDetector(int sampleRate, int channels, int hopSize = 512, int windowSize = 1024);
+    ~BeatDetector();
+
+    BeatDetector(const BeatDetector &) = delete;
+    BeatDetector &operator=(const BeatDetector &) = delete;
+
+    void process(const float *interleaved, int frames);
+    BeatMap finish();
+
+private:
+    struct Aubio;
+
+    void analyseHop();
+
+    int m_channels;
+    int m_hopSize;
+    int m_fill = 0;
+    std::unique_ptr<Aubio> m_aubio;
+    BeatMap m_result;
+};
+
+} // namespace vep
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core/BinaryIO.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+
+// Result of beat analysis for one media file, times in seconds from the
+// start of the file. Stored in the MediaCache under kCacheKind.
+struct BeatMap
+{
+    static constexpr const char *kCacheKind = "beats";
+
+    double bpm = 0.0;
+    double confidence = 0.0;
+    std::vector<double> beats;
+    std::vector<double> onsets;
+
+    std::vector<uint8_t> serialize() const
+    {
+        ByteWriter out;
+        out.putMagic("VEPBEAT1");
+        out.put(bpm);
+        out.put(confidence);
+        out.putArray(beats);
+        out.putArray(onsets);
+        return out.take();
+    }
+
+    // Throws std::runtime_error on a malformed record.
+    static BeatMap deserialize(const std::vector<uint8_t> &bytes)
+    {
+        ByteReader in(bytes);
+        in.expectMagic("VEPBEAT1");
+        BeatMap map;
+        map.bpm = in.get<double>();
+        map.confidence = in.get<double>();
+        map.beats = in.getArray<double>();
+        map.onsets = in.getArray<double>();
+        return map;
+    }
+};
+
+} // namespace vep
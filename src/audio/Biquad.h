@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+enum class FilterShape
+{
+    Peaking,
+    LowShelf,
+    HighShelf,
+    LowPass,
+    HighPass,
+    Notch,
+};
+
+// Normalised biquad coefficients (a0 == 1), designed with the RBJ audio EQ
+// cookbook formulas.
+struct BiquadCoefficients
+{
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+
+    static BiquadCoefficients design(FilterShape shape, double sampleRate,
+                                     double frequency, double gainDb, double q)
+    {
+        constexpr double pi = 3.14159265358979323846;
+        const double nyquistSafe = sampleRate * 0.49;
+        const double f = std::clamp(frequency, 10.0, nyquistSafe);
+        const double w0 = 2.0 * pi * f / sampleRate;
+        const double cosW0 = std::cos(w0);
+        const double alpha = std::sin(w0) / (2.0 * std::max(q, 0.025));
+        const double A = std::pow(10.0, gainDb / 40.0);
+
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+        switch (shape) {
+        case FilterShape::Peaking:
+            b0 = 1.0 + alpha * A;
+            b1 = -2.0 * cosW0;
+            b2 = 1.0 - alpha * A;
+            a0 = 1.0 + alpha / A;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha / A;
+            break;
+        case FilterShape::LowShelf: {
+            const double s = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1.0) - (A - 1.0) * cosW0 + s);
+            b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW0);
+            b2 = A * ((A + 1.0) - (A - 1.0) * cosW0 - s);
+            a0 = (A + 1.0) + (A - 1.0) * cosW0 + s;
+            a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW0);
+            a2 = (A + 1.0) + (A - 1.0) * cosW0 - s;
+            break;
+        }
+        case FilterShape::HighShelf: {
+            const double s = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1.0) + (A - 1.0) * cosW0 + s);
+            b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW0);
+            b2 = A * ((A + 1.0) + (A - 1.0) * cosW0 - s);
+            a0 = (A + 1.0) - (A - 1.0) * cosW0 + s;
+            a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW0);
+            a2 = (A + 1.0) - (A - 1.0) * cosW0 - s;
+            break;
+        }
+        case FilterShape::LowPass:
+            b0 = (1.0 - cosW0) / 2.0;
+            b1 = 1.0 - cosW0;
+            b2 = (1.0 - cosW0) / 2.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+        case FilterShape::HighPass:
+            b0 = (1.0 + cosW0) / 2.0;
+            b1 = -(1.0 + cosW0);
+            b2 = (1.0 + cosW0) / 2.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+        case FilterShape::Notch:
+            b0 = 1.0;
+            b1 = -2.0 * cosW0;
+            b2 = 1.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+        }
+
+        BiquadCoefficients c;
+        c.b0 = float(b0 / a0);
+        c.b1 = float(b1 / a0);
+        c.b2 = float(b2 / a0);
+        c.a1 = float(a1 / a0);
+        c.a2 = float(a2 / a0);
+        return c;
+    }
+};
+
+} // namespace vep
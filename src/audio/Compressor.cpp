@@ -0,0 +1,208 @@
+#include "audio/Compressor.h"
+
+#include "core/SimdFloat4.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vep {
+
+namespace {
+
+constexpr float kDbPerLog2 = 6.0205999f; // 20 * log10(2)
+constexpr double kGlide = 0.2;
+constexpr double kMaxLookaheadMs = 50.0;
+
+float timeCoefficient(double ms, double sampleRate)
+{
+    const double samples = std::max(ms, 0.01) * 0.001 * sampleRate;
+    return float(std::exp(-1.0 / samples));
+}
+
+void approach(double &current, double target, double tolerance)
+{
+    if (std::fabs(target - current) <= tolerance)
+        current = target;
+    else
+        current += (target - current) * kGlide;
+}
+
+} // namespace
+
+Compressor::Compressor(double sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(std::max(channels, 1))
+{
+    setSettings(CompressorSettings());
+    m_current = m_target;
+}
+
+void Compressor::setSettings(const CompressorSettings &settings)
+{
+    CompressorSettings s = settings;
+    s.ratio = std::max(s.ratio, 1.0);
+    s.kneeDb = std::clamp(s.kneeDb, 0.0, 24.0);
+    s.lookaheadMs = std::clamp(s.lookaheadMs, 0.0, kMaxLookaheadMs);
+    m_target = s;
+    m_attackCoeff = timeCoefficient(s.attackMs, m_sampleRate);
+    m_releaseCoeff = timeCoefficient(s.releaseMs, m_sampleRate);
+
+    const int lookahead = int(std::lround(s.lookaheadMs * 0.001 * m_sampleRate));
+    if (lookahead != m_lookahead || m_delay.empty()) {
+        m_lookahead = lookahead;
+        reset();
+    }
+    m_current.limiter = s.limiter;
+    m_current.attackMs = s.attackMs;
+    m_current.releaseMs = s.releaseMs;
+    m_current.lookaheadMs = s.lookaheadMs;
+}
+
+void Compressor::reset()
+{
+    m_minQueue.assign(size_t(m_lookahead) + 2, HeldValue{0, 0.0f});
+    m_minHead = 0;
+    m_minSize = 0;
+    m_sampleIndex = 0;
+    m_boxHistory.assign(size_t(std::max(m_lookahead, 1)), 0.0f);
+    m_boxPos = 0;
+    m_boxSum = 0.0;
+    m_envelopeDb = 0.0f;
+    m_meterDb = 0.0f;
+    m_delay.assign(size_t(m_lookahead + kControlBlock) * size_t(m_channels), 0.0f);
+    m_gainInterleaved.assign(size_t(kControlBlock) * size_t(m_channels), 0.0f);
+}
+
+void Compressor::glide()
+{
+    approach(m_current.thresholdDb, m_target.thresholdDb, 1e-3);
+    approach(m_current.ratio, m_target.ratio, 1e-3);
+    approach(m_current.kneeDb, m_target.kneeDb, 1e-3);
+    approach(m_current.makeupDb, m_target.makeupDb, 1e-3);
+}
+
+void Compressor::process(float *interleaved, int frames)
+{
+    ScopedFlushDenormals flush;
+    for (int offset = 0; offset < frames; offset += kControlBlock) {
+        glide();
+        processBlock(interleaved + size_t(offset) * size_t(m_channels),
+                     std::min(kControlBlock, frames - offset));
+    }
+}
+
+void Compressor::processBlock(float *interleaved, int frames)
+{
+    const int C = m_channels;
+
+    // Detector: linked peak level across channels, four frames per step.
+    for (int i = 0; i < frames; i += 4) {
+        const int n = std::min(4, frames - i);
+        const float *x = interleaved + size_t(i) * size_t(C);
+        Float4 peak;
+        if (C == 2 && n == 4) {
+            const Float4 a = abs(Float4::load(x));
+            const Float4 b = abs(Float4::load(x + 4));
+            peak = max(evenLanes(a, b), oddLanes(a, b));
+        } else if (C == 1 && n == 4) {
+            peak = abs(Float4::load(x));
+        } else {
+            float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int f = 0; f < n; ++f)
+                for (int c = 0; c < C; ++c)
+                    lanes[f] = std::max(lanes[f], std::fabs(x[f * C + c]));
+            peak = Float4::load(lanes);
+        }
+        peak.store(&m_level[size_t(i)]);
+    }
+
+    // Gain computer (dB domain) with a quadratic soft knee:
+    //   r = slope * (t^2 / 2k + max(over - k/2, 0)),  t = clamp(over + k/2, 0, k)
+    const float knee = float(std::max(m_current.kneeDb, 0.01));
+    const float slope = m_current.limiter ? -1.0f : float(1.0 / m_current.ratio - 1.0);
+    const Float4 vThreshold(float(m_current.thresholdDb));
+    const Float4 vHalfKnee(knee * 0.5f);
+    const Float4 vKnee(knee);
+    const Float4 vInvTwoKnee(0.5f / knee);
+    const Float4 vSlope(slope);
+    const Float4 vDb(kDbPerLog2);
+    const Float4 vFloor(1e-9f);
+    const Float4 vZero(0.0f);
+    for (int i = 0; i < frames; i += 4) {
+        const Float4 levelDb = vDb * fastLog2(max(Float4::load(&m_level[size_t(i)]), vFloor));
+        const Float4 over = levelDb - vThreshold;
+        const Float4 t = min(max(over + vHalfKnee, vZero), vKnee);
+        const Float4 reduction = vSlope * (t * t * vInvTwoKnee + max(over - vHalfKnee, vZero));
+        reduction.store(&m_level[size_t(i)]);
+    }
+
+    // Look-ahead hold and attack/release: inherently sequential.
+    float deepest = 0.0f;
+    for (int i = 0; i < frames; ++i) {
+        const float env = smooth(holdMinimum(m_level[size_t(i)]));
+        m_level[size_t(i)] = env;
+        deepest = std::min(deepest, env);
+    }
+    m_meterDb = deepest;
+
+    const Float4 vMakeup(float(m_current.makeupDb));
+    const Float4 vInvDb(1.0f / kDbPerLog2);
+    for (int i = 0; i < frames; i += 4)
+        fastExp2((Float4::load(&m_level[size_t(i)]) + vMakeup) * vInvDb).store(&m_gain[size_t(i)]);
+
+    // Push the block through the delay line and apply the gain.
+    const size_t history = size_t(m_lookahead) * size_t(C);
+    const size_t samples = size_t(frames) * size_t(C);
+    std::memcpy(m_delay.data() + history, interleaved, samples * sizeof(float));
+    for (int i = 0; i < frames; ++i)
+        std::fill_n(m_gainInterleaved.data() + size_t(i) * size_t(C), C, m_gain[size_t(i)]);
+    size_t s = 0;
+    for (; s + 4 <= samples; s += 4)
+        (Float4::load(m_delay.data() + s) * Float4::load(m_gainInterleaved.data() + s)).store(interleaved + s);
+    for (; s < samples; ++s)
+        interleaved[s] = m_delay[s] * m_gainInterleaved[s];
+    std::memmove(m_delay.data(), m_delay.data() + samples, history * sizeof(float));
+}
+
+float Compressor::holdMinimum(float reductionDb)
+{
+    const size_t capacity = m_minQueue.size();
+    const long long index = m_sampleIndex++;
+    // Drop values that can no longer be the minimum, then expired ones.
+    while (m_minSize > 0) {
+        const size_t back = (m_minHead + m_minSize - 1) % capacity;
+        if (m_minQueue[back].value < reductionDb)
+            break;
+        --m_minSize;
+    }
+    m_minQueue[(m_minHead + m_minSize) % capacity] = HeldValue{index, reductionDb};
+    ++m_minSize;
+    while (m_minQueue[m_minHead].index < index - m_lookahead) {
+        m_minHead = (m_minHead + 1) % capacity;
+        --m_minSize;
+    }
+    return m_minQueue[m_minHead].value;
+}
+
+float Compressor::smooth(float heldDb)
+{
+    if (m_current.limiter) {
+        // The box average of the held minimum reaches the peak's reduction
+        // exactly when the peak leaves the delay line.
+        m_boxSum += double(heldDb) - double(m_boxHistory[m_boxPos]);
+        m_boxHistory[m_boxPos] = heldDb;
+        m_boxPos = (m_boxPos + 1) % m_boxHistory.size();
+        const float averaged = float(m_boxSum / double(m_boxHistory.size()));
+        if (averaged < m_envelopeDb)
+            m_envelopeDb = averaged;
+        else
+            m_envelopeDb = averaged + m_releaseCoeff * (m_envelopeDb - averaged);
+        return m_envelopeDb;
+    }
+    const float coeff = heldDb < m_envelopeDb ? m_attackCoeff : m_releaseCoeff;
+    m_envelopeDb = heldDb + coeff * (m_envelopeDb - heldDb);
+    return m_envelopeDb;
+}
+
+} // namespace vep
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace vep {
+
+struct CompressorSettings
+{
+    double thresholdDb = -18.0;
+    double ratio = 4.0;
+    double kneeDb = 6.0;
+    double attackMs = 10.0;
+    double releaseMs = 120.0;
+    double makeupDb = 0.0;
+    double lookaheadMs = 5.0;
+    // Brickwall mode: infinite ratio, and the look-ahead window is used to
+    // ramp the gain down before the peak so the output never exceeds the
+    // threshold.
+    bool limiter = false;
+};
+
+// Feed-forward compressor/limiter with stereo-linked peak detection and a
+// look-ahead delay. The detector, gain computer and gain application run on
+// Float4 lanes across frames; only the attack/release recursion is serial.
+//
+// The look-ahead delays the output by latency() frames. MLT has no plugin
+// delay compensation, so keep it short (the default 5 ms is well inside
+// lip-sync tolerance).
+class Compressor
+{
+public:
+    static constexpr int kControlBlock = 64;
+
+    Compressor(double sampleRate, int channels);
+
+    // Threshold, knee, ratio and make-up gain glide to new values; changing
+    // the look-ahead resets the delay line.
+    void setSettings(const CompressorSettings &settings);
+    const CompressorSettings &settings() const { return m_target; }
+
+    int latency() const { return m_lookahead; }
+    float gainReductionDb() const { return m_meterDb; }
+
+    void reset();
+    void process(float *interleaved, int frames);
+
+private:
+    void glide();
+    void processBlock(float *interleaved, int frames);
+    float holdMinimum(float reductionDb);
+    float smooth(float heldDb);
+
+    double m_sampleRate;
+    int m_channels;
+    CompressorSettings m_target;
+    CompressorSettings m_current;
+    float m_attackCoeff = 0.0f;
+    float m_releaseCoeff = 0.0f;
+    int m_lookahead = 0;
+
+    // Sliding-window minimum over the look-ahead window (monotonic queue).
+    struct HeldValue
+    {
+        long long index;
+        float value;
+    };
+    std::vector<HeldValue> m_minQueue;
+    size_t m_minHead = 0;
+    size_t m_minSize = 0;
+    long long m_sampleIndex = 0;
+
+    // Limiter mode: moving average of the held minimum over the window.
+    std::vector<float> m_boxHistory;
+    size_t m_boxPos = 0;
+    double m_boxSum = 0.0;
+
+    float m_envelopeDb = 0.0f;
+    float m_meterDb = 0.0f;
+
+    // Interleaved delay line holding the last m_lookahead frames followed by
+    // the block being processed.
+    std::vector<float> m_delay;
+
+    alignas(16) std::array<float, kControlBlock> m_level{};
+    alignas(16) std::array<float, kControlBlock> m_gain{};
+    std::vector<float> m_gainInterleaved;
+};
+
+} // namespace vep
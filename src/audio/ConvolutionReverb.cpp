@@ -0,0 +1,161 @@
+#include "audio/ConvolutionReverb.h"
+
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vep {
+
+namespace {
+
+constexpr int kHeadBlock = 256;
+constexpr int kGrowth = 8;
+
+float dbToGain(double db)
+{
+    return db <= -96.0 ? 0.0f : float(std::pow(10.0, db / 20.0));
+}
+
+ThreadPool &tailPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace
+
+ConvolutionReverb::ConvolutionReverb(double sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(std::max(channels, 1))
+    , m_wetBuffers(size_t(m_channels))
+{
+}
+
+int ConvolutionReverb::latency() const
+{
+    return kHeadBlock;
+}
+
+void ConvolutionReverb::setImpulseResponse(std::shared_ptr<const ImpulseResponse> ir)
+{
+    if (ir == m_ir)
+        return;
+    m_ir = std::move(ir);
+    m_routes.clear();
+    if (!m_ir || m_ir->channels.empty())
+        return;
+
+    const auto &c = m_ir->channels;
+    auto add = [this](int input, std::vector<int> outputs, std::vector<std::vector<float>> irs) {
+        Route route;
+        route.input = input;
+        route.outputs = std::move(outputs);
+        route.convolver = std::make_unique<PartitionedConvolver>(irs, kHeadBlock, kGrowth, &tailPool());
+        m_routes.push_back(std::move(route));
+    };
+    const bool stereo = m_channels >= 2;
+    if (c.size() == 4 && stereo) {
+        add(0, {0, 1}, {c[0], c[1]});
+        add(1, {0, 1}, {c[2], c[3]});
+    } else if (c.size() == 2 && stereo) {
+        add(0, {0}, {c[0]});
+        add(1, {1}, {c[1]});
+    } else if (c.size() == 1) {
+        for (int ch = 0; ch < m_channels; ++ch)
+            add(ch, {ch}, {c[0]});
+    } else {
+        add(0, {0}, {c[0]});
+    }
+
+    size_t scratch = 0;
+    for (const Route &route : m_routes)
+        scratch = std::max(scratch, route.outputs.size());
+    m_routeScratch.resize(scratch);
+    m_routeOutputs.resize(scratch);
+    const int maxFrames = m_maxFrames;
+    m_maxFrames = 0;
+    prepare(maxFrames);
+}
+
+void ConvolutionReverb::prepare(int maxFrames)
+{
+    if (maxFrames <= m_maxFrames)
+        return;
+    m_maxFrames = maxFrames;
+    const size_t n = size_t(maxFrames);
+    for (auto &wet : m_wetBuffers)
+        wet.resize(n);
+    for (size_t i = 0; i < m_routeScratch.size(); ++i) {
+        m_routeScratch[i].resize(n);
+        m_routeOutputs[i] = m_routeScratch[i].data();
+    }
+    m_dryDelay.resize((size_t(latency()) + n) * size_t(m_channels), 0.0f);
+}
+
+void ConvolutionReverb::setMix(double wetDb, double dryDb)
+{
+    m_wetTarget = dbToGain(wetDb);
+    m_dryTarget = dbToGain(dryDb);
+}
+
+void ConvolutionReverb::continueFrom(const ConvolutionReverb &previous)
+{
+    if (previous.m_channels != m_channels)
+        return;
+    prepare(previous.m_maxFrames);
+    const size_t history = size_t(latency()) * size_t(m_channels);
+    if (previous.m_dryDelay.size() >= history && m_dryDelay.size() >= history)
+        std::copy_n(previous.m_dryDelay.begin(), history, m_dryDelay.begin());
+    m_wet = previous.m_wet;
+    m_dry = previous.m_dry;
+}
+
+void ConvolutionReverb::reset()
+{
+    for (Route &route : m_routes)
+        route.convolver->reset();
+    std::fill(m_dryDelay.begin(), m_dryDelay.end(), 0.0f);
+    m_wet = m_wetTarget;
+    m_dry = m_dryTarget;
+}
+
+void ConvolutionReverb::process(float *interleaved, int frames)
+{
+    if (frames <= 0)
+        return;
+    const size_t C = size_t(m_channels);
+    const size_t n = size_t(frames);
+
+    prepare(frames);
+    for (auto &wet : m_wetBuffers)
+        std::fill_n(wet.begin(), n, 0.0f);
+
+    for (Route &route : m_routes) {
+        route.convolver->process(interleaved + route.input, m_channels, m_routeOutputs.data(), 1, frames);
+        for (size_t o = 0; o < route.outputs.size(); ++o) {
+            float *wet = m_wetBuffers[size_t(route.outputs[o])].data();
+            const float *src = m_routeOutputs[o];
+            for (size_t i = 0; i < n; ++i)
+                wet[i] += src[i];
+        }
+    }
+
+    // Delay the dry path by the convolver latency, then mix.
+    const size_t history = size_t(latency()) * C;
+    std::memcpy(m_dryDelay.data() + history, interleaved, n * C * sizeof(float));
+    const float wetStep = (m_wetTarget - m_wet) / float(frames);
+    const float dryStep = (m_dryTarget - m_dry) / float(frames);
+    for (size_t i = 0; i < n; ++i) {
+        const float wetGain = m_wet + wetStep * float(i);
+        const float dryGain = m_dry + dryStep * float(i);
+        for (size_t ch = 0; ch < C; ++ch)
+            interleaved[i * C + ch] = m_dryDelay[i * C + ch] * dryGain + m_wetBuffers[ch][i] * wetGain;
+    }
+    std::memmove(m_dryDelay.data(), m_dryDelay.data() + n * C, history * sizeof(float));
+    m_wet = m_wetTarget;
+    m_dry = m_dryTarget;
+}
+
+} // namespace vep
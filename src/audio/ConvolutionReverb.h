@@ -0,0 +1,74 @@
+#pragma once
+
+#include "audio/ImpulseResponseLibrary.h"
+#include "audio/PartitionedConvolver.h"
+
+#include <memory>
+#include <vector>
+
+namespace vep {
+
+// Convolution reverb over interleaved float audio. Mono IRs are applied to
+// every channel, stereo IRs to the first two, and true-stereo IRs feed both
+// input channels into both outputs (one convolver per input, two filters
+// each, so input spectra are computed once). The dry signal is delayed by
+// the convolver latency to stay phase-aligned with the wet signal.
+//
+// Tail partitions run on a pool of the reverb's own rather than on
+// ThreadPool::shared(), which a render can keep busy with video work long
+// enough for a tail to miss its deadline.
+class ConvolutionReverb
+{
+public:
+    ConvolutionReverb(double sampleRate, int channels);
+
+    double sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+    // The same with or without an IR, so loading the first one does not
+    // move the dry signal.
+    int latency() const;
+
+    // Rebuilds the convolvers when the IR differs from the current one.
+    // Partitioning a long IR takes a while, so callers on the audio thread
+    // should build the reverb elsewhere and swap it in.
+    void setImpulseResponse(std::shared_ptr<const ImpulseResponse> ir);
+    // Sizes the work buffers for blocks of up to maxFrames, so process()
+    // does not allocate. A longer block grows them.
+    void prepare(int maxFrames);
+    // Gains ramp linearly across the next process() call.
+    void setMix(double wetDb, double dryDb);
+    // Takes over the dry delay line and the current gains of the reverb
+    // this one replaces, so the dry signal runs on across the swap. Does
+    // not allocate once both are prepared for the block size.
+    void continueFrom(const ConvolutionReverb &previous);
+
+    void reset();
+    void process(float *interleaved, int frames);
+
+private:
+    struct Route
+    {
+        int input;
+        std::vector<int> outputs; // channel each convolver output is added to
+        std::unique_ptr<PartitionedConvolver> convolver;
+    };
+
+    double m_sampleRate;
+    int m_channels;
+    std::shared_ptr<const ImpulseResponse> m_ir;
+    std::vector<Route> m_routes;
+
+    float m_wet = 0.25f;
+    float m_dry = 1.0f;
+    float m_wetTarget = 0.25f;
+    float m_dryTarget = 1.0f;
+
+    std::vector<std::vector<float>> m_wetBuffers;   // per channel
+    std::vector<std::vector<float>> m_routeScratch; // per convolver output
+    std::vector<float *> m_routeOutputs;            // m_routeScratch data
+    // Interleaved: latency() frames of history, then room for a block.
+    std::vector<float> m_dryDelay;
+    int m_maxFrames = 0;
+};
+
+} // namespace vep
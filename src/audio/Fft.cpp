@@ -0,0 +1,133 @@
+#include "audio/Fft.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace vep {
+
+void SplitComplex::clear()
+{
+    std::fill(re.begin(), re.end(), 0.0f);
+    std::fill(im.begin(), im.end(), 0.0f);
+}
+
+void multiplyAccumulate(SplitComplex &acc, const SplitComplex &a, const SplitComplex &b)
+{
+    const int n = acc.bins();
+    float *__restrict accRe = acc.re.data();
+    float *__restrict accIm = acc.im.data();
+    const float *__restrict aRe = a.re.data();
+    const float *__restrict aIm = a.im.data();
+    const float *__restrict bRe = b.re.data();
+    const float *__restrict bIm = b.im.data();
+    for (int k = 0; k < n; ++k) {
+        accRe[k] += aRe[k] * bRe[k] - aIm[k] * bIm[k];
+        accIm[k] += aRe[k] * bIm[k] + aIm[k] * bRe[k];
+    }
+}
+
+void accumulate(SplitComplex &acc, const SplitComplex &a)
+{
+    const int n = acc.bins();
+    for (int k = 0; k < n; ++k) {
+        acc.re[size_t(k)] += a.re[size_t(k)];
+        acc.im[size_t(k)] += a.im[size_t(k)];
+    }
+}
+
+RealFft::RealFft(int size)
+    : m_size(size)
+    , m_half(size / 2)
+{
+    assert(size >= 4 && (size & (size - 1)) == 0);
+    constexpr double pi = 3.14159265358979323846;
+
+    int bits = 0;
+    while ((1 << bits) < m_half)
+        ++bits;
+    m_bitReverse.resize(size_t(m_half));
+    for (int i = 0; i < m_half; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        m_bitReverse[size_t(i)] = r;
+    }
+
+    m_twiddles.resize(size_t(m_half / 2 + 1));
+    for (size_t k = 0; k < m_twiddles.size(); ++k)
+        m_twiddles[k] = std::polar(1.0, -2.0 * pi * double(k) / m_half);
+    m_split.resize(size_t(m_half + 1));
+    for (size_t k = 0; k < m_split.size(); ++k)
+        m_split[k] = std::polar(1.0, -2.0 * pi * double(k) / m_size);
+    m_work.resize(size_t(m_half));
+}
+
+void RealFft::transform(std::complex<float> *data, bool inverse) const
+{
+    for (int i = 0; i < m_half; ++i) {
+        const int j = m_bitReverse[size_t(i)];
+        if (j > i)
+            std::swap(data[i], data[j]);
+    }
+    for (int length = 2; length <= m_half; length <<= 1) {
+        const int halfLength = length >> 1;
+        const int stride = m_half / length;
+        for (int start = 0; start < m_half; start += length) {
+            for (int k = 0; k < halfLength; ++k) {
+                std::complex<float> w = m_twiddles[size_t(k * stride)];
+                if (inverse)
+                    w = std::conj(w);
+                const std::complex<float> a = data[start + k];
+                const std::complex<float> b = data[start + k + halfLength];
+                const std::complex<float> t(w.real() * b.real() - w.imag() * b.imag(),
+                                            w.real() * b.imag() + w.imag() * b.real());
+                data[start + k] = a + t;
+                data[start + k + halfLength] = a - t;
+            }
+        }
+    }
+}
+
+void RealFft::forward(const float *input, SplitComplex &spectrum)
+{
+    if (spectrum.bins() != bins())
+        spectrum = SplitComplex(bins());
+    std::complex<float> *z = m_work.data();
+    for (int n = 0; n < m_half; ++n)
+        z[n] = std::complex<float>(input[2 * n], input[2 * n + 1]);
+    transform(z, false);
+
+    // X[k] = E[k] + W^k O[k], E = (Z[k] + Z*[M-k]) / 2, O = (Z[k] - Z*[M-k]) / 2i
+    for (int k = 0; k <= m_half; ++k) {
+        const std::complex<float> zk = z[k % m_half];
+        const std::complex<float> zm = std::conj(z[(m_half - k) % m_half]);
+        const std::complex<float> even = 0.5f * (zk + zm);
+        const std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (zk - zm);
+        const std::complex<float> x = even + m_split[size_t(k)] * odd;
+        spectrum.re[size_t(k)] = x.real();
+        spectrum.im[size_t(k)] = x.imag();
+    }
+}
+
+void RealFft::inverse(const SplitComplex &spectrum, float *output)
+{
+    std::complex<float> *z = m_work.data();
+    // Z[k] = E[k] + i O[k], E = (X[k] + X*[M-k]) / 2, O = (X[k] - X*[M-k]) W^-k / 2
+    for (int k = 0; k < m_half; ++k) {
+        const std::complex<float> xk(spectrum.re[size_t(k)], spectrum.im[size_t(k)]);
+        const std::complex<float> xm(spectrum.re[size_t(m_half - k)], -spectrum.im[size_t(m_half - k)]);
+        const std::complex<float> even = 0.5f * (xk + xm);
+        const std::complex<float> odd = 0.5f * (xk - xm) * std::conj(m_split[size_t(k)]);
+        z[k] = even + std::complex<float>(0.0f, 1.0f) * odd;
+    }
+    transform(z, true);
+    // The half-size inverse contributes a factor of M = N/2; scale by 2 so
+    // the overall gain is N, matching an unnormalised full-size inverse.
+    for (int n = 0; n < m_half; ++n) {
+        output[2 * n] = 2.0f * z[n].real();
+        output[2 * n + 1] = 2.0f * z[n].imag();
+    }
+}
+
+} // namespace vep
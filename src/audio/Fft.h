@@ -0,0 +1,51 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+namespace vep {
+
+// Spectrum in split (structure-of-arrays) form so multiply-accumulate loops
+// over bins vectorise.
+struct SplitComplex
+{
+    std::vector<float> re;
+    std::vector<float> im;
+
+    SplitComplex() = default;
+    explicit SplitComplex(int bins) : re(size_t(bins), 0.0f), im(size_t(bins), 0.0f) {}
+    int bins() const { return int(re.size()); }
+    void clear();
+};
+
+// acc += a * b over all bins.
+void multiplyAccumulate(SplitComplex &acc, const SplitComplex &a, const SplitComplex &b);
+// acc += a over all bins.
+void accumulate(SplitComplex &acc, const SplitComplex &a);
+
+// Power-of-two real FFT computed as a half-size complex FFT plus a split
+// step. forward() produces size/2 + 1 bins; inverse() is unnormalised, the
+// caller scales by 1 / size.
+class RealFft
+{
+public:
+    explicit RealFft(int size);
+
+    int size() const { return m_size; }
+    int bins() const { return m_size / 2 + 1; }
+
+    void forward(const float *input, SplitComplex &spectrum);
+    void inverse(const SplitComplex &spectrum, float *output);
+
+private:
+    void transform(std::complex<float> *data, bool inverse) const;
+
+    int m_size;
+    int m_half;
+    std::vector<int> m_bitReverse;
+    std::vector<std::complex<float>> m_twiddles; // e^{-2 pi i k / half}
+    std::vector<std::complex<float>> m_split;    // e^{-2 pi i k / size}
+    std::vector<std::complex<float>> m_work;
+};
+
+} // namespace vep
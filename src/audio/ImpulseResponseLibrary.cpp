@@ -0,0 +1,192 @@
+#include "audio/ImpulseResponseLibrary.h"
+
+#include "audio/WavFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace vep {
+
+namespace {
+
+// Longest IR we accept; anything beyond is trimmed.
+constexpr double kMaxSeconds = 12.0;
+
+bool isWav(const fs::path &path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    return ext == ".wav";
+}
+
+// Windowed-sinc (Blackman) resampler. IRs are resampled once at load time,
+// so quality matters more than speed here.
+std::vector<float> resample(const std::vector<float> &input, int fromRate, int toRate)
+{
+    if (fromRate == toRate || input.empty())
+        return input;
+    constexpr double pi = 3.14159265358979323846;
+    constexpr int kZeroCrossings = 32;
+    const double ratio = double(toRate) / double(fromRate);
+    const double cutoff = std::min(1.0, ratio) * 0.97;
+    const double halfWidth = kZeroCrossings / cutoff;
+    const size_t outFrames = size_t(std::ceil(double(input.size()) * ratio));
+
+    std::vector<float> output(outFrames);
+    for (size_t n = 0; n < outFrames; ++n) {
+        const double center = double(n) / ratio;
+        const long first = long(std::ceil(center - halfWidth));
+        const long last = long(std::floor(center + halfWidth));
+        double sum = 0.0;
+        for (long i = std::max(first, 0L); i <= last && i < long(input.size()); ++i) {
+            const double t = double(i) - center;
+            const double x = pi * t * cutoff;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+            const double w = 0.42 + 0.5 * std::cos(pi * t / halfWidth) + 0.08 * std::cos(2.0 * pi * t / halfWidth);
+            sum += double(input[size_t(i)]) * sinc * w * cutoff;
+        }
+        output[n] = float(sum);
+    }
+    return output;
+}
+
+// Scale so the loudest output path carries unit energy; keeps wet levels
+// comparable across IRs of very different lengths.
+void normalise(std::vector<std::vector<float>> &channels, bool trueStereo)
+{
+    auto energy = [](const std::vector<float> &c) {
+        double e = 0.0;
+        for (float s : c)
+            e += double(s) * double(s);
+        return e;
+    };
+    double loudest = 0.0;
+    if (trueStereo) {
+        loudest = std::max(energy(channels[0]) + energy(channels[2]),
+                           energy(channels[1]) + energy(channels[3]));
+    } else {
+        for (const auto &c : channels)
+            loudest = std::max(loudest, energy(c));
+    }
+    if (loudest <= 0.0)
+        return;
+    const float gain = float(1.0 / std::sqrt(loudest));
+    for (auto &c : channels)
+        for (float &s : c)
+            s *= gain;
+}
+
+} // namespace
+
+ImpulseResponseLibrary &ImpulseResponseLibrary::instance()
+{
+    static ImpulseResponseLibrary library;
+    return library;
+}
+
+void ImpulseResponseLibrary::addSearchPath(const std::string &directory)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (std::find(m_searchPaths.begin(), m_searchPaths.end(), directory) != m_searchPaths.end())
+            return;
+        m_searchPaths.push_back(directory);
+    }
+    rescan();
+}
+
+void ImpulseResponseLibrary::rescan()
+{
+    std::vector<std::string> roots;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        roots = m_searchPaths;
+    }
+
+    std::vector<ImpulseResponseInfo> entries;
+    for (const std::string &root : roots) {
+        std::error_code error;
+        for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+            if (!it->is_regular_file() || !isWav(it->path()))
+                continue;
+            ImpulseResponseInfo info;
+            info.path = it->path().string();
+            info.id = fs::relative(it->path(), root).replace_extension().generic_string();
+            info.name = it->path().stem().string();
+            info.category = it->path().parent_path().filename().string();
+            try {
+                const AudioFileInfo wav = WavFile::readInfo(info.path);
+                info.channels = wav.channels;
+                info.sampleRate = wav.sampleRate;
+                info.seconds = double(wav.frames) / wav.sampleRate;
+            } catch (const std::exception &) {
+                continue;
+            }
+            if (info.channels == 1 || info.channels == 2 || info.channels == 4)
+                entries.push_back(std::move(info));
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        return a.category != b.category ? a.category < b.category : a.name < b.name;
+    });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries = std::move(entries);
+}
+
+std::vector<ImpulseResponseInfo> ImpulseResponseLibrary::entries() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries;
+}
+
+std::string ImpulseResponseLibrary::resolve(const std::string &idOrPath) const
+{
+    for (const ImpulseResponseInfo &info : m_entries) {
+        if (info.id == idOrPath)
+            return info.path;
+    }
+    return idOrPath;
+}
+
+std::shared_ptr<const ImpulseResponse> ImpulseResponseLibrary::load(const std::string &idOrPath,
+                                                                   int sampleRate)
+{
+    std::string path;
+    const std::string key = idOrPath + '@' + std::to_string(sampleRate);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto cached = m_cache[key].lock())
+            return cached;
+        path = resolve(idOrPath);
+    }
+
+    AudioFileInfo info;
+    std::vector<std::vector<float>> channels = WavFile::read(path, &info);
+    if (channels.size() != 1 && channels.size() != 2 && channels.size() != 4)
+        throw std::runtime_error("impulse response must be mono, stereo or true stereo: " + path);
+
+    const size_t maxFrames = size_t(kMaxSeconds * info.sampleRate);
+    auto ir = std::make_shared<ImpulseResponse>();
+    ir->id = idOrPath;
+    ir->sampleRate = sampleRate;
+    for (auto &c : channels) {
+        if (c.size() > maxFrames)
+            c.resize(maxFrames);
+        ir->channels.push_back(resample(c, info.sampleRate, sampleRate));
+    }
+    normalise(ir->channels, ir->trueStereo());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto raced = m_cache[key].lock())
+        return raced;
+    m_cache[key] = ir;
+    return ir;
+}
+
+} // namespace vep
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// Impulse response ready for convolution. Channel layout:
+//   1 - mono, applied to every input channel
+//   2 - stereo, L->L and R->R
+//   4 - true stereo, L->L, L->R, R->L, R->R
+struct ImpulseResponse
+{
+    std::string id;
+    int sampleRate = 0;
+    std::vector<std::vector<float>> channels;
+
+    int frames() const { return channels.empty() ? 0 : int(channels.front().size()); }
+    bool trueStereo() const { return channels.size() == 4; }
+};
+
+struct ImpulseResponseInfo
+{
+    std::string id;       // path relative to its search root, without extension
+    std::string name;     // file stem
+    std::string category; // parent directory, e.g. "Halls"
+    std::string path;
+    int channels = 0;
+    int sampleRate = 0;
+    double seconds = 0.0;
+};
+
+// Catalogue of the WAV impulse responses found under the search paths. The
+// application registers share/videoeditorpro/impulses next to its binary
+// and an "impulses" folder in the user's data directory; no IRs ship with
+// it yet, so the list holds what the user puts in that folder, and the
+// reverb also takes a path to any WAV file. Loaded IRs are resampled to the
+// requested rate, normalised to unit energy and cached, so every track
+// using the same hall shares one copy.
+class ImpulseResponseLibrary
+{
+public:
+    static ImpulseResponseLibrary &instance();
+
+    void addSearchPath(const std::string &directory);
+    void rescan();
+    std::vector<ImpulseResponseInfo> entries() const;
+
+    // idOrPath is an entry id or a path to a WAV file. Throws
+    // std::runtime_error if it cannot be read.
+    std::shared_ptr<const ImpulseResponse> load(const std::string &idOrPath, int sampleRate);
+
+private:
+    std::string resolve(const std::string &idOrPath) const;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::string> m_searchPaths;
+    std::vector<ImpulseResponseInfo> m_entries;
+    std::map<std::string, std::weak_ptr<const ImpulseResponse>> m_cache;
+};
+
+} // namespace vep
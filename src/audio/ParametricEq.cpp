@@ -0,0 +1,186 @@
+#include "audio/ParametricEq.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+namespace {
+
+// Fraction of the remaining distance covered per control block; about 2 ms
+// to settle within 1% at 48 kHz.
+constexpr double kGlide = 0.35;
+
+bool approach(double &current, double target, double tolerance)
+{
+    if (std::fabs(target - current) <= tolerance) {
+        const bool changed = current != target;
+        current = target;
+        return changed;
+    }
+    current += (target - current) * kGlide;
+    return true;
+}
+
+bool approachLog(double &current, double target, double tolerance)
+{
+    const double logTarget = std::log(target);
+    double logCurrent = std::log(current);
+    if (!approach(logCurrent, logTarget, tolerance))
+        return false;
+    current = logCurrent == logTarget ? target : std::exp(logCurrent);
+    return true;
+}
+
+} // namespace
+
+ParametricEq::ParametricEq(double sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(std::max(channels, 1))
+    , m_groups((m_channels + 3) / 4)
+    , m_z1(size_t(m_groups) * kMaxBands)
+    , m_z2(size_t(m_groups) * kMaxBands)
+{
+    for (BandState &band : m_bands)
+        redesign(band);
+}
+
+void ParametricEq::setBand(int index, const EqBand &band)
+{
+    if (index < 0 || index >= kMaxBands)
+        return;
+    BandState &state = m_bands[size_t(index)];
+    EqBand target = band;
+    target.frequency = std::clamp(target.frequency, 10.0, m_sampleRate * 0.49);
+    target.q = std::clamp(target.q, 0.025, 40.0);
+    target.gainDb = std::clamp(target.gainDb, -48.0, 48.0);
+    // Shape and on/off changes cannot be interpolated meaningfully.
+    if (target.shape != state.current.shape || target.enabled != state.current.enabled) {
+        state.current = target;
+        state.dirty = true;
+    }
+    state.target = target;
+}
+
+void ParametricEq::snapToTargets()
+{
+    for (BandState &band : m_bands) {
+        band.current = band.target;
+        band.dirty = true;
+    }
+}
+
+void ParametricEq::reset()
+{
+    std::fill(m_z1.begin(), m_z1.end(), Float4());
+    std::fill(m_z2.begin(), m_z2.end(), Float4());
+}
+
+bool ParametricEq::glide()
+{
+    bool any = false;
+    for (BandState &band : m_bands) {
+        bool changed = band.dirty;
+        changed |= approachLog(band.current.frequency, band.target.frequency, 1e-4);
+        changed |= approachLog(band.current.q, band.target.q, 1e-4);
+        changed |= approach(band.current.gainDb, band.target.gainDb, 1e-3);
+        if (changed)
+            redesign(band);
+        any |= changed;
+    }
+    return any;
+}
+
+void ParametricEq::redesign(BandState &band)
+{
+    band.coefficients = BiquadCoefficients::design(band.current.shape, m_sampleRate,
+                                                   band.current.frequency,
+                                                   band.current.gainDb, band.current.q);
+    band.dirty = false;
+}
+
+void ParametricEq::process(float *interleaved, int frames)
+{
+    ScopedFlushDenormals flush;
+    int offset = 0;
+    while (offset < frames) {
+        const int n = std::min(kControlBlock, frames - offset);
+        if (glide() || offset == 0) {
+            unsigned activeMask = 0;
+            m_activeCount = 0;
+            for (int b = 0; b < kMaxBands; ++b) {
+                const EqBand &band = m_bands[size_t(b)].current;
+                const bool flat = band.gainDb == 0.0
+                                  && (band.shape == FilterShape::Peaking
+                                      || band.shape == FilterShape::LowShelf
+                                      || band.shape == FilterShape::HighShelf);
+                if (band.enabled && !flat) {
+                    m_activeBands[size_t(m_activeCount++)] = b;
+                    activeMask |= 1u << b;
+                }
+            }
+            // A band entering the cascade must not replay stale memory.
+            const unsigned entering = activeMask & ~m_activeMask;
+            for (int g = 0; g < m_groups && entering; ++g) {
+                for (int b = 0; b < kMaxBands; ++b) {
+                    if (entering & (1u << b)) {
+                        m_z1[size_t(g) * kMaxBands + size_t(b)] = Float4();
+                        m_z2[size_t(g) * kMaxBands + size_t(b)] = Float4();
+                    }
+                }
+            }
+            m_activeMask = activeMask;
+        }
+        if (m_activeCount > 0) {
+            for (int g = 0; g < m_groups; ++g)
+                processGroup(interleaved + size_t(offset) * size_t(m_channels), n, g);
+        }
+        offset += n;
+    }
+}
+
+void ParametricEq::processGroup(float *interleaved, int frames, int group)
+{
+    struct Lanes
+    {
+        Float4 b0, b1, b2, a1, a2;
+    };
+    std::array<Lanes, kMaxBands> c;
+    for (int i = 0; i < m_activeCount; ++i) {
+        const BiquadCoefficients &k = m_bands[size_t(m_activeBands[size_t(i)])].coefficients;
+        c[size_t(i)] = {Float4(k.b0), Float4(k.b1), Float4(k.b2), Float4(k.a1), Float4(k.a2)};
+    }
+
+    Float4 *z1 = &m_z1[size_t(group) * kMaxBands];
+    Float4 *z2 = &m_z2[size_t(group) * kMaxBands];
+    const int firstChannel = group * 4;
+    const int lanes = std::min(4, m_channels - firstChannel);
+    const bool direct = lanes == 4;
+
+    for (int i = 0; i < frames; ++i) {
+        float *frame = interleaved + size_t(i) * size_t(m_channels) + size_t(firstChannel);
+        float padded[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        if (!direct)
+            std::copy(frame, frame + lanes, padded);
+        Float4 x = direct ? Float4::load(frame) : Float4::load(padded);
+
+        for (int i2 = 0; i2 < m_activeCount; ++i2) {
+            const int b = m_activeBands[size_t(i2)];
+            const Lanes &k = c[size_t(i2)];
+            // Transposed direct form II.
+            const Float4 y = k.b0 * x + z1[b];
+            z1[b] = k.b1 * x - k.a1 * y + z2[b];
+            z2[b] = k.b2 * x - k.a2 * y;
+            x = y;
+        }
+
+        if (direct) {
+            x.store(frame);
+        } else {
+            x.store(padded);
+            std::copy(padded, padded + lanes, frame);
+        }
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "audio/Biquad.h"
+#include "core/SimdFloat4.h"
+
+#include <array>
+#include <vector>
+
+namespace vep {
+
+struct EqBand
+{
+    FilterShape shape = FilterShape::Peaking;
+    double frequency = 1000.0;
+    double gainDb = 0.0;
+    double q = 0.707;
+    bool enabled = false;
+};
+
+// Native parametric EQ: a cascade of up to kMaxBands biquads applied to
+// interleaved float audio. Channels are packed four to a Float4 so every
+// band processes a whole channel group per instruction. Band parameters set
+// through setBand() are treated as automation targets and glide there over
+// a few milliseconds, with coefficients redesigned every kControlBlock
+// frames, so keyframed gain/frequency changes do not click.
+class ParametricEq
+{
+public:
+    static constexpr int kMaxBands = 8;
+    static constexpr int kControlBlock = 32;
+
+    ParametricEq(double sampleRate, int channels);
+
+    double sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+
+    void setBand(int index, const EqBand &band);
+    const EqBand &band(int index) const { return m_bands[index].target; }
+
+    // Jump to the target parameters without gliding; used after a seek.
+    void snapToTargets();
+    // Clears the filter memory; used when playback is not contiguous.
+    void reset();
+
+    void process(float *interleaved, int frames);
+
+private:
+    struct BandState
+    {
+        EqBand target;
+        EqBand current;
+        BiquadCoefficients coefficients;
+        bool dirty = true;
+    };
+
+    bool glide();
+    void redesign(BandState &band);
+    void processGroup(float *interleaved, int frames, int group);
+
+    double m_sampleRate;
+    int m_channels;
+    int m_groups;
+    std::array<BandState, kMaxBands> m_bands;
+    std::array<int, kMaxBands> m_activeBands{};
+    int m_activeCount = 0;
+    unsigned m_activeMask = 0;
+    // Filter memory, indexed [group * kMaxBands + band].
+    std::vector<Float4> m_z1;
+    std::vector<Float4> m_z2;
+};
+
+} // namespace vep
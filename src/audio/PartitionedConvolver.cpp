@@ -0,0 +1,273 @@
+#include "audio/PartitionedConvolver.h"
+
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vep {
+
+namespace {
+
+// Larger blocks only add latency headroom nobody needs; the last stage
+// takes the rest of the IR in blocks of this size.
+constexpr int kMaxBlock = 16384;
+// Fewer partitions than this per worker is not worth a task.
+constexpr int kMinPartitionsPerChunk = 4;
+
+} // namespace
+
+struct PartitionedConvolver::Stage
+{
+    Stage(int block_, int offset_, int partitions_, int outputs, int chunks_)
+        : block(block_)
+        , offset(offset_)
+        , partitions(partitions_)
+        , chunks(chunks_)
+        , fft(2 * block_)
+        , filters(size_t(outputs))
+        , fdl(size_t(partitions_), SplitComplex(block_ + 1))
+        , window(size_t(2 * block_), 0.0f)
+        , jobInput(size_t(2 * block_), 0.0f)
+        , partial(size_t(chunks_), std::vector<SplitComplex>(size_t(outputs), SplitComplex(block_ + 1)))
+        , ifftOut(size_t(2 * block_), 0.0f)
+    {
+        for (auto &slot : slots)
+            slot.assign(size_t(outputs), std::vector<float>(size_t(block_), 0.0f));
+    }
+
+    const int block;
+    const int offset;
+    const int partitions;
+    const int chunks;
+    RealFft fft;
+    std::vector<std::vector<SplitComplex>> filters; // [output][partition]
+    std::vector<SplitComplex> fdl;                  // input spectra, newest at fdlHead
+    int fdlHead = 0;
+
+    std::vector<float> window; // previous block followed by the one filling up
+    int fill = 0;
+
+    // Tail stages only.
+    std::vector<float> jobInput;
+    std::vector<std::vector<SplitComplex>> partial; // [chunk][output]
+    std::vector<float> ifftOut;
+    std::vector<std::vector<float>> slots[2];       // [job % 2][output]
+    int jobSlot = 0;
+    long long launched = 0;
+    std::atomic<int> remaining{0};
+    std::promise<void> done;
+    std::future<void> pending;
+};
+
+PartitionedConvolver::PartitionedConvolver(const std::vector<std::vector<float>> &irs,
+                                           int headBlock, int growth, ThreadPool *pool)
+    : m_headBlock(headBlock)
+    , m_outputs(int(irs.size()))
+    , m_pool(pool ? pool : &ThreadPool::shared())
+    , m_inputBlock(size_t(headBlock), 0.0f)
+    , m_outputBlocks(irs.size(), std::vector<float>(size_t(headBlock), 0.0f))
+{
+    size_t length = 0;
+    for (const auto &ir : irs)
+        length = std::max(length, ir.size());
+    growth = std::max(growth, 2);
+
+    int block = headBlock;
+    int offset = 0;
+    for (int s = 0; offset < int(length) || s == 0; ++s) {
+        const bool last = block >= kMaxBlock;
+        const int end = last ? int(length) : std::min(int(length), 2 * block * growth);
+        const int partitions = std::max(1, (end - offset + block - 1) / block);
+        const int chunks = s == 0 ? 1
+                                  : std::clamp(partitions / kMinPartitionsPerChunk, 1,
+                                               m_pool->threadCount());
+        auto stage = std::make_unique<Stage>(block, offset, partitions, m_outputs, chunks);
+
+        std::vector<float> segment(size_t(2 * block));
+        const float scale = 1.0f / float(2 * block);
+        for (int o = 0; o < m_outputs; ++o) {
+            const std::vector<float> &ir = irs[size_t(o)];
+            stage->filters[size_t(o)].resize(size_t(partitions));
+            for (int p = 0; p < partitions; ++p) {
+                std::fill(segment.begin(), segment.end(), 0.0f);
+                const size_t from = size_t(offset) + size_t(p) * size_t(block);
+                for (size_t i = 0; i < size_t(block) && from + i < ir.size(); ++i)
+                    segment[i] = ir[from + i] * scale;
+                stage->fft.forward(segment.data(), stage->filters[size_t(o)][size_t(p)]);
+            }
+        }
+        m_stages.push_back(std::move(stage));
+
+        offset = end;
+        if (last)
+            break;
+        block *= growth;
+    }
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+    waitIdle();
+}
+
+void PartitionedConvolver::waitIdle()
+{
+    for (size_t s = 1; s < m_stages.size(); ++s) {
+        if (m_stages[s]->pending.valid())
+            m_stages[s]->pending.wait();
+    }
+}
+
+void PartitionedConvolver::reset()
+{
+    waitIdle();
+    for (auto &stage : m_stages) {
+        for (SplitComplex &spectrum : stage->fdl)
+            spectrum.clear();
+        std::fill(stage->window.begin(), stage->window.end(), 0.0f);
+        stage->fill = 0;
+        stage->launched = 0;
+        stage->pending = std::future<void>();
+        for (auto &slot : stage->slots)
+            for (auto &samples : slot)
+                std::fill(samples.begin(), samples.end(), 0.0f);
+    }
+    for (auto &block : m_outputBlocks)
+        std::fill(block.begin(), block.end(), 0.0f);
+    m_blockIndex = 0;
+    m_fill = 0;
+}
+
+void PartitionedConvolver::process(const float *input, int inputStride, float *const *outputs,
+                                   int outputStride, int frames)
+{
+    int done = 0;
+    while (done < frames) {
+        const int n = std::min(frames - done, m_headBlock - m_fill);
+        for (int i = 0; i < n; ++i)
+            m_inputBlock[size_t(m_fill + i)] = input[size_t(done + i) * size_t(inputStride)];
+        for (int o = 0; o < m_outputs; ++o) {
+            const float *block = m_outputBlocks[size_t(o)].data() + m_fill;
+            float *out = outputs[o] + size_t(done) * size_t(outputStride);
+            for (int i = 0; i < n; ++i)
+                out[size_t(i) * size_t(outputStride)] = block[i];
+        }
+        m_fill += n;
+        done += n;
+        if (m_fill == m_headBlock) {
+            processBlock();
+            m_fill = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processBlock()
+{
+    const int B = m_headBlock;
+
+    // 1. Head stage, synchronously.
+    Stage &head = *m_stages.front();
+    std::memcpy(head.window.data() + B, m_inputBlock.data(), size_t(B) * sizeof(float));
+    head.fdlHead = (head.fdlHead + head.partitions - 1) % head.partitions;
+    head.fft.forward(head.window.data(), head.fdl[size_t(head.fdlHead)]);
+    std::memcpy(head.window.data(), head.window.data() + B, size_t(B) * sizeof(float));
+    for (int o = 0; o < m_outputs; ++o) {
+        SplitComplex &acc = head.partial[0][size_t(o)];
+        acc.clear();
+        for (int p = 0; p < head.partitions; ++p)
+            multiplyAccumulate(acc, head.fdl[size_t((head.fdlHead + p) % head.partitions)],
+                               head.filters[size_t(o)][size_t(p)]);
+        head.fft.inverse(acc, head.ifftOut.data());
+        std::memcpy(m_outputBlocks[size_t(o)].data(), head.ifftOut.data() + B,
+                    size_t(B) * sizeof(float));
+    }
+
+    // 2. Mix in tail output due now. Job k of stage s lands at
+    //    [(k + 2) Bs, (k + 3) Bs) and was waited for when job k + 1 launched.
+    const long long position = m_blockIndex * B;
+    for (size_t s = 1; s < m_stages.size(); ++s) {
+        Stage &stage = *m_stages[s];
+        const long long k = position / stage.block - 2;
+        if (k < 0 || k >= stage.launched - 1)
+            continue;
+        const int offset = int(position % stage.block);
+        for (int o = 0; o < m_outputs; ++o) {
+            const float *tail = stage.slots[k % 2][size_t(o)].data() + offset;
+            float *out = m_outputBlocks[size_t(o)].data();
+            for (int i = 0; i < B; ++i)
+                out[i] += tail[i];
+        }
+    }
+
+    // 3. Feed the tail stages; a stage whose block filled up starts a job.
+    //    This must follow step 2, which may still read the slot the new job
+    //    is about to overwrite.
+    for (size_t s = 1; s < m_stages.size(); ++s) {
+        Stage &stage = *m_stages[s];
+        std::memcpy(stage.window.data() + stage.block + stage.fill, m_inputBlock.data(),
+                    size_t(B) * sizeof(float));
+        stage.fill += B;
+        if (stage.fill == stage.block) {
+            launch(stage);
+            std::memcpy(stage.window.data(), stage.window.data() + stage.block,
+                        size_t(stage.block) * sizeof(float));
+            stage.fill = 0;
+        }
+    }
+
+    ++m_blockIndex;
+}
+
+void PartitionedConvolver::launch(Stage &stage)
+{
+    // One job in flight per stage: the previous one owns the FDL and its
+    // output is due right now anyway.
+    if (stage.pending.valid())
+        stage.pending.wait();
+
+    stage.jobInput = stage.window;
+    stage.jobSlot = int(stage.launched % 2);
+    stage.done = std::promise<void>();
+    stage.pending = stage.done.get_future();
+    stage.remaining.store(stage.chunks, std::memory_order_relaxed);
+    ++stage.launched;
+
+    m_pool->post([this, &stage] {
+        stage.fdlHead = (stage.fdlHead + stage.partitions - 1) % stage.partitions;
+        stage.fft.forward(stage.jobInput.data(), stage.fdl[size_t(stage.fdlHead)]);
+        for (int c = 1; c < stage.chunks; ++c)
+            m_pool->post([this, &stage, c] { runChunk(stage, c); });
+        runChunk(stage, 0);
+    });
+}
+
+void PartitionedConvolver::runChunk(Stage &stage, int chunk)
+{
+    const int first = chunk * stage.partitions / stage.chunks;
+    const int last = (chunk + 1) * stage.partitions / stage.chunks;
+    for (int o = 0; o < m_outputs; ++o) {
+        SplitComplex &acc = stage.partial[size_t(chunk)][size_t(o)];
+        acc.clear();
+        for (int p = first; p < last; ++p)
+            multiplyAccumulate(acc, stage.fdl[size_t((stage.fdlHead + p) % stage.partitions)],
+                               stage.filters[size_t(o)][size_t(p)]);
+    }
+    if (stage.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        finish(stage);
+}
+
+void PartitionedConvolver::finish(Stage &stage)
+{
+    for (int o = 0; o < m_outputs; ++o) {
+        SplitComplex &acc = stage.partial[0][size_t(o)];
+        for (int c = 1; c < stage.chunks; ++c)
+            accumulate(acc, stage.partial[size_t(c)][size_t(o)]);
+        stage.fft.inverse(acc, stage.ifftOut.data());
+        std::memcpy(stage.slots[stage.jobSlot][size_t(o)].data(),
+                    stage.ifftOut.data() + stage.block, size_t(stage.block) * sizeof(float));
+    }
+    stage.done.set_value();
+}
+
+} // namespace vep
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "audio/Fft.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace vep {
+
+class ThreadPool;
+
+// Non-uniformly partitioned overlap-save convolution of one input signal
+// with one or more impulse responses (true-stereo IRs share the input
+// spectra this way).
+//
+// The IR is cut into stages with geometrically growing block sizes
+// B, rB, r^2 B, ... Stage 0 covers IR[0, 2rB) in B-sized partitions and runs
+// synchronously inside process(), so the latency is only B samples. Stage s
+// >= 1 uses blocks Bs = r^s B, starts at IR offset 2 Bs and therefore has a
+// full block period between receiving its input and its first output being
+// due; it runs on the thread pool, with its partitions split across several
+// workers. process() only blocks if a tail job misses that deadline, which
+// keeps offline renders exact on slow machines.
+class PartitionedConvolver
+{
+public:
+    // irs: one impulse response per output, all at the processing rate.
+    PartitionedConvolver(const std::vector<std::vector<float>> &irs, int headBlock = 256,
+                         int growth = 8, ThreadPool *pool = nullptr);
+    ~PartitionedConvolver();
+
+    PartitionedConvolver(const PartitionedConvolver &) = delete;
+    PartitionedConvolver &operator=(const PartitionedConvolver &) = delete;
+
+    int latency() const { return m_headBlock; }
+    int outputCount() const { return m_outputs; }
+
+    // Reads `frames` input samples (stride inputStride) and writes `frames`
+    // samples, delayed by latency(), to each of outputCount() outputs
+    // (stride outputStride).
+    void process(const float *input, int inputStride, float *const *outputs, int outputStride,
+                 int frames);
+    void reset();
+
+private:
+    struct Stage;
+
+    void processBlock();
+    void launch(Stage &stage);
+    void runChunk(Stage &stage, int chunk);
+    void finish(Stage &stage);
+    void waitIdle();
+
+    int m_headBlock;
+    int m_outputs;
+    ThreadPool *m_pool;
+    std::vector<std::unique_ptr<Stage>> m_stages;
+
+    long long m_blockIndex = 0;
+    int m_fill = 0;
+    std::vector<float> m_inputBlock;
+    std::vector<std::vector<float>> m_outputBlocks;
+};
+
+} // namespace vep
@@ -0,0 +1,189 @@
+#include "audio/PeakFile.h"
+
+#include "core/BinaryIO.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+constexpr int kMinTopBins = 16;
+constexpr int kMaxLevels = 16;
+
+int16_t quantize(double value)
+{
+    return int16_t(std::lround(std::clamp(value, -1.0, 1.0) * 32767.0));
+}
+
+// Merges runs of `factor` bins (per channel) of one level into the next.
+std::vector<PeakBin> coarsen(const std::vector<PeakBin> &finer, int channels, int factor)
+{
+    const size_t finerBins = finer.size() / size_t(channels);
+    const size_t bins = (finerBins + size_t(factor) - 1) / size_t(factor);
+    std::vector<PeakBin> coarser(bins * size_t(channels));
+    for (size_t bin = 0; bin < bins; ++bin) {
+        const size_t first = bin * size_t(factor);
+        const size_t last = std::min(first + size_t(factor), finerBins);
+        for (int c = 0; c < channels; ++c) {
+            int16_t lo = std::numeric_limits<int16_t>::max();
+            int16_t hi = std::numeric_limits<int16_t>::min();
+            double squares = 0.0;
+            for (size_t i = first; i < last; ++i) {
+                const PeakBin &p = finer[i * size_t(channels) + size_t(c)];
+                lo = std::min(lo, p.min);
+                hi = std::max(hi, p.max);
+                squares += double(p.rms) * double(p.rms);
+            }
+            coarser[bin * size_t(channels) + size_t(c)] =
+                PeakBin{lo, hi, int16_t(std::lround(std::sqrt(squares / double(last - first))))};
+        }
+    }
+    return coarser;
+}
+
+} // namespace
+
+PeakBuilder::PeakBuilder(int sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(channels)
+    , m_min(static_cast<size_t>(channels), std::numeric_limits<float>::max())
+    , m_max(static_cast<size_t>(channels), std::numeric_limits<float>::lowest())
+    , m_sumSquares(static_cast<size_t>(channels), 0.0)
+{
+}
+
+void PeakBuilder::process(const float *interleaved, int frames)
+{
+    for (int i = 0; i < frames; ++i) {
+        const float *frame = interleaved + size_t(i) * size_t(m_channels);
+        for (int c = 0; c < m_channels; ++c) {
+            const float v = frame[c];
+            m_min[size_t(c)] = std::min(m_min[size_t(c)], v);
+            m_max[size_t(c)] = std::max(m_max[size_t(c)], v);
+            m_sumSquares[size_t(c)] += double(v) * double(v);
+        }
+        if (++m_fill == kBaseFrames)
+            flushBin();
+    }
+    m_frames += uint64_t(frames);
+}
+
+void PeakBuilder::flushBin()
+{
+    for (int c = 0; c < m_channels; ++c) {
+        const size_t i = size_t(c);
+        m_base.push_back(PeakBin{quantize(m_min[i]), quantize(m_max[i]),
+                                 quantize(std::sqrt(m_sumSquares[i] / m_fill))});
+        m_min[i] = std::numeric_limits<float>::max();
+        m_max[i] = std::numeric_limits<float>::lowest();
+        m_sumSquares[i] = 0.0;
+    }
+    m_fill = 0;
+}
+
+std::vector<uint8_t> PeakBuilder::finish()
+{
+    if (m_fill > 0)
+        flushBin();
+
+    std::vector<std::vector<PeakBin>> levels;
+    levels.push_back(std::move(m_base));
+    uint64_t framesPerBin = kBaseFrames;
+    while (int(levels.size()) < kMaxLevels
+           && levels.back().size() / size_t(std::max(m_channels, 1)) > size_t(kMinTopBins)) {
+        levels.push_back(coarsen(levels.back(), m_channels, kLevelFactor));
+        framesPerBin *= kLevelFactor;
+    }
+
+    const size_t headerSize = 8 + 4 + 4 + 8 + 4 + 4 + levels.size() * 24;
+    ByteWriter out;
+    out.putMagic("VEPPEAK1");
+    out.put(uint32_t(m_sampleRate));
+    out.put(uint32_t(m_channels));
+    out.put(m_frames);
+    out.put(uint32_t(levels.size()));
+    out.put(uint32_t(0));
+    uint64_t offset = (headerSize + 7) & ~size_t(7);
+    uint64_t binFrames = kBaseFrames;
+    for (const auto &level : levels) {
+        const uint64_t binCount = level.size() / size_t(std::max(m_channels, 1));
+        out.put(binFrames);
+        out.put(binCount);
+        out.put(offset);
+        offset += (level.size() * sizeof(PeakBin) + 7) & ~size_t(7);
+        binFrames *= kLevelFactor;
+    }
+    for (const auto &level : levels) {
+        while (out.bytes().size() % 8)
+            out.put(uint8_t(0));
+        out.putRaw(level.data(), level.size() * sizeof(PeakBin));
+    }
+    return out.take();
+}
+
+PeakFile::PeakFile(const std::string &path)
+    : m_file(std::make_unique<MappedFile>(path))
+{
+    ByteReader in(m_file->data(), m_file->size());
+    in.expectMagic("VEPPEAK1");
+    m_sampleRate = int(in.get<uint32_t>());
+    m_channels = int(in.get<uint32_t>());
+    m_frames = in.get<uint64_t>();
+    const uint32_t levelCount = in.get<uint32_t>();
+    in.get<uint32_t>();
+    if (m_channels <= 0 || m_sampleRate <= 0 || levelCount == 0 || levelCount > uint32_t(kMaxLevels))
+        throw std::runtime_error("malformed peak file " + path);
+
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        Level level;
+        level.framesPerBin = in.get<uint64_t>();
+        level.binCount = in.get<uint64_t>();
+        const uint64_t offset = in.get<uint64_t>();
+        const uint64_t bytes = level.binCount * uint64_t(m_channels) * sizeof(PeakBin);
+        if (level.framesPerBin == 0 || offset % alignof(PeakBin) || offset > m_file->size()
+            || bytes > m_file->size() - offset)
+            throw std::runtime_error("malformed peak file " + path);
+        level.bins = reinterpret_cast<const PeakBin *>(m_file->data() + offset);
+        m_levels.push_back(level);
+    }
+}
+
+int PeakFile::levelFor(double framesPerPixel) const
+{
+    int best = 0;
+    for (int i = 1; i < levelCount(); ++i) {
+        if (double(m_levels[size_t(i)].framesPerBin) <= framesPerPixel)
+            best = i;
+    }
+    return best;
+}
+
+PeakBin PeakFile::summarize(int levelIndex, int channel, double fromFrame, double toFrame) const
+{
+    const Level &level = m_levels[size_t(levelIndex)];
+    if (level.binCount == 0)
+        return PeakBin{0, 0, 0};
+    const double binFrames = double(level.framesPerBin);
+    const uint64_t last = level.binCount - 1;
+    const uint64_t first = std::min(uint64_t(std::max(fromFrame, 0.0) / binFrames), last);
+    // Always at least one bin, so zoomed-in views repeat the bin under the
+    // pixel rather than leaving gaps.
+    const uint64_t end = std::clamp(uint64_t(std::ceil(std::max(toFrame, 0.0) / binFrames)), first + 1, last + 1);
+
+    int16_t lo = std::numeric_limits<int16_t>::max();
+    int16_t hi = std::numeric_limits<int16_t>::min();
+    double squares = 0.0;
+    for (uint64_t bin = first; bin < end; ++bin) {
+        const PeakBin &p = level.at(bin, channel, m_channels);
+        lo = std::min(lo, p.min);
+        hi = std::max(hi, p.max);
+        squares += double(p.rms) * double(p.rms);
+    }
+    return PeakBin{lo, hi, int16_t(std::lround(std::sqrt(squares / double(end - first))))};
+}
+
+} // namespace vep
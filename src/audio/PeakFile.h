@@ -0,0 +1,97 @@
+#pragma once
+
+#include "core/MappedFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// One waveform column: extremes and RMS of a run of samples, full scale
+// mapped to +-32767.
+struct PeakBin
+{
+    int16_t min;
+    int16_t max;
+    int16_t rms;
+};
+
+// Streams audio into a peak pyramid: level 0 summarises every kBaseFrames
+// frames and each further level merges kLevelFactor bins of the level
+// below, until a level fits in a handful of bins. Memory and output are
+// about 1/30 of the audio as 16-bit PCM.
+class PeakBuilder
+{
+public:
+    static constexpr int kBaseFrames = 128;
+    static constexpr int kLevelFactor = 4;
+
+    PeakBuilder(int sampleRate, int channels);
+
+    void process(const float *interleaved, int frames);
+    // Serialised peak file (see PeakFile for the layout).
+    std::vector<uint8_t> finish();
+
+private:
+    void flushBin();
+
+    int m_sampleRate;
+    int m_channels;
+    uint64_t m_frames = 0;
+    int m_fill = 0;
+    std::vector<float> m_min;
+    std::vector<float> m_max;
+    std::vector<double> m_sumSquares;
+    std::vector<PeakBin> m_base;
+};
+
+// Read-only view of a peak file, memory-mapped so drawing an hour-long clip
+// touches only the pages of the level and range on screen.
+//
+// Layout (host byte order): "VEPPEAK1", u32 sampleRate, u32 channels,
+// u64 frames, u32 levelCount, u32 reserved, then per level u64 framesPerBin,
+// u64 binCount, u64 byteOffset; bins are stored channel-interleaved.
+class PeakFile
+{
+public:
+    static constexpr const char *kCacheKind = "peaks";
+
+    struct Level
+    {
+        uint64_t framesPerBin;
+        uint64_t binCount;
+        const PeakBin *bins;
+
+        const PeakBin &at(uint64_t bin, int channel, int channels) const
+        {
+            return bins[bin * uint64_t(channels) + uint64_t(channel)];
+        }
+    };
+
+    // Throws std::runtime_error if the file is missing or malformed.
+    explicit PeakFile(const std::string &path);
+
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+    uint64_t frames() const { return m_frames; }
+    int levelCount() const { return int(m_levels.size()); }
+    const Level &level(int index) const { return m_levels[size_t(index)]; }
+
+    // The coarsest level that still has at least one bin per pixel.
+    int levelFor(double framesPerPixel) const;
+
+    // Combined peak of [fromFrame, toFrame) on one channel, read from the
+    // given level.
+    PeakBin summarize(int level, int channel, double fromFrame, double toFrame) const;
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+    int m_sampleRate = 0;
+    int m_channels = 0;
+    uint64_t m_frames = 0;
+    std::vector<Level> m_levels;
+};
+
+} // namespace vep
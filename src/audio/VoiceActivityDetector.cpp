@@ -0,0 +1,132 @@
+#include "audio/VoiceActivityDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+namespace {
+
+// The floor follows quieter frames at once and louder ones at ~0.7 dB/s
+// (a tenth of that while speech is detected), so it settles on the room
+// tone between phrases and not on the voice, but still recovers if the
+// background gets louder for good.
+constexpr double kFloorRiseDbPerFrame = 0.02;
+constexpr double kFloorRiseDuringSpeech = 0.1;
+// Long regions are cut at the quietest frame within this much of the limit.
+constexpr double kCutSearchSeconds = 5.0;
+
+double toDb(double meanSquare)
+{
+    return 10.0 * std::log10(meanSquare + 1e-12);
+}
+
+} // namespace
+
+VoiceActivityDetector::VoiceActivityDetector(int sampleRate, VadSettings settings)
+    : m_sampleRate(sampleRate)
+    , m_settings(settings)
+    , m_frameSize(std::max(1, sampleRate * 30 / 1000))
+{
+    m_highPass.c = BiquadCoefficients::design(FilterShape::HighPass, sampleRate, 300.0, 0.0, 0.707);
+    m_lowPass.c = BiquadCoefficients::design(FilterShape::LowPass, sampleRate, 3400.0, 0.0, 0.707);
+}
+
+std::vector<SpeechRegion> VoiceActivityDetector::process(const float *samples, int count)
+{
+    std::vector<SpeechRegion> out;
+    for (int i = 0; i < count; ++i) {
+        const float x = samples[i];
+        const float band = m_lowPass.process(m_highPass.process(x));
+        m_energy += double(x) * double(x);
+        m_bandEnergy += double(band) * double(band);
+        ++m_position;
+        if (++m_fill == m_frameSize)
+            analyseFrame(out);
+    }
+    return out;
+}
+
+void VoiceActivityDetector::analyseFrame(std::vector<SpeechRegion> &out)
+{
+    const double energyDb = toDb(m_energy / m_frameSize);
+    const double bandRatio = m_energy > 0.0 ? m_bandEnergy / m_energy : 0.0;
+    m_energy = 0.0;
+    m_bandEnergy = 0.0;
+    m_fill = 0;
+
+    if (!m_floorInitialised) {
+        m_noiseFloorDb = energyDb;
+        m_floorInitialised = true;
+    }
+    const bool speech = energyDb > m_noiseFloorDb + m_settings.thresholdDb
+                        && energyDb > m_settings.absoluteFloorDb
+                        && bandRatio >= m_settings.minVoiceBandRatio;
+    if (energyDb < m_noiseFloorDb)
+        m_noiseFloorDb = energyDb;
+    else
+        m_noiseFloorDb += kFloorRiseDbPerFrame * (speech ? kFloorRiseDuringSpeech : 1.0);
+    const int64_t frameEnd = m_position;
+    const int64_t frameStart = frameEnd - m_frameSize;
+    const double framesPerSecond = double(m_sampleRate) / m_frameSize;
+    const int minSpeechFrames = std::max(1, int(std::lround(m_settings.minSpeechSeconds * framesPerSecond)));
+    const int hangoverFrames = std::max(1, int(std::lround(m_settings.hangoverSeconds * framesPerSecond)));
+
+    if (m_inRegion)
+        m_regionEnergy.push_back(float(energyDb));
+
+    if (speech) {
+        m_silenceRun = 0;
+        ++m_speechRun;
+        m_lastSpeechEnd = frameEnd;
+        if (!m_inRegion && m_speechRun >= minSpeechFrames) {
+            m_inRegion = true;
+            m_regionStart = frameStart - int64_t(m_speechRun - 1) * m_frameSize;
+            m_regionEnergy.assign(size_t(m_speechRun), float(energyDb));
+        }
+    } else {
+        m_speechRun = 0;
+        if (m_inRegion && ++m_silenceRun >= hangoverFrames) {
+            closeRegion(m_lastSpeechEnd, true, out);
+            return;
+        }
+    }
+
+    const int64_t maxRegion = int64_t(m_settings.maxRegionSeconds * m_sampleRate);
+    if (m_inRegion && frameEnd - m_regionStart >= maxRegion) {
+        // Cut at the quietest frame of the last few seconds and carry on
+        // with a new region from there.
+        const size_t search = std::min(m_regionEnergy.size(), size_t(kCutSearchSeconds * framesPerSecond));
+        const auto begin = m_regionEnergy.end() - ptrdiff_t(search);
+        const auto quietest = std::min_element(begin, m_regionEnergy.end());
+        const int64_t cut = m_regionStart + int64_t(quietest - m_regionEnergy.begin() + 1) * m_frameSize;
+        std::vector<float> rest(quietest + 1, m_regionEnergy.end());
+        closeRegion(cut, false, out);
+        m_inRegion = true;
+        m_regionStart = cut;
+        m_regionEnergy = std::move(rest);
+    }
+}
+
+void VoiceActivityDetector::closeRegion(int64_t end, bool padEnd, std::vector<SpeechRegion> &out)
+{
+    const int64_t padding = int64_t(m_settings.paddingSeconds * m_sampleRate);
+    // Padding never reaches into the previous region.
+    const SpeechRegion region{std::max(m_regionStart - padding, m_lastRegionEnd),
+                              padEnd ? std::min(m_position, end + padding) : end, !padEnd};
+    m_lastRegionEnd = region.end;
+    out.push_back(region);
+    m_inRegion = false;
+    m_silenceRun = 0;
+    m_regionEnergy.clear();
+}
+
+std::vector<SpeechRegion> VoiceActivityDetector::finish()
+{
+    std::vector<SpeechRegion> out;
+    if (m_inRegion)
+        closeRegion(m_position, true, out);
+    return out;
+}
+
+} // namespace vep
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "audio/Biquad.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+
+// Half-open sample range [start, end) of detected speech.
+struct SpeechRegion
+{
+    int64_t start;
+    int64_t end;
+    // Cut mid-speech at the length limit; the next region starts at `end`.
+    bool continues = false;
+};
+
+struct VadSettings
+{
+    double thresholdDb = 10.0;     // above the noise floor
+    double absoluteFloorDb = -50.0;
+    double minVoiceBandRatio = 0.45;
+    double minSpeechSeconds = 0.09;
+    double hangoverSeconds = 0.5;
+    double paddingSeconds = 0.2;
+    double maxRegionSeconds = 28.0;
+};
+
+// Streaming speech/non-speech segmentation of mono audio, cheap enough to
+// run ahead of Whisper so that silence and most music beds never reach the
+// model. Each 30 ms frame is classed as speech when its energy stands
+// clear of an adaptive noise floor and most of that energy falls in the
+// voice band (300-3400 Hz); short blips are ignored and regions end after a
+// hangover, then get padded so word onsets and tails are not clipped.
+//
+// Regions longer than maxRegionSeconds are cut at the quietest frame near
+// the limit, so each fits one Whisper window.
+class VoiceActivityDetector
+{
+public:
+    explicit VoiceActivityDetector(int sampleRate, VadSettings settings = VadSettings());
+
+    // Feeds the next samples; returns regions that are now complete. A
+    // region's padded start may reach up to paddingSeconds back, so callers
+    // should keep that much audio before the open region.
+    std::vector<SpeechRegion> process(const float *samples, int count);
+    // Closes any open region at end of stream.
+    std::vector<SpeechRegion> finish();
+
+    int64_t samplesSeen() const { return m_position; }
+
+private:
+    void analyseFrame(std::vector<SpeechRegion> &out);
+    void closeRegion(int64_t end, bool padEnd, std::vector<SpeechRegion> &out);
+
+    struct Filter
+    {
+        BiquadCoefficients c;
+        float z1 = 0.0f;
+        float z2 = 0.0f;
+
+        float process(float x)
+        {
+            const float y = c.b0 * x + z1;
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            return y;
+        }
+    };
+
+    int m_sampleRate;
+    VadSettings m_settings;
+    int m_frameSize;
+    Filter m_highPass;
+    Filter m_lowPass;
+
+    int64_t m_position = 0;
+    int m_fill = 0;
+    double m_energy = 0.0;
+    double m_bandEnergy = 0.0;
+    double m_noiseFloorDb = 0.0;
+    bool m_floorInitialised = false;
+
+    int m_speechRun = 0;
+    int m_silenceRun = 0;
+    bool m_inRegion = false;
+    int64_t m_regionStart = 0;
+    int64_t m_lastSpeechEnd = 0;
+    int64_t m_lastRegionEnd = 0;
+    // Per-frame energy of the open region, used to pick a cut point.
+    std::vector<float> m_regionEnergy;
+};
+
+} // namespace vep
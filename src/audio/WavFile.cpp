@@ -0,0 +1,142 @@
+#include "audio/WavFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xfffe;
+
+struct Layout
+{
+    AudioFileInfo info;
+    uint16_t format = 0;
+    uint16_t bitsPerSample = 0;
+    std::streamoff dataOffset = 0;
+    uint32_t dataSize = 0;
+};
+
+uint16_t le16(const unsigned char *p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+uint32_t le32(const unsigned char *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+Layout parse(std::ifstream &in, const std::string &path)
+{
+    unsigned char header[12];
+    if (!in.read(reinterpret_cast<char *>(header), 12) || std::memcmp(header, "RIFF", 4)
+        || std::memcmp(header + 8, "WAVE", 4))
+        throw std::runtime_error("not a WAVE file: " + path);
+
+    Layout layout;
+    bool haveFormat = false;
+    unsigned char chunk[8];
+    while (in.read(reinterpret_cast<char *>(chunk), 8)) {
+        const uint32_t size = le32(chunk + 4);
+        const std::streamoff body = in.tellg();
+        if (!std::memcmp(chunk, "fmt ", 4)) {
+            unsigned char fmt[40] = {};
+            in.read(reinterpret_cast<char *>(fmt), std::min<uint32_t>(size, sizeof(fmt)));
+            layout.format = le16(fmt);
+            layout.info.channels = le16(fmt + 2);
+            layout.info.sampleRate = int(le32(fmt + 4));
+            layout.bitsPerSample = le16(fmt + 14);
+            if (layout.format == kFormatExtensible && size >= 26)
+                layout.format = le16(fmt + 24); // first two bytes of the subformat GUID
+            haveFormat = true;
+        } else if (!std::memcmp(chunk, "data", 4)) {
+            layout.dataOffset = body;
+            layout.dataSize = size;
+            break;
+        }
+        in.seekg(body + std::streamoff(size + (size & 1)));
+    }
+
+    if (!haveFormat || !layout.dataOffset || layout.info.channels <= 0 || layout.info.sampleRate <= 0)
+        throw std::runtime_error("malformed WAVE file: " + path);
+    const bool pcm = layout.format == kFormatPcm
+                     && (layout.bitsPerSample == 8 || layout.bitsPerSample == 16
+                         || layout.bitsPerSample == 24 || layout.bitsPerSample == 32);
+    const bool ieee = layout.format == kFormatFloat
+                      && (layout.bitsPerSample == 32 || layout.bitsPerSample == 64);
+    if (!pcm && !ieee)
+        throw std::runtime_error("unsupported WAVE sample format: " + path);
+
+    const uint32_t frameBytes = uint32_t(layout.info.channels) * layout.bitsPerSample / 8;
+    layout.info.frames = layout.dataSize / frameBytes;
+    return layout;
+}
+
+float decodeSample(const unsigned char *p, uint16_t format, uint16_t bits)
+{
+    if (format == kFormatFloat) {
+        if (bits == 32) {
+            float f;
+            std::memcpy(&f, p, 4);
+            return f;
+        }
+        double d;
+        std::memcpy(&d, p, 8);
+        return float(d);
+    }
+    switch (bits) {
+    case 8:
+        return (float(p[0]) - 128.0f) / 128.0f;
+    case 16:
+        return float(int16_t(le16(p))) / 32768.0f;
+    case 24: {
+        const int32_t v = int32_t((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24));
+        return float(v >> 8) / 8388608.0f;
+    }
+    default:
+        return float(double(int32_t(le32(p))) / 2147483648.0);
+    }
+}
+
+} // namespace
+
+AudioFileInfo WavFile::readInfo(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("cannot open " + path);
+    return parse(in, path).info;
+}
+
+std::vector<std::vector<float>> WavFile::read(const std::string &path, AudioFileInfo *info)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("cannot open " + path);
+    const Layout layout = parse(in, path);
+    if (info)
+        *info = layout.info;
+
+    const int channels = layout.info.channels;
+    const size_t sampleBytes = layout.bitsPerSample / 8;
+    std::vector<unsigned char> raw(size_t(layout.info.frames) * size_t(channels) * sampleBytes);
+    in.seekg(layout.dataOffset);
+    in.read(reinterpret_cast<char *>(raw.data()), std::streamsize(raw.size()));
+    const size_t frames = size_t(in.gcount()) / (size_t(channels) * sampleBytes);
+
+    std::vector<std::vector<float>> samples(static_cast<size_t>(channels), std::vector<float>(frames));
+    const unsigned char *p = raw.data();
+    for (size_t f = 0; f < frames; ++f)
+        for (int c = 0; c < channels; ++c, p += sampleBytes)
+            samples[size_t(c)][f] = decodeSample(p, layout.format, layout.bitsPerSample);
+    return samples;
+}
+
+} // namespace vep
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace vep {
+
+struct AudioFileInfo
+{
+    int sampleRate = 0;
+    int channels = 0;
+    long long frames = 0;
+};
+
+// Minimal RIFF/WAVE reader for assets shipped with the app (impulse
+// responses, presets). Handles 8/16/24/32-bit PCM and 32/64-bit float,
+// including WAVE_FORMAT_EXTENSIBLE. Media on the timeline goes through
+// FFmpeg instead. Throws std::runtime_error on unreadable files.
+class WavFile
+{
+public:
+    static AudioFileInfo readInfo(const std::string &path);
+    // Planar samples, one vector per channel.
+    static std::vector<std::vector<float>> read(const std::string &path, AudioFileInfo *info = nullptr);
+};
+
+} // namespace vep
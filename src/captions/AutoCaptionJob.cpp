@@ -0,0 +1,366 @@
+#include "captions/AutoCaptionJob.h"
+
+#include "captions/CaptionCache.h"
+#include "captions/ParallelCaptioner.h"
+#include "captions/StreamingCaptioner.h"
+#include "captions/TimelineCaptioner.h"
+#include "captions/WhisperModel.h"
+#include "captions/WhisperModelManager.h"
+#include "core/MediaCache.h"
+#include "media/AudioDecoder.h"
+
+#include <QMetaObject>
+#include <QVariantMap>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+// Extra audio transcribed on each side of a missing range so words cut by
+// its edges can be matched with the cached transcript.
+constexpr double kSpliceMargin = 2.0;
+
+} // namespace
+
+AutoCaptionJob::AutoCaptionJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+AutoCaptionJob::~AutoCaptionJob()
+{
+    cancel();
+    m_future.waitForFinished();
+    m_preload.waitForFinished();
+}
+
+QVariantList AutoCaptionJob::toVariant(const std::vector<CaptionSegment> &segments)
+{
+    QVariantList list;
+    for (const CaptionSegment &segment : segments) {
+        QVariantList words;
+        for (const CaptionWord &word : segment.words) {
+            words.append(QVariantMap{{"start", word.start},
+                                     {"end", word.end},
+                                     {"text", QString::fromStdString(word.text)},
+                                     {"probability", word.probability}});
+        }
+        list.append(QVariantMap{{"start", segment.start},
+                                {"end", segment.end},
+                                {"text", QString::fromStdString(segment.text).trimmed()},
+                                {"words", words}});
+    }
+    return list;
+}
+
+void AutoCaptionJob::start(const QString &mediaPath, const QString &modelPath, const QString &language,
+                           double from, double to)
+{
+    if (m_running)
+        return;
+    setRunning(true);
+    setProgress(0.0);
+
+    const std::string media = mediaPath.toStdString();
+    const std::string model = modelPath.toStdString();
+    WhisperOptions options;
+    options.language = language.isEmpty() ? "auto" : language.toStdString();
+
+    ParallelCaptionSettings parallel;
+    parallel.contexts = m_contexts;
+    parallel.threadsPerContext = m_threadsPerContext;
+    options.threads = m_threadsPerContext;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelRequested = false;
+    }
+    m_future = QtConcurrent::run([this, media, model, options, parallel, from, to] {
+        bool completed = false;
+        QString error;
+        double speech = 0.0;
+        auto emitSegments = [this](const std::vector<CaptionSegment> &segments) {
+            if (!segments.empty())
+                emit segmentsReady(toVariant(segments));
+        };
+        auto reportProgress = [this](double fraction) {
+            QMetaObject::invokeMethod(this, [this, fraction] { setProgress(fraction); });
+        };
+        try {
+            // The same cache TimelineCaptioner fills, so a file captioned
+            // either way is not transcribed again.
+            CaptionCache cache(MediaCache::instance());
+            const CaptionCacheKey key = cache.keyFor(media, model, options.language, options.translate);
+            CachedTranscript transcript = cache.load(key);
+            // 0 when the container does not say; such a range cannot be
+            // marked covered, so it is transcribed whole and not cached.
+            const double end = to > 0.0 ? to : AudioDecoder(media).duration();
+            const std::vector<std::pair<double, double>> missing =
+                end > from ? transcript.missing(from, end) : std::vector<std::pair<double, double>>{};
+            double toTranscribe = 0.0;
+            for (const auto &[gapFrom, gapTo] : missing)
+                toTranscribe += gapTo - gapFrom;
+
+            // Cached captions up to each missing range, then the range as it
+            // is transcribed, in media order.
+            auto caption = [&](auto &captioner) {
+                if (end <= from) {
+                    captioner.setSegmentsCallback(emitSegments);
+                    captioner.setProgressCallback(reportProgress);
+                    const bool done = runCaptioner(captioner, media, from, to);
+                    speech += captioner.speechSeconds();
+                    return done;
+                }
+                double cursor = from;
+                double transcribed = 0.0;
+                for (const auto &[gapFrom, gapTo] : missing) {
+                    emitSegments(transcript.range(cursor, gapFrom));
+                    cursor = gapTo;
+
+                    // Shown as it arrives, cut to the range at word centres;
+                    // the cache gets it joined to its neighbours.
+                    std::vector<CaptionSegment> fresh;
+                    captioner.setSegmentsCallback([&, gapFrom = gapFrom, gapTo = gapTo](
+                                                      const std::vector<CaptionSegment> &segments) {
+                        fresh.insert(fresh.end(), segments.begin(), segments.end());
+                        std::vector<CaptionSegment> shown = segments;
+                        retainWords(shown, [&](double start, double wordEnd) {
+                            const double centre = (start + wordEnd) * 0.5;
+                            return centre >= gapFrom && centre < gapTo;
+                        });
+                        emitSegments(shown);
+                    });
+                    const double length = gapTo - gapFrom;
+                    captioner.setProgressCallback([&, length](double fraction) {
+                        reportProgress(std::min(1.0, (transcribed + fraction * length) / toTranscribe));
+                    });
+                    const bool done = runCaptioner(captioner, media, std::max(0.0, gapFrom - kSpliceMargin),
+                                                   gapTo + kSpliceMargin);
+                    speech += captioner.speechSeconds();
+                    if (!done)
+                        return false;
+                    // Stored range by range, so a cancelled job keeps what it did.
+                    transcript.splice(gapFrom, gapTo, std::move(fresh), kSpliceMargin);
+                    cache.store(key, transcript);
+                    transcribed += length;
+                }
+                emitSegments(transcript.range(cursor, end));
+                return true;
+            };
+
+            if (end > from && missing.empty()) {
+                // All cached: no model needed.
+                emitSegments(transcript.range(from, end));
+                completed = true;
+            } else {
+                auto weights = WhisperModelManager::instance().acquire(model);
+                if (parallel.contexts == 1) {
+                    StreamingCaptioner captioner(weights, options);
+                    completed = caption(captioner);
+                } else {
+                    ParallelCaptioner captioner(weights, options, parallel);
+                    completed = caption(captioner);
+                }
+            }
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        WhisperModelManager::instance().trim();
+        QMetaObject::invokeMethod(this, [this, completed, error, speech] {
+            if (completed)
+                setProgress(1.0);
+            setRunning(false);
+            emit finished(completed, error, speech);
+        });
+    });
+}
+
+void AutoCaptionJob::updateTimeline(const QVariantList &clips, const QString &modelPath, const QString &language)
+{
+    if (m_running)
+        return;
+    setRunning(true);
+    setProgress(0.0);
+
+    std::vector<CaptionClip> timeline;
+    for (const QVariant &value : clips) {
+        const QVariantMap map = value.toMap();
+        CaptionClip clip;
+        clip.id = map.value("id").toInt();
+        clip.mediaPath = map.value("mediaPath").toString().toStdString();
+        clip.sourceIn = map.value("sourceIn").toDouble();
+        clip.sourceOut = map.value("sourceOut").toDouble();
+        clip.timelineStart = map.value("timelineStart").toDouble();
+        timeline.push_back(std::move(clip));
+    }
+    const std::string model = modelPath.toStdString();
+    WhisperOptions options;
+    options.language = language.isEmpty() ? "auto" : language.toStdString();
+    options.threads = m_threadsPerContext;
+    ParallelCaptionSettings parallel;
+    parallel.contexts = m_contexts;
+    parallel.threadsPerContext = m_threadsPerContext;
+    const std::string config = model + '\n' + options.language + '\n' + std::to_string(m_contexts) + '\n'
+                               + std::to_string(m_threadsPerContext);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelRequested = false;
+    }
+    m_future = QtConcurrent::run([this, timeline, model, options, parallel, config] {
+        bool completed = false;
+        QString error;
+        double transcribed = 0.0;
+        try {
+            if (!m_timeline || m_timelineConfig != config) {
+                // A different model or language invalidates what the
+                // track shows, so every clip is emitted again.
+                m_timeline = std::make_unique<TimelineCaptioner>(MediaCache::instance(), model, options, parallel);
+                m_timelineConfig = config;
+            }
+            TimelineCaptioner &captioner = *m_timeline;
+            captioner.setClipCaptionsCallback([this](int clipId, const std::vector<CaptionSegment> &segments) {
+                emit clipCaptionsReady(clipId, toVariant(segments));
+            });
+            captioner.setClipRemovedCallback([this](int clipId) { emit clipCaptionsRemoved(clipId); });
+            captioner.setProgressCallback([this](double fraction) {
+                QMetaObject::invokeMethod(this, [this, fraction] { setProgress(fraction); });
+            });
+            {
+                // The captioner is kept between jobs, so this job starts by
+                // clearing the last one's cancel, then honours its own.
+                std::lock_guard<std::mutex> lock(m_mutex);
+                captioner.resetCancel();
+                if (m_cancelRequested)
+                    captioner.cancel();
+                m_cancelCaptioner = [&captioner] { captioner.cancel(); };
+            }
+            try {
+                completed = captioner.update(timeline);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_cancelCaptioner = nullptr;
+                throw;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_cancelCaptioner = nullptr;
+            }
+            transcribed = captioner.transcribedSeconds();
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        WhisperModelManager::instance().trim();
+        QMetaObject::invokeMethod(this, [this, completed, error, transcribed] {
+            if (completed)
+                setProgress(1.0);
+            setRunning(false);
+            emit finished(completed, error, transcribed);
+        });
+    });
+}
+
+template <typename Captioner>
+bool AutoCaptionJob::runCaptioner(Captioner &captioner, const std::string &media, double from, double to)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_cancelRequested)
+            captioner.cancel();
+        m_cancelCaptioner = [&captioner] { captioner.cancel(); };
+    }
+    // The captioner lives on the worker's stack; cancel() must not reach it
+    // once run() has returned or thrown.
+    auto forget = [this] {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelCaptioner = nullptr;
+    };
+    bool completed = false;
+    try {
+        completed = captioner.run(media, from, to);
+    } catch (...) {
+        forget();
+        throw;
+    }
+    forget();
+    return completed;
+}
+
+void AutoCaptionJob::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cancelRequested = true;
+    if (m_cancelCaptioner)
+        m_cancelCaptioner();
+}
+
+void AutoCaptionJob::preloadModel(const QString &modelPath)
+{
+    if (m_preload.isRunning())
+        return;
+    m_preload = QtConcurrent::run([this, modelPath] {
+        QString error;
+        try {
+            WhisperModelManager::instance().preload(modelPath.toStdString());
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        QMetaObject::invokeMethod(this, [this, modelPath, error] { emit modelLoaded(modelPath, error); });
+    });
+}
+
+QVariantList AutoCaptionJob::loadedModels() const
+{
+    QVariantList list;
+    for (const WhisperModelInfo &info : WhisperModelManager::instance().loaded()) {
+        list.append(QVariantMap{{"path", QString::fromStdString(info.path)},
+                                {"quantization", QString::fromStdString(info.quantization)},
+                                {"fileBytes", qint64(info.fileBytes)},
+                                {"residentBytes", qint64(info.residentBytes)},
+                                {"loadSeconds", info.loadSeconds},
+                                {"users", qint64(info.users)}});
+    }
+    return list;
+}
+
+void AutoCaptionJob::setContexts(int contexts)
+{
+    contexts = std::max(0, contexts);
+    if (m_contexts == contexts)
+        return;
+    m_contexts = contexts;
+    emit contextsChanged();
+}
+
+void AutoCaptionJob::setThreadsPerContext(int threads)
+{
+    threads = std::max(1, threads);
+    if (m_threadsPerContext == threads)
+        return;
+    m_threadsPerContext = threads;
+    emit threadsPerContextChanged();
+}
+
+void AutoCaptionJob::setProgress(double progress)
+{
+    if (m_progress == progress)
+        return;
+    m_progress = progress;
+    emit progressChanged();
+}
+
+void AutoCaptionJob::setRunning(bool running)
+{
+    if (m_running == running)
+        return;
+    m_running = running;
+    emit runningChanged();
+}
+
+} // namespace vep
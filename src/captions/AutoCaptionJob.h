@@ -0,0 +1,107 @@
+#pragma once
+
+#include "captions/Caption.h"
+
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class TimelineCaptioner;
+
+// Runs auto captions off the UI thread and forwards each batch of captions
+// to QML as it is recognised. With one context this is a StreamingCaptioner;
+// with more, a ParallelCaptioner splitting the speech across contexts of
+// threadsPerContext threads each (contexts 0 sizes it to the machine).
+// Segments are maps with start, end, text and words (each with start, end,
+// text, probability), in media time. start() reuses the file's transcript in
+// CaptionCache and only sends the audio not transcribed before to Whisper.
+//
+// updateTimeline() captions a whole timeline instead, through a
+// TimelineCaptioner that is kept between calls: after an edit only the
+// clips that changed are re-emitted, and only audio never transcribed
+// before is sent to Whisper.
+//
+// Models come from WhisperModelManager, so jobs share one loaded copy and
+// a model used recently (or preloaded) is still warm for the next job.
+class AutoCaptionJob : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(int contexts READ contexts WRITE setContexts NOTIFY contextsChanged)
+    Q_PROPERTY(int threadsPerContext READ threadsPerContext WRITE setThreadsPerContext NOTIFY threadsPerContextChanged)
+
+public:
+    explicit AutoCaptionJob(QObject *parent = nullptr);
+    ~AutoCaptionJob() override;
+
+    bool isRunning() const { return m_running; }
+    double progress() const { return m_progress; }
+    int contexts() const { return m_contexts; }
+    void setContexts(int contexts);
+    int threadsPerContext() const { return m_threadsPerContext; }
+    void setThreadsPerContext(int threads);
+
+    static QVariantList toVariant(const std::vector<CaptionSegment> &segments);
+
+    // Maps with path, quantization, fileBytes, residentBytes, loadSeconds
+    // and users, one per model currently loaded.
+    Q_INVOKABLE QVariantList loadedModels() const;
+
+public slots:
+    // to <= 0 captions to the end of the file.
+    void start(const QString &mediaPath, const QString &modelPath, const QString &language,
+               double from = 0.0, double to = 0.0);
+    // clips: maps with id, mediaPath, sourceIn, sourceOut and timelineStart.
+    void updateTimeline(const QVariantList &clips, const QString &modelPath, const QString &language);
+    void cancel();
+    // Loads the model in the background so the first start() need not wait.
+    void preloadModel(const QString &modelPath);
+
+signals:
+    void segmentsReady(const QVariantList &segments);
+    // From updateTimeline(): a clip's captions in timeline time, replacing
+    // any it had before.
+    void clipCaptionsReady(int clipId, const QVariantList &segments);
+    void clipCaptionsRemoved(int clipId);
+    void runningChanged();
+    void progressChanged();
+    void contextsChanged();
+    void threadsPerContextChanged();
+    // A model finished loading (or failed to: error is set).
+    void modelLoaded(const QString &modelPath, const QString &error);
+    // speechSeconds: how much audio the voice detector passed to Whisper
+    // (for updateTimeline(), how much source audio was not cached).
+    void finished(bool completed, const QString &error, double speechSeconds);
+
+private:
+    void setProgress(double progress);
+    void setRunning(bool running);
+    template <typename Captioner>
+    bool runCaptioner(Captioner &captioner, const std::string &media, double from, double to);
+
+    // Guards the captioner handoff between the worker and cancel().
+    std::mutex m_mutex;
+    std::function<void()> m_cancelCaptioner;
+    bool m_cancelRequested = false;
+    // Only touched by the worker; rebuilt when the model or options change.
+    std::unique_ptr<TimelineCaptioner> m_timeline;
+    std::string m_timelineConfig;
+    QFuture<void> m_future;
+    QFuture<void> m_preload;
+    bool m_running = false;
+    double m_progress = 0.0;
+    int m_contexts = 0;
+    int m_threadsPerContext = 4;
+};
+
+} // namespace vep
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// Times are seconds in the media file's own timeline. A word's text is
+// what Whisper wrote for it, including the space before it if there was one
+// (there is none within CJK text), so words concatenated as they are give
+// back the segment's text.
+struct CaptionWord
+{
+    double start = 0.0;
+    double end = 0.0;
+    std::string text;
+    float probability = 0.0f;
+};
+
+struct CaptionSegment
+{
+    double start = 0.0;
+    double end = 0.0;
+    std::string text;
+    std::vector<CaptionWord> words;
+};
+
+// Drops the words for which keep(start, end) is false, refitting each
+// segment's text and times to what is left; segments without word timings
+// are judged as a whole.
+template <typename Keep>
+void retainWords(std::vector<CaptionSegment> &segments, Keep keep)
+{
+    std::vector<CaptionSegment> kept;
+    for (CaptionSegment &segment : segments) {
+        if (segment.words.empty()) {
+            if (keep(segment.start, segment.end))
+                kept.push_back(std::move(segment));
+            continue;
+        }
+        const size_t before = segment.words.size();
+        segment.words.erase(std::remove_if(segment.words.begin(), segment.words.end(),
+                                           [&](const CaptionWord &w) { return !keep(w.start, w.end); }),
+                            segment.words.end());
+        if (segment.words.empty())
+            continue;
+        if (segment.words.size() != before) {
+            segment.text.clear();
+            for (const CaptionWord &word : segment.words)
+                segment.text += word.text;
+            segment.start = segment.words.front().start;
+            segment.end = segment.words.back().end;
+        }
+        kept.push_back(std::move(segment));
+    }
+    segments = std::move(kept);
+}
+
+// Moves every time by `delta` seconds.
+inline void shiftCaptions(std::vector<CaptionSegment> &segments, double delta)
+{
+    for (CaptionSegment &segment : segments) {
+        segment.start += delta;
+        segment.end += delta;
+        for (CaptionWord &word : segment.words) {
+            word.start += delta;
+            word.end += delta;
+        }
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,172 @@
+#include "captions/CaptionCache.h"
+
+#include "captions/ParallelCaptioner.h"
+#include "core/BinaryIO.h"
+#include "core/MediaCache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vep {
+
+ContentHash CaptionCacheKey::combined() const
+{
+    Hasher64 hasher;
+    hasher.update(std::string("captions"));
+    hasher.updateValue(media.value);
+    hasher.updateValue(model.value);
+    hasher.update(language);
+    hasher.updateValue(uint8_t(translate));
+    return ContentHash{hasher.digest()};
+}
+
+std::vector<std::pair<double, double>> CachedTranscript::missing(double from, double to, double minLength) const
+{
+    std::vector<std::pair<double, double>> gaps;
+    double cursor = from;
+    for (const auto &[start, end] : covered) {
+        if (end <= cursor)
+            continue;
+        if (start >= to)
+            break;
+        if (start - cursor >= minLength)
+            gaps.emplace_back(cursor, start);
+        cursor = std::max(cursor, end);
+    }
+    if (to - cursor >= minLength)
+        gaps.emplace_back(cursor, to);
+    return gaps;
+}
+
+void CachedTranscript::splice(double from, double to, std::vector<CaptionSegment> fresh, double margin)
+{
+    std::vector<CaptionSegment> before;
+    std::vector<CaptionSegment> after;
+    for (CaptionSegment &segment : segments) {
+        if (segment.start < from)
+            before.push_back(std::move(segment));
+        else if (segment.start >= to)
+            after.push_back(std::move(segment));
+    }
+
+    // Join on each edge that borders audio transcribed earlier; elsewhere
+    // cut at the edge, so what is kept matches what is marked covered.
+    auto coveredAt = [&](double t) {
+        return std::any_of(covered.begin(), covered.end(),
+                           [&](const auto &range) { return range.first <= t && t <= range.second; });
+    };
+    if (coveredAt(from))
+        ParallelCaptioner::joinAtBoundary(before, fresh, from, margin);
+    else
+        retainWords(fresh, [&](double start, double end) { return (start + end) * 0.5 >= from; });
+    if (coveredAt(to))
+        ParallelCaptioner::joinAtBoundary(fresh, after, to, margin);
+    else
+        retainWords(fresh, [&](double start, double end) { return (start + end) * 0.5 < to; });
+
+    segments = std::move(before);
+    segments.insert(segments.end(), std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+    segments.insert(segments.end(), std::make_move_iterator(after.begin()), std::make_move_iterator(after.end()));
+
+    covered.emplace_back(from, to);
+    std::sort(covered.begin(), covered.end());
+    std::vector<std::pair<double, double>> merged;
+    for (const auto &range : covered) {
+        if (!merged.empty() && range.first <= merged.back().second)
+            merged.back().second = std::max(merged.back().second, range.second);
+        else
+            merged.push_back(range);
+    }
+    covered = std::move(merged);
+}
+
+std::vector<CaptionSegment> CachedTranscript::range(double from, double to) const
+{
+    std::vector<CaptionSegment> result;
+    for (const CaptionSegment &segment : segments) {
+        if (segment.end > from && segment.start < to)
+            result.push_back(segment);
+    }
+    retainWords(result, [&](double start, double end) {
+        const double centre = (start + end) * 0.5;
+        return centre >= from && centre < to;
+    });
+    return result;
+}
+
+std::vector<uint8_t> CachedTranscript::serialize() const
+{
+    ByteWriter out;
+    out.putMagic("VEPCAPT2");
+    out.putArray(covered);
+    out.put(uint64_t(segments.size()));
+    for (const CaptionSegment &segment : segments) {
+        out.put(segment.start);
+        out.put(segment.end);
+        out.putString(segment.text);
+        out.put(uint64_t(segment.words.size()));
+        for (const CaptionWord &word : segment.words) {
+            out.put(word.start);
+            out.put(word.end);
+            out.put(word.probability);
+            out.putString(word.text);
+        }
+    }
+    return out.take();
+}
+
+CachedTranscript CachedTranscript::deserialize(const std::vector<uint8_t> &bytes)
+{
+    ByteReader in(bytes);
+    in.expectMagic("VEPCAPT2");
+    CachedTranscript transcript;
+    transcript.covered = in.getArray<std::pair<double, double>>();
+    const uint64_t segmentCount = in.get<uint64_t>();
+    for (uint64_t s = 0; s < segmentCount; ++s) {
+        CaptionSegment segment;
+        segment.start = in.get<double>();
+        segment.end = in.get<double>();
+        segment.text = in.getString();
+        const uint64_t wordCount = in.get<uint64_t>();
+        for (uint64_t w = 0; w < wordCount; ++w) {
+            CaptionWord word;
+            word.start = in.get<double>();
+            word.end = in.get<double>();
+            word.probability = in.get<float>();
+            word.text = in.getString();
+            segment.words.push_back(std::move(word));
+        }
+        transcript.segments.push_back(std::move(segment));
+    }
+    return transcript;
+}
+
+CaptionCache::CaptionCache(MediaCache &cache)
+    : m_cache(cache)
+{
+}
+
+CaptionCacheKey CaptionCache::keyFor(const std::string &mediaPath, const std::string &modelPath,
+                                     const std::string &language, bool translate)
+{
+    return CaptionCacheKey{m_cache.hashOf(mediaPath), m_cache.hashOf(modelPath), language, translate};
+}
+
+CachedTranscript CaptionCache::load(const CaptionCacheKey &key) const
+{
+    const auto bytes = m_cache.read(key.combined(), CachedTranscript::kCacheKind);
+    if (!bytes)
+        return {};
+    try {
+        return CachedTranscript::deserialize(*bytes);
+    } catch (const std::runtime_error &) {
+        return {};
+    }
+}
+
+void CaptionCache::store(const CaptionCacheKey &key, const CachedTranscript &transcript)
+{
+    m_cache.write(key.combined(), CachedTranscript::kCacheKind, transcript.serialize());
+}
+
+} // namespace vep
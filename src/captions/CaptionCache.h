@@ -0,0 +1,74 @@
+#pragma once
+
+#include "captions/Caption.h"
+#include "core/ContentHash.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vep {
+
+class MediaCache;
+
+// What a transcript depends on: the media's content, the exact model
+// weights and the decoding language/task. Renaming or moving either file
+// keeps the cache; swapping the model or language does not reuse it.
+struct CaptionCacheKey
+{
+    ContentHash media;
+    ContentHash model;
+    std::string language;
+    bool translate = false;
+
+    // The MediaCache key for this combination.
+    ContentHash combined() const;
+};
+
+// A media file's transcript as far as it has been transcribed: the source
+// time ranges already covered and the captions found in them (in media
+// time). Built up piecewise as clips of the file are captioned, so trimming
+// or extending a clip only ever transcribes audio not seen before.
+struct CachedTranscript
+{
+    static constexpr const char *kCacheKind = "captions";
+
+    std::vector<std::pair<double, double>> covered; // sorted, disjoint
+    std::vector<CaptionSegment> segments;           // sorted by start
+
+    // Parts of [from, to) not covered yet, ignoring slivers shorter than
+    // minLength.
+    std::vector<std::pair<double, double>> missing(double from, double to, double minLength = 0.25) const;
+
+    // Splices a fresh transcript of [from, to) in. `fresh` was made from
+    // [from - margin, to + margin) so that words straddling from/to can be
+    // matched against the captions already there and joined cleanly.
+    void splice(double from, double to, std::vector<CaptionSegment> fresh, double margin);
+
+    // Captions overlapping [from, to), words cut to that range.
+    std::vector<CaptionSegment> range(double from, double to) const;
+
+    std::vector<uint8_t> serialize() const;
+    // Throws std::runtime_error on a malformed record.
+    static CachedTranscript deserialize(const std::vector<uint8_t> &bytes);
+};
+
+class CaptionCache
+{
+public:
+    explicit CaptionCache(MediaCache &cache);
+
+    // Throws std::runtime_error if either file cannot be hashed.
+    CaptionCacheKey keyFor(const std::string &mediaPath, const std::string &modelPath,
+                           const std::string &language, bool translate);
+
+    // Empty transcript if nothing is cached (or the entry is damaged).
+    CachedTranscript load(const CaptionCacheKey &key) const;
+    void store(const CaptionCacheKey &key, const CachedTranscript &transcript);
+
+private:
+    MediaCache &m_cache;
+};
+
+} // namespace vep
@@ -0,0 +1,290 @@
+#include "captions/ParallelCaptioner.h"
+
+#include "captions/SpeechSource.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <thread>
+
+namespace vep {
+
+namespace {
+
+// The same word heard by both chunks starts within this much in each.
+constexpr double kAnchorTolerance = 0.3;
+
+// Lower-cased ASCII with punctuation removed; other bytes (Arabic and other
+// scripts) are compared as they are.
+std::string matchKey(const std::string &text)
+{
+    std::string key;
+    key.reserve(text.size());
+    for (unsigned char c : text) {
+        if (c < 0x80 && (std::ispunct(c) || std::isspace(c)))
+            continue;
+        key.push_back(c < 0x80 ? char(std::tolower(c)) : char(c));
+    }
+    return key;
+}
+
+} // namespace
+
+struct ParallelCaptioner::Run
+{
+    struct Result
+    {
+        std::vector<CaptionSegment> segments;
+        double boundary;
+        bool continues;
+    };
+
+    // Guarded by ParallelCaptioner::m_mutex, changes signalled on m_changed.
+    std::vector<std::unique_ptr<WhisperTranscriber>> idle;
+    std::map<int, Result> done;
+    int inFlight = 0;
+    int completed = 0;
+    std::exception_ptr error;
+};
+
+ParallelCaptioner::ParallelCaptioner(std::shared_ptr<const WhisperModel> model, WhisperOptions options,
+                                     ParallelCaptionSettings settings, VadSettings vad)
+    : m_model(std::move(model))
+    , m_options(std::move(options))
+    , m_settings(settings)
+    , m_vad(vad)
+{
+    m_settings.threadsPerContext = std::max(1, m_settings.threadsPerContext);
+    const int cores = std::max(1, int(std::thread::hardware_concurrency()));
+    m_contexts = m_settings.contexts > 0 ? m_settings.contexts : std::max(1, cores / m_settings.threadsPerContext);
+    m_options.threads = m_settings.threadsPerContext;
+}
+
+ParallelCaptioner::~ParallelCaptioner() = default;
+
+void ParallelCaptioner::cancel()
+{
+    {
+        // Under the lock, so run() cannot check the flag, miss this and
+        // then wait for a chunk that never finishes.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+    }
+    m_changed.notify_all();
+}
+
+void ParallelCaptioner::joinAtBoundary(std::vector<CaptionSegment> &left, std::vector<CaptionSegment> &right,
+                                       double boundary, double overlapSeconds)
+{
+    // Look for a word both transcripts heard at the same moment near the
+    // boundary; left ends just before it and right resumes with it.
+    const CaptionWord *leftAnchor = nullptr;
+    const CaptionWord *rightAnchor = nullptr;
+    double bestDistance = overlapSeconds;
+    for (const CaptionSegment &l : left) {
+        for (const CaptionWord &lw : l.words) {
+            const double distance = std::abs(lw.start - boundary);
+            const std::string key = matchKey(lw.text);
+            if (distance > bestDistance || key.empty())
+                continue;
+            for (const CaptionSegment &r : right) {
+                for (const CaptionWord &rw : r.words) {
+                    if (std::abs(rw.start - lw.start) < kAnchorTolerance && matchKey(rw.text) == key) {
+                        leftAnchor = &lw;
+                        rightAnchor = &rw;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+    }
+
+    if (leftAnchor) {
+        const double leftCut = leftAnchor->start;
+        const double rightCut = rightAnchor->start;
+        retainWords(left, [=](double start, double) { return start < leftCut; });
+        retainWords(right, [=](double start, double) { return start >= rightCut; });
+    } else {
+        // No agreement: split at the boundary by word centre.
+        retainWords(left, [=](double start, double end) { return (start + end) * 0.5 < boundary; });
+        retainWords(right, [=](double start, double end) { return (start + end) * 0.5 >= boundary; });
+    }
+}
+
+bool ParallelCaptioner::run(const std::string &mediaPath, double from, double to)
+{
+    constexpr int rate = WhisperTranscriber::kSampleRate;
+    m_speechSeconds = 0.0;
+
+    SpeechSource source(mediaPath, from, to, m_vad, 2.0 * m_settings.overlapSeconds);
+
+    Run state;
+    for (int i = int(m_transcribers.size()); i < m_contexts; ++i)
+        m_transcribers.push_back(std::make_unique<WhisperTranscriber>(m_model, m_options));
+    state.idle = std::move(m_transcribers);
+    m_transcribers.clear();
+    // Returns the transcribers for the next run once the pool below has
+    // joined its workers, however run() exits.
+    struct HandBack
+    {
+        std::vector<std::unique_ptr<WhisperTranscriber>> &from;
+        std::vector<std::unique_ptr<WhisperTranscriber>> &to;
+        ~HandBack() { to = std::move(from); }
+    } handBack{state.idle, m_transcribers};
+    // Declared after `state` so its workers are joined before it goes away.
+    ThreadPool pool(m_contexts);
+
+    const int64_t overlap = int64_t(m_settings.overlapSeconds * rate);
+    const int maxInFlight = 2 * m_contexts;
+
+    // Regions waiting for the overlap audio past their end to be decoded.
+    std::deque<SpeechRegion> waiting;
+    bool previousContinues = false;
+    int nextIndex = 0;
+    int nextEmit = 0;
+    double delivered = from;
+
+    // Queues a region as a chunk; false if its audio is not all decoded yet.
+    auto submit = [&](const SpeechRegion &region, bool streamEnded) {
+        const int64_t available = source.heldTo();
+        int64_t first = region.start - (previousContinues ? overlap : 0);
+        int64_t last = region.end + (region.continues ? overlap : 0);
+        if (last > available && !streamEnded)
+            return false;
+        first = std::max(first, source.heldFrom());
+        last = std::min(last, available);
+        previousContinues = region.continues;
+        m_speechSeconds += double(region.end - region.start) / rate;
+
+        const int index = nextIndex++;
+        const double offset = source.seconds(first);
+        const double boundary = source.seconds(region.end);
+        std::vector<float> audio;
+        if (last > first)
+            audio.assign(source.at(first), source.at(last));
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++state.inFlight;
+        }
+        pool.post([this, &state, index, offset, boundary, continues = region.continues,
+                   audio = std::move(audio)] {
+            std::unique_ptr<WhisperTranscriber> transcriber;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                transcriber = std::move(state.idle.back());
+                state.idle.pop_back();
+            }
+            Run::Result result{{}, boundary, continues};
+            try {
+                if (!m_cancelled && !audio.empty()) {
+                    transcriber->resetContext();
+                    result.segments = transcriber->transcribe(audio.data(), int(audio.size()), offset, &m_cancelled);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!state.error)
+                    state.error = std::current_exception();
+                m_cancelled = true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                state.idle.push_back(std::move(transcriber));
+                state.done.emplace(index, std::move(result));
+                --state.inFlight;
+                ++state.completed;
+            }
+            m_changed.notify_all();
+        });
+        return true;
+    };
+
+    // Hands out finished chunks in media order. A chunk cut mid-speech waits
+    // for its successor so the two can be joined first.
+    auto deliver = [&](bool streamEnded) {
+        for (;;) {
+            std::vector<CaptionSegment> segments;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto current = state.done.find(nextEmit);
+                if (current == state.done.end())
+                    break;
+                if (current->second.continues) {
+                    auto next = state.done.find(nextEmit + 1);
+                    if (next != state.done.end()) {
+                        joinAtBoundary(current->second.segments, next->second.segments, current->second.boundary,
+                                       m_settings.overlapSeconds);
+                    } else if (!(streamEnded && waiting.empty() && nextEmit + 1 >= nextIndex)) {
+                        break;
+                    }
+                }
+                segments = std::move(current->second.segments);
+                delivered = current->second.boundary;
+                state.done.erase(current);
+                ++nextEmit;
+            }
+            if (!segments.empty() && m_segmentsReady && !m_cancelled)
+                m_segmentsReady(segments);
+        }
+    };
+
+    double reported = 0.0;
+    auto reportProgress = [&] {
+        if (!m_progress || source.end() <= from)
+            return;
+        // With nothing outstanding, everything decoded so far is done.
+        const double upTo = nextEmit == nextIndex && waiting.empty() ? source.seconds(source.decoded()) : delivered;
+        reported = std::max(reported, std::clamp((upTo - from) / (source.end() - from), 0.0, 1.0));
+        m_progress(reported);
+    };
+
+    std::vector<SpeechRegion> regions;
+    while (!m_cancelled && source.next(regions)) {
+        waiting.insert(waiting.end(), regions.begin(), regions.end());
+        while (!waiting.empty() && submit(waiting.front(), false))
+            waiting.pop_front();
+
+        {
+            // Keep decoding at most a couple of chunks ahead of Whisper.
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [&] { return state.inFlight < maxInFlight || m_cancelled; });
+        }
+        deliver(false);
+        reportProgress();
+    }
+
+    if (!m_cancelled) {
+        for (const SpeechRegion &region : source.finish())
+            waiting.push_back(region);
+        while (!waiting.empty()) {
+            submit(waiting.front(), true);
+            waiting.pop_front();
+        }
+    }
+
+    for (;;) {
+        int seen;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (state.inFlight == 0)
+                break;
+            seen = state.completed;
+        }
+        deliver(true);
+        reportProgress();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [&] { return state.completed != seen; });
+    }
+    deliver(true);
+    reportProgress();
+
+    if (state.error)
+        std::rethrow_exception(state.error);
+    return !m_cancelled;
+}
+
+} // namespace vep
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "audio/VoiceActivityDetector.h"
+#include "captions/Caption.h"
+#include "captions/WhisperTranscriber.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class WhisperModel;
+
+struct ParallelCaptionSettings
+{
+    // Whisper states running at once, all on the one loaded model (each
+    // state costs its KV cache and work buffers, not another copy of the
+    // weights). 0 picks cores / threadsPerContext.
+    int contexts = 0;
+    // Threads inside each whisper_full call; Whisper scales poorly past ~4.
+    int threadsPerContext = 4;
+    // Audio shared by two chunks where speech was cut at the window limit.
+    double overlapSeconds = 2.0;
+};
+
+// Auto captions for long recordings on many cores. Decoding and voice
+// detection run ahead on the calling thread and cut the speech into chunks
+// of at most one Whisper window; the chunks are transcribed concurrently
+// and handed out in media order, as each prefix of the file completes.
+//
+// Where speech runs through a chunk boundary, both chunks also see
+// overlapSeconds of audio past it and the two transcripts are joined on a
+// word they agree on, so the word at the boundary is neither lost nor
+// duplicated and its timestamps come from the chunk that heard it whole.
+// Chunks are independent, so unlike StreamingCaptioner no text is carried
+// over as prompt between them.
+//
+// The Whisper states are made on the first run() and kept for the next, so
+// one captioner can transcribe several ranges without setting them up again.
+class ParallelCaptioner
+{
+public:
+    using SegmentsReady = std::function<void(const std::vector<CaptionSegment> &segments)>;
+    // Fraction of the requested range whose captions have been delivered.
+    using Progress = std::function<void(double fraction)>;
+
+    ParallelCaptioner(std::shared_ptr<const WhisperModel> model, WhisperOptions options,
+                      ParallelCaptionSettings settings = ParallelCaptionSettings(),
+                      VadSettings vad = VadSettings());
+    ~ParallelCaptioner();
+
+    void setSegmentsCallback(SegmentsReady callback) { m_segmentsReady = std::move(callback); }
+    void setProgressCallback(Progress callback) { m_progress = std::move(callback); }
+
+    // Same contract as StreamingCaptioner::run.
+    bool run(const std::string &mediaPath, double from = 0.0, double to = 0.0);
+    // Thread-safe; also wakes a run() waiting for chunks to finish.
+    void cancel();
+    double speechSeconds() const { return m_speechSeconds; }
+
+    int contexts() const { return m_contexts; }
+
+    // Joins two transcripts whose audio overlaps around `boundary` (media
+    // seconds): trims the tail of `left` and the head of `right` in place.
+    static void joinAtBoundary(std::vector<CaptionSegment> &left, std::vector<CaptionSegment> &right,
+                               double boundary, double overlapSeconds);
+
+private:
+    struct Run;
+
+    std::shared_ptr<const WhisperModel> m_model;
+    WhisperOptions m_options;
+    ParallelCaptionSettings m_settings;
+    VadSettings m_vad;
+    int m_contexts;
+    SegmentsReady m_segmentsReady;
+    Progress m_progress;
+    std::vector<std::unique_ptr<WhisperTranscriber>> m_transcribers; // idle between runs
+    // Guards the state of the current run (see Run) and signals its changes.
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::atomic<bool> m_cancelled{false};
+    double m_speechSeconds = 0.0;
+};
+
+} // namespace vep
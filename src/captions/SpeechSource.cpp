@@ -0,0 +1,71 @@
+#include "captions/SpeechSource.h"
+
+#include "captions/WhisperTranscriber.h"
+#include "media/AudioDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+namespace {
+
+constexpr int kRate = WhisperTranscriber::kSampleRate;
+
+} // namespace
+
+SpeechSource::SpeechSource(const std::string &mediaPath, double from, double to, const VadSettings &vad,
+                           double extraSeconds)
+    : m_decoder(std::make_unique<AudioDecoder>(mediaPath, kRate, 1))
+    , m_vad(kRate, vad)
+    , m_from(from)
+{
+    if (from > 0.0)
+        m_decoder->seek(from);
+    m_end = to > 0.0 ? to : m_decoder->duration();
+    m_endSample = to > 0.0 ? int64_t(std::llround((to - from) * kRate)) : INT64_MAX;
+    m_keep = int64_t((vad.maxRegionSeconds + vad.hangoverSeconds + vad.paddingSeconds + extraSeconds + 1.0) * kRate);
+}
+
+SpeechSource::~SpeechSource() = default;
+
+bool SpeechSource::next(std::vector<SpeechRegion> &regions)
+{
+    regions.clear();
+    // The caller is done with the regions handed out before; trimmed here
+    // rather than after the read so they stay cut-able until it asks again.
+    if (int64_t(m_buffer.size()) > 2 * m_keep) {
+        const int64_t drop = int64_t(m_buffer.size()) - m_keep;
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + ptrdiff_t(drop));
+        m_base += drop;
+    }
+    if (m_decoded >= m_endSample)
+        return false;
+    int frames = m_decoder->read(m_block);
+    if (frames == 0)
+        return false;
+    frames = int(std::min<int64_t>(frames, m_endSample - m_decoded));
+    m_buffer.insert(m_buffer.end(), m_block.begin(), m_block.begin() + frames);
+    m_decoded += frames;
+    regions = m_vad.process(m_block.data(), frames);
+    return true;
+}
+
+std::vector<SpeechRegion> SpeechSource::finish()
+{
+    return m_vad.finish();
+}
+
+double SpeechSource::seconds(int64_t sample) const
+{
+    return m_from + double(sample) / kRate;
+}
+
+double SpeechSource::progress() const
+{
+    if (m_end <= m_from)
+        return 0.0;
+    return std::min(1.0, double(m_decoded) / kRate / (m_end - m_from));
+}
+
+} // namespace vep
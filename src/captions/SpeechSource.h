@@ -0,0 +1,69 @@
+#pragma once
+
+#include "audio/VoiceActivityDetector.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class AudioDecoder;
+
+// The front half of both captioners: [from, to) seconds of a media file
+// decoded to Whisper's 16 kHz mono and run through the VoiceActivityDetector,
+// with the recent audio held so the speech regions it reports can be cut
+// out. Sample positions count from `from`.
+//
+// Enough audio is held for the open region, its padding and extraSeconds
+// more (ParallelCaptioner's overlaps); older audio is dropped as decoding
+// moves on.
+class SpeechSource
+{
+public:
+    // to <= 0 decodes to the end of the file. Throws std::runtime_error if
+    // the file cannot be decoded.
+    SpeechSource(const std::string &mediaPath, double from, double to, const VadSettings &vad,
+                 double extraSeconds = 0.0);
+    ~SpeechSource();
+
+    SpeechSource(const SpeechSource &) = delete;
+    SpeechSource &operator=(const SpeechSource &) = delete;
+
+    // Decodes the next block and replaces `regions` with the speech regions
+    // it completed (often none). Returns false, with nothing decoded, once
+    // the range or the file is exhausted.
+    bool next(std::vector<SpeechRegion> &regions);
+    // The region still open at the end of the range, if any.
+    std::vector<SpeechRegion> finish();
+
+    // Audio held: samples [heldFrom(), heldTo()).
+    int64_t heldFrom() const { return m_base; }
+    int64_t heldTo() const { return m_base + int64_t(m_buffer.size()); }
+    const float *at(int64_t sample) const { return m_buffer.data() + (sample - m_base); }
+
+    int64_t decoded() const { return m_decoded; }
+    // Media time of a sample position.
+    double seconds(int64_t sample) const;
+    double from() const { return m_from; }
+    // End of the range in media time; the file's duration if open-ended (0
+    // if the container does not say).
+    double end() const { return m_end; }
+    // Share of the range decoded so far; 0 if its length is unknown.
+    double progress() const;
+
+private:
+    std::unique_ptr<AudioDecoder> m_decoder;
+    VoiceActivityDetector m_vad;
+    double m_from;
+    double m_end;
+    int64_t m_endSample;
+    int64_t m_keep;
+    std::vector<float> m_buffer;
+    std::vector<float> m_block;
+    int64_t m_base = 0;
+    int64_t m_decoded = 0;
+};
+
+} // namespace vep
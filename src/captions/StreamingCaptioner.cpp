@@ -0,0 +1,53 @@
+#include "captions/StreamingCaptioner.h"
+
+#include "captions/SpeechSource.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace vep {
+
+StreamingCaptioner::StreamingCaptioner(std::shared_ptr<const WhisperModel> model, WhisperOptions options,
+                                       VadSettings vad)
+    : m_model(std::move(model))
+    , m_options(std::move(options))
+    , m_vad(vad)
+{
+}
+
+bool StreamingCaptioner::run(const std::string &mediaPath, double from, double to)
+{
+    constexpr int rate = WhisperTranscriber::kSampleRate;
+    m_speechSeconds = 0.0;
+
+    SpeechSource source(mediaPath, from, to, m_vad);
+    WhisperTranscriber transcriber(m_model, m_options);
+
+    auto transcribe = [&](const std::vector<SpeechRegion> &regions) {
+        for (const SpeechRegion &region : regions) {
+            if (m_cancelled)
+                return;
+            const int64_t first = std::max(region.start, source.heldFrom());
+            const int64_t last = std::min(region.end, source.heldTo());
+            if (last <= first)
+                continue;
+            m_speechSeconds += double(last - first) / rate;
+            auto segments = transcriber.transcribe(source.at(first), int(last - first), source.seconds(first),
+                                                   &m_cancelled);
+            if (!segments.empty() && m_segmentsReady && !m_cancelled)
+                m_segmentsReady(segments);
+        }
+    };
+
+    std::vector<SpeechRegion> regions;
+    while (!m_cancelled && source.next(regions)) {
+        transcribe(regions);
+        if (m_progress)
+            m_progress(source.progress());
+    }
+    if (!m_cancelled)
+        transcribe(source.finish());
+    return !m_cancelled;
+}
+
+} // namespace vep
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "audio/VoiceActivityDetector.h"
+#include "captions/Caption.h"
+#include "captions/WhisperTranscriber.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class WhisperModel;
+
+// Auto captions for one media file: audio is decoded to 16 kHz mono and
+// passed through the VoiceActivityDetector, and only the speech regions
+// reach Whisper, one region (at most one Whisper window) at a time. Each
+// region's captions are handed out as soon as it is transcribed, so the
+// timeline fills in while the job runs instead of at the end.
+class StreamingCaptioner
+{
+public:
+    using SegmentsReady = std::function<void(const std::vector<CaptionSegment> &segments)>;
+    // Fraction of the requested range decoded so far.
+    using Progress = std::function<void(double fraction)>;
+
+    StreamingCaptioner(std::shared_ptr<const WhisperModel> model, WhisperOptions options,
+                       VadSettings vad = VadSettings());
+
+    void setSegmentsCallback(SegmentsReady callback) { m_segmentsReady = std::move(callback); }
+    void setProgressCallback(Progress callback) { m_progress = std::move(callback); }
+
+    // Captions [from, to) seconds of the file (to <= 0: to the end). Returns
+    // false if cancelled. Throws std::runtime_error on decode/model errors.
+    bool run(const std::string &mediaPath, double from = 0.0, double to = 0.0);
+
+    // Thread-safe, including before run(); also interrupts a window that is
+    // being transcribed. A cancelled captioner stays cancelled.
+    void cancel() { m_cancelled = true; }
+
+    // Speech found by the last run, in seconds (for reporting how much of
+    // the file actually went through the model).
+    double speechSeconds() const { return m_speechSeconds; }
+
+private:
+    std::shared_ptr<const WhisperModel> m_model;
+    WhisperOptions m_options;
+    VadSettings m_vad;
+    SegmentsReady m_segmentsReady;
+    Progress m_progress;
+    std::atomic<bool> m_cancelled{false};
+    double m_speechSeconds = 0.0;
+};
+
+} // namespace vep
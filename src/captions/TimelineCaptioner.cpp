@@ -0,0 +1,147 @@
+#include "captions/TimelineCaptioner.h"
+
+#include "captions/WhisperModelManager.h"
+
+#include <algorithm>
+
+namespace vep {
+
+namespace {
+
+// Extra audio transcribed on each side of a missing range so words cut by
+// its edges can be matched with the cached transcript.
+constexpr double kSpliceMargin = 2.0;
+
+} // namespace
+
+TimelineCaptioner::TimelineCaptioner(MediaCache &cache, std::string modelPath, WhisperOptions options,
+                                     ParallelCaptionSettings settings)
+    : m_cache(cache)
+    , m_modelPath(std::move(modelPath))
+    , m_options(std::move(options))
+    , m_settings(settings)
+{
+}
+
+TimelineCaptioner::~TimelineCaptioner() = default;
+
+void TimelineCaptioner::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cancelled = true;
+    if (m_running)
+        m_running->cancel();
+}
+
+void TimelineCaptioner::resetCancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cancelled = false;
+}
+
+bool TimelineCaptioner::update(const std::vector<CaptionClip> &clips)
+{
+    m_transcribedSeconds = 0.0;
+
+    std::map<int, CaptionClip> current;
+    for (const CaptionClip &clip : clips)
+        current[clip.id] = clip;
+    for (auto it = m_applied.begin(); it != m_applied.end();) {
+        if (current.count(it->first)) {
+            ++it;
+            continue;
+        }
+        if (m_clipRemoved)
+            m_clipRemoved(it->first);
+        it = m_applied.erase(it);
+    }
+
+    std::vector<const CaptionClip *> changed;
+    for (const CaptionClip &clip : clips) {
+        auto applied = m_applied.find(clip.id);
+        if (applied == m_applied.end() || applied->second != clip)
+            changed.push_back(&clip);
+    }
+
+    // What is missing now, for progress. Clips of one source can share a
+    // range, which is then transcribed once, so this may overestimate.
+    auto keyFor = [this](const CaptionClip &clip) {
+        return m_cache.keyFor(clip.mediaPath, m_modelPath, m_options.language, m_options.translate);
+    };
+    m_secondsToTranscribe = 0.0;
+    for (const CaptionClip *clip : changed) {
+        for (const auto &[from, to] : m_cache.load(keyFor(*clip)).missing(clip->sourceIn, clip->sourceOut))
+            m_secondsToTranscribe += to - from;
+    }
+
+    // One captioner, and so one set of Whisper states, for every range
+    // this update transcribes; made when the first range needs it.
+    std::unique_ptr<ParallelCaptioner> captioner;
+    for (const CaptionClip *changedClip : changed) {
+        const CaptionClip &clip = *changedClip;
+        const CaptionCacheKey key = keyFor(clip);
+        // Loaded again: an earlier clip of the same source may have
+        // filled some of it in.
+        CachedTranscript transcript = m_cache.load(key);
+        if (!transcribe(clip, key, transcript, captioner))
+            return false;
+
+        std::vector<CaptionSegment> segments = transcript.range(clip.sourceIn, clip.sourceOut);
+        shiftCaptions(segments, clip.timelineStart - clip.sourceIn);
+        if (m_clipCaptions)
+            m_clipCaptions(clip.id, segments);
+        m_applied[clip.id] = clip;
+    }
+    return true;
+}
+
+bool TimelineCaptioner::transcribe(const CaptionClip &clip, const CaptionCacheKey &key, CachedTranscript &transcript,
+                                   std::unique_ptr<ParallelCaptioner> &captioner)
+{
+    for (const auto &[from, to] : transcript.missing(clip.sourceIn, clip.sourceOut)) {
+        if (!m_model)
+            m_model = WhisperModelManager::instance().acquire(m_modelPath);
+        if (!captioner)
+            captioner = std::make_unique<ParallelCaptioner>(m_model, m_options, m_settings);
+
+        std::vector<CaptionSegment> fresh;
+        captioner->setSegmentsCallback([&fresh](const std::vector<CaptionSegment> &segments) {
+            fresh.insert(fresh.end(), segments.begin(), segments.end());
+        });
+        if (m_progress && m_secondsToTranscribe > 0.0) {
+            const double done = m_transcribedSeconds;
+            const double length = to - from;
+            captioner->setProgressCallback([this, done, length](double fraction) {
+                m_progress(std::min(1.0, (done + fraction * length) / m_secondsToTranscribe));
+            });
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_cancelled)
+                return false;
+            m_running = captioner.get();
+        }
+        bool completed = false;
+        try {
+            completed = captioner->run(clip.mediaPath, std::max(0.0, from - kSpliceMargin), to + kSpliceMargin);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = nullptr;
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = nullptr;
+        }
+        if (!completed)
+            return false;
+
+        // Stored range by range, so a cancelled update keeps what it did.
+        transcript.splice(from, to, std::move(fresh), kSpliceMargin);
+        m_cache.store(key, transcript);
+        m_transcribedSeconds += to - from;
+    }
+    return true;
+}
+
+} // namespace vep
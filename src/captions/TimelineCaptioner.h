@@ -0,0 +1,97 @@
+#pragma once
+
+#include "captions/CaptionCache.h"
+#include "captions/ParallelCaptioner.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class MediaCache;
+class WhisperModel;
+
+// A speech clip on the timeline: [sourceIn, sourceOut) of mediaPath placed
+// at timelineStart.
+struct CaptionClip
+{
+    int id = -1;
+    std::string mediaPath;
+    double sourceIn = 0.0;
+    double sourceOut = 0.0;
+    double timelineStart = 0.0;
+
+    bool operator==(const CaptionClip &other) const
+    {
+        return id == other.id && mediaPath == other.mediaPath && sourceIn == other.sourceIn
+               && sourceOut == other.sourceOut && timelineStart == other.timelineStart;
+    }
+    bool operator!=(const CaptionClip &other) const { return !(*this == other); }
+};
+
+// Keeps a timeline's caption track in step with its clips without
+// re-transcribing audio it has seen. Transcripts are cached per source file
+// (CaptionCache), so on update():
+//  - unchanged clips are skipped;
+//  - moved or trimmed-in clips are re-cut from the cache;
+//  - extended or new clips transcribe only the source ranges never
+//    transcribed before, spliced into the file's cached transcript;
+//  - clips that disappeared are reported removed.
+// The model is loaded only if something actually needs transcribing.
+class TimelineCaptioner
+{
+public:
+    // Captions for one clip, in timeline time; replaces the clip's previous ones.
+    using ClipCaptions = std::function<void(int clipId, const std::vector<CaptionSegment> &segments)>;
+    using ClipRemoved = std::function<void(int clipId)>;
+    // Fraction of the audio update() has to transcribe that is done.
+    using Progress = std::function<void(double fraction)>;
+
+    TimelineCaptioner(MediaCache &cache, std::string modelPath, WhisperOptions options,
+                      ParallelCaptionSettings settings = ParallelCaptionSettings());
+    ~TimelineCaptioner();
+
+    void setClipCaptionsCallback(ClipCaptions callback) { m_clipCaptions = std::move(callback); }
+    void setClipRemovedCallback(ClipRemoved callback) { m_clipRemoved = std::move(callback); }
+    void setProgressCallback(Progress callback) { m_progress = std::move(callback); }
+
+    // Returns false if cancelled; what was transcribed so far stays cached.
+    // Throws std::runtime_error on decode/model errors.
+    bool update(const std::vector<CaptionClip> &clips);
+    // Thread-safe. Holds until resetCancel(), so a cancel that arrives
+    // before update() starts still stops it.
+    void cancel();
+    // Clears an earlier cancel(); the owner calls it when a new job starts.
+    void resetCancel();
+
+    // Seconds of source audio update() had to transcribe (the rest came
+    // from the cache).
+    double transcribedSeconds() const { return m_transcribedSeconds; }
+
+private:
+    bool transcribe(const CaptionClip &clip, const CaptionCacheKey &key, CachedTranscript &transcript,
+                    std::unique_ptr<ParallelCaptioner> &captioner);
+
+    CaptionCache m_cache;
+    std::string m_modelPath;
+    WhisperOptions m_options;
+    ParallelCaptionSettings m_settings;
+    std::shared_ptr<const WhisperModel> m_model;
+    std::map<int, CaptionClip> m_applied;
+    ClipCaptions m_clipCaptions;
+    ClipRemoved m_clipRemoved;
+    Progress m_progress;
+    double m_transcribedSeconds = 0.0;
+    double m_secondsToTranscribe = 0.0;
+
+    std::mutex m_mutex;
+    bool m_cancelled = false;
+    ParallelCaptioner *m_running = nullptr;
+};
+
+} // namespace vep
@@ -0,0 +1,288 @@
+#include "captions/TranscriptIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace vep {
+
+namespace {
+
+// Decodes one UTF-8 sequence at text[pos], advancing pos; malformed bytes
+// come back as themselves so nothing is lost.
+uint32_t decode(const std::string &text, size_t &pos)
+{
+    const auto byte = [&](size_t i) { return uint8_t(text[i]); };
+    const uint8_t lead = byte(pos);
+    int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xe ? 3 : (lead >> 3) == 0x1e ? 4 : 0;
+    if (length == 0 || pos + size_t(length) > text.size()) {
+        ++pos;
+        return lead;
+    }
+    uint32_t cp = length == 1 ? lead : lead & (0x7f >> length);
+    for (int i = 1; i < length; ++i) {
+        if ((byte(pos + size_t(i)) & 0xc0) != 0x80) {
+            ++pos;
+            return lead;
+        }
+        cp = (cp << 6) | (byte(pos + size_t(i)) & 0x3f);
+    }
+    pos += size_t(length);
+    return cp;
+}
+
+void encode(uint32_t cp, std::string &out)
+{
+    if (cp < 0x80) {
+        out += char(cp);
+    } else if (cp < 0x800) {
+        out += char(0xc0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        out += char(0xe0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3f));
+        out += char(0x80 | (cp & 0x3f));
+    } else {
+        out += char(0xf0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3f));
+        out += char(0x80 | ((cp >> 6) & 0x3f));
+        out += char(0x80 | (cp & 0x3f));
+    }
+}
+
+constexpr uint32_t kDrop = 0;
+constexpr uint32_t kBreak = ~uint32_t(0);
+
+// What a code point becomes in a search token: itself, another code point,
+// kDrop (vanishes) or kBreak (ends the token).
+uint32_t fold(uint32_t cp)
+{
+    if (cp < 0x80) {
+        if ((cp >= 'a' && cp <= 'z') || (cp >= '0' && cp <= '9'))
+            return cp;
+        if (cp >= 'A' && cp <= 'Z')
+            return cp + 0x20;
+        return cp == '\'' ? kDrop : kBreak;
+    }
+    if (cp >= 0xc0 && cp <= 0xde && cp != 0xd7) // Latin-1 capitals
+        return cp + 0x20;
+    if (cp < 0xc0 || cp == 0xd7 || cp == 0xf7)
+        return kBreak;
+    if ((cp >= 0x064b && cp <= 0x065f) || cp == 0x0670 || cp == 0x0640) // harakat, dagger alef, tatweel
+        return kDrop;
+    switch (cp) {
+    case 0x0622: // آ
+    case 0x0623: // أ
+    case 0x0625: // إ
+    case 0x0671: // ٱ
+        return 0x0627;
+    case 0x0629: // ة
+        return 0x0647;
+    case 0x0649: // ى
+        return 0x064a;
+    case 0x060c: // ، ؛ ؟ and Arabic full stop
+    case 0x061b:
+    case 0x061f:
+    case 0x06d4:
+        return kBreak;
+    case 0x2018: // curly apostrophes
+    case 0x2019:
+        return kDrop;
+    default:
+        break;
+    }
+    if (cp >= 0x0660 && cp <= 0x0669)
+        return '0' + (cp - 0x0660);
+    if (cp >= 0x06f0 && cp <= 0x06f9)
+        return '0' + (cp - 0x06f0);
+    if ((cp >= 0x066a && cp <= 0x066d) || (cp >= 0x2000 && cp <= 0x206f) || cp == 0x3000)
+        return kBreak;
+    return cp;
+}
+
+bool startsWith(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+} // namespace
+
+std::vector<std::string> searchTokens(const std::string &text)
+{
+    std::vector<std::string> tokens;
+    std::string current;
+    for (size_t pos = 0; pos < text.size();) {
+        const uint32_t cp = fold(decode(text, pos));
+        if (cp == kDrop)
+            continue;
+        if (cp == kBreak) {
+            if (!current.empty())
+                tokens.push_back(std::move(current));
+            current.clear();
+            continue;
+        }
+        encode(cp, current);
+    }
+    if (!current.empty())
+        tokens.push_back(std::move(current));
+    return tokens;
+}
+
+void TranscriptIndex::setClip(int clipId, const std::vector<CaptionSegment> &segments)
+{
+    removeClip(clipId);
+    Clip clip;
+    for (const CaptionSegment &segment : segments) {
+        if (segment.words.empty()) {
+            clip.words.push_back({segment.start, segment.end, segment.text});
+            continue;
+        }
+        for (const CaptionWord &word : segment.words)
+            clip.words.push_back({word.start, word.end, word.text});
+    }
+    std::stable_sort(clip.words.begin(), clip.words.end(),
+                     [](const TranscriptWord &a, const TranscriptWord &b) { return a.start < b.start; });
+    for (int w = 0; w < int(clip.words.size()); ++w) {
+        for (std::string &token : searchTokens(clip.words[size_t(w)].text)) {
+            m_postings[token].push_back({clipId, int(clip.tokens.size())});
+            clip.tokens.push_back({std::move(token), w});
+        }
+    }
+    if (!clip.words.empty())
+        m_clips.emplace(clipId, std::move(clip));
+}
+
+void TranscriptIndex::removeClip(int clipId)
+{
+    auto it = m_clips.find(clipId);
+    if (it == m_clips.end())
+        return;
+    // Each posting list the clip appears in is filtered once, however often
+    // the token occurs in the clip.
+    std::vector<const std::string *> texts;
+    texts.reserve(it->second.tokens.size());
+    for (const Token &token : it->second.tokens)
+        texts.push_back(&token.text);
+    std::sort(texts.begin(), texts.end(), [](const std::string *a, const std::string *b) { return *a < *b; });
+    texts.erase(std::unique(texts.begin(), texts.end(),
+                            [](const std::string *a, const std::string *b) { return *a == *b; }),
+                texts.end());
+    for (const std::string *text : texts) {
+        auto postings = m_postings.find(*text);
+        if (postings == m_postings.end())
+            continue;
+        auto &list = postings->second;
+        list.erase(std::remove_if(list.begin(), list.end(), [&](const Posting &p) { return p.clipId == clipId; }),
+                   list.end());
+        if (list.empty())
+            m_postings.erase(postings);
+    }
+    m_clips.erase(it);
+}
+
+void TranscriptIndex::clear()
+{
+    m_clips.clear();
+    m_postings.clear();
+}
+
+std::vector<TranscriptHit> TranscriptIndex::search(const std::string &query, size_t limit) const
+{
+    const std::vector<std::string> tokens = searchTokens(query);
+    std::vector<TranscriptHit> hits;
+    if (tokens.empty())
+        return hits;
+
+    auto check = [&](const Posting &posting) {
+        const Clip &clip = m_clips.at(posting.clipId);
+        const size_t first = size_t(posting.token);
+        if (first + tokens.size() > clip.tokens.size())
+            return;
+        for (size_t i = 1; i < tokens.size(); ++i) {
+            const std::string &text = clip.tokens[first + i].text;
+            if (i + 1 == tokens.size() ? !startsWith(text, tokens[i]) : text != tokens[i])
+                return;
+        }
+        TranscriptHit hit;
+        hit.clipId = posting.clipId;
+        hit.firstWord = clip.tokens[first].word;
+        hit.lastWord = clip.tokens[first + tokens.size() - 1].word;
+        hit.start = clip.words[size_t(hit.firstWord)].start;
+        hit.end = clip.words[size_t(hit.lastWord)].end;
+        hits.push_back(hit);
+    };
+
+    if (tokens.size() == 1) {
+        for (auto it = m_postings.lower_bound(tokens[0]); it != m_postings.end() && startsWith(it->first, tokens[0]);
+             ++it) {
+            for (const Posting &posting : it->second)
+                check(posting);
+        }
+    } else if (auto it = m_postings.find(tokens[0]); it != m_postings.end()) {
+        for (const Posting &posting : it->second)
+            check(posting);
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const TranscriptHit &a, const TranscriptHit &b) {
+        return a.start != b.start ? a.start < b.start : a.clipId < b.clipId;
+    });
+    // One word can fold to several tokens; report each span once.
+    hits.erase(std::unique(hits.begin(), hits.end(),
+                           [](const TranscriptHit &a, const TranscriptHit &b) {
+                               return a.clipId == b.clipId && a.firstWord == b.firstWord
+                                      && a.lastWord == b.lastWord;
+                           }),
+               hits.end());
+    if (hits.size() > limit)
+        hits.resize(limit);
+    return hits;
+}
+
+const std::vector<TranscriptWord> &TranscriptIndex::words(int clipId) const
+{
+    static const std::vector<TranscriptWord> none;
+    auto it = m_clips.find(clipId);
+    return it == m_clips.end() ? none : it->second.words;
+}
+
+std::vector<std::pair<double, double>> TranscriptIndex::cutRanges(int clipId, std::vector<int> wordIndices) const
+{
+    std::vector<std::pair<double, double>> ranges;
+    const std::vector<TranscriptWord> &all = words(clipId);
+    const int count = int(all.size());
+    wordIndices.erase(std::remove_if(wordIndices.begin(), wordIndices.end(),
+                                     [&](int w) { return w < 0 || w >= count; }),
+                      wordIndices.end());
+    std::sort(wordIndices.begin(), wordIndices.end());
+    wordIndices.erase(std::unique(wordIndices.begin(), wordIndices.end()), wordIndices.end());
+
+    for (size_t i = 0; i < wordIndices.size();) {
+        const int first = wordIndices[i];
+        int last = first;
+        while (++i < wordIndices.size() && wordIndices[i] == last + 1)
+            ++last;
+        const TranscriptWord &head = all[size_t(first)];
+        const TranscriptWord &tail = all[size_t(last)];
+        double start = head.start;
+        double end = tail.end;
+        if (first > 0) {
+            const double before = all[size_t(first - 1)].end;
+            start = std::min(start, std::max((before + head.start) * 0.5, before));
+        }
+        if (last + 1 < count) {
+            const double after = all[size_t(last + 1)].start;
+            end = std::max(end, std::min((tail.end + after) * 0.5, after));
+        }
+        ranges.emplace_back(start, end);
+    }
+    return ranges;
+}
+
+size_t TranscriptIndex::wordCount() const
+{
+    size_t count = 0;
+    for (const auto &[id, clip] : m_clips)
+        count += clip.words.size();
+    return count;
+}
+
+} // namespace vep
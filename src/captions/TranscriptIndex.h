@@ -0,0 +1,88 @@
+#pragma once
+
+#include "captions/Caption.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vep {
+
+// Folds a piece of caption text to search tokens: lower-case (ASCII and
+// Latin-1), Arabic diacritics and tatweel removed, alef/hamza, ta marbuta
+// and alef maqsura variants unified, Arabic-Indic digits made ASCII, and
+// split on whitespace and punctuation (apostrophes are dropped, so "don't"
+// matches "dont").
+std::vector<std::string> searchTokens(const std::string &text);
+
+struct TranscriptWord
+{
+    double start = 0.0; // timeline seconds
+    double end = 0.0;
+    std::string text;
+};
+
+struct TranscriptHit
+{
+    int clipId = -1;
+    int firstWord = 0; // indices into words(clipId), inclusive
+    int lastWord = 0;
+    double start = 0.0;
+    double end = 0.0;
+};
+
+// Inverted index over the word timings of every clip's captions, for
+// "where was X said" searches and text-based cuts. Each clip's words are
+// kept in order and folded to tokens (see searchTokens); a sorted vocabulary
+// maps each token to where it occurs, so a phrase query costs one prefix
+// range lookup plus a check of the following tokens per candidate, not a
+// scan of the project's text.
+//
+// Clips are replaced whole whenever their captions change (e.g. from
+// TimelineCaptioner after a trim). Not thread-safe; owned by the UI thread.
+class TranscriptIndex
+{
+public:
+    // Segments in timeline time; segments without word timings are indexed
+    // as one word.
+    void setClip(int clipId, const std::vector<CaptionSegment> &segments);
+    void removeClip(int clipId);
+    void clear();
+
+    // Occurrences of the phrase, in timeline order. The last query token also
+    // matches as a prefix, so results appear while the user is still typing.
+    std::vector<TranscriptHit> search(const std::string &query, size_t limit = 500) const;
+
+    const std::vector<TranscriptWord> &words(int clipId) const;
+
+    // Timeline ranges to cut so that the given words of the clip disappear.
+    // Adjacent words merge into one range; each range extends halfway into
+    // the pauses on either side, so neighbouring words keep their breaths.
+    std::vector<std::pair<double, double>> cutRanges(int clipId, std::vector<int> wordIndices) const;
+
+    size_t wordCount() const;
+
+private:
+    struct Token
+    {
+        std::string text;
+        int word;
+    };
+    struct Clip
+    {
+        std::vector<TranscriptWord> words;
+        std::vector<Token> tokens;
+    };
+    struct Posting
+    {
+        int clipId;
+        int token;
+    };
+
+    std::unordered_map<int, Clip> m_clips;
+    std::map<std::string, std::vector<Posting>> m_postings;
+};
+
+} // namespace vep
@@ -0,0 +1,93 @@
+#include "captions/TranscriptModel.h"
+
+#include <QVariantMap>
+
+#include <algorithm>
+
+namespace vep {
+
+TranscriptModel::TranscriptModel(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QVariantList TranscriptModel::search(const QString &query, int limit) const
+{
+    QVariantList result;
+    for (const TranscriptHit &hit : m_index.search(query.toStdString(), size_t(std::max(0, limit)))) {
+        const std::vector<TranscriptWord> &words = m_index.words(hit.clipId);
+        // Words carry their own leading spaces (none in CJK text).
+        std::string text;
+        for (int w = hit.firstWord; w <= hit.lastWord; ++w)
+            text += words[size_t(w)].text;
+        result.append(QVariantMap{{"clipId", hit.clipId},
+                                  {"firstWord", hit.firstWord},
+                                  {"lastWord", hit.lastWord},
+                                  {"start", hit.start},
+                                  {"end", hit.end},
+                                  {"text", QString::fromStdString(text).trimmed()}});
+    }
+    return result;
+}
+
+QVariantList TranscriptModel::words(int clipId) const
+{
+    QVariantList result;
+    for (const TranscriptWord &word : m_index.words(clipId)) {
+        result.append(QVariantMap{{"start", word.start},
+                                  {"end", word.end},
+                                  {"text", QString::fromStdString(word.text).trimmed()}});
+    }
+    return result;
+}
+
+QVariantList TranscriptModel::cutRanges(int clipId, const QVariantList &wordIndices) const
+{
+    std::vector<int> indices;
+    indices.reserve(size_t(wordIndices.size()));
+    for (const QVariant &index : wordIndices)
+        indices.push_back(index.toInt());
+    QVariantList result;
+    for (const auto &[start, end] : m_index.cutRanges(clipId, std::move(indices)))
+        result.append(QVariantMap{{"start", start}, {"end", end}});
+    return result;
+}
+
+void TranscriptModel::setClipCaptions(int clipId, const QVariantList &segments)
+{
+    std::vector<CaptionSegment> captions;
+    captions.reserve(size_t(segments.size()));
+    for (const QVariant &value : segments) {
+        const QVariantMap map = value.toMap();
+        CaptionSegment segment;
+        segment.start = map.value("start").toDouble();
+        segment.end = map.value("end").toDouble();
+        segment.text = map.value("text").toString().toStdString();
+        for (const QVariant &wordValue : map.value("words").toList()) {
+            const QVariantMap wordMap = wordValue.toMap();
+            CaptionWord word;
+            word.start = wordMap.value("start").toDouble();
+            word.end = wordMap.value("end").toDouble();
+            word.text = wordMap.value("text").toString().toStdString();
+            word.probability = wordMap.value("probability").toFloat();
+            segment.words.push_back(std::move(word));
+        }
+        captions.push_back(std::move(segment));
+    }
+    m_index.setClip(clipId, captions);
+    emit indexChanged();
+}
+
+void TranscriptModel::removeClip(int clipId)
+{
+    m_index.removeClip(clipId);
+    emit indexChanged();
+}
+
+void TranscriptModel::clear()
+{
+    m_index.clear();
+    emit indexChanged();
+}
+
+} // namespace vep
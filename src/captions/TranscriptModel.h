@@ -0,0 +1,50 @@
+#pragma once
+
+#include "captions/TranscriptIndex.h"
+
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+
+namespace vep {
+
+// QML face of the project's TranscriptIndex. Connected to
+// AutoCaptionJob::clipCaptionsReady / clipCaptionsRemoved (see main.cpp),
+// it follows the caption track; the search box and the transcript editor
+// query it. cutRanges() gives the ranges a text-based cut would remove,
+// but nothing applies them yet: that needs a timeline model, which this
+// tree does not have.
+class TranscriptModel : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int wordCount READ wordCount NOTIFY indexChanged)
+
+public:
+    explicit TranscriptModel(QObject *parent = nullptr);
+
+    TranscriptIndex &index() { return m_index; }
+    int wordCount() const { return int(m_index.wordCount()); }
+
+    // Maps with clipId, firstWord, lastWord, start, end (timeline seconds)
+    // and text (the matched words as captioned).
+    Q_INVOKABLE QVariantList search(const QString &query, int limit = 500) const;
+    // The clip's words as maps with start, end and text.
+    Q_INVOKABLE QVariantList words(int clipId) const;
+    // Timeline ranges (maps with start, end) to cut so the given words of
+    // the clip are removed.
+    Q_INVOKABLE QVariantList cutRanges(int clipId, const QVariantList &wordIndices) const;
+
+public slots:
+    // Segments as produced by AutoCaptionJob::toVariant, in timeline time.
+    void setClipCaptions(int clipId, const QVariantList &segments);
+    void removeClip(int clipId);
+    void clear();
+
+signals:
+    void indexChanged();
+
+private:
+    TranscriptIndex m_index;
+};
+
+} // namespace vep
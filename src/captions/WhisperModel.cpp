@@ -0,0 +1,131 @@
+#include "captions/WhisperModel.h"
+
+#include <whisper.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace vep {
+
+namespace {
+
+// ggml Whisper files start with the "ggml" magic and eleven int32 hparams,
+// the last of which is the ggml_ftype (plus a quantization version * 1000).
+std::string quantizationOf(const std::string &path)
+{
+    constexpr uint32_t kGgmlMagic = 0x67676d6c;
+    constexpr size_t kFtypeOffset = 4 + 10 * 4;
+    char header[kFtypeOffset + 4];
+    std::ifstream in(fs::u8path(path), std::ios::binary);
+    if (!in.read(header, sizeof(header)))
+        return "unknown";
+    uint32_t magic = 0;
+    int32_t ftype = 0;
+    std::memcpy(&magic, header, 4);
+    std::memcpy(&ftype, header + kFtypeOffset, 4);
+    if (magic != kGgmlMagic)
+        return "unknown";
+    switch (ftype % 1000) {
+    case 0: return "f32";
+    case 1: return "f16";
+    case 2: return "q4_0";
+    case 3: return "q4_1";
+    case 7: return "q8_0";
+    case 8: return "q5_0";
+    case 9: return "q5_1";
+    case 10: return "q2_k";
+    case 11: return "q3_k";
+    case 12: return "q4_k";
+    case 13: return "q5_k";
+    case 14: return "q6_k";
+    default: return "unknown";
+    }
+}
+
+} // namespace
+
+WhisperModel::WhisperModel(const std::string &path, bool useGpu)
+    : m_path(path)
+    , m_useGpu(useGpu)
+{
+    std::error_code error;
+    m_fileBytes = fs::file_size(fs::u8path(path), error);
+    if (error)
+        throw std::runtime_error("cannot open Whisper model " + path + ": " + error.message());
+    m_quantization = quantizationOf(path);
+
+    whisper_context_params params = whisper_context_default_params();
+    params.use_gpu = useGpu;
+    m_context = whisper_init_from_file_with_params_no_state(path.c_str(), params);
+    if (!m_context)
+        throw std::runtime_error("cannot load Whisper model " + path);
+}
+
+WhisperModel::~WhisperModel()
+{
+    for (whisper_state *state : m_idle)
+        whisper_free_state(state);
+    whisper_free(m_context);
+}
+
+whisper_state *WhisperModel::acquireState() const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_idle.empty()) {
+            whisper_state *state = m_idle.back();
+            m_idle.pop_back();
+            return state;
+        }
+    }
+    whisper_state *state = whisper_init_state(m_context);
+    if (!state)
+        throw std::runtime_error("cannot allocate Whisper state");
+    return state;
+}
+
+void WhisperModel::releaseState(whisper_state *state) const
+{
+    if (!state)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.push_back(state);
+}
+
+void WhisperModel::warmStates(int count) const
+{
+    while (idleStates() < count) {
+        whisper_state *state = whisper_init_state(m_context);
+        if (!state)
+            throw std::runtime_error("cannot allocate Whisper state");
+        releaseState(state);
+    }
+}
+
+void WhisperModel::trimStates(int keep) const
+{
+    std::vector<whisper_state *> freed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (int(m_idle.size()) > std::max(0, keep)) {
+            freed.push_back(m_idle.back());
+            m_idle.pop_back();
+        }
+    }
+    for (whisper_state *state : freed)
+        whisper_free_state(state);
+}
+
+int WhisperModel::idleStates() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return int(m_idle.size());
+}
+
+} // namespace vep
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct whisper_context;
+struct whisper_state;
+
+namespace vep {
+
+// Loaded Whisper.cpp weights, without decoder state: any number of
+// WhisperTranscribers (each with a whisper_state of its own) can run on one
+// model concurrently.
+//
+// whisper.cpp reads the file into buffers of its own, so a loaded model
+// holds its whole weights in memory; WhisperModelManager keeps that to one
+// copy per file per process. Quantized models (Q4/Q5/Q8, K-quants) load
+// the same way and take correspondingly less; quantization() reports which
+// one this is.
+class WhisperModel
+{
+public:
+    // Throws std::runtime_error if the model cannot be loaded.
+    explicit WhisperModel(const std::string &path, bool useGpu = false);
+    ~WhisperModel();
+
+    WhisperModel(const WhisperModel &) = delete;
+    WhisperModel &operator=(const WhisperModel &) = delete;
+
+    whisper_context *context() const { return m_context; }
+    const std::string &path() const { return m_path; }
+    bool usesGpu() const { return m_useGpu; }
+    uint64_t fileBytes() const { return m_fileBytes; }
+    // "f32", "f16", "q5_0", "q8_0"... from the file header.
+    const std::string &quantization() const { return m_quantization; }
+
+    // A decoder state for this model: an idle one if any, otherwise a new
+    // one. Allocating a state (KV caches, work buffers) costs tens to
+    // hundreds of MB and noticeable time, so states are handed back with
+    // releaseState() and reused by the next transcriber. Thread-safe; throws
+    // std::runtime_error if a state cannot be allocated.
+    whisper_state *acquireState() const;
+    void releaseState(whisper_state *state) const;
+    // Allocates idle states until `count` are waiting.
+    void warmStates(int count) const;
+    // Frees the idle states beyond `keep`.
+    void trimStates(int keep) const;
+    int idleStates() const;
+
+private:
+    std::string m_path;
+    bool m_useGpu;
+    uint64_t m_fileBytes = 0;
+    std::string m_quantization;
+    whisper_context *m_context = nullptr;
+
+    mutable std::mutex m_mutex;
+    mutable std::vector<whisper_state *> m_idle;
+};
+
+} // namespace vep
@@ -0,0 +1,197 @@
+#include "captions/WhisperModelManager.h"
+
+#include "captions/WhisperModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace vep {
+
+namespace {
+
+uint64_t residentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return uint64_t(counters.WorkingSetSize);
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)
+        == KERN_SUCCESS)
+        return uint64_t(info.resident_size);
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident))
+        return 0;
+    return resident * uint64_t(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+std::string canonicalPath(const std::string &path)
+{
+    std::error_code error;
+    const fs::path canonical = fs::weakly_canonical(fs::u8path(path), error);
+    return error ? path : canonical.u8string();
+}
+
+} // namespace
+
+WhisperModelManager &WhisperModelManager::instance()
+{
+    static WhisperModelManager manager;
+    return manager;
+}
+
+std::shared_ptr<const WhisperModel> WhisperModelManager::acquire(const std::string &path, bool useGpu)
+{
+    const Key key{canonicalPath(path), useGpu};
+    std::promise<Model> promise;
+    std::shared_future<Model> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry &entry = m_entries[key];
+        if (Model model = entry.model.lock()) {
+            touch(model);
+            return model;
+        }
+        if (entry.pending.valid())
+            pending = entry.pending;
+        else
+            entry.pending = promise.get_future().share();
+    }
+    // Someone else is loading it; rethrows their error, if they had one.
+    if (pending.valid())
+        return pending.get();
+
+    Model model;
+    WhisperModelInfo info;
+    try {
+        const uint64_t before = residentBytes();
+        const auto started = std::chrono::steady_clock::now();
+        model = std::make_shared<const WhisperModel>(key.first, useGpu);
+        model->warmStates(1);
+        info.loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        const uint64_t after = residentBytes();
+        info.residentBytes = after > before ? after - before : 0;
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    info.path = key.first;
+    info.quantization = model->quantization();
+    info.useGpu = useGpu;
+    info.fileBytes = model->fileBytes();
+
+    // Declared first so the models it takes are let go after the lock.
+    std::vector<Model> evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry &entry = m_entries[key];
+        entry.model = model;
+        entry.pending = {};
+        entry.info = info;
+        touch(model);
+        evicted = trimLocked();
+    }
+    promise.set_value(model);
+    return model;
+}
+
+void WhisperModelManager::setWarmModels(int count)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_warmModels = std::max(0, count);
+    }
+    trim();
+}
+
+int WhisperModelManager::warmModels() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_warmModels;
+}
+
+void WhisperModelManager::trim()
+{
+    std::vector<Model> evicted;
+    std::vector<Model> warm;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evicted = trimLocked();
+        warm = m_warm;
+    }
+    // Unlocked: freeing decoder states and whisper contexts takes a while,
+    // and every acquire() would wait for it.
+    for (const Model &model : warm)
+        model->trimStates(1);
+}
+
+std::vector<WhisperModelInfo> WhisperModelManager::loaded() const
+{
+    std::vector<WhisperModelInfo> result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &[key, entry] : m_entries) {
+        const Model model = entry.model.lock();
+        if (!model)
+            continue;
+        WhisperModelInfo info = entry.info;
+        info.idleStates = model->idleStates();
+        const bool warm = std::find(m_warm.begin(), m_warm.end(), model) != m_warm.end();
+        // Neither the local copy nor the warm reference is a job.
+        info.users = model.use_count() - 1 - (warm ? 1 : 0);
+        result.push_back(std::move(info));
+    }
+    return result;
+}
+
+void WhisperModelManager::touch(const Model &model)
+{
+    m_warm.erase(std::remove(m_warm.begin(), m_warm.end(), model), m_warm.end());
+    m_warm.insert(m_warm.begin(), model);
+}
+
+std::vector<WhisperModelManager::Model> WhisperModelManager::trimLocked()
+{
+    std::vector<Model> evicted;
+    if (int(m_warm.size()) > m_warmModels) {
+        evicted.assign(std::make_move_iterator(m_warm.begin() + m_warmModels),
+                       std::make_move_iterator(m_warm.end()));
+        m_warm.resize(size_t(m_warmModels));
+    }
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.model.expired() && !it->second.pending.valid())
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+    return evicted;
+}
+
+} // namespace vep
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vep {
+
+class WhisperModel;
+
+struct WhisperModelInfo
+{
+    std::string path;
+    std::string quantization;
+    bool useGpu = false;
+    uint64_t fileBytes = 0;
+    // Growth of the process's resident set over the load (weights plus the
+    // warm decoder state). Approximate: other threads allocate too.
+    uint64_t residentBytes = 0;
+    double loadSeconds = 0.0;
+    int idleStates = 0;
+    // Jobs holding the model right now (the manager's warm reference aside).
+    long users = 0;
+};
+
+// Process-wide owner of loaded Whisper models. Every caption job asking for
+// the same file gets the same WhisperModel, and jobs that ask while it is
+// still loading wait for that one load instead of starting their own.
+//
+// The most recently used models (warmModels, default one) stay loaded with
+// one idle decoder state after their last job finishes, so the next caption
+// run starts transcribing at once. trim() drops whatever is beyond that.
+class WhisperModelManager
+{
+public:
+    static WhisperModelManager &instance();
+
+    // Throws std::runtime_error if the model cannot be loaded.
+    std::shared_ptr<const WhisperModel> acquire(const std::string &path, bool useGpu = false);
+    // acquire() for its side effect, e.g. when the captions panel opens.
+    void preload(const std::string &path, bool useGpu = false) { acquire(path, useGpu); }
+
+    void setWarmModels(int count);
+    int warmModels() const;
+    // Frees idle decoder states beyond the warm one and unloads models that
+    // are neither in use nor among the warm ones. Call when a job ends.
+    void trim();
+
+    std::vector<WhisperModelInfo> loaded() const;
+
+private:
+    using Key = std::pair<std::string, bool>;
+    using Model = std::shared_ptr<const WhisperModel>;
+
+    struct Entry
+    {
+        std::weak_ptr<const WhisperModel> model;
+        std::shared_future<Model> pending; // valid while loading
+        WhisperModelInfo info;
+    };
+
+    void touch(const Model &model);
+    // Drops the warm references beyond m_warmModels and forgets unloaded
+    // entries. The references dropped are returned, for the caller to let
+    // go of once the mutex is released: the last one frees its model.
+    std::vector<Model> trimLocked();
+
+    mutable std::mutex m_mutex;
+    std::map<Key, Entry> m_entries;
+    std::vector<Model> m_warm; // most recently used first
+    int m_warmModels = 1;
+};
+
+} // namespace vep
@@ -0,0 +1,114 @@
+#include "captions/WhisperTranscriber.h"
+
+#include "captions/WhisperModel.h"
+
+#include <whisper.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+// Whisper accepts at most half its 448-token context as prompt; a short
+// tail is enough to keep spelling and punctuation consistent.
+constexpr size_t kMaxPromptTokens = 64;
+
+bool isWordStart(const char *text)
+{
+    return text[0] == ' ' || text[0] == '\0';
+}
+
+} // namespace
+
+WhisperTranscriber::WhisperTranscriber(std::shared_ptr<const WhisperModel> model, WhisperOptions options)
+    : m_model(std::move(model))
+    , m_options(std::move(options))
+{
+    m_state = m_model->acquireState();
+}
+
+WhisperTranscriber::~WhisperTranscriber()
+{
+    m_model->releaseState(m_state);
+}
+
+std::vector<CaptionSegment> WhisperTranscriber::transcribe(const float *samples, int count, double offsetSeconds,
+                                                           const std::atomic<bool> *abort)
+{
+    whisper_context *context = m_model->context();
+
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = m_options.threads;
+    params.language = m_options.language.c_str();
+    params.translate = m_options.translate;
+    params.token_timestamps = true;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_special = false;
+    params.print_timestamps = false;
+    params.prompt_tokens = m_prompt.empty() ? nullptr : m_prompt.data();
+    params.prompt_n_tokens = int(m_prompt.size());
+    if (abort) {
+        params.abort_callback = [](void *flag) { return static_cast<const std::atomic<bool> *>(flag)->load(); };
+        params.abort_callback_user_data = const_cast<std::atomic<bool> *>(abort);
+    }
+
+    if (whisper_full_with_state(context, m_state, params, samples, count) != 0 && !(abort && *abort))
+        throw std::runtime_error("Whisper transcription failed");
+
+    const whisper_token eot = whisper_token_eot(context);
+    std::vector<CaptionSegment> segments;
+    std::vector<int32_t> tokens;
+    const int segmentCount = whisper_full_n_segments_from_state(m_state);
+    for (int s = 0; s < segmentCount; ++s) {
+        if (whisper_full_get_segment_no_speech_prob_from_state(m_state, s) > m_options.noSpeechThreshold)
+            continue;
+
+        CaptionSegment segment;
+        // Whisper reports times in centiseconds.
+        segment.start = offsetSeconds + whisper_full_get_segment_t0_from_state(m_state, s) * 0.01;
+        segment.end = offsetSeconds + whisper_full_get_segment_t1_from_state(m_state, s) * 0.01;
+        segment.text = whisper_full_get_segment_text_from_state(m_state, s);
+
+        // Byte-pair tokens that start with a space begin a new word; the
+        // rest (including partial UTF-8 sequences) continue the current one.
+        const int tokenCount = whisper_full_n_tokens_from_state(m_state, s);
+        float probabilitySum = 0.0f;
+        int pieces = 0;
+        for (int t = 0; t < tokenCount; ++t) {
+            const whisper_token_data data = whisper_full_get_token_data_from_state(m_state, s, t);
+            if (data.id >= eot)
+                continue;
+            tokens.push_back(data.id);
+            const char *text = whisper_full_get_token_text_from_state(context, m_state, s, t);
+            if (segment.words.empty() || isWordStart(text)) {
+                if (!segment.words.empty())
+                    segment.words.back().probability = probabilitySum / float(pieces);
+                CaptionWord word;
+                word.start = offsetSeconds + data.t0 * 0.01;
+                word.text = text;
+                segment.words.push_back(std::move(word));
+                probabilitySum = 0.0f;
+                pieces = 0;
+            } else {
+                segment.words.back().text += text;
+            }
+            segment.words.back().end = offsetSeconds + data.t1 * 0.01;
+            probabilitySum += data.p;
+            ++pieces;
+        }
+        if (!segment.words.empty())
+            segment.words.back().probability = probabilitySum / float(pieces);
+        segments.push_back(std::move(segment));
+    }
+
+    if (tokens.size() > kMaxPromptTokens)
+        tokens.erase(tokens.begin(), tokens.end() - ptrdiff_t(kMaxPromptTokens));
+    if (!tokens.empty())
+        m_prompt = std::move(tokens);
+    return segments;
+}
+
+} // namespace vep
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "captions/Caption.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct whisper_state;
+
+namespace vep {
+
+class WhisperModel;
+
+struct WhisperOptions
+{
+    std::string language = "auto";
+    bool translate = false;
+    int threads = 4;
+    // Segments Whisper itself rates as more likely silence than speech are
+    // dropped; this catches most hallucinated text on music beds.
+    float noSpeechThreshold = 0.6f;
+};
+
+// One decoder state on a shared WhisperModel, borrowed from the model's
+// idle states and handed back on destruction. transcribe() takes 16 kHz
+// mono audio (at most one 30 s window is ideal) and returns segments with
+// word timings, shifted by the window's offset in the media. The tail of
+// each result is kept as the prompt for the next call so that consecutive
+// windows of one recording read as a single text.
+class WhisperTranscriber
+{
+public:
+    static constexpr int kSampleRate = 16000;
+
+    // Throws std::runtime_error if the state cannot be allocated.
+    WhisperTranscriber(std::shared_ptr<const WhisperModel> model, WhisperOptions options);
+    ~WhisperTranscriber();
+
+    WhisperTranscriber(const WhisperTranscriber &) = delete;
+    WhisperTranscriber &operator=(const WhisperTranscriber &) = delete;
+
+    // Returns what was recognised before an abort if `abort` is set while
+    // running. Throws std::runtime_error on a Whisper failure.
+    std::vector<CaptionSegment> transcribe(const float *samples, int count, double offsetSeconds,
+                                           const std::atomic<bool> *abort = nullptr);
+
+    // Forgets the carried-over prompt, e.g. before a non-contiguous window.
+    void resetContext() { m_prompt.clear(); }
+
+private:
+    std::shared_ptr<const WhisperModel> m_model;
+    WhisperOptions m_options;
+    whisper_state *m_state = nullptr;
+    std::vector<int32_t> m_prompt; // whisper_token
+};
+
+} // namespace vep
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace vep {
+
+// Little helpers for the small binary cache formats (beat maps, peaks,
+// tracks...). Values are written in host byte order; every format starts
+// with a magic and version so a cache written elsewhere is simply rejected
+// and recomputed.
+class ByteWriter
+{
+public:
+    template <typename T>
+    void put(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "POD values only");
+        const auto *p = reinterpret_cast<const uint8_t *>(&value);
+        m_bytes.insert(m_bytes.end(), p, p + sizeof(T));
+    }
+
+    template <typename T>
+    void putArray(const std::vector<T> &values)
+    {
+        put(uint64_t(values.size()));
+        putRaw(values.data(), values.size() * sizeof(T));
+    }
+
+    void putString(const std::string &text)
+    {
+        put(uint32_t(text.size()));
+        putRaw(text.data(), text.size());
+    }
+
+    void putMagic(const char (&magic)[9]) { putRaw(magic, 8); }
+
+    void putRaw(const void *data, size_t size)
+    {
+        const auto *p = static_cast<const uint8_t *>(data);
+        m_bytes.insert(m_bytes.end(), p, p + size);
+    }
+
+    const std::vector<uint8_t> &bytes() const { return m_bytes; }
+    std::vector<uint8_t> take() { return std::move(m_bytes); }
+
+private:
+    std::vector<uint8_t> m_bytes;
+};
+
+// Throws std::runtime_error on truncated input.
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+    explicit ByteReader(const std::vector<uint8_t> &bytes) : ByteReader(bytes.data(), bytes.size()) {}
+
+    template <typename T>
+    T get()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "POD values only");
+        T value;
+        getRaw(&value, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    std::vector<T> getArray()
+    {
+        const uint64_t count = get<uint64_t>();
+        if (count > (m_size - m_pos) / sizeof(T))
+            throw std::runtime_error("truncated cache record");
+        std::vector<T> values(static_cast<size_t>(count));
+        getRaw(values.data(), values.size() * sizeof(T));
+        return values;
+    }
+
+    std::string getString()
+    {
+        const uint32_t size = get<uint32_t>();
+        if (size > m_size - m_pos)
+            throw std::runtime_error("truncated cache record");
+        std::string text(reinterpret_cast<const char *>(m_data + m_pos), size);
+        m_pos += size;
+        return text;
+    }
+
+    void getRaw(void *out, size_t size)
+    {
+        if (size > m_size - m_pos)
+            throw std::runtime_error("truncated cache record");
+        std::memcpy(out, m_data + m_pos, size);
+        m_pos += size;
+    }
+
+    void expectMagic(const char (&magic)[9])
+    {
+        char found[8];
+        getRaw(found, 8);
+        if (std::memcmp(found, magic, 8))
+            throw std::runtime_error("unexpected cache record type");
+    }
+
+    size_t remaining() const { return m_size - m_pos; }
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+};
+
+} // namespace vep
@@ -0,0 +1,169 @@
+#include "core/ContentHash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const unsigned char *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+inline uint32_t read32(const unsigned char *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input)
+{
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+Hasher64::Hasher64(uint64_t seed)
+    : m_acc{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1}
+    , m_seed(seed)
+{
+}
+
+void Hasher64::update(const void *data, size_t size)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    m_total += size;
+
+    if (m_buffered + size < 32) {
+        std::memcpy(m_buffer + m_buffered, p, size);
+        m_buffered += size;
+        return;
+    }
+    if (m_buffered) {
+        const size_t fill = 32 - m_buffered;
+        std::memcpy(m_buffer + m_buffered, p, fill);
+        for (int i = 0; i < 4; ++i)
+            m_acc[i] = round(m_acc[i], read64(m_buffer + 8 * i));
+        p += fill;
+        size -= fill;
+        m_buffered = 0;
+    }
+    while (size >= 32) {
+        for (int i = 0; i < 4; ++i)
+            m_acc[i] = round(m_acc[i], read64(p + 8 * i));
+        p += 32;
+        size -= 32;
+    }
+    std::memcpy(m_buffer, p, size);
+    m_buffered = size;
+}
+
+uint64_t Hasher64::digest() const
+{
+    uint64_t h;
+    if (m_total >= 32) {
+        h = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (int i = 0; i < 4; ++i)
+            h = mergeRound(h, m_acc[i]);
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += m_total;
+
+    const unsigned char *p = m_buffer;
+    size_t remaining = m_buffered;
+    while (remaining >= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+        remaining -= 8;
+    }
+    if (remaining >= 4) {
+        h ^= uint64_t(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+        remaining -= 4;
+    }
+    while (remaining--) {
+        h ^= uint64_t(*p++) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::string ContentHash::hex() const
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+ContentHash ContentHash::fromHex(const std::string &hex)
+{
+    ContentHash hash;
+    try {
+        hash.value = std::stoull(hex, nullptr, 16);
+    } catch (const std::exception &) {
+        hash.value = 0;
+    }
+    return hash;
+}
+
+ContentHash ContentHash::ofFile(const std::string &path, const std::function<bool()> &keepGoing)
+{
+    std::unique_ptr<FILE, int (*)(FILE *)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!file)
+        throw std::runtime_error("cannot open " + path);
+    Hasher64 hasher;
+    std::vector<unsigned char> buffer(1 << 20);
+    size_t n;
+    while ((n = std::fread(buffer.data(), 1, buffer.size(), file.get())) > 0) {
+        if (keepGoing && !keepGoing())
+            return ContentHash();
+        hasher.update(buffer.data(), n);
+    }
+    if (std::ferror(file.get()))
+        throw std::runtime_error("read error in " + path);
+    return ContentHash{hasher.digest()};
+}
+
+ContentHash ContentHash::ofBytes(const void *data, size_t size)
+{
+    Hasher64 hasher;
+    hasher.update(data, size);
+    return ContentHash{hasher.digest()};
+}
+
+} // namespace vep
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace vep {
+
+// Streaming XXH64. Fast enough (several GB/s) to hash whole media files on
+// import, and stable across platforms, so it can key on-disk caches.
+class Hasher64
+{
+public:
+    explicit Hasher64(uint64_t seed = 0);
+
+    void update(const void *data, size_t size);
+    template <typename T>
+    void updateValue(const T &value)
+    {
+        update(&value, sizeof(value));
+    }
+    void update(const std::string &text) { update(text.data(), text.size()); }
+
+    uint64_t digest() const;
+
+private:
+    uint64_t m_acc[4];
+    uint64_t m_seed;
+    uint64_t m_total = 0;
+    unsigned char m_buffer[32];
+    size_t m_buffered = 0;
+};
+
+struct ContentHash
+{
+    uint64_t value = 0;
+
+    bool isNull() const { return value == 0; }
+    std::string hex() const;
+    static ContentHash fromHex(const std::string &hex);
+
+    // Hash of the file's bytes; throws std::runtime_error if unreadable.
+    // keepGoing is polled once per megabyte read; if it returns false the
+    // read stops and a null hash is returned.
+    static ContentHash ofFile(const std::string &path, const std::function<bool()> &keepGoing = {});
+    static ContentHash ofBytes(const void *data, size_t size);
+
+    bool operator==(const ContentHash &other) const { return value == other.value; }
+    bool operator!=(const ContentHash &other) const { return value != other.value; }
+    bool operator<(const ContentHash &other) const { return value < other.value; }
+};
+
+} // namespace vep
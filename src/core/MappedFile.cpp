@@ -0,0 +1,95 @@
+#include "core/MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vep {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path)
+{
+    const int wideLength = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring widePath(size_t(wideLength), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, widePath.data(), wideLength);
+
+    // FILE_SHARE_DELETE lets the cache replace the entry while it is mapped.
+    m_file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        m_file = nullptr;
+        throw std::runtime_error("cannot open " + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) {
+        CloseHandle(m_file);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    m_size = size_t(size.QuadPart);
+    if (m_size == 0)
+        return;
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping)
+        m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data) {
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        throw std::runtime_error("cannot map " + path);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file)
+        CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + path);
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    m_size = size_t(info.st_size);
+    if (m_size > 0) {
+        void *mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("cannot map " + path);
+        }
+        m_data = static_cast<const uint8_t *>(mapping);
+    }
+    // The mapping keeps the file alive; the descriptor is not needed.
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        ::munmap(const_cast<uint8_t *>(m_data), m_size);
+}
+
+#endif
+
+} // namespace vep
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vep {
+
+// Read-only memory mapping of a whole file. Pages are faulted in on access,
+// so readers of large cache files (peaks, masks) touch only what they draw.
+class MappedFile
+{
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
+
+} // namespace vep
@@ -0,0 +1,232 @@
+#include "core/MediaCache.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace vep {
+
+namespace {
+
+constexpr const char *kMemoFile = "hashes.tsv";
+// Lines the memo may carry beyond twice its live entries before it is
+// compacted, so small memos are never rewritten.
+constexpr size_t kMemoSlack = 256;
+
+std::string defaultRoot()
+{
+#ifdef _WIN32
+    const char *base = std::getenv("LOCALAPPDATA");
+    return std::string(base ? base : ".") + "/VideoEditorPro/cache/media";
+#else
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        return std::string(xdg) + "/VideoEditorPro/media";
+    const char *home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.cache/VideoEditorPro/media";
+#endif
+}
+
+int64_t modificationTime(const fs::path &path)
+{
+    return int64_t(fs::last_write_time(path).time_since_epoch().count());
+}
+
+} // namespace
+
+MediaCache &MediaCache::instance()
+{
+    static MediaCache cache(defaultRoot());
+    return cache;
+}
+
+MediaCache::MediaCache(std::string root)
+    : m_root(std::move(root))
+{
+}
+
+void MediaCache::setRoot(const std::string &root)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_root = root;
+    m_memo.clear();
+    m_memoLines = 0;
+    m_memoLoaded = false;
+}
+
+std::string MediaCache::root() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_root;
+}
+
+void MediaCache::loadMemo()
+{
+    m_memoLoaded = true;
+    std::ifstream in(fs::path(m_root) / kMemoFile);
+    std::string line;
+    while (std::getline(in, line)) {
+        ++m_memoLines;
+        std::istringstream fields(line);
+        FileStamp stamp;
+        std::string hex, path;
+        if (!(fields >> stamp.size >> stamp.mtime >> hex) || !std::getline(fields >> std::ws, path))
+            continue;
+        stamp.hash = ContentHash::fromHex(hex);
+        m_memo[path] = stamp;
+    }
+}
+
+void MediaCache::appendMemo(const std::string &path, const FileStamp &stamp)
+{
+    m_memo[path] = stamp;
+    std::error_code error;
+    fs::create_directories(m_root, error);
+    {
+        std::ofstream out(fs::path(m_root) / kMemoFile, std::ios::app);
+        out << stamp.size << '\t' << stamp.mtime << '\t' << stamp.hash.hex() << '\t' << path << '\n';
+        if (!out)
+            return;
+    }
+    if (++m_memoLines > 2 * m_memo.size() + kMemoSlack)
+        compactMemo();
+}
+
+void MediaCache::compactMemo()
+{
+    std::error_code error;
+    for (auto it = m_memo.begin(); it != m_memo.end();) {
+        if (fs::exists(it->first, error))
+            ++it;
+        else
+            it = m_memo.erase(it);
+    }
+
+    const fs::path target = fs::path(m_root) / kMemoFile;
+    fs::path temporary = target;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        for (const auto &[path, stamp] : m_memo)
+            out << stamp.size << '\t' << stamp.mtime << '\t' << stamp.hash.hex() << '\t' << path << '\n';
+        if (!out.flush()) {
+            fs::remove(temporary, error);
+            return;
+        }
+    }
+    fs::rename(temporary, target, error);
+    if (error) {
+        fs::remove(temporary, error);
+        return;
+    }
+    m_memoLines = m_memo.size();
+}
+
+ContentHash MediaCache::hashOf(const std::string &mediaPath, const std::function<bool()> &keepGoing)
+{
+    std::error_code error;
+    const fs::path path = fs::absolute(mediaPath, error);
+    const std::string key = path.string();
+    const uint64_t size = fs::file_size(path, error);
+    if (error)
+        throw std::runtime_error("cannot stat " + mediaPath);
+    const int64_t mtime = modificationTime(path);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_memoLoaded)
+            loadMemo();
+        auto it = m_memo.find(key);
+        if (it != m_memo.end() && it->second.size == size && it->second.mtime == mtime)
+            return it->second.hash;
+    }
+
+    const ContentHash hash = ContentHash::ofFile(key, keepGoing);
+    if (hash.isNull())
+        return hash;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    appendMemo(key, FileStamp{size, mtime, hash});
+    return hash;
+}
+
+std::optional<ContentHash> MediaCache::knownHashOf(const std::string &mediaPath)
+{
+    std::error_code error;
+    const fs::path path = fs::absolute(mediaPath, error);
+    const uint64_t size = fs::file_size(path, error);
+    if (error)
+        return std::nullopt;
+    const auto modified = fs::last_write_time(path, error);
+    if (error)
+        return std::nullopt;
+    const int64_t mtime = int64_t(modified.time_since_epoch().count());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_memoLoaded)
+        loadMemo();
+    auto it = m_memo.find(path.string());
+    if (it == m_memo.end() || it->second.size != size || it->second.mtime != mtime)
+        return std::nullopt;
+    return it->second.hash;
+}
+
+std::string MediaCache::entryPath(ContentHash hash, const std::string &kind) const
+{
+    const std::string hex = hash.hex();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (fs::path(m_root) / hex.substr(0, 2) / (hex + '.' + kind)).string();
+}
+
+bool MediaCache::contains(ContentHash hash, const std::string &kind) const
+{
+    std::error_code error;
+    return fs::is_regular_file(entryPath(hash, kind), error);
+}
+
+std::optional<std::vector<uint8_t>> MediaCache::read(ContentHash hash, const std::string &kind) const
+{
+    std::ifstream in(entryPath(hash, kind), std::ios::binary | std::ios::ate);
+    if (!in)
+        return std::nullopt;
+    std::vector<uint8_t> bytes(size_t(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(bytes.data()), std::streamsize(bytes.size())))
+        return std::nullopt;
+    return bytes;
+}
+
+void MediaCache::write(ContentHash hash, const std::string &kind, const std::vector<uint8_t> &bytes)
+{
+    const fs::path target = entryPath(hash, kind);
+    std::error_code error;
+    fs::create_directories(target.parent_path(), error);
+
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    fs::path temporary = target;
+    temporary += ".tmp" + std::to_string(rng());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(bytes.data()), std::streamsize(bytes.size()));
+        if (!out.flush())
+            throw std::runtime_error("cannot write " + temporary.string());
+    }
+    fs::rename(temporary, target, error);
+    if (error) {
+        fs::remove(temporary, error);
+        throw std::runtime_error("cannot write " + target.string());
+    }
+}
+
+void MediaCache::remove(ContentHash hash, const std::string &kind)
+{
+    std::error_code error;
+    fs::remove(entryPath(hash, kind), error);
+}
+
+} // namespace vep
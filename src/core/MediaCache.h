@@ -0,0 +1,72 @@
+#pragma once
+
+#include "core/ContentHash.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// On-disk cache of per-media analysis results (beat maps, waveform peaks,
+// captions, masks...), keyed by the content hash of the source file and a
+// short "kind" tag. Entries live at <root>/<hh>/<hash>.<kind>, so renaming or
+// moving a file keeps its analysis, and two copies of one file share it.
+//
+// Hashing a large file is the expensive part, so hashOf() memoises the hash
+// by (path, size, mtime) in <root>/hashes.tsv. The memo is append-only and
+// is rewritten without superseded lines and deleted files once those make
+// up most of it.
+class MediaCache
+{
+public:
+    // Process-wide cache, rooted under the user's cache directory until the
+    // application calls setRoot().
+    static MediaCache &instance();
+
+    explicit MediaCache(std::string root);
+
+    void setRoot(const std::string &root);
+    std::string root() const;
+
+    // Throws std::runtime_error if the file cannot be read. Returns a null
+    // hash (and memoises nothing) if keepGoing, polled while a file that is
+    // not memoised is read, returns false.
+    ContentHash hashOf(const std::string &mediaPath, const std::function<bool()> &keepGoing = {});
+    // The memoised hash if the file has not changed since hashOf() last saw
+    // it; never reads the file, so render paths can call it per frame. The
+    // import or the analysis job does the hashing.
+    std::optional<ContentHash> knownHashOf(const std::string &mediaPath);
+
+    std::string entryPath(ContentHash hash, const std::string &kind) const;
+    bool contains(ContentHash hash, const std::string &kind) const;
+    std::optional<std::vector<uint8_t>> read(ContentHash hash, const std::string &kind) const;
+    // Atomic (write to a temporary, then rename). Throws std::runtime_error.
+    void write(ContentHash hash, const std::string &kind, const std::vector<uint8_t> &bytes);
+    void remove(ContentHash hash, const std::string &kind);
+
+private:
+    struct FileStamp
+    {
+        uint64_t size;
+        int64_t mtime;
+        ContentHash hash;
+    };
+
+    void loadMemo();
+    void appendMemo(const std::string &path, const FileStamp &stamp);
+    void compactMemo();
+
+    mutable std::mutex m_mutex;
+    std::string m_root;
+    bool m_memoLoaded = false;
+    std::map<std::string, FileStamp> m_memo;
+    // Lines in hashes.tsv, superseded ones included.
+    size_t m_memoLines = 0;
+};
+
+} // namespace vep
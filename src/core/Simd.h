@@ -0,0 +1,14 @@
+#pragma once
+
+// Which vector instruction set the build targets, and its intrinsics:
+// VEP_SIMD_SSE2 (x86-64, or x86 built for SSE2) or VEP_SIMD_NEON (ARM),
+// neither for a scalar build. Code with its own intrinsics tests these;
+// arithmetic that fits four float lanes uses Float4 (core/SimdFloat4.h).
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEP_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VEP_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "core/Simd.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace vep {
+
+// Four float lanes. The audio processors keep one channel per lane so a
+// biquad or envelope step runs on up to four channels in one instruction;
+// the image code (guided upsampling, lens remaps, scene signatures) runs
+// four pixels or bins at once.
+struct Float4
+{
+#if defined(VEP_SIMD_SSE2)
+    __m128 v;
+    Float4() : v(_mm_setzero_ps()) {}
+    explicit Float4(__m128 x) : v(x) {}
+    explicit Float4(float x) : v(_mm_set1_ps(x)) {}
+    static Float4 load(const float *p) { return Float4(_mm_loadu_ps(p)); }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+#elif defined(VEP_SIMD_NEON)
+    float32x4_t v;
+    Float4() : v(vdupq_n_f32(0.0f)) {}
+    explicit Float4(float32x4_t x) : v(x) {}
+    explicit Float4(float x) : v(vdupq_n_f32(x)) {}
+    static Float4 load(const float *p) { return Float4(vld1q_f32(p)); }
+    void store(float *p) const { vst1q_f32(p, v); }
+#else
+    float v[4];
+    Float4() : v{0.0f, 0.0f, 0.0f, 0.0f} {}
+    explicit Float4(float x) : v{x, x, x, x} {}
+    static Float4 load(const float *p)
+    {
+        Float4 r;
+        std::memcpy(r.v, p, sizeof(r.v));
+        return r;
+    }
+    void store(float *p) const { std::memcpy(p, v, sizeof(v)); }
+#endif
+};
+
+#if defined(VEP_SIMD_SSE2)
+
+inline Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.v, b.v)); }
+inline Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+inline Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+inline Float4 min(Float4 a, Float4 b) { return Float4(_mm_min_ps(a.v, b.v)); }
+inline Float4 max(Float4 a, Float4 b) { return Float4(_mm_max_ps(a.v, b.v)); }
+inline Float4 abs(Float4 a)
+{
+    return Float4(_mm_and_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))));
+}
+// Lanes 0 and 2 of a followed by lanes 0 and 2 of b, i.e. the left channel
+// of four interleaved stereo frames; oddLanes() gives the right channel.
+inline Float4 evenLanes(Float4 a, Float4 b) { return Float4(_mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(2, 0, 2, 0))); }
+inline Float4 oddLanes(Float4 a, Float4 b) { return Float4(_mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(3, 1, 3, 1))); }
+
+// Bit-level log2/exp2 approximations, accurate to ~2e-5, which is far below
+// what a gain computer working in dB can resolve.
+inline Float4 fastLog2(Float4 x)
+{
+    const __m128i bits = _mm_castps_si128(x.v);
+    const __m128 exponent = _mm_cvtepi32_ps(
+        _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    const __m128 m = _mm_castsi128_ps(
+        _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+    // log2(m) = 2/ln2 * atanh(t), t = (m - 1) / (m + 1) <= 1/3 for m in [1, 2).
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+    const __m128 t2 = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(1.0f / 7.0f);
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 5.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 3.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), one);
+    p = _mm_mul_ps(_mm_mul_ps(p, t), _mm_set1_ps(2.88539008f));
+    return Float4(_mm_add_ps(p, exponent));
+}
+
+inline Float4 fastExp2(Float4 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 clamped = _mm_max_ps(_mm_min_ps(x.v, _mm_set1_ps(126.0f)), _mm_set1_ps(-126.0f));
+    // Floor via truncation corrected for negative values.
+    __m128 ip = _mm_cvtepi32_ps(_mm_cvttps_epi32(clamped));
+    ip = _mm_sub_ps(ip, _mm_and_ps(_mm_cmpgt_ps(ip, clamped), one));
+    const __m128 f = _mm_sub_ps(clamped, ip);
+    // Taylor series of 2^f on [0, 1).
+    __m128 p = _mm_set1_ps(1.5403530e-4f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.3333558e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.6181291e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.5504109e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.4022651e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.9314718e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), one);
+    const __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(ip), _mm_set1_epi32(127)), 23);
+    return Float4(_mm_mul_ps(p, _mm_castsi128_ps(e)));
+}
+
+#elif defined(VEP_SIMD_NEON)
+
+inline Float4 operator+(Float4 a, Float4 b) { return Float4(vaddq_f32(a.v, b.v)); }
+inline Float4 operator-(Float4 a, Float4 b) { return Float4(vsubq_f32(a.v, b.v)); }
+inline Float4 operator*(Float4 a, Float4 b) { return Float4(vmulq_f32(a.v, b.v)); }
+inline Float4 min(Float4 a, Float4 b) { return Float4(vminq_f32(a.v, b.v)); }
+inline Float4 max(Float4 a, Float4 b) { return Float4(vmaxq_f32(a.v, b.v)); }
+inline Float4 abs(Float4 a) { return Float4(vabsq_f32(a.v)); }
+inline Float4 evenLanes(Float4 a, Float4 b) { return Float4(vuzpq_f32(a.v, b.v).val[0]); }
+inline Float4 oddLanes(Float4 a, Float4 b) { return Float4(vuzpq_f32(a.v, b.v).val[1]); }
+
+inline Float4 fastLog2(Float4 x)
+{
+    float lanes[4];
+    x.store(lanes);
+    for (float &l : lanes)
+        l = std::log2(l);
+    return Float4::load(lanes);
+}
+
+inline Float4 fastExp2(Float4 x)
+{
+    float lanes[4];
+    x.store(lanes);
+    for (float &l : lanes)
+        l = std::exp2(l);
+    return Float4::load(lanes);
+}
+
+#else
+
+#define VEP_FLOAT4_LANEWISE(expr)   \
+    Float4 r;                       \
+    for (int i = 0; i < 4; ++i)     \
+        r.v[i] = (expr);            \
+    return r
+
+inline Float4 operator+(Float4 a, Float4 b) { VEP_FLOAT4_LANEWISE(a.v[i] + b.v[i]); }
+inline Float4 operator-(Float4 a, Float4 b) { VEP_FLOAT4_LANEWISE(a.v[i] - b.v[i]); }
+inline Float4 operator*(Float4 a, Float4 b) { VEP_FLOAT4_LANEWISE(a.v[i] * b.v[i]); }
+inline Float4 min(Float4 a, Float4 b) { VEP_FLOAT4_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline Float4 max(Float4 a, Float4 b) { VEP_FLOAT4_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline Float4 abs(Float4 a) { VEP_FLOAT4_LANEWISE(std::fabs(a.v[i])); }
+inline Float4 evenLanes(Float4 a, Float4 b) { VEP_FLOAT4_LANEWISE(i < 2 ? a.v[2 * i] : b.v[2 * i - 4]); }
+inline Float4 oddLanes(Float4 a, Float4 b) { VEP_FLOAT4_LANEWISE(i < 2 ? a.v[2 * i + 1] : b.v[2 * i - 3]); }
+inline Float4 fastLog2(Float4 x) { VEP_FLOAT4_LANEWISE(std::log2(x.v[i])); }
+inline Float4 fastExp2(Float4 x) { VEP_FLOAT4_LANEWISE(std::exp2(x.v[i])); }
+
+#undef VEP_FLOAT4_LANEWISE
+
+#endif
+
+inline Float4 &operator+=(Float4 &a, Float4 b) { return a = a + b; }
+inline Float4 &operator*=(Float4 &a, Float4 b) { return a = a * b; }
+
+// Recursive filters decay into denormals on silence, which costs ~100x per
+// operation on x86. Processors hold one of these for the duration of a block.
+class ScopedFlushDenormals
+{
+public:
+#if defined(VEP_SIMD_SSE2)
+    ScopedFlushDenormals() : m_saved(_mm_getcsr()) { _mm_setcsr(m_saved | 0x8040); }
+    ~ScopedFlushDenormals() { _mm_setcsr(m_saved); }
+
+private:
+    unsigned int m_saved;
+#else
+    ScopedFlushDenormals() = default;
+#endif
+};
+
+} // namespace vep
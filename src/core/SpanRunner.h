@@ -0,0 +1,94 @@
+#pragma once
+
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <optional>
+#include <vector>
+
+namespace vep {
+
+// Runs a per-frame analysis of a video file (scene scores, camera motion)
+// as concurrent spans, since decoding dominates and one reader per span
+// scales with the cores. The file is cut into one span per pool worker,
+// none shorter than minSpanFrames; without a frame count it is one span.
+//
+// measure(begin, end, done, cancel) runs on a pool thread. It analyses
+// frames [begin, end), or to the end of the stream if end < 0, returns one
+// value per frame from `begin` on, adds each to `done` and stops early once
+// `cancel` is set. A span that comes back short (frames that would not
+// decode, a frame count that overstates the stream) is padded with T{} if a
+// later span has frames, so every value stays on its frame; otherwise the
+// stream ended there.
+//
+// progress gets the analysed fraction on the calling thread; returning
+// false cancels, and nullopt is returned. The first exception a span throws
+// is rethrown. Must not be called from a task of `pool`.
+template <typename T, typename Measure>
+std::optional<std::vector<T>> runSpans(ThreadPool &pool, int64_t totalFrames, int64_t minSpanFrames,
+                                       const std::function<bool(double)> &progress, Measure &&measure)
+{
+    const int64_t spans = totalFrames > 0 ? std::clamp<int64_t>(totalFrames / std::max<int64_t>(1, minSpanFrames),
+                                                                1, std::max(1, pool.threadCount()))
+                                          : 1;
+
+    std::atomic<int64_t> done{0};
+    std::atomic<bool> cancel{false};
+    std::vector<std::future<std::vector<T>>> futures;
+    std::vector<int64_t> lengths;
+    for (int64_t i = 0; i < spans; ++i) {
+        const int64_t begin = totalFrames * i / spans;
+        // The last span runs to the end of the stream, wherever that is.
+        const int64_t end = i + 1 == spans ? -1 : totalFrames * (i + 1) / spans;
+        lengths.push_back(end < 0 ? -1 : end - begin);
+        futures.push_back(pool.submit([&measure, begin, end, &done, &cancel] {
+            return measure(begin, end, done, static_cast<const std::atomic<bool> &>(cancel));
+        }));
+    }
+
+    // The tasks hold references to the locals above: every future is waited
+    // for before anything can leave.
+    std::exception_ptr error;
+    std::vector<std::vector<T>> parts;
+    for (auto &future : futures) {
+        while (future.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+            const double fraction = totalFrames > 0 ? std::min(1.0, double(done) / double(totalFrames)) : 0.0;
+            if (progress && !cancel && !progress(fraction))
+                cancel = true;
+        }
+        try {
+            parts.push_back(future.get());
+        } catch (...) {
+            if (!error)
+                error = std::current_exception();
+            cancel = true;
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+    if (cancel)
+        return std::nullopt;
+
+    size_t lastWithFrames = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (!parts[i].empty())
+            lastWithFrames = i;
+    }
+    std::vector<T> values;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i < lastWithFrames && int64_t(parts[i].size()) < lengths[i])
+            parts[i].resize(size_t(lengths[i]), T{});
+        values.insert(values.end(), parts[i].begin(), parts[i].end());
+    }
+    if (progress)
+        progress(1.0);
+    return values;
+}
+
+} // namespace vep
@@ -0,0 +1,58 @@
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace vep {
+
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads <= 0)
+        threads = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+    m_threads.reserve(size_t(threads));
+    for (int i = 0; i < threads; ++i)
+        m_threads.emplace_back([this] { run(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vep {
+
+// Fixed-size worker pool. Tasks must not block waiting on other tasks of the
+// same pool; fan-out work should chain continuations instead (see
+// PartitionedConvolver for the pattern).
+class ThreadPool
+{
+public:
+    // threads <= 0 uses one thread per hardware core, minus one for the
+    // thread that feeds the pool.
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int threadCount() const { return int(m_threads.size()); }
+
+    void post(std::function<void()> task);
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F &&fn)
+    {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> future = task->get_future();
+        post([task] { (*task)(); });
+        return future;
+    }
+
+    // Process-wide pool for short compute tasks (DSP partitions, analysis
+    // chunks). Long-running jobs should own a pool of their own.
+    static ThreadPool &shared();
+
+private:
+    void run();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_queue;
+    bool m_stopping = false;
+};
+
+} // namespace vep
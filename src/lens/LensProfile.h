@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+namespace vep {
+
+// How a lens maps the angle theta between a ray and its axis to a distance
+// r from the image centre, for focal length f:
+//   Rectilinear    r = f tan(theta)      (ordinary lenses, the corrected output)
+//   Equidistant    r = f theta           (most action cameras)
+//   Equisolid      r = 2f sin(theta / 2)
+//   Stereographic  r = 2f tan(theta / 2)
+enum class LensProjection { Rectilinear, Equidistant, Equisolid, Stereographic };
+
+const char *lensProjectionName(LensProjection projection);
+
+// A lens as far as distortion goes. The field of view is measured across
+// the diagonal of the full sensor frame, as makers publish it, so one
+// profile fits every resolution and crop of the same aspect. k1 bends the
+// projection further, r' = r (1 + k1 (r / halfDiagonal)^2), for lenses that
+// sit between the ideal curves.
+struct LensProfile
+{
+    std::string id;
+    std::string name;
+    std::string maker;
+    LensProjection projection = LensProjection::Equidistant;
+    double diagonalFov = 150.0; // degrees
+    double k1 = 0.0;
+};
+
+} // namespace vep
@@ -0,0 +1,103 @@
+#include "lens/LensProfileLibrary.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace vep {
+
+const char *lensProjectionName(LensProjection projection)
+{
+    switch (projection) {
+    case LensProjection::Rectilinear:
+        return "rectilinear";
+    case LensProjection::Equidistant:
+        return "equidistant";
+    case LensProjection::Equisolid:
+        return "equisolid";
+    case LensProjection::Stereographic:
+        return "stereographic";
+    }
+    return "equidistant";
+}
+
+namespace {
+
+std::string tableKey(const std::string &id, int width, int height, const LensCorrectionSettings &settings)
+{
+    char suffix[96];
+    std::snprintf(suffix, sizeof(suffix), "@%dx%d/%.4f/%.4f", width, height, settings.strength, settings.zoom);
+    return id + suffix;
+}
+
+} // namespace
+
+LensProfileLibrary &LensProfileLibrary::instance()
+{
+    static LensProfileLibrary library;
+    return library;
+}
+
+LensProfileLibrary::LensProfileLibrary()
+    : m_profiles{
+        {"gopro-hero-wide", "HERO (Wide)", "GoPro", LensProjection::Equidistant, 133.0, 0.0},
+        {"dji-osmo-action", "Osmo Action", "DJI", LensProjection::Equidistant, 145.0, 0.0},
+        {"action-170", "Action camera, 170°", "Generic", LensProjection::Equidistant, 170.0, 0.0},
+        {"fisheye-120", "Fisheye, 120°", "Generic", LensProjection::Equidistant, 120.0, 0.0},
+        {"fisheye-150", "Fisheye, 150°", "Generic", LensProjection::Equidistant, 150.0, 0.0},
+        {"fisheye-180", "Fisheye, 180°", "Generic", LensProjection::Equidistant, 180.0, 0.0},
+        {"fisheye-180-equisolid", "Fisheye, 180° (equisolid)", "Generic", LensProjection::Equisolid, 180.0,
+         0.0},
+    }
+{
+}
+
+std::vector<LensProfile> LensProfileLibrary::profiles() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_profiles;
+}
+
+void LensProfileLibrary::addProfile(const LensProfile &profile)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto existing = std::find_if(m_profiles.begin(), m_profiles.end(),
+                                 [&](const LensProfile &other) { return other.id == profile.id; });
+    if (existing != m_profiles.end())
+        *existing = profile;
+    else
+        m_profiles.push_back(profile);
+
+    const std::string prefix = profile.id + '@';
+    auto it = m_tables.lower_bound(prefix);
+    while (it != m_tables.end() && it->first.compare(0, prefix.size(), prefix) == 0)
+        it = m_tables.erase(it);
+}
+
+std::shared_ptr<const LensRemapTable> LensProfileLibrary::remapTable(const std::string &id, int width, int height,
+                                                                     const LensCorrectionSettings &settings)
+{
+    const std::string key = tableKey(id, width, height, settings);
+    LensProfile profile;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto cached = m_tables[key].lock())
+            return cached;
+        auto found = std::find_if(m_profiles.begin(), m_profiles.end(),
+                                  [&](const LensProfile &other) { return other.id == id; });
+        if (found == m_profiles.end())
+            throw std::runtime_error("unknown lens profile " + id);
+        profile = *found;
+    }
+
+    // Built outside the lock: a 4K table takes a moment.
+    auto table = std::make_shared<const LensRemapTable>(buildLensRemapTable(profile, width, height, settings));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto raced = m_tables[key].lock())
+        return raced;
+    m_tables[key] = table;
+    return table;
+}
+
+} // namespace vep
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lens/LensProfile.h"
+#include "lens/LensRemap.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// Catalogue of lens profiles: the bundled ones for common action cameras
+// and generic fisheyes, plus any the user calibrates and adds. Remap
+// tables are built on first use and cached per (profile, size, settings),
+// so every clip from the same camera shares one table and a frame costs
+// only the blend.
+//
+// The bundled profiles are derived from the field of view each maker
+// publishes and an assumed projection, not from a calibration of the lens,
+// so some curvature may remain towards the corners; a calibrated profile
+// (with k1) replaces a bundled one under the same id.
+class LensProfileLibrary
+{
+public:
+    static LensProfileLibrary &instance();
+
+    std::vector<LensProfile> profiles() const;
+    // Replaces a profile with the same id. Tables built from the old one
+    // are dropped as their last users let go.
+    void addProfile(const LensProfile &profile);
+
+    // Throws std::runtime_error for an unknown id or a profile that cannot
+    // be mapped at this size (see buildLensRemapTable()).
+    std::shared_ptr<const LensRemapTable> remapTable(const std::string &id, int width, int height,
+                                                     const LensCorrectionSettings &settings = {});
+
+private:
+    LensProfileLibrary();
+
+    mutable std::mutex m_mutex;
+    std::vector<LensProfile> m_profiles;
+    std::map<std::string, std::weak_ptr<const LensRemapTable>> m_tables;
+};
+
+} // namespace vep
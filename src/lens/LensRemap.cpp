@@ -0,0 +1,230 @@
+#include "lens/LensRemap.h"
+
+#include "core/Simd.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kOne = 1 << LensRemapTable::kFractionBits;
+// The four bilinear weights sum to kOne * kOne.
+constexpr int kWeightBits = 2 * LensRemapTable::kFractionBits;
+constexpr int kBandRows = 32;
+
+// r / f for a ray at `theta` from the axis.
+double project(LensProjection projection, double theta)
+{
+    switch (projection) {
+    case LensProjection::Rectilinear:
+        return std::tan(theta);
+    case LensProjection::Equidistant:
+        return theta;
+    case LensProjection::Equisolid:
+        return 2.0 * std::sin(0.5 * theta);
+    case LensProjection::Stereographic:
+        return 2.0 * std::tan(0.5 * theta);
+    }
+    return theta;
+}
+
+// r / halfDiagonal for the undistorted radius r that k1 bends onto the
+// corner: the root of u (1 + k1 u^2) = 1. The left side rises with u up to
+// its peak at 1 / sqrt(-3 k1) when k1 is negative, so the root is bisected
+// for below that (or below 1, where it lies otherwise). 0 if k1 is under
+// -4/27 and the corner is never reached.
+double cornerRatio(double k1)
+{
+    auto bent = [k1](double u) { return u * (1.0 + k1 * u * u); };
+    double low = 0.0;
+    double high = k1 < 0.0 ? 1.0 / std::sqrt(-3.0 * k1) : 1.0;
+    if (bent(high) < 1.0)
+        return 0.0;
+    for (int i = 0; i < 60; ++i) {
+        const double mid = 0.5 * (low + high);
+        if (bent(mid) < 1.0)
+            low = mid;
+        else
+            high = mid;
+    }
+    return high;
+}
+
+struct SourceLens
+{
+    const LensProfile &profile;
+    double focal = 0.0;
+    double halfDiagonal = 0.0;
+
+    // Distance from the centre, in source pixels, of a ray at `theta`.
+    double radius(double theta) const
+    {
+        const double r = focal * project(profile.projection, theta);
+        const double q = r / halfDiagonal;
+        return r * (1.0 + profile.k1 * q * q);
+    }
+};
+
+// Splits a source coordinate into the first of the two pixels it blends
+// and the fraction towards the second, keeping the pair inside [0, size).
+// False if the coordinate is outside the picture.
+bool split(double coordinate, int size, int16_t &first, uint8_t &fraction)
+{
+    // Rounding must not lose the outermost pixels of an unchanged picture.
+    constexpr double kSlack = 1e-6;
+    if (!(coordinate >= -kSlack) || coordinate > double(size - 1) + kSlack)
+        return false;
+    coordinate = std::clamp(coordinate, 0.0, double(size - 1));
+    int whole = int(coordinate);
+    int part = int(std::lround((coordinate - whole) * kOne));
+    if (part == kOne) {
+        ++whole;
+        part = 0;
+    }
+    if (whole >= size - 1) {
+        whole = size - 2;
+        part = kOne;
+    }
+    first = int16_t(whole);
+    fraction = uint8_t(part);
+    return true;
+}
+
+void remapRow(const LensRemapTable &table, int row, const uint8_t *source, int sourceStride, uint8_t *target)
+{
+    const LensRemapTable::Sample *sample = table.samples.data() + size_t(row) * size_t(table.width);
+#if defined(VEP_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi32(1 << (kWeightBits - 1));
+#endif
+    for (int x = 0; x < table.width; ++x, ++sample, target += 4) {
+        if (sample->x < 0) {
+            std::memset(target, 0, 4);
+            continue;
+        }
+        const uint8_t *top = source + std::ptrdiff_t(sample->y) * sourceStride + std::ptrdiff_t(sample->x) * 4;
+        const uint8_t *bottom = top + sourceStride;
+        const int fx = sample->fx;
+        const int fy = sample->fy;
+        const int w00 = (kOne - fx) * (kOne - fy);
+        const int w01 = fx * (kOne - fy);
+        const int w10 = (kOne - fx) * fy;
+        const int w11 = fx * fy;
+#if defined(VEP_SIMD_SSE2)
+        // Both pixels of a row widened to 16 bits and interleaved channel by
+        // channel, so one multiply-add per row weights and sums each pair.
+        __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(top)), zero);
+        __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(bottom)), zero);
+        a = _mm_unpacklo_epi16(a, _mm_unpackhi_epi64(a, a));
+        b = _mm_unpacklo_epi16(b, _mm_unpackhi_epi64(b, b));
+        __m128i sum = _mm_add_epi32(_mm_madd_epi16(a, _mm_set1_epi32(w00 | (w01 << 16))),
+                                    _mm_madd_epi16(b, _mm_set1_epi32(w10 | (w11 << 16))));
+        sum = _mm_srli_epi32(_mm_add_epi32(sum, half), kWeightBits);
+        sum = _mm_packs_epi32(sum, sum);
+        const int32_t pixel = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+        std::memcpy(target, &pixel, 4);
+#else
+        for (int c = 0; c < 4; ++c) {
+            const int sum = top[c] * w00 + top[4 + c] * w01 + bottom[c] * w10 + bottom[4 + c] * w11;
+            target[c] = uint8_t((sum + (1 << (kWeightBits - 1))) >> kWeightBits);
+        }
+#endif
+    }
+}
+
+} // namespace
+
+LensRemapTable buildLensRemapTable(const LensProfile &profile, int width, int height,
+                                   const LensCorrectionSettings &settings)
+{
+    if (width < 2 || height < 2 || width > 32767 || height > 32767)
+        throw std::runtime_error("lens correction needs a frame of 2x2 to 32767x32767 pixels");
+    const double halfFov = 0.5 * profile.diagonalFov * kPi / 180.0;
+    if (!(halfFov > 0.0) || (profile.projection == LensProjection::Rectilinear && halfFov >= 0.5 * kPi))
+        throw std::runtime_error("lens profile " + profile.id + " has an impossible field of view");
+
+    SourceLens lens{profile};
+    lens.halfDiagonal = 0.5 * std::hypot(double(width), double(height));
+    // The ray at half the field of view lands on the corner.
+    const double corner = cornerRatio(profile.k1);
+    lens.focal = corner * lens.halfDiagonal / project(profile.projection, halfFov);
+    if (!(lens.focal > 0.0) || !std::isfinite(lens.focal))
+        throw std::runtime_error("lens profile " + profile.id + " cannot be mapped");
+
+    // The output focal length that keeps the middle of the side edges in
+    // place: the angle whose ray lands there, by bisection.
+    const double halfWidth = 0.5 * (width - 1);
+    double low = 0.0;
+    double high = 0.5 * kPi - 1e-6;
+    for (int i = 0; i < 60; ++i) {
+        const double mid = 0.5 * (low + high);
+        if (lens.radius(mid) < halfWidth)
+            low = mid;
+        else
+            high = mid;
+    }
+    const double outputFocal = halfWidth / std::tan(low) * std::max(0.1, settings.zoom);
+    const double strength = std::clamp(settings.strength, 0.0, 1.0);
+
+    LensRemapTable table;
+    table.width = width;
+    table.height = height;
+    table.samples.resize(size_t(width) * size_t(height));
+    const double cx = 0.5 * (width - 1);
+    const double cy = 0.5 * (height - 1);
+    LensRemapTable::Sample *sample = table.samples.data();
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x, ++sample) {
+            const double dx = x - cx;
+            const double dy = y - cy;
+            const double distance = std::hypot(dx, dy);
+            // How much further from the centre the source has this point.
+            const double stretch = distance > 0.0 ? lens.radius(std::atan(distance / outputFocal)) / distance
+                                                  : lens.focal / outputFocal;
+            const double sx = x + strength * (cx + dx * stretch - x);
+            const double sy = y + strength * (cy + dy * stretch - y);
+            if (!split(sx, width, sample->x, sample->fx) || !split(sy, height, sample->y, sample->fy))
+                *sample = LensRemapTable::Sample{};
+        }
+    }
+    return table;
+}
+
+void applyLensRemap(const LensRemapTable &table, const uint8_t *source, int sourceStride, uint8_t *target,
+                    int targetStride, ThreadPool *pool)
+{
+    const int bands = (table.height + kBandRows - 1) / kBandRows;
+    auto render = [&](int band) {
+        const int end = std::min(table.height, (band + 1) * kBandRows);
+        for (int row = band * kBandRows; row < end; ++row)
+            remapRow(table, row, source, sourceStride, target + std::ptrdiff_t(row) * targetStride);
+    };
+
+    // Bands are handed out one at a time, so a helper that starts late just
+    // takes fewer.
+    ThreadPool &workers = pool ? *pool : ThreadPool::shared();
+    std::atomic<int> next{0};
+    auto work = [&] {
+        for (int band = next++; band < bands; band = next++)
+            render(band);
+    };
+    std::vector<std::future<void>> helpers;
+    const int helperCount = std::min(workers.threadCount(), bands - 1);
+    for (int i = 0; i < helperCount; ++i)
+        helpers.push_back(workers.submit(work));
+    work();
+    for (auto &helper : helpers)
+        helper.get();
+}
+
+} // namespace vep
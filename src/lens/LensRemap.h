@@ -0,0 +1,61 @@
+#pragma once
+
+#include "lens/LensProfile.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+
+class ThreadPool;
+
+// Where every output pixel of a lens correction samples the source, worked
+// out once per profile, size and settings: the top-left of the 2x2 source
+// pixels it blends (x is -1 if it falls outside the source) and the
+// position inside them in 1/128ths of a pixel. Applying it is then a
+// fixed-point bilinear blend with no trigonometry, at 6 bytes a pixel.
+struct LensRemapTable
+{
+    struct Sample
+    {
+        int16_t x = -1;
+        int16_t y = 0;
+        uint8_t fx = 0;
+        uint8_t fy = 0;
+    };
+
+    static constexpr int kFractionBits = 7;
+
+    int width = 0;
+    int height = 0;
+    // Row by row.
+    std::vector<Sample> samples;
+};
+
+struct LensCorrectionSettings
+{
+    // 0 leaves the picture as it is, 1 straightens lines fully.
+    double strength = 1.0;
+    // 1 scales the result so the middle of the left and right edges stay
+    // where they are; more crops the curved borders away.
+    double zoom = 1.0;
+};
+
+// The table that turns a width x height picture taken through the
+// profile's lens into the rectilinear one an ordinary lens would have
+// given. Throws std::runtime_error for a size under 2x2 or over 32767, or a
+// profile that cannot be mapped (a rectilinear one of 180 degrees or more,
+// or a k1 under -4/27, which never reaches the corner).
+LensRemapTable buildLensRemapTable(const LensProfile &profile, int width, int height,
+                                   const LensCorrectionSettings &settings = {});
+
+// Applies `table` to an RGBA image of its size; pixels that sample outside
+// the source become transparent black. The blend runs on SSE2 where the
+// build has it, and a scalar path gives identical results elsewhere. Rows
+// are split into bands run on `pool` (ThreadPool::shared() if null) with
+// the caller taking a band too, so it must not be called from a task of
+// that pool. source and target must not overlap.
+void applyLensRemap(const LensRemapTable &table, const uint8_t *source, int sourceStride, uint8_t *target,
+                    int targetStride, ThreadPool *pool = nullptr);
+
+} // namespace vep
@@ -0,0 +1,79 @@
+#include "audio/ImpulseResponseLibrary.h"
+#include "captions/AutoCaptionJob.h"
+#include "captions/TranscriptModel.h"
+#include "media/MediaImportJob.h"
+#include "media/SceneDetectionJob.h"
+#include "mlt/VepFilters.h"
+#include "stabilization/StabilizationJob.h"
+#include "timeline/SnapModel.h"
+#include "tracking/PlanarTrackingJob.h"
+#include "tracking/TrackingJob.h"
+#include "ui/QmlTypes.h"
+
+#include <MltFactory.h>
+#include <MltRepository.h>
+
+#include <QDir>
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QStandardPaths>
+#include <QUrl>
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setApplicationName(QStringLiteral("VideoEditorPro"));
+    QGuiApplication::setOrganizationName(QStringLiteral("VideoEditorPro"));
+
+    Mlt::Repository *repository = Mlt::Factory::init();
+    if (!repository) {
+        qCritical("MLT could not be initialised");
+        return 1;
+    }
+    vep::registerMltFilters(repository);
+    vep::registerQmlTypes();
+
+    // Impulse responses installed with the application, then the user's own.
+    vep::ImpulseResponseLibrary &impulses = vep::ImpulseResponseLibrary::instance();
+    impulses.addSearchPath(QDir(QCoreApplication::applicationDirPath())
+                               .absoluteFilePath(QStringLiteral("../share/videoeditorpro/impulses"))
+                               .toStdString());
+    const QString userImpulses
+        = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/impulses");
+    QDir().mkpath(userImpulses);
+    impulses.addSearchPath(userImpulses.toStdString());
+
+    // One of each for the whole session; QML reaches them by name.
+    vep::MediaImportJob importJob;
+    vep::SnapModel snapModel;
+    vep::TranscriptModel transcriptModel;
+    vep::AutoCaptionJob captionJob;
+    vep::SceneDetectionJob sceneDetectionJob;
+    vep::StabilizationJob stabilizationJob;
+    vep::TrackingJob trackingJob;
+    vep::PlanarTrackingJob planarTrackingJob;
+    // Captions made for the timeline feed the transcript search.
+    QObject::connect(&captionJob, &vep::AutoCaptionJob::clipCaptionsReady, &transcriptModel,
+                     &vep::TranscriptModel::setClipCaptions);
+    QObject::connect(&captionJob, &vep::AutoCaptionJob::clipCaptionsRemoved, &transcriptModel,
+                     &vep::TranscriptModel::removeClip);
+
+    QQmlApplicationEngine engine;
+    QQmlContext *context = engine.rootContext();
+    context->setContextProperty(QStringLiteral("importJob"), &importJob);
+    context->setContextProperty(QStringLiteral("snapModel"), &snapModel);
+    context->setContextProperty(QStringLiteral("transcriptModel"), &transcriptModel);
+    context->setContextProperty(QStringLiteral("captionJob"), &captionJob);
+    context->setContextProperty(QStringLiteral("sceneDetectionJob"), &sceneDetectionJob);
+    context->setContextProperty(QStringLiteral("stabilizationJob"), &stabilizationJob);
+    context->setContextProperty(QStringLiteral("trackingJob"), &trackingJob);
+    context->setContextProperty(QStringLiteral("planarTrackingJob"), &planarTrackingJob);
+    engine.load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
+    if (engine.rootObjects().isEmpty())
+        return 1;
+
+    const int result = app.exec();
+    Mlt::Factory::close();
+    return result;
+}
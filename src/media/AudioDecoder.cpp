@@ -0,0 +1,187 @@
+#include "media/AudioDecoder.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libswresample/swresample.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace vep {
+
+struct AudioDecoder::Private
+{
+    AVFormatContext *format = nullptr;
+    AVCodecContext *codec = nullptr;
+    SwrContext *swr = nullptr;
+    AVPacket *packet = nullptr;
+    AVFrame *frame = nullptr;
+    int stream = -1;
+    int outRate = 0;
+    int outChannels = 0;
+    bool demuxEnded = false;
+    bool resamplerFlushed = false;
+    long long delivered = 0;
+    double seekTarget = -1.0;
+
+    ~Private()
+    {
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        swr_free(&swr);
+        avcodec_free_context(&codec);
+        avformat_close_input(&format);
+    }
+
+    void openResampler()
+    {
+        swr_free(&swr);
+        AVChannelLayout outLayout;
+        av_channel_layout_default(&outLayout, outChannels);
+        int error = swr_alloc_set_opts2(&swr, &outLayout, AV_SAMPLE_FMT_FLT, outRate,
+                                        &codec->ch_layout, codec->sample_fmt, codec->sample_rate,
+                                        0, nullptr);
+        av_channel_layout_uninit(&outLayout);
+        if (error < 0 || swr_init(swr) < 0)
+            throw std::runtime_error("cannot set up audio resampler");
+    }
+
+    // Converts the current frame (or flushes the resampler when frame is
+    // null) into out; returns frames produced.
+    int convert(const AVFrame *input, std::vector<float> &out)
+    {
+        const int inSamples = input ? input->nb_samples : 0;
+        const int capacity = swr_get_out_samples(swr, inSamples) + 32;
+        out.resize(size_t(capacity) * size_t(outChannels));
+        uint8_t *dst = reinterpret_cast<uint8_t *>(out.data());
+        const int produced = swr_convert(swr, &dst, capacity,
+                                         input ? const_cast<const uint8_t **>(input->extended_data) : nullptr,
+                                         inSamples);
+        const int frames = std::max(produced, 0);
+        out.resize(size_t(frames) * size_t(outChannels));
+        return frames;
+    }
+};
+
+AudioDecoder::AudioDecoder(const std::string &path, int targetRate, int targetChannels)
+    : d(std::make_unique<Private>())
+{
+    if (avformat_open_input(&d->format, path.c_str(), nullptr, nullptr) < 0)
+        throw std::runtime_error("cannot open " + path);
+    if (avformat_find_stream_info(d->format, nullptr) < 0)
+        throw std::runtime_error("cannot read stream info of " + path);
+
+    const AVCodec *decoder = nullptr;
+    d->stream = av_find_best_stream(d->format, AVMEDIA_TYPE_AUDIO, -1, -1, &decoder, 0);
+    if (d->stream < 0 || !decoder)
+        throw std::runtime_error("no audio stream in " + path);
+    for (unsigned i = 0; i < d->format->nb_streams; ++i)
+        d->format->streams[i]->discard = int(i) == d->stream ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+
+    d->codec = avcodec_alloc_context3(decoder);
+    if (!d->codec
+        || avcodec_parameters_to_context(d->codec, d->format->streams[d->stream]->codecpar) < 0
+        || avcodec_open2(d->codec, decoder, nullptr) < 0)
+        throw std::runtime_error("cannot open audio decoder for " + path);
+
+    d->outRate = targetRate > 0 ? targetRate : d->codec->sample_rate;
+    d->outChannels = targetChannels > 0 ? targetChannels : d->codec->ch_layout.nb_channels;
+    d->openResampler();
+    d->packet = av_packet_alloc();
+    d->frame = av_frame_alloc();
+}
+
+AudioDecoder::~AudioDecoder() = default;
+
+int AudioDecoder::sampleRate() const
+{
+    return d->outRate;
+}
+
+int AudioDecoder::channels() const
+{
+    return d->outChannels;
+}
+
+double AudioDecoder::duration() const
+{
+    const AVStream *stream = d->format->streams[d->stream];
+    if (stream->duration != AV_NOPTS_VALUE)
+        return double(stream->duration) * av_q2d(stream->time_base);
+    if (d->format->duration != AV_NOPTS_VALUE)
+        return double(d->format->duration) / AV_TIME_BASE;
+    return 0.0;
+}
+
+double AudioDecoder::position() const
+{
+    return double(d->delivered) / d->outRate;
+}
+
+void AudioDecoder::seek(double seconds)
+{
+    const AVStream *stream = d->format->streams[d->stream];
+    const int64_t timestamp = int64_t(seconds / av_q2d(stream->time_base));
+    if (av_seek_frame(d->format, d->stream, timestamp, AVSEEK_FLAG_BACKWARD) < 0)
+        throw std::runtime_error("seek failed");
+    avcodec_flush_buffers(d->codec);
+    d->openResampler();
+    d->demuxEnded = false;
+    d->resamplerFlushed = false;
+    d->seekTarget = seconds;
+    d->delivered = std::llround(seconds * d->outRate);
+}
+
+int AudioDecoder::read(std::vector<float> &out)
+{
+    for (;;) {
+        const int received = avcodec_receive_frame(d->codec, d->frame);
+        if (received == 0) {
+            int frames = d->convert(d->frame, out);
+            if (d->seekTarget >= 0.0 && d->frame->pts != AV_NOPTS_VALUE) {
+                // Drop whatever precedes the seek target.
+                const double start = double(d->frame->pts) * av_q2d(d->format->streams[d->stream]->time_base);
+                const int skip = std::clamp(int(std::lround((d->seekTarget - start) * d->outRate)), 0, frames);
+                out.erase(out.begin(), out.begin() + ptrdiff_t(skip) * d->outChannels);
+                frames -= skip;
+                if (frames > 0)
+                    d->seekTarget = -1.0;
+            }
+            av_frame_unref(d->frame);
+            if (frames > 0) {
+                d->delivered += frames;
+                return frames;
+            }
+            continue;
+        }
+        if (received == AVERROR_EOF) {
+            if (d->resamplerFlushed)
+                return 0;
+            d->resamplerFlushed = true;
+            const int frames = d->convert(nullptr, out);
+            d->delivered += frames;
+            return frames;
+        }
+        if (received != AVERROR(EAGAIN))
+            throw std::runtime_error("audio decode error");
+
+        if (d->demuxEnded)
+            return 0;
+        const int read = av_read_frame(d->format, d->packet);
+        if (read < 0) {
+            d->demuxEnded = true;
+            avcodec_send_packet(d->codec, nullptr);
+            continue;
+        }
+        if (d->packet->stream_index == d->stream)
+            avcodec_send_packet(d->codec, d->packet);
+        av_packet_unref(d->packet);
+    }
+}
+
+} // namespace vep
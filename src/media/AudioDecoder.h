@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// Sequential FFmpeg decode of a file's best audio stream to interleaved
+// float, optionally resampled/remixed (e.g. 16 kHz mono for speech models).
+// Other streams are discarded at the demuxer so video is never decoded.
+class AudioDecoder
+{
+public:
+    // targetRate / targetChannels <= 0 keep the stream's own. Throws
+    // std::runtime_error if the file cannot be opened or has no audio.
+    explicit AudioDecoder(const std::string &path, int targetRate = 0, int targetChannels = 0);
+    ~AudioDecoder();
+
+    AudioDecoder(const AudioDecoder &) = delete;
+    AudioDecoder &operator=(const AudioDecoder &) = delete;
+
+    int sampleRate() const;
+    int channels() const;
+    // Seconds, or 0 if the container does not say.
+    double duration() const;
+    // Seconds of audio delivered so far.
+    double position() const;
+
+    // Replaces `out` with the next chunk of decoded frames (typically one
+    // packet's worth). Returns the number of frames, 0 at end of stream.
+    int read(std::vector<float> &out);
+
+    // Seeks to `seconds` (to the preceding keyframe, then discards up to
+    // the exact sample) so analysis can decode a sub-range of the file.
+    void seek(double seconds);
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+} // namespace vep
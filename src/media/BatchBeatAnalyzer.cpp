@@ -0,0 +1,196 @@
+#include "media/BatchBeatAnalyzer.h"
+
+#include "media/BeatAnalysisStage.h"
+#include "media/ImportPipeline.h"
+#include "media/PeakAnalysisStage.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vep {
+
+BatchBeatAnalyzer::BatchBeatAnalyzer(MediaCache &cache, int concurrency)
+    : m_cache(cache)
+    , m_pool(concurrency)
+{
+}
+
+BatchBeatAnalyzer::~BatchBeatAnalyzer()
+{
+    cancelAll();
+    waitForIdle();
+}
+
+void BatchBeatAnalyzer::setFileProgressCallback(FileProgress callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_fileProgress = std::move(callback);
+}
+
+void BatchBeatAnalyzer::setFinishedCallback(Finished callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished = std::move(callback);
+}
+
+int BatchBeatAnalyzer::enqueue(const std::string &path, Priority priority)
+{
+    return enqueue(std::vector<std::string>{path}, priority);
+}
+
+int BatchBeatAnalyzer::enqueue(const std::vector<std::string> &paths, Priority priority)
+{
+    int added = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const std::string &path : paths) {
+            auto matches = [&](const std::shared_ptr<Job> &job) { return job->path == path; };
+            auto queued = std::find_if(m_queued.begin(), m_queued.end(), matches);
+            if (queued != m_queued.end()) {
+                (*queued)->priority = std::max((*queued)->priority, priority);
+                continue;
+            }
+            if (std::any_of(m_running.begin(), m_running.end(), matches))
+                continue;
+            auto job = std::make_shared<Job>();
+            job->path = path;
+            job->priority = priority;
+            job->order = m_nextOrder++;
+            m_queued.push_back(std::move(job));
+            ++added;
+        }
+    }
+    // One pool task per job; each picks whatever is most urgent when it
+    // starts rather than the job it was posted for.
+    for (int i = 0; i < added; ++i)
+        m_pool.post([this] { runNext(); });
+    return added;
+}
+
+void BatchBeatAnalyzer::setPriority(const std::string &path, Priority priority)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &job : m_queued) {
+        if (job->path == path)
+            job->priority = priority;
+    }
+}
+
+void BatchBeatAnalyzer::cancel(const std::string &path)
+{
+    // Queued jobs stay in the queue; the pool task posted for each one
+    // retires it (and reports it as cancelled) without decoding anything.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &job : m_queued) {
+        if (job->path == path)
+            job->cancelled = true;
+    }
+    for (const auto &job : m_running) {
+        if (job->path == path)
+            job->cancelled = true;
+    }
+}
+
+void BatchBeatAnalyzer::cancelAll()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &job : m_queued)
+        job->cancelled = true;
+    for (const auto &job : m_running)
+        job->cancelled = true;
+}
+
+void BatchBeatAnalyzer::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_queued.empty() && m_running.empty(); });
+}
+
+double BatchBeatAnalyzer::progress() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t total = size_t(m_finishedCount) + m_running.size() + m_queued.size();
+    if (total == 0)
+        return 1.0;
+    double done = m_finishedCount;
+    for (const auto &job : m_running)
+        done += job->fraction;
+    return done / double(total);
+}
+
+int BatchBeatAnalyzer::remaining() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return int(m_queued.size() + m_running.size());
+}
+
+void BatchBeatAnalyzer::runNext()
+{
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queued.empty())
+            return;
+        // Cancelled jobs first (they cost nothing), then highest priority,
+        // then first come first served.
+        auto next = std::min_element(m_queued.begin(), m_queued.end(),
+                                     [](const std::shared_ptr<Job> &a, const std::shared_ptr<Job> &b) {
+                                         if (a->cancelled != b->cancelled)
+                                             return bool(a->cancelled);
+                                         if (a->priority != b->priority)
+                                             return a->priority > b->priority;
+                                         return a->order < b->order;
+                                     });
+        job = *next;
+        m_queued.erase(next);
+        m_running.push_back(job);
+    }
+
+    std::optional<BeatMap> beats;
+    std::string error;
+    if (!job->cancelled) {
+        try {
+            ImportPipeline pipeline(m_cache, job->path);
+            // Peaks ride along so the waveform costs no second decode.
+            pipeline.addStage(std::make_unique<BeatAnalysisStage>());
+            pipeline.addStage(std::make_unique<PeakAnalysisStage>());
+            const bool completed = pipeline.run([this, &job](double fraction) {
+                FileProgress callback;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    job->fraction = fraction;
+                    callback = m_fileProgress;
+                }
+                if (callback)
+                    callback(job->path, fraction);
+                return !job->cancelled;
+            });
+            if (completed)
+                beats = BeatAnalysisStage::cached(m_cache, job->path);
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+    }
+
+    Finished callback;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        callback = m_finished;
+    }
+    if (callback)
+        callback(job->path, beats, error);
+    complete(job);
+}
+
+void BatchBeatAnalyzer::complete(const std::shared_ptr<Job> &job)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running.erase(std::find(m_running.begin(), m_running.end(), job));
+    ++m_finishedCount;
+    if (m_queued.empty() && m_running.empty()) {
+        m_finishedCount = 0;
+        m_idle.notify_all();
+    }
+}
+
+} // namespace vep
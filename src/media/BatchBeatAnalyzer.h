@@ -0,0 +1,92 @@
+#pragma once
+
+#include "audio/BeatMap.h"
+#include "core/ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class MediaCache;
+
+// Beat analysis of many files at once (an imported album, a stock-music
+// folder); each file's waveform peaks are built from the same decode. Files
+// run concurrently on a pool of their own, bounded so a large folder cannot
+// starve playback; the queue is ordered by priority at the moment a worker
+// frees up, so a file dragged onto the timeline while the library is still
+// being scanned jumps ahead of everything else. Files already in the
+// MediaCache complete immediately without decoding.
+//
+// Callbacks run on worker threads.
+class BatchBeatAnalyzer
+{
+public:
+    enum class Priority { Library, Timeline };
+
+    // fraction in [0, 1] for one file.
+    using FileProgress = std::function<void(const std::string &path, double fraction)>;
+    // beats is empty if the file failed (error says why) or was cancelled
+    // (error is empty).
+    using Finished = std::function<void(const std::string &path, const std::optional<BeatMap> &beats,
+                                        const std::string &error)>;
+
+    // concurrency <= 0 picks one worker per core, minus one.
+    explicit BatchBeatAnalyzer(MediaCache &cache, int concurrency = 0);
+    // Cancels everything and waits for running files to stop.
+    ~BatchBeatAnalyzer();
+
+    BatchBeatAnalyzer(const BatchBeatAnalyzer &) = delete;
+    BatchBeatAnalyzer &operator=(const BatchBeatAnalyzer &) = delete;
+
+    void setFileProgressCallback(FileProgress callback);
+    void setFinishedCallback(Finished callback);
+
+    // Re-adding a queued or running file only raises its priority. Returns
+    // how many files were added; each gets exactly one Finished call.
+    int enqueue(const std::string &path, Priority priority = Priority::Library);
+    int enqueue(const std::vector<std::string> &paths, Priority priority = Priority::Library);
+    void setPriority(const std::string &path, Priority priority);
+
+    void cancel(const std::string &path);
+    void cancelAll();
+    void waitForIdle();
+
+    // Overall completion of the files added since the analyzer was last idle.
+    double progress() const;
+    int remaining() const;
+
+private:
+    struct Job
+    {
+        std::string path;
+        Priority priority;
+        uint64_t order;
+        double fraction = 0.0;
+        std::atomic<bool> cancelled{false};
+    };
+
+    void runNext();
+    void complete(const std::shared_ptr<Job> &job);
+
+    MediaCache &m_cache;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_idle;
+    std::vector<std::shared_ptr<Job>> m_queued;
+    std::vector<std::shared_ptr<Job>> m_running;
+    uint64_t m_nextOrder = 0;
+    int m_finishedCount = 0;
+    FileProgress m_fileProgress;
+    Finished m_finished;
+    // Last, so its workers are joined before anything they touch is destroyed.
+    ThreadPool m_pool;
+};
+
+} // namespace vep
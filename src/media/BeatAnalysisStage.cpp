@@ -0,0 +1,46 @@
+#include "media/BeatAnalysisStage.h"
+
+#include "audio/BeatDetector.h"
+#include "core/MediaCache.h"
+
+#include <stdexcept>
+
+namespace vep {
+
+BeatAnalysisStage::BeatAnalysisStage() = default;
+
+BeatAnalysisStage::~BeatAnalysisStage() = default;
+
+void BeatAnalysisStage::begin(int sampleRate, int channels)
+{
+    m_detector = std::make_unique<BeatDetector>(sampleRate, channels);
+}
+
+void BeatAnalysisStage::process(const float *interleaved, int frames)
+{
+    m_detector->process(interleaved, frames);
+}
+
+std::vector<uint8_t> BeatAnalysisStage::finish()
+{
+    const BeatMap map = m_detector->finish();
+    m_detector.reset();
+    return map.serialize();
+}
+
+std::optional<BeatMap> BeatAnalysisStage::cached(MediaCache &cache, const std::string &mediaPath)
+{
+    const ContentHash hash = cache.hashOf(mediaPath);
+    const auto bytes = cache.read(hash, BeatMap::kCacheKind);
+    if (!bytes)
+        return std::nullopt;
+    try {
+        return BeatMap::deserialize(*bytes);
+    } catch (const std::runtime_error &) {
+        // Stale or damaged entry: drop it so the next import regenerates it.
+        cache.remove(hash, BeatMap::kCacheKind);
+        return std::nullopt;
+    }
+}
+
+} // namespace vep
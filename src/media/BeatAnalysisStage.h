@@ -0,0 +1,34 @@
+#pragma once
+
+#include "audio/BeatMap.h"
+#include "media/ImportPipeline.h"
+
+#include <memory>
+#include <optional>
+
+namespace vep {
+
+class BeatDetector;
+
+// Import stage that tracks tempo and onsets on the audio as it is decoded
+// for the rest of the import, instead of a separate pass on request.
+class BeatAnalysisStage : public AudioAnalysisStage
+{
+public:
+    BeatAnalysisStage();
+    ~BeatAnalysisStage() override;
+
+    std::string cacheKind() const override { return BeatMap::kCacheKind; }
+    void begin(int sampleRate, int channels) override;
+    void process(const float *interleaved, int frames) override;
+    std::vector<uint8_t> finish() override;
+
+    // The beat map stored by a previous import of this content, if any.
+    // Throws std::runtime_error if the file cannot be hashed.
+    static std::optional<BeatMap> cached(MediaCache &cache, const std::string &mediaPath);
+
+private:
+    std::unique_ptr<BeatDetector> m_detector;
+};
+
+} // namespace vep
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace vep {
+
+// Puts a decoder exactly on `target`, given one whose own seek may land a
+// few frames either side of where it was asked to (FFmpeg through OpenCV
+// does, for streams with B-frames or sparse timestamps). seekTo(frame)
+// asks the decoder for `frame` and returns the index it reports landing
+// on, i.e. that of the next frame it would decode; grab() decodes and
+// drops one frame, false at the end of the stream. An overshoot is retried
+// from further back, doubling the margin each time, and the rest is
+// decoded forward.
+//
+// Returns the index of the next frame the decoder returns: `target`, less
+// if the stream ends before it, or more if even a seek to the start
+// overshoots it.
+template <typename SeekTo, typename Grab>
+int64_t seekExactly(int64_t target, SeekTo &&seekTo, Grab &&grab)
+{
+    target = std::max<int64_t>(0, target);
+    int64_t landed = 0;
+    for (int64_t margin = 0;; margin = std::max<int64_t>(2 * margin, 8)) {
+        const int64_t from = std::max<int64_t>(0, target - margin);
+        landed = seekTo(from);
+        if (landed <= target || from == 0)
+            break;
+    }
+    while (landed < target && grab())
+        ++landed;
+    return landed;
+}
+
+} // namespace vep
@@ -0,0 +1,63 @@
+#include "media/ImportPipeline.h"
+
+#include "core/MediaCache.h"
+#include "media/AudioDecoder.h"
+
+#include <algorithm>
+
+namespace vep {
+
+ImportPipeline::ImportPipeline(MediaCache &cache, std::string mediaPath)
+    : m_cache(cache)
+    , m_path(std::move(mediaPath))
+{
+}
+
+ImportPipeline::~ImportPipeline() = default;
+
+void ImportPipeline::addStage(std::unique_ptr<AudioAnalysisStage> stage)
+{
+    m_stages.push_back(std::move(stage));
+}
+
+bool ImportPipeline::run(const Progress &progress)
+{
+    // Hashing a long file that is not memoised yet can take seconds, so it
+    // is cancellable too; it counts as no progress through the decode.
+    m_hash = m_cache.hashOf(m_path, [&progress] { return !progress || progress(0.0); });
+    if (m_hash.isNull())
+        return false;
+
+    std::vector<AudioAnalysisStage *> pending;
+    for (const auto &stage : m_stages) {
+        if (!m_cache.contains(m_hash, stage->cacheKind()))
+            pending.push_back(stage.get());
+    }
+    if (pending.empty()) {
+        if (progress)
+            progress(1.0);
+        return true;
+    }
+
+    AudioDecoder decoder(m_path);
+    for (AudioAnalysisStage *stage : pending)
+        stage->begin(decoder.sampleRate(), decoder.channels());
+
+    const double duration = decoder.duration();
+    std::vector<float> block;
+    while (const int frames = decoder.read(block)) {
+        for (AudioAnalysisStage *stage : pending)
+            stage->process(block.data(), frames);
+        if (progress && duration > 0.0
+            && !progress(std::min(decoder.position() / duration, 1.0)))
+            return false;
+    }
+
+    for (AudioAnalysisStage *stage : pending)
+        m_cache.write(m_hash, stage->cacheKind(), stage->finish());
+    if (progress)
+        progress(1.0);
+    return true;
+}
+
+} // namespace vep
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "core/ContentHash.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class MediaCache;
+
+// One consumer of a file's decoded audio during import (beat tracking,
+// waveform peaks, ...). A stage sees the stream exactly once, in decode
+// order, and returns its serialised result from finish(); the pipeline
+// stores that under cacheKind() in the MediaCache.
+class AudioAnalysisStage
+{
+public:
+    virtual ~AudioAnalysisStage() = default;
+
+    virtual std::string cacheKind() const = 0;
+    virtual void begin(int sampleRate, int channels) = 0;
+    virtual void process(const float *interleaved, int frames) = 0;
+    virtual std::vector<uint8_t> finish() = 0;
+};
+
+// Runs every registered stage over a single decode of the media file's
+// audio. Stages whose result is already cached for the file's content hash
+// are dropped before decoding starts, and if nothing is left the file is not
+// decoded at all, so re-importing a known file costs one hash lookup.
+class ImportPipeline
+{
+public:
+    // Called with the decoded fraction in [0, 1]; return false to cancel.
+    using Progress = std::function<bool(double)>;
+
+    ImportPipeline(MediaCache &cache, std::string mediaPath);
+    ~ImportPipeline();
+
+    void addStage(std::unique_ptr<AudioAnalysisStage> stage);
+
+    // Returns false if cancelled (nothing is written for a cancelled run).
+    // Throws std::runtime_error if the file cannot be hashed or decoded.
+    bool run(const Progress &progress = {});
+
+    // Valid after run().
+    ContentHash hash() const { return m_hash; }
+
+private:
+    MediaCache &m_cache;
+    std::string m_path;
+    ContentHash m_hash;
+    std::vector<std::unique_ptr<AudioAnalysisStage>> m_stages;
+};
+
+} // namespace vep
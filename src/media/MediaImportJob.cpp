@@ -0,0 +1,93 @@
+#include "media/MediaImportJob.h"
+
+#include "core/MediaCache.h"
+#include "media/BatchBeatAnalyzer.h"
+
+#include <QMetaObject>
+
+namespace vep {
+
+MediaImportJob::MediaImportJob(QObject *parent)
+    : QObject(parent)
+    , m_analyzer(std::make_unique<BatchBeatAnalyzer>(MediaCache::instance()))
+{
+    // Both callbacks run on the analyzer's workers. Queued calls to a job
+    // that is gone are dropped, and the destructor waits for the workers.
+    m_analyzer->setFileProgressCallback([this](const std::string &, double) {
+        QMetaObject::invokeMethod(this, [this] { emit progressChanged(); });
+    });
+    m_analyzer->setFinishedCallback(
+        [this](const std::string &path, const std::optional<BeatMap> &beats, const std::string &error) {
+            const QString mediaPath = QString::fromStdString(path);
+            const QString message = QString::fromStdString(error);
+            const bool completed = bool(beats);
+            double bpm = 0.0;
+            QVariantList times;
+            if (beats) {
+                bpm = beats->bpm;
+                for (double beat : beats->beats)
+                    times.append(beat);
+            }
+            QMetaObject::invokeMethod(this, [this, mediaPath, message, completed, bpm, times] {
+                if (completed) {
+                    emit beatsReady(mediaPath, bpm, times);
+                    emit fileImported(mediaPath);
+                } else if (!message.isEmpty()) {
+                    emit fileFailed(mediaPath, message);
+                }
+                added(-1);
+            });
+        });
+}
+
+MediaImportJob::~MediaImportJob()
+{
+    m_analyzer.reset();
+}
+
+double MediaImportJob::progress() const
+{
+    return m_analyzer->progress();
+}
+
+int MediaImportJob::remaining() const
+{
+    return m_analyzer->remaining();
+}
+
+void MediaImportJob::importFiles(const QStringList &mediaPaths)
+{
+    std::vector<std::string> paths;
+    paths.reserve(size_t(mediaPaths.size()));
+    for (const QString &path : mediaPaths)
+        paths.push_back(path.toStdString());
+    added(m_analyzer->enqueue(paths, BatchBeatAnalyzer::Priority::Library));
+}
+
+void MediaImportJob::placedOnTimeline(const QString &mediaPath)
+{
+    added(m_analyzer->enqueue(mediaPath.toStdString(), BatchBeatAnalyzer::Priority::Timeline));
+}
+
+void MediaImportJob::cancel(const QString &mediaPath)
+{
+    m_analyzer->cancel(mediaPath.toStdString());
+}
+
+void MediaImportJob::cancelAll()
+{
+    m_analyzer->cancelAll();
+}
+
+void MediaImportJob::added(int files)
+{
+    m_outstanding += files;
+    emit progressChanged();
+    const bool running = m_outstanding > 0;
+    if (m_running == running)
+        return;
+    m_running = running;
+    emit runningChanged();
+}
+
+} // namespace vep
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+#include <memory>
+
+namespace vep {
+
+class BatchBeatAnalyzer;
+
+// The import path: every file added to the project goes through here, and a
+// BatchBeatAnalyzer builds its beat map and waveform peaks from one decode.
+// Files placed on the timeline jump ahead of files only added to the
+// library. Results land in the MediaCache; the signals tell the snap model
+// and the waveform views to pick them up.
+class MediaImportJob : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(int remaining READ remaining NOTIFY progressChanged)
+
+public:
+    explicit MediaImportJob(QObject *parent = nullptr);
+    // Cancels what is left and waits for running files to stop.
+    ~MediaImportJob() override;
+
+    bool isRunning() const { return m_running; }
+    double progress() const;
+    int remaining() const;
+
+public slots:
+    void importFiles(const QStringList &mediaPaths);
+    // Also imports the file if it was not already.
+    void placedOnTimeline(const QString &mediaPath);
+    void cancel(const QString &mediaPath);
+    void cancelAll();
+
+signals:
+    // Sent once per imported file, also for one that was already cached.
+    void beatsReady(const QString &mediaPath, double bpm, const QVariantList &beats);
+    // The file's peak file exists now; waveforms of it can reload().
+    void fileImported(const QString &mediaPath);
+    void fileFailed(const QString &mediaPath, const QString &error);
+    void runningChanged();
+    void progressChanged();
+
+private:
+    void added(int files);
+
+    std::unique_ptr<BatchBeatAnalyzer> m_analyzer;
+    // Files enqueued whose Finished call has not reached the UI thread yet.
+    int m_outstanding = 0;
+    bool m_running = false;
+};
+
+} // namespace vep
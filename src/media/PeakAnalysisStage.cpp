@@ -0,0 +1,61 @@
+#include "media/PeakAnalysisStage.h"
+
+#include "core/MediaCache.h"
+
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace vep {
+
+PeakAnalysisStage::PeakAnalysisStage() = default;
+
+PeakAnalysisStage::~PeakAnalysisStage() = default;
+
+void PeakAnalysisStage::begin(int sampleRate, int channels)
+{
+    m_builder = std::make_unique<PeakBuilder>(sampleRate, channels);
+}
+
+void PeakAnalysisStage::process(const float *interleaved, int frames)
+{
+    m_builder->process(interleaved, frames);
+}
+
+std::vector<uint8_t> PeakAnalysisStage::finish()
+{
+    std::vector<uint8_t> bytes = m_builder->finish();
+    m_builder.reset();
+    return bytes;
+}
+
+std::shared_ptr<const PeakFile> PeakAnalysisStage::cached(MediaCache &cache, const std::string &mediaPath)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<const PeakFile>> open;
+
+    const ContentHash hash = cache.hashOf(mediaPath);
+    const std::string path = cache.entryPath(hash, PeakFile::kCacheKind);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto it = open.find(path); it != open.end()) {
+        if (auto peaks = it->second.lock())
+            return peaks;
+    }
+    if (!cache.contains(hash, PeakFile::kCacheKind))
+        return nullptr;
+    try {
+        auto peaks = std::make_shared<const PeakFile>(path);
+        // Forget files no clip shows any more before adding one, so the map
+        // stays as small as the set of mapped files.
+        for (auto it = open.begin(); it != open.end();)
+            it = it->second.expired() ? open.erase(it) : std::next(it);
+        open[path] = peaks;
+        return peaks;
+    } catch (const std::runtime_error &) {
+        cache.remove(hash, PeakFile::kCacheKind);
+        return nullptr;
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "audio/PeakFile.h"
+#include "media/ImportPipeline.h"
+
+#include <memory>
+
+namespace vep {
+
+// Import stage that builds the waveform peak pyramid from the same decoded
+// audio the beat tracker sees, so showing or zooming a clip never decodes.
+class PeakAnalysisStage : public AudioAnalysisStage
+{
+public:
+    PeakAnalysisStage();
+    ~PeakAnalysisStage() override;
+
+    std::string cacheKind() const override { return PeakFile::kCacheKind; }
+    void begin(int sampleRate, int channels) override;
+    void process(const float *interleaved, int frames) override;
+    std::vector<uint8_t> finish() override;
+
+    // Maps the peak file of a previous import of this content, or returns
+    // null if there is none (or it is damaged, in which case it is removed
+    // so the next import regenerates it). Clips of the same media share one
+    // mapping. Throws std::runtime_error if the file cannot be hashed.
+    static std::shared_ptr<const PeakFile> cached(MediaCache &cache, const std::string &mediaPath);
+
+private:
+    std::unique_ptr<PeakBuilder> m_builder;
+};
+
+} // namespace vep
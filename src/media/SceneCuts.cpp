@@ -0,0 +1,54 @@
+#include "media/SceneCuts.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+namespace {
+
+// Neighbours on each side a cut must stand out from.
+constexpr int kWindow = 2;
+constexpr double kMinShotSeconds = 0.5;
+
+} // namespace
+
+std::vector<int64_t> detectCuts(const SceneCuts &cuts, double sensitivity)
+{
+    sensitivity = std::clamp(sensitivity, 0.0, 1.0);
+    // A cut must score at least this, and this many times its neighbours'
+    // mean: fast motion raises a whole run of scores, a cut only one.
+    const float minScore = float(0.45 - 0.3 * sensitivity);
+    const float ratio = float(4.0 - 2.0 * sensitivity);
+    const int64_t minGap = std::max<int64_t>(1, std::llround(kMinShotSeconds * cuts.fps));
+
+    const std::vector<float> &scores = cuts.scores;
+    const int64_t count = int64_t(scores.size());
+    std::vector<int64_t> result;
+    for (int64_t frame = 1; frame < count; ++frame) {
+        const float value = scores[size_t(frame)];
+        if (value < minScore)
+            continue;
+        float neighbours = 0.0f;
+        int counted = 0;
+        for (int64_t other = std::max<int64_t>(1, frame - kWindow); other <= std::min(count - 1, frame + kWindow);
+             ++other) {
+            if (other != frame) {
+                neighbours += scores[size_t(other)];
+                ++counted;
+            }
+        }
+        if (counted && value < ratio * (neighbours / float(counted) + 0.01f))
+            continue;
+        // Of two cuts too close together, the stronger stands.
+        if (!result.empty() && frame - result.back() < minGap) {
+            if (value > scores[size_t(result.back())])
+                result.back() = frame;
+            continue;
+        }
+        result.push_back(frame);
+    }
+    return result;
+}
+
+} // namespace vep
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core/BinaryIO.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+
+// Result of scene detection for one media file: how much each frame
+// differs from the one before, in [0, 1] (scores[0] is always 0). The cuts
+// themselves are picked from these by detectCuts(), so a different
+// sensitivity never decodes the file again. Stored in the MediaCache under
+// kCacheKind.
+struct SceneCuts
+{
+    static constexpr const char *kCacheKind = "scenes";
+
+    double fps = 0.0;
+    std::vector<float> scores;
+
+    std::vector<uint8_t> serialize() const
+    {
+        ByteWriter out;
+        out.putMagic("VEPSCEN1");
+        out.put(fps);
+        out.putArray(scores);
+        return out.take();
+    }
+
+    // Throws std::runtime_error on a malformed record.
+    static SceneCuts deserialize(const std::vector<uint8_t> &bytes)
+    {
+        ByteReader in(bytes);
+        in.expectMagic("VEPSCEN1");
+        SceneCuts cuts;
+        cuts.fps = in.get<double>();
+        cuts.scores = in.getArray<float>();
+        return cuts;
+    }
+};
+
+// Frames that start a new shot, ascending. sensitivity in [0, 1]: higher
+// finds softer cuts and risks splitting on fast motion or flashes. Shots
+// shorter than about half a second are merged into one cut.
+std::vector<int64_t> detectCuts(const SceneCuts &cuts, double sensitivity = 0.5);
+
+} // namespace vep
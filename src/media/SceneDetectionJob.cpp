@@ -0,0 +1,147 @@
+#include "media/SceneDetectionJob.h"
+
+#include "core/MediaCache.h"
+#include "media/SceneDetector.h"
+
+#include <QMetaObject>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+QVariantList toSeconds(const SceneCuts &cuts, double sensitivity)
+{
+    QVariantList list;
+    if (cuts.fps <= 0.0)
+        return list;
+    for (int64_t frame : detectCuts(cuts, sensitivity))
+        list.append(double(frame) / cuts.fps);
+    return list;
+}
+
+} // namespace
+
+SceneDetectionJob::SceneDetectionJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+SceneDetectionJob::~SceneDetectionJob()
+{
+    cancel();
+    m_future.waitForFinished();
+}
+
+QVariantList SceneDetectionJob::cuts(const QString &mediaPath) const
+{
+    // Only media the import or start() has hashed: hashing here would stall
+    // the UI for as long as it takes to read the file.
+    MediaCache &cache = MediaCache::instance();
+    const std::optional<ContentHash> hash = cache.knownHashOf(mediaPath.toStdString());
+    if (!hash)
+        return {};
+    const std::optional<SceneCuts> cached = SceneDetector::cached(cache, *hash);
+    return cached ? toSeconds(*cached, m_sensitivity) : QVariantList();
+}
+
+QVariantList SceneDetectionJob::splitPoints(const QString &mediaPath, double sourceIn, double sourceOut,
+                                            double timelineStart) const
+{
+    QVariantList points;
+    for (const QVariant &cut : cuts(mediaPath)) {
+        const double seconds = cut.toDouble();
+        if (seconds > sourceIn && seconds < sourceOut)
+            points.append(timelineStart + seconds - sourceIn);
+    }
+    return points;
+}
+
+void SceneDetectionJob::start(const QString &mediaPath)
+{
+    if (m_running)
+        return;
+
+    m_detector = std::make_unique<SceneDetector>(m_concurrency);
+    m_cancel = false;
+    m_progress = 0.0;
+    emit progressChanged();
+    setRunning(true);
+
+    SceneDetector *detector = m_detector.get();
+    const double sensitivity = m_sensitivity;
+    m_future = QtConcurrent::run([this, detector, mediaPath, sensitivity] {
+        const std::string media = mediaPath.toStdString();
+        bool completed = false;
+        QString error;
+        try {
+            MediaCache &cache = MediaCache::instance();
+            std::optional<SceneCuts> cuts = SceneDetector::cached(cache, media);
+            if (!cuts) {
+                cuts = detector->analyze(media, [this](double fraction) {
+                    QMetaObject::invokeMethod(this, [this, fraction] {
+                        m_progress = fraction;
+                        emit progressChanged();
+                    });
+                    return !m_cancel;
+                });
+                if (cuts)
+                    cache.write(cache.hashOf(media), SceneCuts::kCacheKind, cuts->serialize());
+            }
+            if (cuts) {
+                completed = true;
+                const QVariantList seconds = toSeconds(*cuts, sensitivity);
+                QMetaObject::invokeMethod(this, [this, mediaPath, seconds] {
+                    emit cutsReady(mediaPath, seconds);
+                });
+            }
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        QMetaObject::invokeMethod(this, [this, completed, error] {
+            if (completed) {
+                m_progress = 1.0;
+                emit progressChanged();
+            }
+            setRunning(false);
+            emit finished(completed, error);
+        });
+    });
+}
+
+void SceneDetectionJob::cancel()
+{
+    m_cancel = true;
+}
+
+void SceneDetectionJob::setSensitivity(double sensitivity)
+{
+    sensitivity = std::clamp(sensitivity, 0.0, 1.0);
+    if (m_sensitivity == sensitivity)
+        return;
+    m_sensitivity = sensitivity;
+    emit sensitivityChanged();
+}
+
+void SceneDetectionJob::setConcurrency(int concurrency)
+{
+    concurrency = std::max(0, concurrency);
+    if (m_concurrency == concurrency)
+        return;
+    m_concurrency = concurrency;
+    emit concurrencyChanged();
+}
+
+void SceneDetectionJob::setRunning(bool running)
+{
+    if (m_running == running)
+        return;
+    m_running = running;
+    emit runningChanged();
+}
+
+} // namespace vep
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+
+#include <atomic>
+#include <memory>
+
+namespace vep {
+
+class SceneDetector;
+
+// Runs a SceneDetector off the UI thread, on import or when asked, and
+// keeps its scores in the MediaCache: a file already analysed reports its
+// cuts without decoding. Cuts are picked from the cached scores at the
+// current sensitivity, so moving the slider is instant.
+//
+// splitPoints() gives where a clip would be cut to split it at its scenes.
+// Nothing applies them yet: there is no timeline model to split clips in,
+// so a "split at scenes" action has to do the cutting itself.
+class SceneDetectionJob : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(double sensitivity READ sensitivity WRITE setSensitivity NOTIFY sensitivityChanged)
+    Q_PROPERTY(int concurrency READ concurrency WRITE setConcurrency NOTIFY concurrencyChanged)
+
+public:
+    explicit SceneDetectionJob(QObject *parent = nullptr);
+    ~SceneDetectionJob() override;
+
+    bool isRunning() const { return m_running; }
+    double progress() const { return m_progress; }
+    double sensitivity() const { return m_sensitivity; }
+    void setSensitivity(double sensitivity);
+    int concurrency() const { return m_concurrency; }
+    void setConcurrency(int concurrency);
+
+    // Times in seconds from the start of the file at which a new shot
+    // begins; empty if the file has not been analysed. Never hashes: a file
+    // not hashed yet (by the import or start()) reads as not analysed.
+    Q_INVOKABLE QVariantList cuts(const QString &mediaPath) const;
+    // The cuts strictly inside a clip showing [sourceIn, sourceOut] of the
+    // file from timelineStart, in timeline seconds.
+    Q_INVOKABLE QVariantList splitPoints(const QString &mediaPath, double sourceIn, double sourceOut,
+                                         double timelineStart) const;
+
+public slots:
+    void start(const QString &mediaPath);
+    void cancel();
+
+signals:
+    // Also sent for a file that was already cached.
+    void cutsReady(const QString &mediaPath, const QVariantList &cuts);
+    void runningChanged();
+    void progressChanged();
+    void sensitivityChanged();
+    void concurrencyChanged();
+    void finished(bool completed, const QString &error);
+
+private:
+    void setRunning(bool running);
+
+    // Replaced only between runs, on the UI thread.
+    std::unique_ptr<SceneDetector> m_detector;
+    QFuture<void> m_future;
+    std::atomic<bool> m_cancel{false};
+    bool m_running = false;
+    double m_progress = 0.0;
+    double m_sensitivity = 0.5;
+    int m_concurrency = 0;
+};
+
+} // namespace vep
@@ -0,0 +1,133 @@
+#include "media/SceneDetector.h"
+
+#include "core/MediaCache.h"
+#include "core/SimdFloat4.h"
+#include "core/SpanRunner.h"
+#include "media/VideoFrameReader.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+constexpr int kThumbnailWidth = 64;
+constexpr int kHistogramBins = 16;
+// Mean thumbnail difference, in 8-bit levels, that counts as a complete
+// change of picture.
+constexpr float kDifferenceScale = 64.0f;
+// Spans shorter than this are not worth a reader (and a seek) of their own.
+constexpr double kMinSpanSeconds = 20.0;
+
+struct FrameSignature
+{
+    // Continuous CV_32FC3.
+    cv::Mat thumbnail;
+    // Per channel, normalised so that all three sum to 1.
+    std::array<float, 3 * kHistogramBins> histogram{};
+};
+
+// sum |a[i] - b[i]| for i < count.
+float sumAbsDifference(const float *a, const float *b, size_t count)
+{
+    Float4 sum;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        sum += abs(Float4::load(a + i) - Float4::load(b + i));
+    float lanes[4];
+    sum.store(lanes);
+    float total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < count; ++i)
+        total += std::fabs(a[i] - b[i]);
+    return total;
+}
+
+FrameSignature signatureOf(const cv::Mat &frame)
+{
+    FrameSignature signature;
+    const int height = std::max(1, int(std::lround(double(kThumbnailWidth) * frame.rows / frame.cols)));
+    cv::Mat small;
+    cv::resize(frame, small, cv::Size(kThumbnailWidth, height), 0.0, 0.0, cv::INTER_AREA);
+
+    signature.histogram.fill(0.0f);
+    const size_t pixels = small.total();
+    const uint8_t *p = small.ptr<uint8_t>();
+    for (size_t i = 0; i < pixels; ++i, p += 3) {
+        ++signature.histogram[p[0] * kHistogramBins / 256];
+        ++signature.histogram[kHistogramBins + p[1] * kHistogramBins / 256];
+        ++signature.histogram[2 * kHistogramBins + p[2] * kHistogramBins / 256];
+    }
+    const float norm = 1.0f / float(3 * pixels);
+    for (float &bin : signature.histogram)
+        bin *= norm;
+
+    small.convertTo(signature.thumbnail, CV_32F);
+    return signature;
+}
+
+// Half the mean pixel change, half the histogram change; both in [0, 1].
+float score(const FrameSignature &previous, const FrameSignature &current)
+{
+    const size_t values = current.thumbnail.total() * 3;
+    const float difference
+        = sumAbsDifference(previous.thumbnail.ptr<float>(), current.thumbnail.ptr<float>(), values) / float(values);
+    const float histogram
+        = 0.5f * sumAbsDifference(previous.histogram.data(), current.histogram.data(), current.histogram.size());
+    return 0.5f * std::min(1.0f, difference / kDifferenceScale) + 0.5f * std::min(1.0f, histogram);
+}
+
+} // namespace
+
+SceneDetector::SceneDetector(int concurrency)
+    : m_pool(concurrency)
+{
+}
+
+std::optional<SceneCuts> SceneDetector::analyze(const std::string &mediaPath, const Progress &progress)
+{
+    SceneCuts result;
+    int64_t total = 0;
+    {
+        const VideoFrameReader probe(mediaPath);
+        result.fps = probe.fps();
+        total = probe.frameCount();
+    }
+
+    const int64_t minSpan = std::max<int64_t>(1, std::llround(kMinSpanSeconds * result.fps));
+    std::optional<std::vector<float>> scores = runSpans<float>(
+        m_pool, total, minSpan, progress,
+        [&mediaPath](int64_t begin, int64_t end, std::atomic<int64_t> &done, const std::atomic<bool> &cancel) {
+            return compareFrames<float>(mediaPath, begin, end, done, cancel, signatureOf, score);
+        });
+    if (!scores)
+        return std::nullopt;
+    result.scores = std::move(*scores);
+    return result;
+}
+
+std::optional<SceneCuts> SceneDetector::cached(MediaCache &cache, const std::string &mediaPath)
+{
+    return cached(cache, cache.hashOf(mediaPath));
+}
+
+std::optional<SceneCuts> SceneDetector::cached(MediaCache &cache, ContentHash hash)
+{
+    const auto bytes = cache.read(hash, SceneCuts::kCacheKind);
+    if (!bytes)
+        return std::nullopt;
+    try {
+        return SceneCuts::deserialize(*bytes);
+    } catch (const std::runtime_error &) {
+        // Stale or damaged entry: drop it so the next analysis regenerates it.
+        cache.remove(hash, SceneCuts::kCacheKind);
+        return std::nullopt;
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/ContentHash.h"
+#include "core/ThreadPool.h"
+#include "media/SceneCuts.h"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class MediaCache;
+
+// Finds the shot changes in a video file. Every frame is reduced to a
+// 64-pixel-wide thumbnail and a colour histogram, and scored by how far
+// both moved from the previous frame; the difference kernels run on Float4
+// lanes. Decoding dominates, so the file is split into one span per worker
+// and the spans are decoded and scored concurrently, each from its own
+// reader.
+class SceneDetector
+{
+public:
+    // Called with the scored fraction in [0, 1]; return false to cancel.
+    using Progress = std::function<bool(double)>;
+
+    // concurrency <= 0 picks one worker per core, minus one.
+    explicit SceneDetector(int concurrency = 0);
+
+    SceneDetector(const SceneDetector &) = delete;
+    SceneDetector &operator=(const SceneDetector &) = delete;
+
+    // Scores every frame of the file. Returns nullopt if cancelled; throws
+    // std::runtime_error if the file cannot be opened. Progress is called on
+    // the calling thread. Must not be called from a task of the detector's
+    // own pool.
+    std::optional<SceneCuts> analyze(const std::string &mediaPath, const Progress &progress = {});
+
+    // The scores stored by a previous analysis of this content, if any.
+    // Throws std::runtime_error if the file cannot be hashed.
+    static std::optional<SceneCuts> cached(MediaCache &cache, const std::string &mediaPath);
+    // The same for content whose hash is already known (see
+    // MediaCache::knownHashOf()); never hashes, so the UI thread can use it.
+    static std::optional<SceneCuts> cached(MediaCache &cache, ContentHash hash);
+
+private:
+    ThreadPool m_pool;
+};
+
+} // namespace vep
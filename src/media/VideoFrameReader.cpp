@@ -0,0 +1,59 @@
+#include "media/VideoFrameReader.h"
+
+#include "media/FrameSeek.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace vep {
+
+VideoFrameReader::VideoFrameReader(const std::string &path)
+    : m_path(path)
+{
+    if (!m_capture.open(path, cv::CAP_FFMPEG) && !m_capture.open(path))
+        throw std::runtime_error("cannot open video " + path);
+    m_fps = m_capture.get(cv::CAP_PROP_FPS);
+    m_frameCount = std::max<int64_t>(0, int64_t(m_capture.get(cv::CAP_PROP_FRAME_COUNT)));
+    m_width = int(m_capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    m_height = int(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+    if (m_width <= 0 || m_height <= 0)
+        throw std::runtime_error("no video stream in " + path);
+    if (!(m_fps > 0.0))
+        m_fps = 25.0;
+}
+
+void VideoFrameReader::seek(int64_t frame)
+{
+    frame = std::max<int64_t>(0, frame);
+    if (frame == m_position)
+        return;
+    m_position = seekExactly(
+        frame,
+        [this](int64_t from) {
+            m_capture.set(cv::CAP_PROP_POS_FRAMES, double(from));
+            return std::max<int64_t>(0, std::llround(m_capture.get(cv::CAP_PROP_POS_FRAMES)));
+        },
+        [this] { return m_capture.grab(); });
+}
+
+bool VideoFrameReader::read(cv::Mat &frame)
+{
+    if (!m_capture.read(frame) || frame.empty())
+        return false;
+    ++m_position;
+    return true;
+}
+
+cv::Mat toGrey(const cv::Mat &frame, double scale)
+{
+    cv::Mat grey;
+    cv::cvtColor(frame, grey, cv::COLOR_BGR2GRAY);
+    if (scale < 1.0)
+        cv::resize(grey, grey, cv::Size(), scale, scale, cv::INTER_AREA);
+    return grey;
+}
+
+} // namespace vep
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace vep {
+
+// Sequential decode of a file's video stream to 8-bit BGR frames, for
+// analysis (tracking, scene detection, stabilisation) rather than display.
+// Frames are numbered from 0 at the stream's own rate, which is the time
+// base analysis results are stored in.
+class VideoFrameReader
+{
+public:
+    // Throws std::runtime_error if the file cannot be opened or has no
+    // video.
+    explicit VideoFrameReader(const std::string &path);
+
+    const std::string &path() const { return m_path; }
+    double fps() const { return m_fps; }
+    // 0 if the container does not say.
+    int64_t frameCount() const { return m_frameCount; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    // Index of the frame the next read() returns.
+    int64_t position() const { return m_position; }
+
+    // Resumes reading at `frame`. The backend's own seek can land a frame
+    // or so off, so this reads back where it landed and decodes forward to
+    // `frame` (see seekExactly()); position() is the real index afterwards,
+    // short of `frame` only if the stream ends first.
+    void seek(int64_t frame);
+    // Replaces `frame` with the next one. False at the end of the stream.
+    bool read(cv::Mat &frame);
+
+private:
+    std::string m_path;
+    cv::VideoCapture m_capture;
+    double m_fps = 0.0;
+    int64_t m_frameCount = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int64_t m_position = 0;
+};
+
+// Greyscale copy of a decoded frame, shrunk by `scale` if that is below 1,
+// for the analyses that follow features from frame to frame.
+cv::Mat toGrey(const cv::Mat &frame, double scale = 1.0);
+
+// The per-span half of a runSpans() analysis that compares each frame with
+// the one before it: decodes frames [begin, end) of the file (to its end
+// if end < 0) from begin - 1, reduces each with prepare(frame) and returns
+// compare(previous, current) for every frame from `begin` on. Values are
+// placed by frame index, so a frame the seek could not reach, and the
+// file's first frame, get T{}.
+template <typename T, typename Prepare, typename Compare>
+std::vector<T> compareFrames(const std::string &path, int64_t begin, int64_t end, std::atomic<int64_t> &done,
+                             const std::atomic<bool> &cancel, Prepare &&prepare, Compare &&compare)
+{
+    VideoFrameReader reader(path);
+    reader.seek(std::max<int64_t>(0, begin - 1));
+    std::vector<T> values;
+    std::optional<std::invoke_result_t<Prepare &, const cv::Mat &>> previous;
+    cv::Mat frame;
+    while ((end < 0 || reader.position() < end) && !cancel) {
+        const int64_t index = reader.position();
+        if (!reader.read(frame))
+            break;
+        auto current = prepare(frame);
+        if (index >= begin) {
+            values.resize(size_t(index - begin), T{});
+            values.push_back(previous ? compare(*previous, current) : T{});
+            ++done;
+        }
+        previous = std::move(current);
+    }
+    return values;
+}
+
+} // namespace vep
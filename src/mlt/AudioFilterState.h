@@ -0,0 +1,42 @@
+#pragma once
+
+#include "mlt/FilterState.h"
+
+#include <framework/mlt.h>
+
+#include <memory>
+
+namespace vep {
+
+// Per-filter state shared by the native audio filters. MLT calls get_audio
+// for whatever frame is being rendered, so the processor is rebuilt when the
+// stream format changes and its memory cleared whenever the frame position
+// is not the successor of the previous one (seek, loop, scrub).
+template <typename Processor>
+struct AudioFilterState
+{
+    std::unique_ptr<Processor> processor;
+    int frequency = 0;
+    int channels = 0;
+    mlt_position expected = -1;
+
+    // Returns true when the processor is fresh or discontinuous, in which
+    // case automation targets should be applied without gliding.
+    bool prepare(int frequency_, int channels_, mlt_position position)
+    {
+        if (!processor || frequency != frequency_ || channels != channels_) {
+            processor = std::make_unique<Processor>(double(frequency_), channels_);
+            frequency = frequency_;
+            channels = channels_;
+            expected = position + 1;
+            return true;
+        }
+        const bool discontinuous = position != expected;
+        if (discontinuous)
+            processor->reset();
+        expected = position + 1;
+        return discontinuous;
+    }
+};
+
+} // namespace vep
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <framework/mlt.h>
+
+namespace vep {
+
+// Close callback for a filter that keeps its per-instance state in
+// filter->child. When filter->close is set mlt_filter_close() leaves the
+// whole teardown to it, so after freeing the state this unhooks itself and
+// closes the service the way the default path would.
+template <typename State>
+void closeFilterWithState(mlt_filter filter)
+{
+    delete static_cast<State *>(filter->child);
+    filter->child = nullptr;
+    filter->close = nullptr;
+    filter->parent.close = nullptr;
+    mlt_service_close(&filter->parent);
+}
+
+} // namespace vep
@@ -0,0 +1,36 @@
+#include "mlt/VepFilters.h"
+
+#include <MltRepository.h>
+#include <framework/mlt.h>
+
+mlt_filter filter_vep_eq_init(mlt_profile profile, mlt_service_type type, const char *id, char *arg);
+mlt_filter filter_vep_compressor_init(mlt_profile profile, mlt_service_type type, const char *id, char *arg);
+mlt_filter filter_vep_reverb_init(mlt_profile profile, mlt_service_type type, const char *id, char *arg);
+mlt_filter filter_vep_bgremove_init(mlt_profile profile, mlt_service_type type, const char *id, char *arg);
+mlt_filter filter_vep_cornerpin_init(mlt_profile profile, mlt_service_type type, const char *id, char *arg);
+mlt_filter filter_vep_stabilize_init(mlt_profile profile, mlt_service_type type, const char *id, char *arg);
+mlt_filter filter_vep_lens_init(mlt_profile profile, mlt_service_type type, const char *id, char *arg);
+
+namespace vep {
+
+void registerMltFilters(Mlt::Repository *repository)
+{
+    if (!repository)
+        return;
+    repository->register_service(mlt_service_filter_type, "vep_eq",
+                                 reinterpret_cast<mlt_register_callback>(filter_vep_eq_init));
+    repository->register_service(mlt_service_filter_type, "vep_compressor",
+                                 reinterpret_cast<mlt_register_callback>(filter_vep_compressor_init));
+    repository->register_service(mlt_service_filter_type, "vep_reverb",
+                                 reinterpret_cast<mlt_register_callback>(filter_vep_reverb_init));
+    repository->register_service(mlt_service_filter_type, "vep_bgremove",
+                                 reinterpret_cast<mlt_register_callback>(filter_vep_bgremove_init));
+    repository->register_service(mlt_service_filter_type, "vep_cornerpin",
+                                 reinterpret_cast<mlt_register_callback>(filter_vep_cornerpin_init));
+    repository->register_service(mlt_service_filter_type, "vep_stabilize",
+                                 reinterpret_cast<mlt_register_callback>(filter_vep_stabilize_init));
+    repository->register_service(mlt_service_filter_type, "vep_lens",
+                                 reinterpret_cast<mlt_register_callback>(filter_vep_lens_init));
+}
+
+} // namespace vep
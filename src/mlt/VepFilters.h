@@ -0,0 +1,16 @@
+#pragma once
+
+namespace Mlt {
+class Repository;
+}
+
+namespace vep {
+
+// Registers the application's built-in MLT services (vep_eq, vep_compressor,
+// vep_reverb, vep_bgremove, vep_cornerpin, vep_stabilize, vep_lens, ...) so
+// they can be attached to any track or clip like the stock filters, without
+// going through the LADSPA/LV2 plugin hosts or a Python worker. Call once,
+// right after Mlt::Factory::init().
+void registerMltFilters(Mlt::Repository *repository);
+
+} // namespace vep
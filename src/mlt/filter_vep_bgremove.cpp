@@ -0,0 +1,287 @@
+#include "core/MediaCache.h"
+#include "mlt/FilterState.h"
+#include "segmentation/GuidedUpsampler.h"
+#include "segmentation/MaskFile.h"
+#include "segmentation/MaskPropagator.h"
+#include "segmentation/SegmentationModel.h"
+
+#include <framework/mlt.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Native background removal. Properties:
+//   model    rembg model name (u2net, u2netp, isnet-general-use...) or .onnx path
+//   threads  ONNX Runtime intra-op threads; 0 lets it pick
+//   mode     alpha (mask multiplied into the frame's alpha) | mask (the
+//            matte itself as a grey image, for checking edges)
+//   invert   0/1, keep the background instead of the subject
+//   resolution  frames taller than this many rows are segmented scaled down
+//            and the matte is brought back to full size by a guided filter
+//            against the full frame (see guidedUpsample()); 0 segments at
+//            full size. The network sees 320x320 either way, so beyond
+//            ~720 rows the extra pixels only cost resampling time.
+//   refine.radius, refine.epsilon  guided filter window (in scaled-down
+//            pixels) and edge regularisation
+//   sparse   0/1, run the model on adaptive keyframes only and carry the
+//            mask between them by optical flow (see MaskPropagator)
+//   sparse.threshold     edge-band warp error that forces a keyframe
+//   sparse.max_interval  longest run of propagated frames
+//   inferred_fraction    (read-only) share of frames the model actually ran
+//                        on since sparse mode was turned on
+//   cache    0/1, keep computed mattes in the media cache (see MaskFile),
+//            keyed by source frame, so replaying, re-trimming and exporting
+//            the clip reuse them; a change of model file, sparse settings
+//            or frame rate selects a fresh file. Only sources the import
+//            has hashed are cached; rendering never hashes media itself
+//
+// MLT pulls one frame at a time, so the filter runs batches of one; the
+// batched path of SegmentationModel is for offline jobs that own the
+// producer and can read frames ahead.
+
+namespace {
+
+struct BackgroundRemovalState
+{
+    std::shared_ptr<vep::SegmentationModel> model;
+    std::string modelName;
+    int threads = -1;
+    // Sparse mode: valid while frames arrive in order; anything else (a
+    // seek, parallel rendering) restarts it with an inferred frame.
+    std::unique_ptr<vep::MaskPropagator> propagator;
+    mlt_position expected = -1;
+    // Matte cache for the current source and settings; null if the source
+    // is not a file.
+    std::shared_ptr<vep::MaskFile> cache;
+    std::string cacheSignature;
+};
+
+// The shared model for the current properties, loaded on first use or when
+// they change. Null (with the error logged) if it cannot be loaded.
+std::shared_ptr<vep::SegmentationModel> currentModel(mlt_filter filter)
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    const char *name = mlt_properties_get(properties, "model");
+    const std::string modelName = name && *name ? name : "u2net";
+    const int threads = mlt_properties_get_int(properties, "threads");
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<BackgroundRemovalState *>(filter->child);
+    if (!state->model || state->modelName != modelName || state->threads != threads) {
+        state->model.reset();
+        state->propagator.reset();
+        state->modelName = modelName;
+        state->threads = threads;
+        try {
+            state->model = vep::SegmentationModel::shared(modelName, threads);
+        } catch (const std::runtime_error &e) {
+            mlt_log_error(MLT_FILTER_SERVICE(filter), "%s\n", e.what());
+        }
+    }
+    std::shared_ptr<vep::SegmentationModel> model = state->model;
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return model;
+}
+
+// The matte cache for the frame's source under the current settings,
+// opened when either changes. Null if caching is off or impossible.
+std::shared_ptr<vep::MaskFile> currentCache(mlt_filter filter, mlt_frame frame,
+                                            const std::shared_ptr<vep::SegmentationModel> &model)
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    if (!mlt_properties_get_int(properties, "cache"))
+        return nullptr;
+    mlt_producer producer = mlt_frame_get_original_producer(frame);
+    const char *resource = producer ? mlt_properties_get(MLT_PRODUCER_PROPERTIES(producer), "resource") : nullptr;
+    if (!resource || !*resource)
+        return nullptr;
+    mlt_profile profile = mlt_service_profile(MLT_FILTER_SERVICE(filter));
+    const bool sparse = mlt_properties_get_int(properties, "sparse") != 0;
+
+    // Everything the mattes depend on besides the source and the model
+    // file. Source frames, not timeline positions, index the file, so
+    // trimming or moving the clip keeps every matte it still shows.
+    std::string settings = std::to_string(profile ? profile->frame_rate_num : 0) + '/'
+        + std::to_string(profile ? profile->frame_rate_den : 0);
+    settings += " res " + std::to_string(mlt_properties_get_int(properties, "resolution")) + ' '
+        + std::to_string(mlt_properties_get_int(properties, "refine.radius")) + ' '
+        + std::to_string(mlt_properties_get_double(properties, "refine.epsilon"));
+    if (sparse)
+        settings += " sparse " + std::to_string(mlt_properties_get_double(properties, "sparse.threshold")) + ' '
+            + std::to_string(mlt_properties_get_int(properties, "sparse.max_interval"));
+
+    // Looked up, never computed, here: the import hashed the source, and
+    // the model hashed its file when it was loaded. A source nobody has
+    // hashed yet (or that changed since) is not cached.
+    vep::MediaCache &media = vep::MediaCache::instance();
+    const std::optional<vep::ContentHash> source = media.knownHashOf(resource);
+    const vep::ContentHash weights = model->contentHash();
+    if (!source)
+        return nullptr;
+    const std::string signature = source->hex() + '\n' + weights.hex() + '\n' + settings;
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<BackgroundRemovalState *>(filter->child);
+    if (state->cacheSignature != signature) {
+        state->cacheSignature = signature;
+        state->cache.reset();
+        try {
+            vep::Hasher64 key;
+            key.updateValue(weights.value);
+            key.update(settings);
+            state->cache = vep::MaskFile::shared(media.entryPath(*source, vep::MaskFile::kindFor(key.digest())));
+        } catch (const std::runtime_error &e) {
+            mlt_log_warning(MLT_FILTER_SERVICE(filter), "matte cache disabled: %s\n", e.what());
+        }
+    }
+    std::shared_ptr<vep::MaskFile> cache = state->cache;
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return cache;
+}
+
+void segmentSparse(mlt_filter filter, mlt_frame frame, const std::shared_ptr<vep::SegmentationModel> &model,
+                   const vep::SegmentationInput &input, uint8_t *mask)
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    const mlt_position position = mlt_filter_get_position(filter, frame);
+    vep::MaskPropagationSettings settings;
+    settings.errorThreshold = mlt_properties_get_double(properties, "sparse.threshold");
+    settings.maxInterval
+        = std::max(settings.minInterval, mlt_properties_get_int(properties, "sparse.max_interval"));
+
+    // Propagation needs the previous frame's result, so sparse frames are
+    // processed one at a time.
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<BackgroundRemovalState *>(filter->child);
+    if (!state->propagator)
+        state->propagator = std::make_unique<vep::MaskPropagator>(model, settings);
+    else
+        state->propagator->setSettings(settings);
+    if (position != state->expected)
+        state->propagator->reset();
+    state->expected = position + 1;
+    try {
+        state->propagator->process(input, mask, input.width);
+    } catch (...) {
+        state->expected = -1;
+        mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+        throw;
+    }
+    mlt_properties_set_double(properties, "inferred_fraction", state->propagator->inferredFraction());
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+}
+
+int filter_get_image(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height,
+                     int)
+{
+    mlt_filter filter = static_cast<mlt_filter>(mlt_frame_pop_service(frame));
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+
+    *format = mlt_image_rgba;
+    const int error = mlt_frame_get_image(frame, image, format, width, height, 1);
+    if (error || *format != mlt_image_rgba || *width <= 0 || *height <= 0)
+        return error;
+
+    const std::shared_ptr<vep::SegmentationModel> model = currentModel(filter);
+    if (!model)
+        return 0;
+
+    const int w = *width;
+    const int h = *height;
+    std::vector<uint8_t> mask(size_t(w) * size_t(h));
+    vep::SegmentationInput input;
+    input.pixels = *image;
+    input.width = w;
+    input.height = h;
+    input.stride = w * 4;
+    input.channels = 4;
+    const std::shared_ptr<vep::MaskFile> cache = currentCache(filter, frame, model);
+    const mlt_position source = mlt_frame_original_position(frame);
+    // A cached frame skips the propagator, which then restarts with an
+    // inferred frame at the next uncached one.
+    if (!cache || !cache->read(source, mask.data(), w, h, w)) {
+        std::vector<uint8_t> reducedPixels;
+        const vep::SegmentationInput reduced
+            = vep::reduceFrame(input, mlt_properties_get_int(properties, "resolution"), reducedPixels);
+        const bool scaled = reduced.pixels != input.pixels;
+        std::vector<uint8_t> lowMask(scaled ? size_t(reduced.width) * size_t(reduced.height) : 0);
+        uint8_t *target = scaled ? lowMask.data() : mask.data();
+        try {
+            if (mlt_properties_get_int(properties, "sparse"))
+                segmentSparse(filter, frame, model, reduced, target);
+            else
+                model->segment(reduced, target, reduced.width);
+            if (scaled) {
+                vep::GuidedUpsampleSettings refine;
+                refine.radius = mlt_properties_get_int(properties, "refine.radius");
+                refine.epsilon = mlt_properties_get_double(properties, "refine.epsilon");
+                vep::guidedUpsample(reduced, target, reduced.width, input, mask.data(), w, refine);
+            }
+        } catch (const std::runtime_error &e) {
+            mlt_log_error(MLT_FILTER_SERVICE(filter), "%s\n", e.what());
+            return 0;
+        }
+        if (cache) {
+            try {
+                cache->write(source, mask.data(), w, h, w);
+            } catch (const std::runtime_error &e) {
+                mlt_log_warning(MLT_FILTER_SERVICE(filter), "%s\n", e.what());
+            }
+        }
+    }
+
+    const bool invert = mlt_properties_get_int(properties, "invert") != 0;
+    const char *mode = mlt_properties_get(properties, "mode");
+    const bool showMask = mode && !std::strcmp(mode, "mask");
+    uint8_t *pixels = *image;
+    for (size_t i = 0; i < mask.size(); ++i) {
+        const unsigned matte = invert ? 255u - mask[i] : mask[i];
+        uint8_t *p = pixels + i * 4;
+        if (showMask) {
+            p[0] = p[1] = p[2] = uint8_t(matte);
+            p[3] = 255;
+        } else {
+            p[3] = uint8_t((p[3] * matte + 127u) / 255u);
+        }
+    }
+    return 0;
+}
+
+mlt_frame filter_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_service(frame, filter);
+    mlt_frame_push_get_image(frame, filter_get_image);
+    return frame;
+}
+
+} // namespace
+
+mlt_filter filter_vep_bgremove_init(mlt_profile, mlt_service_type, const char *, char *arg)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return nullptr;
+    filter->child = new BackgroundRemovalState();
+    filter->process = filter_process;
+    filter->close = vep::closeFilterWithState<BackgroundRemovalState>;
+
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties_set(properties, "model", arg && *arg ? arg : "u2net");
+    mlt_properties_set_int(properties, "threads", 0);
+    mlt_properties_set(properties, "mode", "alpha");
+    mlt_properties_set_int(properties, "invert", 0);
+    mlt_properties_set_int(properties, "resolution", 720);
+    mlt_properties_set_int(properties, "refine.radius", vep::GuidedUpsampleSettings().radius);
+    mlt_properties_set_double(properties, "refine.epsilon", vep::GuidedUpsampleSettings().epsilon);
+    mlt_properties_set_int(properties, "sparse", 0);
+    mlt_properties_set_double(properties, "sparse.threshold", vep::MaskPropagationSettings().errorThreshold);
+    mlt_properties_set_int(properties, "sparse.max_interval", vep::MaskPropagationSettings().maxInterval);
+    mlt_properties_set_double(properties, "inferred_fraction", 0.0);
+    mlt_properties_set_int(properties, "cache", 1);
+    return filter;
+}
@@ -0,0 +1,93 @@
+#include "audio/Compressor.h"
+#include "mlt/AudioFilterState.h"
+
+#include <framework/mlt.h>
+
+#include <string>
+
+// Properties (threshold, ratio and makeup are animatable):
+//   threshold   dB
+//   ratio       n:1, ignored when limiter=1
+//   knee        dB
+//   attack      ms
+//   release     ms
+//   makeup      dB
+//   lookahead   ms, output is delayed by this amount
+//   limiter     0/1
+// Read-only, updated per frame for meters:
+//   gain_reduction  dB (<= 0)
+
+using CompressorState = vep::AudioFilterState<vep::Compressor>;
+
+namespace {
+
+int filter_get_audio(mlt_frame frame, void **buffer, mlt_audio_format *format, int *frequency,
+                     int *channels, int *samples)
+{
+    mlt_filter filter = static_cast<mlt_filter>(mlt_frame_pop_audio(frame));
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+
+    *format = mlt_audio_f32le;
+    const int error = mlt_frame_get_audio(frame, buffer, format, frequency, channels, samples);
+    if (error || *format != mlt_audio_f32le || *samples <= 0)
+        return error;
+
+    const mlt_position position = mlt_filter_get_position(filter, frame);
+    const mlt_position length = mlt_filter_get_length2(filter, frame);
+
+    vep::CompressorSettings settings;
+    settings.thresholdDb = mlt_properties_anim_get_double(properties, "threshold", position, length);
+    settings.ratio = mlt_properties_anim_get_double(properties, "ratio", position, length);
+    settings.makeupDb = mlt_properties_anim_get_double(properties, "makeup", position, length);
+    settings.kneeDb = mlt_properties_get_double(properties, "knee");
+    settings.attackMs = mlt_properties_get_double(properties, "attack");
+    settings.releaseMs = mlt_properties_get_double(properties, "release");
+    settings.lookaheadMs = mlt_properties_get_double(properties, "lookahead");
+    settings.limiter = mlt_properties_get_int(properties, "limiter") != 0;
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<CompressorState *>(filter->child);
+    state->prepare(*frequency, *channels, position);
+    state->processor->setSettings(settings);
+    state->processor->process(static_cast<float *>(*buffer), *samples);
+    mlt_properties_set_double(properties, "gain_reduction", state->processor->gainReductionDb());
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return 0;
+}
+
+mlt_frame filter_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_audio(frame, filter);
+    mlt_frame_push_audio(frame, reinterpret_cast<void *>(filter_get_audio));
+    return frame;
+}
+
+} // namespace
+
+mlt_filter filter_vep_compressor_init(mlt_profile, mlt_service_type, const char *, char *arg)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return nullptr;
+    filter->child = new CompressorState();
+    filter->process = filter_process;
+    filter->close = vep::closeFilterWithState<CompressorState>;
+
+    const vep::CompressorSettings defaults;
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties_set_double(properties, "threshold", defaults.thresholdDb);
+    mlt_properties_set_double(properties, "ratio", defaults.ratio);
+    mlt_properties_set_double(properties, "knee", defaults.kneeDb);
+    mlt_properties_set_double(properties, "attack", defaults.attackMs);
+    mlt_properties_set_double(properties, "release", defaults.releaseMs);
+    mlt_properties_set_double(properties, "makeup", defaults.makeupDb);
+    mlt_properties_set_double(properties, "lookahead", defaults.lookaheadMs);
+    // "vep_compressor:limiter" creates a brickwall limiter preset.
+    const bool limiter = arg && std::string(arg) == "limiter";
+    mlt_properties_set_int(properties, "limiter", limiter ? 1 : 0);
+    if (limiter) {
+        mlt_properties_set_double(properties, "threshold", -1.0);
+        mlt_properties_set_double(properties, "release", 50.0);
+    }
+    return filter;
+}
@@ -0,0 +1,207 @@
+#include "core/MediaCache.h"
+#include "mlt/FilterState.h"
+#include "tracking/PlaneCache.h"
+
+#include <framework/mlt.h>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Pins an image onto a plane tracked by PlanarTrackingJob. Properties:
+//   plane    id of the plane, looked up in the media cache entry of the
+//            clip's source file
+//   image    the image to pin (PNG with alpha, JPEG...); its corners go to
+//            the plane's corners, top-left first, clockwise
+//   opacity  0..1, animatable
+//
+// The plane's per-frame homographies come from the cache, so playing,
+// scrubbing and exporting only warp the image; a plane tracked again is
+// picked up at the next frame. Frames the track does not cover are left
+// as they are.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct CornerPinState
+{
+    // The plane for the current source and id; null if none is cached.
+    std::shared_ptr<const vep::PlaneTrack> plane;
+    std::string planeSignature;
+    // RGBA, straight alpha.
+    cv::Mat image;
+    std::string imagePath;
+};
+
+// The cached plane for the frame's source, reloaded when the source, the
+// id or the cache entry changes.
+std::shared_ptr<const vep::PlaneTrack> currentPlane(mlt_filter filter, mlt_frame frame)
+{
+    mlt_producer producer = mlt_frame_get_original_producer(frame);
+    const char *resource = producer ? mlt_properties_get(MLT_PRODUCER_PROPERTIES(producer), "resource") : nullptr;
+    if (!resource || !*resource)
+        return nullptr;
+    const int id = mlt_properties_get_int(MLT_FILTER_PROPERTIES(filter), "plane");
+
+    // Looked up, never computed, here: PlanarTrackingJob hashed the source
+    // when it stored the plane. A source nobody has hashed yet (or that
+    // changed since) has no plane.
+    vep::MediaCache &media = vep::MediaCache::instance();
+    const std::optional<vep::ContentHash> hash = media.knownHashOf(resource);
+    if (!hash)
+        return nullptr;
+    std::error_code error;
+    const auto modified = fs::last_write_time(media.entryPath(*hash, vep::CachedPlanes::kCacheKind), error);
+    const std::string signature = hash->hex() + '\n' + std::to_string(id) + '\n'
+        + std::to_string(error ? 0 : modified.time_since_epoch().count());
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<CornerPinState *>(filter->child);
+    if (state->planeSignature != signature) {
+        state->planeSignature = signature;
+        state->plane.reset();
+        const vep::CachedPlanes cached = vep::PlaneCache(media).load(*hash);
+        if (const vep::PlaneTrack *plane = cached.find(id))
+            state->plane = std::make_shared<const vep::PlaneTrack>(*plane);
+    }
+    std::shared_ptr<const vep::PlaneTrack> plane = state->plane;
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return plane;
+}
+
+// The image to pin, loaded when the path changes. Empty if it cannot be.
+cv::Mat currentImage(mlt_filter filter)
+{
+    const char *value = mlt_properties_get(MLT_FILTER_PROPERTIES(filter), "image");
+    const std::string path = value ? value : "";
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<CornerPinState *>(filter->child);
+    if (state->imagePath != path) {
+        state->imagePath = path;
+        state->image.release();
+        const cv::Mat loaded = path.empty() ? cv::Mat() : cv::imread(path, cv::IMREAD_UNCHANGED);
+        if (loaded.depth() == CV_8U && loaded.channels() == 4)
+            cv::cvtColor(loaded, state->image, cv::COLOR_BGRA2RGBA);
+        else if (loaded.depth() == CV_8U && loaded.channels() == 3)
+            cv::cvtColor(loaded, state->image, cv::COLOR_BGR2RGBA);
+        else if (loaded.depth() == CV_8U && loaded.channels() == 1)
+            cv::cvtColor(loaded, state->image, cv::COLOR_GRAY2RGBA);
+        else if (!path.empty())
+            mlt_log_error(MLT_FILTER_SERVICE(filter), "cannot load %s\n", path.c_str());
+    }
+    cv::Mat image = state->image;
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return image;
+}
+
+int filter_get_image(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height,
+                     int)
+{
+    mlt_filter filter = static_cast<mlt_filter>(mlt_frame_pop_service(frame));
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+
+    *format = mlt_image_rgba;
+    const int error = mlt_frame_get_image(frame, image, format, width, height, 1);
+    if (error || *format != mlt_image_rgba || *width <= 0 || *height <= 0)
+        return error;
+
+    const std::shared_ptr<const vep::PlaneTrack> plane = currentPlane(filter, frame);
+    const cv::Mat overlay = currentImage(filter);
+    if (!plane || overlay.empty() || plane->fps <= 0.0 || plane->width <= 0 || plane->height <= 0)
+        return 0;
+
+    // Source frames are counted at the source's own rate.
+    mlt_profile profile = mlt_service_profile(MLT_FILTER_SERVICE(filter));
+    const double profileFps = profile ? mlt_profile_fps(profile) : plane->fps;
+    const int64_t source = std::llround(double(mlt_frame_original_position(frame)) * plane->fps / profileFps);
+    const vep::PlaneSample *sample = plane->sampleAt(source);
+    if (!sample)
+        return 0;
+
+    const mlt_position position = mlt_filter_get_position(filter, frame);
+    const mlt_position length = mlt_filter_get_length2(filter, frame);
+    const double opacity =
+        std::clamp(mlt_properties_anim_get_double(properties, "opacity", position, length), 0.0, 1.0);
+    if (opacity <= 0.0)
+        return 0;
+
+    // Image corners -> the quad on the reference frame -> this frame, in
+    // source pixels -> the (possibly scaled) frame MLT renders.
+    const std::vector<cv::Point2f> imageCorners{{0.0f, 0.0f},
+                                                {float(overlay.cols), 0.0f},
+                                                {float(overlay.cols), float(overlay.rows)},
+                                                {0.0f, float(overlay.rows)}};
+    std::vector<cv::Point2f> quad;
+    for (const vep::PlanePoint &point : plane->quad)
+        quad.emplace_back(point.x, point.y);
+    const cv::Matx33d pin(cv::getPerspectiveTransform(imageCorners, quad));
+    cv::Matx33d homography;
+    for (int i = 0; i < 9; ++i)
+        homography.val[i] = sample->homography[size_t(i)];
+    const cv::Matx33d toFrame(double(*width) / plane->width, 0.0, 0.0, 0.0, double(*height) / plane->height, 0.0,
+                              0.0, 0.0, 1.0);
+    const cv::Matx33d transform = toFrame * homography * pin;
+
+    // Only the part of the frame the image lands on is warped and blended.
+    std::vector<cv::Point2f> landed;
+    cv::perspectiveTransform(imageCorners, landed, cv::Mat(transform));
+    const cv::Rect bounds = (cv::boundingRect(landed) + cv::Size(1, 1)) & cv::Rect(0, 0, *width, *height);
+    if (bounds.area() == 0)
+        return 0;
+    const cv::Matx33d shift(1.0, 0.0, -bounds.x, 0.0, 1.0, -bounds.y, 0.0, 0.0, 1.0);
+    cv::Mat warped;
+    cv::warpPerspective(overlay, warped, cv::Mat(shift * transform), bounds.size(), cv::INTER_LINEAR,
+                        cv::BORDER_CONSTANT, cv::Scalar::all(0));
+
+    const unsigned strength = unsigned(std::lround(opacity * 255.0));
+    for (int y = 0; y < bounds.height; ++y) {
+        const uint8_t *src = warped.ptr<uint8_t>(y);
+        uint8_t *dst = *image + (size_t(bounds.y + y) * size_t(*width) + size_t(bounds.x)) * 4;
+        for (int x = 0; x < bounds.width; ++x, src += 4, dst += 4) {
+            const unsigned alpha = (src[3] * strength + 127u) / 255u;
+            if (!alpha)
+                continue;
+            const unsigned keep = 255u - alpha;
+            dst[0] = uint8_t((src[0] * alpha + dst[0] * keep + 127u) / 255u);
+            dst[1] = uint8_t((src[1] * alpha + dst[1] * keep + 127u) / 255u);
+            dst[2] = uint8_t((src[2] * alpha + dst[2] * keep + 127u) / 255u);
+            dst[3] = uint8_t(alpha + (dst[3] * keep + 127u) / 255u);
+        }
+    }
+    return 0;
+}
+
+mlt_frame filter_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_service(frame, filter);
+    mlt_frame_push_get_image(frame, filter_get_image);
+    return frame;
+}
+
+} // namespace
+
+mlt_filter filter_vep_cornerpin_init(mlt_profile, mlt_service_type, const char *, char *arg)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return nullptr;
+    filter->child = new CornerPinState();
+    filter->process = filter_process;
+    filter->close = vep::closeFilterWithState<CornerPinState>;
+
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties_set_int(properties, "plane", 0);
+    mlt_properties_set(properties, "image", arg && *arg ? arg : "");
+    mlt_properties_set_double(properties, "opacity", 1.0);
+    return filter;
+}
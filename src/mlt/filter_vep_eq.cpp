@@ -0,0 +1,119 @@
+#include "audio/ParametricEq.h"
+#include "mlt/AudioFilterState.h"
+
+#include <framework/mlt.h>
+
+#include <cstdio>
+#include <cstring>
+
+// Properties, all animatable except type/enabled (N = 0..7):
+//   band.N.enabled    0/1
+//   band.N.type       peak | lowshelf | highshelf | lowpass | highpass | notch
+//   band.N.frequency  Hz
+//   band.N.gain       dB
+//   band.N.q
+
+using EqState = vep::AudioFilterState<vep::ParametricEq>;
+
+namespace {
+
+vep::FilterShape shapeFromName(const char *name)
+{
+    if (!name)
+        return vep::FilterShape::Peaking;
+    if (!std::strcmp(name, "lowshelf"))
+        return vep::FilterShape::LowShelf;
+    if (!std::strcmp(name, "highshelf"))
+        return vep::FilterShape::HighShelf;
+    if (!std::strcmp(name, "lowpass"))
+        return vep::FilterShape::LowPass;
+    if (!std::strcmp(name, "highpass"))
+        return vep::FilterShape::HighPass;
+    if (!std::strcmp(name, "notch"))
+        return vep::FilterShape::Notch;
+    return vep::FilterShape::Peaking;
+}
+
+void applyBands(mlt_properties properties, vep::ParametricEq &eq, mlt_position position,
+                mlt_position length)
+{
+    char key[32];
+    for (int b = 0; b < vep::ParametricEq::kMaxBands; ++b) {
+        vep::EqBand band = eq.band(b);
+        std::snprintf(key, sizeof(key), "band.%d.enabled", b);
+        band.enabled = mlt_properties_get_int(properties, key) != 0;
+        if (band.enabled) {
+            std::snprintf(key, sizeof(key), "band.%d.type", b);
+            band.shape = shapeFromName(mlt_properties_get(properties, key));
+            std::snprintf(key, sizeof(key), "band.%d.frequency", b);
+            band.frequency = mlt_properties_anim_get_double(properties, key, position, length);
+            std::snprintf(key, sizeof(key), "band.%d.gain", b);
+            band.gainDb = mlt_properties_anim_get_double(properties, key, position, length);
+            std::snprintf(key, sizeof(key), "band.%d.q", b);
+            band.q = mlt_properties_anim_get_double(properties, key, position, length);
+        }
+        eq.setBand(b, band);
+    }
+}
+
+int filter_get_audio(mlt_frame frame, void **buffer, mlt_audio_format *format, int *frequency,
+                     int *channels, int *samples)
+{
+    mlt_filter filter = static_cast<mlt_filter>(mlt_frame_pop_audio(frame));
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+
+    *format = mlt_audio_f32le;
+    const int error = mlt_frame_get_audio(frame, buffer, format, frequency, channels, samples);
+    if (error || *format != mlt_audio_f32le || *samples <= 0)
+        return error;
+
+    const mlt_position position = mlt_filter_get_position(filter, frame);
+    const mlt_position length = mlt_filter_get_length2(filter, frame);
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<EqState *>(filter->child);
+    const bool snap = state->prepare(*frequency, *channels, position);
+    applyBands(properties, *state->processor, position, length);
+    if (snap)
+        state->processor->snapToTargets();
+    state->processor->process(static_cast<float *>(*buffer), *samples);
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return 0;
+}
+
+mlt_frame filter_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_audio(frame, filter);
+    mlt_frame_push_audio(frame, reinterpret_cast<void *>(filter_get_audio));
+    return frame;
+}
+
+} // namespace
+
+mlt_filter filter_vep_eq_init(mlt_profile, mlt_service_type, const char *, char *)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return nullptr;
+    filter->child = new EqState();
+    filter->process = filter_process;
+    filter->close = vep::closeFilterWithState<EqState>;
+
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    char key[32];
+    static const double defaultFrequencies[vep::ParametricEq::kMaxBands]
+        = {60.0, 150.0, 400.0, 1000.0, 2500.0, 6000.0, 12000.0, 16000.0};
+    for (int b = 0; b < vep::ParametricEq::kMaxBands; ++b) {
+        std::snprintf(key, sizeof(key), "band.%d.enabled", b);
+        mlt_properties_set_int(properties, key, 0);
+        std::snprintf(key, sizeof(key), "band.%d.type", b);
+        mlt_properties_set(properties, key, "peak");
+        std::snprintf(key, sizeof(key), "band.%d.frequency", b);
+        mlt_properties_set_double(properties, key, defaultFrequencies[b]);
+        std::snprintf(key, sizeof(key), "band.%d.gain", b);
+        mlt_properties_set_double(properties, key, 0.0);
+        std::snprintf(key, sizeof(key), "band.%d.q", b);
+        mlt_properties_set_double(properties, key, 0.707);
+    }
+    return filter;
+}
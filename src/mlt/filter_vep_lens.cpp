@@ -0,0 +1,113 @@
+#include "lens/LensProfileLibrary.h"
+#include "mlt/FilterState.h"
+
+#include <framework/mlt.h>
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+
+// Lens distortion correction (action-camera fisheye and the like).
+// Properties:
+//   profile   lens profile id (see LensProfileLibrary)
+//   strength  0..1, how far to straighten
+//   zoom      1 keeps the middle of the side edges in place; more crops
+//             the curved, partly empty borders away
+//
+// The remap table is built once per profile, frame size and setting and
+// shared with every other clip that uses it, so a frame costs one
+// fixed-point bilinear pass.
+
+namespace {
+
+struct LensState
+{
+    std::shared_ptr<const vep::LensRemapTable> table;
+    std::string signature;
+};
+
+// The table for the current settings and frame size; null (with the error
+// logged once) if the profile cannot be used.
+std::shared_ptr<const vep::LensRemapTable> currentTable(mlt_filter filter, const std::string &profile, int width,
+                                                        int height, const vep::LensCorrectionSettings &settings)
+{
+    char size[96];
+    std::snprintf(size, sizeof(size), "@%dx%d/%.4f/%.4f", width, height, settings.strength, settings.zoom);
+    const std::string signature = profile + size;
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<LensState *>(filter->child);
+    if (state->signature != signature) {
+        state->signature = signature;
+        state->table.reset();
+        try {
+            state->table = vep::LensProfileLibrary::instance().remapTable(profile, width, height, settings);
+        } catch (const std::exception &e) {
+            mlt_log_error(MLT_FILTER_SERVICE(filter), "%s\n", e.what());
+        }
+    }
+    std::shared_ptr<const vep::LensRemapTable> table = state->table;
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return table;
+}
+
+int filter_get_image(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height,
+                     int)
+{
+    mlt_filter filter = static_cast<mlt_filter>(mlt_frame_pop_service(frame));
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+
+    *format = mlt_image_rgba;
+    const int error = mlt_frame_get_image(frame, image, format, width, height, 1);
+    if (error || *format != mlt_image_rgba || *width < 2 || *height < 2)
+        return error;
+
+    const char *profile = mlt_properties_get(properties, "profile");
+    vep::LensCorrectionSettings settings;
+    settings.strength = mlt_properties_get_double(properties, "strength");
+    settings.zoom = mlt_properties_get_double(properties, "zoom");
+    if (!profile || !*profile || settings.strength <= 0.0)
+        return 0;
+    const std::shared_ptr<const vep::LensRemapTable> table
+        = currentTable(filter, profile, *width, *height, settings);
+    if (!table)
+        return 0;
+
+    // Remapped into a new buffer that the frame takes over, rather than
+    // copying the source aside and writing back over it.
+    const int bytes = *width * *height * 4;
+    auto *target = static_cast<uint8_t *>(mlt_pool_alloc(bytes));
+    if (!target)
+        return 0;
+    vep::applyLensRemap(*table, *image, *width * 4, target, *width * 4);
+    mlt_frame_set_image(frame, target, bytes, mlt_pool_release);
+    *image = target;
+    return 0;
+}
+
+mlt_frame filter_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_service(frame, filter);
+    mlt_frame_push_get_image(frame, filter_get_image);
+    return frame;
+}
+
+} // namespace
+
+mlt_filter filter_vep_lens_init(mlt_profile, mlt_service_type, const char *, char *arg)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return nullptr;
+    filter->child = new LensState();
+    filter->process = filter_process;
+    filter->close = vep::closeFilterWithState<LensState>;
+
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties_set(properties, "profile", arg && *arg ? arg : "");
+    mlt_properties_set_double(properties, "strength", 1.0);
+    mlt_properties_set_double(properties, "zoom", 1.0);
+    return filter;
+}
@@ -0,0 +1,144 @@
+#include "audio/ConvolutionReverb.h"
+#include "audio/ImpulseResponseLibrary.h"
+#include "core/ThreadPool.h"
+#include "mlt/AudioFilterState.h"
+
+#include <framework/mlt.h>
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+#include <string>
+
+// Properties:
+//   ir    impulse response: library id (see ImpulseResponseLibrary) or path
+//   wet   dB, animatable
+//   dry   dB, animatable
+//
+// A new IR is read, resampled and partitioned on a loader thread; the
+// previous one keeps playing until it is ready. Clearing "ir" goes through
+// the loader too, and replaced reverbs are freed there: a reverb's
+// partitions can run to megabytes, and its destructor waits for tail jobs
+// in flight, neither of which belongs on the audio thread.
+
+namespace {
+
+// A reverb built on the loader thread, without an IR if loading failed.
+struct LoadedReverb
+{
+    std::unique_ptr<vep::ConvolutionReverb> reverb;
+    std::string error;
+};
+
+struct ReverbState : vep::AudioFilterState<vep::ConvolutionReverb>
+{
+    std::string requested; // last "ir" value we tried to load
+    std::future<LoadedReverb> pending;
+};
+
+vep::ThreadPool &loaderPool()
+{
+    static vep::ThreadPool pool(1);
+    return pool;
+}
+
+// Destroys `garbage` on the loader thread. The pool has one thread and
+// runs tasks in order, so a pending load handed over here has finished (and
+// is freed there) by the time its turn comes.
+template <typename T>
+void dispose(T garbage)
+{
+    loaderPool().post([garbage = std::make_shared<T>(std::move(garbage))] {});
+}
+
+void updateImpulseResponse(mlt_filter filter, ReverbState &state, int frequency, int channels, int frames,
+                           bool rebuilt)
+{
+    const char *value = mlt_properties_get(MLT_FILTER_PROPERTIES(filter), "ir");
+    const std::string id = value ? value : "";
+    if (id != state.requested || rebuilt) {
+        state.requested = id;
+        // An unfinished load for the old value is left to complete unheard.
+        if (state.pending.valid())
+            dispose(std::move(state.pending));
+        state.pending = loaderPool().submit([id, frequency, channels, frames] {
+            LoadedReverb loaded;
+            loaded.reverb = std::make_unique<vep::ConvolutionReverb>(double(frequency), channels);
+            try {
+                if (!id.empty())
+                    loaded.reverb->setImpulseResponse(vep::ImpulseResponseLibrary::instance().load(id, frequency));
+            } catch (const std::exception &e) {
+                loaded.error = e.what();
+            }
+            loaded.reverb->prepare(frames);
+            return loaded;
+        });
+    }
+
+    if (!state.pending.valid() || state.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+    LoadedReverb loaded = state.pending.get();
+    if (!loaded.error.empty())
+        mlt_log_error(MLT_FILTER_SERVICE(filter), "%s\n", loaded.error.c_str());
+    loaded.reverb->continueFrom(*state.processor);
+    dispose(std::move(state.processor));
+    state.processor = std::move(loaded.reverb);
+}
+
+int filter_get_audio(mlt_frame frame, void **buffer, mlt_audio_format *format, int *frequency,
+                     int *channels, int *samples)
+{
+    mlt_filter filter = static_cast<mlt_filter>(mlt_frame_pop_audio(frame));
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+
+    *format = mlt_audio_f32le;
+    const int error = mlt_frame_get_audio(frame, buffer, format, frequency, channels, samples);
+    if (error || *format != mlt_audio_f32le || *samples <= 0)
+        return error;
+
+    const mlt_position position = mlt_filter_get_position(filter, frame);
+    const mlt_position length = mlt_filter_get_length2(filter, frame);
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<ReverbState *>(filter->child);
+    const bool rebuilt = !state->processor || state->frequency != *frequency
+                         || state->channels != *channels;
+    if (rebuilt && state->processor)
+        dispose(std::move(state->processor));
+    const bool snap = state->prepare(*frequency, *channels, position);
+    updateImpulseResponse(filter, *state, *frequency, *channels, *samples, rebuilt);
+    state->processor->prepare(*samples);
+    state->processor->setMix(mlt_properties_anim_get_double(properties, "wet", position, length),
+                             mlt_properties_anim_get_double(properties, "dry", position, length));
+    if (snap)
+        state->processor->reset();
+    state->processor->process(static_cast<float *>(*buffer), *samples);
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return 0;
+}
+
+mlt_frame filter_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_audio(frame, filter);
+    mlt_frame_push_audio(frame, reinterpret_cast<void *>(filter_get_audio));
+    return frame;
+}
+
+} // namespace
+
+mlt_filter filter_vep_reverb_init(mlt_profile, mlt_service_type, const char *, char *arg)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return nullptr;
+    filter->child = new ReverbState();
+    filter->process = filter_process;
+    filter->close = vep::closeFilterWithState<ReverbState>;
+
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties_set(properties, "ir", arg ? arg : "");
+    mlt_properties_set_double(properties, "wet", -12.0);
+    mlt_properties_set_double(properties, "dry", 0.0);
+    return filter;
+}
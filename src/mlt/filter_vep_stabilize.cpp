@@ -0,0 +1,173 @@
+#include "core/MediaCache.h"
+#include "mlt/FilterState.h"
+#include "stabilization/CameraPath.h"
+#include "stabilization/MotionAnalyzer.h"
+
+#include <framework/mlt.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Stabilises a clip from the camera motion StabilizationJob cached for its
+// source file. Properties:
+//   smoothing  half-width in seconds of the window the camera path is
+//              averaged over; larger is steadier, 0 turns the filter off
+//   crop       0..1, how much of the zoom that hides the uncovered borders
+//              to apply (0 shows them, 1 hides them all)
+//
+// Only the smoothing is computed here, from the cached steps, once per
+// change of source, smoothing or cache entry; each frame is then one
+// warp. Frames without cached motion are left as they are.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Stabilization
+{
+    double fps = 0.0;
+    int width = 0;
+    int height = 0;
+    vep::StabilizedPath path;
+};
+
+struct StabilizeState
+{
+    std::shared_ptr<const Stabilization> stabilization;
+    std::string signature;
+};
+
+// The smoothed path for the frame's source, recomputed when the source, the
+// smoothing or the cache entry changes; null if nothing is cached.
+std::shared_ptr<const Stabilization> currentStabilization(mlt_filter filter, mlt_frame frame, double smoothing)
+{
+    mlt_producer producer = mlt_frame_get_original_producer(frame);
+    const char *resource = producer ? mlt_properties_get(MLT_PRODUCER_PROPERTIES(producer), "resource") : nullptr;
+    if (!resource || !*resource)
+        return nullptr;
+
+    // Looked up, never computed, here: StabilizationJob hashed the source
+    // when it stored the motion. A source nobody has hashed yet (or that
+    // changed since) has none.
+    vep::MediaCache &media = vep::MediaCache::instance();
+    const std::optional<vep::ContentHash> hash = media.knownHashOf(resource);
+    if (!hash)
+        return nullptr;
+    std::error_code error;
+    const auto modified = fs::last_write_time(media.entryPath(*hash, vep::CameraMotion::kCacheKind), error);
+    const std::string signature = hash->hex() + '\n' + std::to_string(smoothing) + '\n'
+        + std::to_string(error ? 0 : modified.time_since_epoch().count());
+
+    mlt_service_lock(MLT_FILTER_SERVICE(filter));
+    auto *state = static_cast<StabilizeState *>(filter->child);
+    if (state->signature != signature) {
+        state->signature = signature;
+        state->stabilization.reset();
+        try {
+            if (const std::optional<vep::CameraMotion> motion = vep::MotionAnalyzer::cached(media, *hash)) {
+                auto stabilization = std::make_shared<Stabilization>();
+                stabilization->fps = motion->fps;
+                stabilization->width = motion->width;
+                stabilization->height = motion->height;
+                stabilization->path = vep::smoothCameraPath(*motion, smoothing);
+                state->stabilization = std::move(stabilization);
+            }
+        } catch (const std::runtime_error &e) {
+            mlt_log_warning(MLT_FILTER_SERVICE(filter), "%s\n", e.what());
+        }
+    }
+    std::shared_ptr<const Stabilization> stabilization = state->stabilization;
+    mlt_service_unlock(MLT_FILTER_SERVICE(filter));
+    return stabilization;
+}
+
+int filter_get_image(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height,
+                     int)
+{
+    mlt_filter filter = static_cast<mlt_filter>(mlt_frame_pop_service(frame));
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+
+    *format = mlt_image_rgba;
+    const int error = mlt_frame_get_image(frame, image, format, width, height, 1);
+    if (error || *format != mlt_image_rgba || *width <= 0 || *height <= 0)
+        return error;
+
+    const double smoothing = std::max(0.0, mlt_properties_get_double(properties, "smoothing"));
+    if (smoothing <= 0.0)
+        return 0;
+    const std::shared_ptr<const Stabilization> stabilization = currentStabilization(filter, frame, smoothing);
+    if (!stabilization || stabilization->fps <= 0.0 || stabilization->width <= 0 || stabilization->height <= 0)
+        return 0;
+
+    // Source frames are counted at the source's own rate.
+    mlt_profile profile = mlt_service_profile(MLT_FILTER_SERVICE(filter));
+    const double profileFps = profile ? mlt_profile_fps(profile) : stabilization->fps;
+    const int64_t source
+        = std::llround(double(mlt_frame_original_position(frame)) * stabilization->fps / profileFps);
+    const std::vector<vep::MotionStep> &corrections = stabilization->path.corrections;
+    if (source < 0 || source >= int64_t(corrections.size()))
+        return 0;
+    const vep::MotionStep &correction = corrections[size_t(source)];
+
+    // The correction in source pixels, turning about the centre like the
+    // steps it undoes (and like the zoom that hides its borders assumes),
+    // brought to the size MLT renders at, then the crop zoom about the centre.
+    const double sx = double(*width) / stabilization->width;
+    const double sy = double(*height) / stabilization->height;
+    const double c = std::cos(correction.angle);
+    const double s = std::sin(correction.angle);
+    const double mx = 0.5 * stabilization->width;
+    const double my = 0.5 * stabilization->height;
+    const cv::Matx33d toSource(1.0 / sx, 0.0, 0.0, 0.0, 1.0 / sy, 0.0, 0.0, 0.0, 1.0);
+    const cv::Matx33d correct(c, -s, mx - c * mx + s * my + correction.dx, s, c, my - s * mx - c * my + correction.dy,
+                              0.0, 0.0, 1.0);
+    const cv::Matx33d toFrame(sx, 0.0, 0.0, 0.0, sy, 0.0, 0.0, 0.0, 1.0);
+    const double crop = std::clamp(mlt_properties_get_double(properties, "crop"), 0.0, 1.0);
+    const double zoom = 1.0 + crop * (stabilization->path.zoom - 1.0);
+    const double cx = 0.5 * *width;
+    const double cy = 0.5 * *height;
+    const cv::Matx33d scale(zoom, 0.0, cx * (1.0 - zoom), 0.0, zoom, cy * (1.0 - zoom), 0.0, 0.0, 1.0);
+    const cv::Matx33d transform = scale * toFrame * correct * toSource;
+
+    const cv::Mat pixels(*height, *width, CV_8UC4, *image);
+    cv::Mat warped;
+    cv::warpAffine(pixels, warped, cv::Mat(transform).rowRange(0, 2), pixels.size(), cv::INTER_LINEAR,
+                   cv::BORDER_REPLICATE);
+    std::memcpy(*image, warped.data, size_t(*width) * size_t(*height) * 4);
+    return 0;
+}
+
+mlt_frame filter_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_service(frame, filter);
+    mlt_frame_push_get_image(frame, filter_get_image);
+    return frame;
+}
+
+} // namespace
+
+mlt_filter filter_vep_stabilize_init(mlt_profile, mlt_service_type, const char *, char *)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return nullptr;
+    filter->child = new StabilizeState();
+    filter->process = filter_process;
+    filter->close = vep::closeFilterWithState<StabilizeState>;
+
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties_set_double(properties, "smoothing", 1.0);
+    mlt_properties_set_double(properties, "crop", 1.0);
+    return filter;
+}
@@ -0,0 +1,227 @@
+#include "segmentation/GuidedUpsampler.h"
+
+#include "core/SimdFloat4.h"
+#include "core/ThreadPool.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+
+namespace vep {
+
+namespace {
+
+// Rec. 601 luma, the weights cv::cvtColor uses for the small guide; the two
+// guides must agree or the fitted model is applied to different values.
+constexpr float kRed = 0.299f;
+constexpr float kGreen = 0.587f;
+constexpr float kBlue = 0.114f;
+constexpr int kBandRows = 32;
+// Floor for GuidedUpsampleSettings::epsilon: a flat window has a variance
+// of zero (or a rounding error either side of it), and a / 0 there would
+// turn the matte into NaN.
+constexpr double kMinEpsilon = 1e-6;
+
+// For each output coordinate, the input sample to its left/top and the
+// weight of the next one, sampling pixel centres.
+struct AxisMap
+{
+    std::vector<int> first;
+    std::vector<float> weight;
+};
+
+AxisMap axisMap(int outSize, int inSize)
+{
+    AxisMap map;
+    map.first.resize(size_t(outSize));
+    map.weight.resize(size_t(outSize));
+    const double scale = double(inSize) / double(outSize);
+    for (int i = 0; i < outSize; ++i) {
+        const double at = std::clamp((i + 0.5) * scale - 0.5, 0.0, double(inSize - 1));
+        const int first = std::min(int(at), std::max(inSize - 2, 0));
+        map.first[size_t(i)] = first;
+        map.weight[size_t(i)] = inSize > 1 ? float(at - first) : 0.0f;
+    }
+    return map;
+}
+
+cv::Mat view(const SegmentationInput &frame)
+{
+    return cv::Mat(frame.height, frame.width, frame.channels == 4 ? CV_8UC4 : CV_8UC3,
+                   const_cast<uint8_t *>(frame.pixels), size_t(frame.stride));
+}
+
+// Coefficient maps of the guided filter, fitted at low resolution and
+// already box-averaged, so the matte at a pixel is a * grey + b.
+struct Coefficients
+{
+    cv::Mat a;
+    cv::Mat b;
+};
+
+Coefficients fit(const SegmentationInput &reduced, const uint8_t *lowMask, int lowMaskStride,
+                 const GuidedUpsampleSettings &settings)
+{
+    cv::Mat grey;
+    cv::cvtColor(view(reduced), grey, reduced.channels == 4 ? cv::COLOR_RGBA2GRAY : cv::COLOR_RGB2GRAY);
+    cv::Mat guide, matte;
+    grey.convertTo(guide, CV_32F, 1.0 / 255.0);
+    cv::Mat(reduced.height, reduced.width, CV_8UC1, const_cast<uint8_t *>(lowMask), size_t(lowMaskStride))
+        .convertTo(matte, CV_32F, 1.0 / 255.0);
+
+    const int side = 2 * std::max(1, settings.radius) + 1;
+    const cv::Size window(side, side);
+    auto mean = [&](const cv::Mat &m) {
+        cv::Mat out;
+        cv::boxFilter(m, out, CV_32F, window, cv::Point(-1, -1), true, cv::BORDER_REFLECT);
+        return out;
+    };
+    const cv::Mat meanGuide = mean(guide);
+    const cv::Mat meanMatte = mean(matte);
+    const cv::Mat spread = mean(guide.mul(guide)) - meanGuide.mul(meanGuide);
+    const cv::Mat variance = cv::max(spread, 0.0);
+    const cv::Mat covariance = mean(guide.mul(matte)) - meanGuide.mul(meanMatte);
+    const cv::Mat a = covariance / (variance + std::max(settings.epsilon, kMinEpsilon));
+    const cv::Mat b = meanMatte - a.mul(meanGuide);
+    return Coefficients{mean(a), mean(b)};
+}
+
+class BandRenderer
+{
+public:
+    BandRenderer(const Coefficients &coefficients, const SegmentationInput &frame, uint8_t *mask, int maskStride)
+        : m_coefficients(coefficients)
+        , m_frame(frame)
+        , m_mask(mask)
+        , m_maskStride(maskStride)
+        , m_columns(axisMap(frame.width, coefficients.a.cols))
+        , m_rows(axisMap(frame.height, coefficients.a.rows))
+    {
+    }
+
+    int bandCount() const { return (m_frame.height + kBandRows - 1) / kBandRows; }
+
+    void render(int band) const
+    {
+        // Padded to whole Float4s; the padding is computed and never stored.
+        const size_t width = (size_t(m_frame.width) + 3) & ~size_t(3);
+        std::vector<float> upperA(width), upperB(width), lowerA(width), lowerB(width), grey(width), out(width);
+        int upperRow = -1;
+        int lowerRow = -1;
+        const int lowRows = m_coefficients.a.rows;
+
+        const int first = band * kBandRows;
+        const int last = std::min(first + kBandRows, m_frame.height);
+        for (int y = first; y < last; ++y) {
+            const int top = m_rows.first[size_t(y)];
+            const int bottom = std::min(top + 1, lowRows - 1);
+            if (upperRow != top) {
+                if (lowerRow == top) {
+                    upperA.swap(lowerA);
+                    upperB.swap(lowerB);
+                    std::swap(upperRow, lowerRow);
+                } else {
+                    expandRow(top, upperA.data(), upperB.data());
+                    upperRow = top;
+                }
+            }
+            if (lowerRow != bottom) {
+                expandRow(bottom, lowerA.data(), lowerB.data());
+                lowerRow = bottom;
+            }
+
+            const uint8_t *pixels = m_frame.pixels + size_t(y) * size_t(m_frame.stride);
+            for (int x = 0; x < m_frame.width; ++x) {
+                const uint8_t *p = pixels + size_t(x) * size_t(m_frame.channels);
+                grey[size_t(x)] = (kRed * p[0] + kGreen * p[1] + kBlue * p[2]) * (1.0f / 255.0f);
+            }
+
+            const Float4 wy(m_rows.weight[size_t(y)]);
+            const Float4 zero(0.0f);
+            const Float4 one(1.0f);
+            const Float4 scale(255.0f);
+            const Float4 half(0.5f);
+            for (size_t x = 0; x < width; x += 4) {
+                const Float4 ua = Float4::load(&upperA[x]);
+                const Float4 ub = Float4::load(&upperB[x]);
+                const Float4 a = ua + (Float4::load(&lowerA[x]) - ua) * wy;
+                const Float4 b = ub + (Float4::load(&lowerB[x]) - ub) * wy;
+                const Float4 matte = min(max(a * Float4::load(&grey[x]) + b, zero), one);
+                (matte * scale + half).store(&out[x]);
+            }
+            uint8_t *row = m_mask + size_t(y) * size_t(m_maskStride);
+            for (int x = 0; x < m_frame.width; ++x)
+                row[x] = uint8_t(out[size_t(x)]);
+        }
+    }
+
+private:
+    // One low-resolution row of a and b, interpolated to the frame width.
+    void expandRow(int lowRow, float *a, float *b) const
+    {
+        const float *rowA = m_coefficients.a.ptr<float>(lowRow);
+        const float *rowB = m_coefficients.b.ptr<float>(lowRow);
+        const int lastColumn = m_coefficients.a.cols - 1;
+        for (int x = 0; x < m_frame.width; ++x) {
+            const int left = m_columns.first[size_t(x)];
+            const int right = std::min(left + 1, lastColumn);
+            const float w = m_columns.weight[size_t(x)];
+            a[x] = rowA[left] + (rowA[right] - rowA[left]) * w;
+            b[x] = rowB[left] + (rowB[right] - rowB[left]) * w;
+        }
+    }
+
+    const Coefficients &m_coefficients;
+    SegmentationInput m_frame;
+    uint8_t *m_mask;
+    int m_maskStride;
+    AxisMap m_columns;
+    AxisMap m_rows;
+};
+
+} // namespace
+
+SegmentationInput reduceFrame(const SegmentationInput &frame, int maxHeight, std::vector<uint8_t> &storage)
+{
+    if (maxHeight <= 0 || frame.height <= maxHeight)
+        return frame;
+    SegmentationInput reduced;
+    reduced.height = maxHeight;
+    reduced.width = std::max(1, int(double(frame.width) * maxHeight / frame.height + 0.5));
+    reduced.channels = frame.channels;
+    reduced.stride = reduced.width * frame.channels;
+    storage.resize(size_t(reduced.stride) * size_t(reduced.height));
+    cv::Mat target(reduced.height, reduced.width, frame.channels == 4 ? CV_8UC4 : CV_8UC3, storage.data(),
+                   size_t(reduced.stride));
+    cv::resize(view(frame), target, target.size(), 0.0, 0.0, cv::INTER_AREA);
+    reduced.pixels = storage.data();
+    return reduced;
+}
+
+void guidedUpsample(const SegmentationInput &reduced, const uint8_t *lowMask, int lowMaskStride,
+                    const SegmentationInput &frame, uint8_t *mask, int maskStride,
+                    const GuidedUpsampleSettings &settings, ThreadPool *pool)
+{
+    const Coefficients coefficients = fit(reduced, lowMask, lowMaskStride, settings);
+    const BandRenderer renderer(coefficients, frame, mask, maskStride);
+
+    // Bands are handed out one at a time, so a helper that starts late just
+    // takes fewer.
+    ThreadPool &workers = pool ? *pool : ThreadPool::shared();
+    std::atomic<int> next{0};
+    auto work = [&] {
+        for (int band = next++; band < renderer.bandCount(); band = next++)
+            renderer.render(band);
+    };
+    std::vector<std::future<void>> helpers;
+    const int helperCount = std::min(workers.threadCount(), renderer.bandCount() - 1);
+    for (int i = 0; i < helperCount; ++i)
+        helpers.push_back(workers.submit(work));
+    work();
+    for (auto &helper : helpers)
+        helper.get();
+}
+
+} // namespace vep
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "segmentation/SegmentationModel.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+
+class ThreadPool;
+
+struct GuidedUpsampleSettings
+{
+    // Window radius, in pixels of the low-resolution matte.
+    int radius = 4;
+    // Regularisation on guide intensities in [0, 1]: edges with less local
+    // contrast than about sqrt(epsilon) are smoothed rather than followed.
+    // Values below 1e-6 are taken as 1e-6.
+    double epsilon = 1e-4;
+};
+
+// The frame scaled down (area averaging, aspect kept) to at most maxHeight
+// rows, in the frame's channel layout, with the pixels held in `storage`.
+// A frame that is no taller is returned as is. maxHeight <= 0 never scales.
+SegmentationInput reduceFrame(const SegmentationInput &frame, int maxHeight, std::vector<uint8_t> &storage);
+
+// Brings a matte computed on a reduced frame (see reduceFrame()) back to
+// full resolution with a fast guided filter (He & Sun, 2015): the local
+// linear model matte ~ a * grey + b is fitted on the small frame, and only
+// the smooth a and b are interpolated, so the matte snaps to edges (hair,
+// fingers) that the full-resolution frame shows and the small one blurs.
+//
+// The fit costs a few box filters at low resolution; the full-resolution
+// pass is a bilinear interpolation and one multiply-add per pixel, run in
+// row bands on `pool` (ThreadPool::shared() if null) with the caller
+// taking a band too, so it must not be called from a task of that pool.
+void guidedUpsample(const SegmentationInput &reduced, const uint8_t *lowMask, int lowMaskStride,
+                    const SegmentationInput &frame, uint8_t *mask, int maskStride,
+                    const GuidedUpsampleSettings &settings = {}, ThreadPool *pool = nullptr);
+
+} // namespace vep
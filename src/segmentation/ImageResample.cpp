@@ -0,0 +1,124 @@
+#include "segmentation/ImageResample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+constexpr int kPrecisionBits = 32 - 8 - 2;
+constexpr double kSupport = 3.0;
+
+double sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    x *= 3.14159265358979323846;
+    return std::sin(x) / x;
+}
+
+double lanczos(double x)
+{
+    return (-kSupport <= x && x < kSupport) ? sinc(x) * sinc(x / kSupport) : 0.0;
+}
+
+struct Coefficients
+{
+    int taps = 0;
+    std::vector<int> first; // per output pixel
+    std::vector<int> count;
+    std::vector<int32_t> weights; // taps per output pixel
+};
+
+// Pillow's precompute_coeffs + normalize_coeffs_8bpc.
+Coefficients coefficients(int inSize, int outSize)
+{
+    const double scale = double(inSize) / double(outSize);
+    const double filterScale = std::max(scale, 1.0);
+    const double support = kSupport * filterScale;
+    Coefficients c;
+    c.taps = int(std::ceil(support)) * 2 + 1;
+    c.first.resize(size_t(outSize));
+    c.count.resize(size_t(outSize));
+    c.weights.assign(size_t(outSize) * size_t(c.taps), 0);
+    std::vector<double> k(size_t(c.taps));
+    for (int xx = 0; xx < outSize; ++xx) {
+        const double center = (xx + 0.5) * scale;
+        const double ss = 1.0 / filterScale;
+        const int xmin = std::max(int(center - support + 0.5), 0);
+        const int xmax = std::min(int(center + support + 0.5), inSize) - xmin;
+        double total = 0.0;
+        for (int x = 0; x < xmax; ++x) {
+            k[size_t(x)] = lanczos((x + xmin - center + 0.5) * ss);
+            total += k[size_t(x)];
+        }
+        int32_t *weights = &c.weights[size_t(xx) * size_t(c.taps)];
+        for (int x = 0; x < xmax; ++x) {
+            const double w = total != 0.0 ? k[size_t(x)] / total : k[size_t(x)];
+            weights[x] = int32_t(w < 0.0 ? -0.5 + w * (1 << kPrecisionBits) : 0.5 + w * (1 << kPrecisionBits));
+        }
+        c.first[size_t(xx)] = xmin;
+        c.count[size_t(xx)] = xmax;
+    }
+    return c;
+}
+
+uint8_t clip8(int32_t value)
+{
+    value >>= kPrecisionBits;
+    return uint8_t(std::clamp(value, 0, 255));
+}
+
+} // namespace
+
+void resizeLanczos(const uint8_t *src, int srcWidth, int srcHeight, int srcStride, int channels, uint8_t *dst,
+                   int dstWidth, int dstHeight, int dstStride)
+{
+    // Horizontal pass into a temporary (skipped when the width is kept).
+    std::vector<uint8_t> horizontal;
+    const uint8_t *rows = src;
+    int rowStride = srcStride;
+    if (dstWidth != srcWidth) {
+        const Coefficients h = coefficients(srcWidth, dstWidth);
+        rowStride = dstWidth * channels;
+        horizontal.resize(size_t(rowStride) * size_t(srcHeight));
+        for (int y = 0; y < srcHeight; ++y) {
+            const uint8_t *in = src + size_t(y) * size_t(srcStride);
+            uint8_t *out = horizontal.data() + size_t(y) * size_t(rowStride);
+            for (int xx = 0; xx < dstWidth; ++xx) {
+                const int32_t *k = &h.weights[size_t(xx) * size_t(h.taps)];
+                const int first = h.first[size_t(xx)];
+                for (int c = 0; c < channels; ++c) {
+                    int32_t sum = 1 << (kPrecisionBits - 1);
+                    for (int x = 0; x < h.count[size_t(xx)]; ++x)
+                        sum += int32_t(in[(first + x) * channels + c]) * k[x];
+                    out[xx * channels + c] = clip8(sum);
+                }
+            }
+        }
+        rows = horizontal.data();
+    }
+
+    const int rowBytes = dstWidth * channels;
+    if (dstHeight == srcHeight) {
+        for (int y = 0; y < dstHeight; ++y)
+            std::copy_n(rows + size_t(y) * size_t(rowStride), rowBytes, dst + size_t(y) * size_t(dstStride));
+        return;
+    }
+    const Coefficients v = coefficients(srcHeight, dstHeight);
+    for (int yy = 0; yy < dstHeight; ++yy) {
+        const int32_t *k = &v.weights[size_t(yy) * size_t(v.taps)];
+        const int first = v.first[size_t(yy)];
+        uint8_t *out = dst + size_t(yy) * size_t(dstStride);
+        for (int i = 0; i < rowBytes; ++i) {
+            int32_t sum = 1 << (kPrecisionBits - 1);
+            for (int y = 0; y < v.count[size_t(yy)]; ++y)
+                sum += int32_t(rows[size_t(first + y) * size_t(rowStride) + size_t(i)]) * k[y];
+            out[i] = clip8(sum);
+        }
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vep {
+
+// Lanczos-3 resize of 8-bit interleaved images, bit-exact with Pillow's
+// Image.resize(..., LANCZOS): same antialiasing support, same 22-bit
+// fixed-point coefficients, horizontal pass then vertical, rounded to 8 bits
+// in between. rembg resizes with Pillow on the way into and out of the
+// network, so matching it here is what makes native masks match rembg's.
+void resizeLanczos(const uint8_t *src, int srcWidth, int srcHeight, int srcStride, int channels, uint8_t *dst,
+                   int dstWidth, int dstHeight, int dstStride);
+
+} // namespace vep
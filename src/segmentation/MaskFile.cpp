@@ -0,0 +1,355 @@
+#include "segmentation/MaskFile.h"
+
+#include "core/ContentHash.h"
+
+#include <lz4.h>
+#include <opencv2/imgproc.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace vep {
+
+namespace {
+
+constexpr char kMagic[9] = "VEPMASK1";
+constexpr uint64_t kHeaderBytes = 8;
+constexpr uint64_t kRecordHeaderBytes = 40;
+constexpr uint32_t kCodecRle = 0;
+constexpr uint32_t kCodecRleLz4 = 1;
+// Superseded records are only rewritten away once they are worth the I/O.
+constexpr uint64_t kMinCompactBytes = 4 << 20;
+
+struct RecordHeader
+{
+    int64_t frame;
+    uint32_t width;
+    uint32_t height;
+    uint32_t codec;
+    uint32_t rawBytes;
+    uint32_t payloadBytes;
+    uint32_t reserved;
+    uint64_t checksum;
+};
+static_assert(sizeof(RecordHeader) == kRecordHeaderBytes, "record header must match the file layout");
+
+void putRun(std::vector<uint8_t> &out, uint8_t value, uint32_t length)
+{
+    out.push_back(value);
+    while (length >= 0x80) {
+        out.push_back(uint8_t(length | 0x80));
+        length >>= 7;
+    }
+    out.push_back(uint8_t(length));
+}
+
+uint64_t checksumOf(const uint8_t *data, size_t size)
+{
+    Hasher64 hasher;
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+void createEmpty(const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(kMagic, 8);
+    if (!out.flush())
+        throw std::runtime_error("cannot create mask file " + path);
+}
+
+} // namespace
+
+std::vector<uint8_t> encodeMask(const uint8_t *mask, int width, int height, int stride, size_t *rawSize)
+{
+    std::vector<uint8_t> runs;
+    runs.reserve(size_t(height) * 8);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = mask + size_t(y) * size_t(stride);
+        int x = 0;
+        while (x < width) {
+            const uint8_t value = row[x];
+            int end = x + 1;
+            while (end < width && row[end] == value)
+                ++end;
+            putRun(runs, value, uint32_t(end - x));
+            x = end;
+        }
+    }
+
+    // Neighbouring rows of a matte are alike, which LZ4 picks up and the
+    // per-row runs cannot.
+    std::vector<uint8_t> packed(size_t(LZ4_compressBound(int(runs.size()))));
+    const int packedBytes = LZ4_compress_default(reinterpret_cast<const char *>(runs.data()),
+                                                 reinterpret_cast<char *>(packed.data()), int(runs.size()),
+                                                 int(packed.size()));
+    *rawSize = runs.size();
+    if (packedBytes <= 0 || size_t(packedBytes) >= runs.size())
+        return runs;
+    packed.resize(size_t(packedBytes));
+    return packed;
+}
+
+bool decodeMask(const uint8_t *data, size_t size, size_t rawSize, uint8_t *mask, int width, int height, int stride)
+{
+    std::vector<uint8_t> unpacked;
+    if (size < rawSize) {
+        unpacked.resize(rawSize);
+        if (LZ4_decompress_safe(reinterpret_cast<const char *>(data), reinterpret_cast<char *>(unpacked.data()),
+                                int(size), int(rawSize))
+            != int(rawSize))
+            return false;
+        data = unpacked.data();
+        size = unpacked.size();
+    }
+
+    size_t pos = 0;
+    for (int y = 0; y < height; ++y) {
+        uint8_t *row = mask + size_t(y) * size_t(stride);
+        int x = 0;
+        while (x < width) {
+            if (pos >= size)
+                return false;
+            const uint8_t value = data[pos++];
+            uint32_t length = 0;
+            for (int shift = 0;; shift += 7) {
+                if (pos >= size || shift > 28)
+                    return false;
+                const uint8_t byte = data[pos++];
+                length |= uint32_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    break;
+            }
+            if (length == 0 || length > uint32_t(width - x))
+                return false;
+            std::memset(row + x, value, length);
+            x += int(length);
+        }
+    }
+    return pos == size;
+}
+
+MaskFile::MaskFile(const std::string &path)
+    : m_path(path)
+{
+    std::error_code error;
+    fs::create_directories(fs::path(path).parent_path(), error);
+    if (!fs::is_regular_file(path, error) || fs::file_size(path, error) < kHeaderBytes)
+        createEmpty(path);
+
+    m_stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    char magic[8] = {};
+    if (!m_stream || !m_stream.read(magic, 8) || std::memcmp(magic, kMagic, 8)) {
+        // Written by another version: it is only a cache, start over.
+        m_stream.close();
+        createEmpty(path);
+        m_stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!m_stream)
+            throw std::runtime_error("cannot open mask file " + path);
+    }
+
+    m_end = scan();
+    if (m_end < fs::file_size(path, error)) {
+        m_stream.close();
+        fs::resize_file(path, m_end, error);
+        m_stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (error || !m_stream)
+            throw std::runtime_error("cannot repair mask file " + path);
+    }
+
+    const uint64_t dead = m_end - kHeaderBytes - m_liveBytes;
+    if (dead > m_liveBytes && dead > kMinCompactBytes)
+        compact();
+}
+
+std::shared_ptr<MaskFile> MaskFile::shared(const std::string &path)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<MaskFile>> open;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto file = open[path].lock())
+        return file;
+    auto file = std::make_shared<MaskFile>(path);
+    open[path] = file;
+    return file;
+}
+
+std::string MaskFile::kindFor(uint64_t settingsHash)
+{
+    return "mask-" + ContentHash{settingsHash}.hex();
+}
+
+uint64_t MaskFile::scan()
+{
+    std::error_code error;
+    const uint64_t size = fs::file_size(m_path, error);
+    uint64_t pos = kHeaderBytes;
+    m_index.clear();
+    m_liveBytes = 0;
+    while (pos + kRecordHeaderBytes <= size) {
+        RecordHeader header;
+        m_stream.clear();
+        m_stream.seekg(std::streamoff(pos));
+        if (!m_stream.read(reinterpret_cast<char *>(&header), kRecordHeaderBytes))
+            break;
+        const uint64_t payload = pos + kRecordHeaderBytes;
+        if (header.payloadBytes > size - payload || header.width == 0 || header.height == 0
+            || header.codec > kCodecRleLz4)
+            break;
+        auto it = m_index.find(header.frame);
+        if (it != m_index.end())
+            m_liveBytes -= kRecordHeaderBytes + it->second.payloadBytes;
+        m_index[header.frame] = Record{payload,          header.width,        header.height, header.codec,
+                                       header.rawBytes, header.payloadBytes, header.checksum};
+        m_liveBytes += kRecordHeaderBytes + header.payloadBytes;
+        pos = payload + header.payloadBytes;
+    }
+    m_stream.clear();
+    return pos;
+}
+
+void MaskFile::compact()
+{
+    fs::path temporary = m_path;
+    temporary += ".tmp";
+    std::map<int64_t, Record> index;
+    uint64_t end = kHeaderBytes;
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(kMagic, 8);
+        std::vector<char> payload;
+        for (const auto &[frame, record] : m_index) {
+            payload.resize(record.payloadBytes);
+            m_stream.clear();
+            m_stream.seekg(std::streamoff(record.offset));
+            if (!m_stream.read(payload.data(), std::streamsize(payload.size())))
+                continue;
+            const RecordHeader header{frame,           record.width,        record.height, record.codec,
+                                      record.rawBytes, record.payloadBytes, 0,             record.checksum};
+            out.write(reinterpret_cast<const char *>(&header), kRecordHeaderBytes);
+            out.write(payload.data(), std::streamsize(payload.size()));
+            Record moved = record;
+            moved.offset = end + kRecordHeaderBytes;
+            index[frame] = moved;
+            end = moved.offset + record.payloadBytes;
+        }
+        if (!out.flush()) {
+            std::error_code error;
+            fs::remove(temporary, error);
+            return;
+        }
+    }
+
+    m_stream.close();
+    std::error_code error;
+    fs::rename(temporary, m_path, error);
+    if (error)
+        fs::remove(temporary, error);
+    m_stream.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!m_stream)
+        throw std::runtime_error("cannot open mask file " + m_path);
+    if (error) {
+        // The old file is still in place; keep its index.
+        m_stream.clear();
+        return;
+    }
+    m_index = std::move(index);
+    m_end = end;
+}
+
+bool MaskFile::contains(int64_t frame, int *width, int *height) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(frame);
+    if (it == m_index.end())
+        return false;
+    if (width)
+        *width = int(it->second.width);
+    if (height)
+        *height = int(it->second.height);
+    return true;
+}
+
+bool MaskFile::read(int64_t frame, uint8_t *mask, int width, int height, int stride) const
+{
+    Record record;
+    std::vector<uint8_t> payload;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(frame);
+        if (it == m_index.end())
+            return false;
+        record = it->second;
+        if (record.width < uint32_t(width) || record.height < uint32_t(height))
+            return false;
+        payload.resize(record.payloadBytes);
+        m_stream.clear();
+        m_stream.seekg(std::streamoff(record.offset));
+        if (!m_stream.read(reinterpret_cast<char *>(payload.data()), std::streamsize(payload.size()))) {
+            m_stream.clear();
+            return false;
+        }
+    }
+    if (checksumOf(payload.data(), payload.size()) != record.checksum)
+        return false;
+
+    if (record.width == uint32_t(width) && record.height == uint32_t(height))
+        return decodeMask(payload.data(), payload.size(), record.rawBytes, mask, width, height, stride);
+
+    cv::Mat stored(int(record.height), int(record.width), CV_8UC1);
+    if (!decodeMask(payload.data(), payload.size(), record.rawBytes, stored.data, stored.cols, stored.rows,
+                    int(stored.step)))
+        return false;
+    cv::Mat target(height, width, CV_8UC1, mask, size_t(stride));
+    cv::resize(stored, target, target.size(), 0, 0, cv::INTER_AREA);
+    return true;
+}
+
+void MaskFile::write(int64_t frame, const uint8_t *mask, int width, int height, int stride)
+{
+    size_t rawBytes = 0;
+    const std::vector<uint8_t> payload = encodeMask(mask, width, height, stride, &rawBytes);
+    const RecordHeader header{frame,
+                              uint32_t(width),
+                              uint32_t(height),
+                              payload.size() < rawBytes ? kCodecRleLz4 : kCodecRle,
+                              uint32_t(rawBytes),
+                              uint32_t(payload.size()),
+                              0,
+                              checksumOf(payload.data(), payload.size())};
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stream.clear();
+    m_stream.seekp(std::streamoff(m_end));
+    m_stream.write(reinterpret_cast<const char *>(&header), kRecordHeaderBytes);
+    m_stream.write(reinterpret_cast<const char *>(payload.data()), std::streamsize(payload.size()));
+    if (!m_stream.flush()) {
+        m_stream.clear();
+        throw std::runtime_error("cannot write mask file " + m_path);
+    }
+    auto it = m_index.find(frame);
+    if (it != m_index.end())
+        m_liveBytes -= kRecordHeaderBytes + it->second.payloadBytes;
+    m_index[frame] = Record{m_end + kRecordHeaderBytes, header.width,        header.height, header.codec,
+                            header.rawBytes,            header.payloadBytes, header.checksum};
+    m_end += kRecordHeaderBytes + payload.size();
+    m_liveBytes += kRecordHeaderBytes + payload.size();
+}
+
+size_t MaskFile::frameCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.size();
+}
+
+uint64_t MaskFile::storedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_liveBytes;
+}
+
+} // namespace vep
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// 8-bit alpha mattes packed for storage: each row as (value, LEB128 run
+// length) pairs, then LZ4 over the whole frame when that is smaller. Hard
+// mattes shrink to a few bytes per row; soft edges cost up to two bytes
+// per edge pixel before LZ4. `rawSize` is the run-length size; the data
+// is LZ4 packed exactly when it is smaller than that. decodeMask() returns
+// false on malformed input.
+std::vector<uint8_t> encodeMask(const uint8_t *mask, int width, int height, int stride, size_t *rawSize);
+bool decodeMask(const uint8_t *data, size_t size, size_t rawSize, uint8_t *mask, int width, int height, int stride);
+
+// Per-clip store of computed mattes (background removal, rotoscoping),
+// random-access by source frame, so preview and export only run the model
+// for frames no one has seen yet. Files live in the MediaCache under the
+// source's content hash, with a kind naming everything else the mattes
+// depend on (see kindFor()); changing any of it simply selects another
+// file.
+//
+// The file is an append-only log so frames can be added in whatever order
+// playback asks for them: "VEPMASK1", then records of i64 frame, u32
+// width, u32 height, u32 codec, u32 raw (run-length) bytes, u32 payload
+// bytes, u32 reserved, u64 XXH64 of the payload, payload. Opening scans
+// the record headers into an index; a later record for a frame replaces
+// the earlier one, a torn record at the end (a crash mid-write) is cut
+// off, and a file that is mostly superseded records is rewritten.
+//
+// Thread-safe; frames can be read and written from several render threads.
+class MaskFile
+{
+public:
+    // Opens or creates the file. Throws std::runtime_error if it can be
+    // neither read nor created.
+    explicit MaskFile(const std::string &path);
+
+    // One open file per path, shared by every filter instance (preview and
+    // export) in the process.
+    static std::shared_ptr<MaskFile> shared(const std::string &path);
+
+    // MediaCache kind for mattes that depend on `settingsHash` (model file,
+    // mode, frame rate...).
+    static std::string kindFor(uint64_t settingsHash);
+
+    const std::string &path() const { return m_path; }
+
+    // Stored size of a frame's matte, or false if there is none.
+    bool contains(int64_t frame, int *width = nullptr, int *height = nullptr) const;
+
+    // Writes the frame's matte at width x height, downscaling a larger
+    // stored one. False if the frame is missing, stored smaller than asked
+    // for (the caller recomputes it at the new size and writes it again) or
+    // fails its checksum.
+    bool read(int64_t frame, uint8_t *mask, int width, int height, int stride) const;
+
+    // Appends the frame's matte. Throws std::runtime_error on I/O errors.
+    void write(int64_t frame, const uint8_t *mask, int width, int height, int stride);
+
+    size_t frameCount() const;
+    // Bytes of live records, for the cache-size UI.
+    uint64_t storedBytes() const;
+
+private:
+    struct Record
+    {
+        uint64_t offset; // of the payload
+        uint32_t width;
+        uint32_t height;
+        uint32_t codec;
+        uint32_t rawBytes;
+        uint32_t payloadBytes;
+        uint64_t checksum;
+    };
+
+    // Returns the end of the last intact record.
+    uint64_t scan();
+    void compact();
+
+    std::string m_path;
+    mutable std::mutex m_mutex;
+    mutable std::fstream m_stream;
+    std::map<int64_t, Record> m_index;
+    uint64_t m_end = 0;
+    uint64_t m_liveBytes = 0;
+};
+
+} // namespace vep
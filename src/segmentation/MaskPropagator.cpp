@@ -0,0 +1,146 @@
+#include "segmentation/MaskPropagator.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace vep {
+
+namespace {
+
+// IoU of the propagated and the inferred mask at a keyframe above which
+// propagation is considered good enough to stretch the interval.
+constexpr double kGoodOverlap = 0.97;
+constexpr double kPoorOverlap = 0.90;
+// Half-width, in flow pixels, of the band around the subject's edge where
+// the warp error is measured; elsewhere (flat background, the subject's
+// interior) errors do not move the matte.
+constexpr int kEdgeBand = 4;
+
+double overlap(const cv::Mat &a, const cv::Mat &b)
+{
+    cv::Mat binaryA = a > 127;
+    cv::Mat binaryB = b > 127;
+    const double together = cv::countNonZero(binaryA & binaryB);
+    const double either = cv::countNonZero(binaryA | binaryB);
+    return either > 0.0 ? together / either : 1.0;
+}
+
+} // namespace
+
+MaskPropagator::MaskPropagator(Segmenter segment, MaskPropagationSettings settings)
+    : m_segment(std::move(segment))
+    , m_settings(settings)
+    , m_flow(cv::DISOpticalFlow::create(cv::DISOpticalFlow::PRESET_FAST))
+    , m_interval(std::max(1, settings.minInterval))
+{
+}
+
+void MaskPropagator::reset()
+{
+    m_previousGrey.release();
+    m_previousMask.release();
+    m_sinceKeyframe = 0;
+    m_drift = 0.0;
+}
+
+void MaskPropagator::setSettings(const MaskPropagationSettings &settings)
+{
+    m_settings = settings;
+    m_interval = std::clamp(m_interval, std::max(1, settings.minInterval), std::max(1, settings.maxInterval));
+}
+
+cv::Mat MaskPropagator::smallGrey(const SegmentationInput &frame) const
+{
+    const cv::Mat pixels(frame.height, frame.width, frame.channels == 4 ? CV_8UC4 : CV_8UC3,
+                         const_cast<uint8_t *>(frame.pixels), size_t(frame.stride));
+    const int width = std::min(frame.width, std::max(16, m_settings.flowWidth));
+    const int height = std::max(1, int(double(frame.height) * width / frame.width + 0.5));
+    cv::Mat small;
+    cv::resize(pixels, small, cv::Size(width, height), 0.0, 0.0, cv::INTER_AREA);
+    cv::Mat grey;
+    cv::cvtColor(small, grey, frame.channels == 4 ? cv::COLOR_RGBA2GRAY : cv::COLOR_RGB2GRAY);
+    return grey;
+}
+
+cv::Mat MaskPropagator::propagate(const cv::Mat &grey, const cv::Size &size)
+{
+    // Flow from the current frame back to the previous one: for each pixel
+    // now, where it was. Sampling the old mask there moves it forward.
+    cv::Mat flow;
+    m_flow->calc(grey, m_previousGrey, flow);
+
+    cv::Mat grid(grey.size(), CV_32FC2);
+    for (int y = 0; y < grid.rows; ++y) {
+        auto *row = grid.ptr<cv::Vec2f>(y);
+        const auto *motion = flow.ptr<cv::Vec2f>(y);
+        for (int x = 0; x < grid.cols; ++x)
+            row[x] = cv::Vec2f(float(x) + motion[x][0], float(y) + motion[x][1]);
+    }
+
+    cv::Mat predicted;
+    cv::remap(m_previousGrey, predicted, grid, cv::noArray(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    cv::Mat smallMask;
+    cv::resize(m_previousMask, smallMask, grey.size(), 0.0, 0.0, cv::INTER_AREA);
+    cv::Mat edge;
+    cv::morphologyEx(smallMask > 127, edge, cv::MORPH_GRADIENT,
+                     cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * kEdgeBand + 1, 2 * kEdgeBand + 1)));
+    cv::Mat error;
+    cv::absdiff(predicted, grey, error);
+    // No edge in view (empty or full mask): judge the whole frame.
+    m_lastError = cv::countNonZero(edge) > 0 ? cv::mean(error, edge)[0] : cv::mean(error)[0];
+
+    // Full-resolution sampling grid from the scaled-up flow.
+    const float scaleX = float(size.width) / float(grey.cols);
+    const float scaleY = float(size.height) / float(grey.rows);
+    cv::Mat bigGrid;
+    cv::resize(grid, bigGrid, size, 0.0, 0.0, cv::INTER_LINEAR);
+    for (int y = 0; y < bigGrid.rows; ++y) {
+        auto *row = bigGrid.ptr<cv::Vec2f>(y);
+        for (int x = 0; x < bigGrid.cols; ++x)
+            row[x] = cv::Vec2f((row[x][0] + 0.5f) * scaleX - 0.5f, (row[x][1] + 0.5f) * scaleY - 0.5f);
+    }
+    cv::Mat mask;
+    cv::remap(m_previousMask, mask, bigGrid, cv::noArray(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    return mask;
+}
+
+bool MaskPropagator::process(const SegmentationInput &frame, uint8_t *mask, int maskStride)
+{
+    const cv::Size size(frame.width, frame.height);
+    cv::Mat output(size, CV_8UC1, mask, size_t(maskStride));
+    const cv::Mat grey = smallGrey(frame);
+    ++m_frames;
+
+    cv::Mat propagated;
+    bool infer = m_previousMask.empty() || m_previousMask.size() != size || m_previousGrey.size() != grey.size();
+    if (!infer) {
+        propagated = propagate(grey, size);
+        m_drift += m_lastError;
+        infer = m_lastError > m_settings.errorThreshold || m_drift > m_settings.driftThreshold
+                || m_sinceKeyframe + 1 >= m_interval;
+    }
+
+    if (infer) {
+        m_segment(frame, mask, maskStride);
+        ++m_inferred;
+        if (!propagated.empty()) {
+            const double iou = overlap(propagated, output);
+            if (iou >= kGoodOverlap && m_lastError <= m_settings.errorThreshold)
+                m_interval = std::min(m_settings.maxInterval, m_interval * 2);
+            else if (iou < kPoorOverlap)
+                m_interval = std::max(m_settings.minInterval, m_interval / 2);
+        }
+        m_sinceKeyframe = 0;
+        m_drift = 0.0;
+    } else {
+        propagated.copyTo(output);
+        ++m_sinceKeyframe;
+    }
+    m_previousGrey = grey;
+    output.copyTo(m_previousMask);
+    return infer;
+}
+
+} // namespace vep
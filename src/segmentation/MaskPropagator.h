@@ -0,0 +1,98 @@
+#pragma once
+
+#include "segmentation/SegmentationModel.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace vep {
+
+struct MaskPropagationSettings
+{
+    // Optical flow is computed on frames scaled to this width; the flow is
+    // then scaled up to move the full-resolution mask.
+    int flowWidth = 320;
+    // Mean absolute error (8-bit grey levels) between a frame and its
+    // predecessor warped by the flow, measured in the band around the
+    // subject's edge. Above this the flow cannot be trusted for the mask.
+    double errorThreshold = 6.0;
+    // Per-step errors add up as the mask drifts; past this total since the
+    // last keyframe the model runs again even if each step looked fine.
+    // Grain alone costs 2-4 per step on clean footage, so this lets a steady
+    // shot run maxInterval frames while one near errorThreshold every step
+    // gets a keyframe about twice as often.
+    double driftThreshold = 160.0;
+    // Bounds for the adaptive keyframe interval.
+    int minInterval = 2;
+    int maxInterval = 48;
+};
+
+// Background-removal masks for a sequence of frames with the model run only
+// on keyframes. In between, the last mask is carried along by dense
+// optical flow (OpenCV DIS) from each frame to its predecessor.
+//
+// Keyframes are chosen adaptively: the model runs again when the warped
+// predecessor stops explaining the new frame around the subject's edge
+// (fast motion, occlusion, a cut), when the accumulated drift gets large,
+// or when the current interval runs out. Each keyframe also checks how
+// well propagation would have done (IoU of the propagated and inferred
+// masks): a good match doubles the interval, a poor one halves it. A
+// talking head settles at the maximum interval; a dance clip at the
+// minimum.
+//
+// Frames must come in order; call reset() after a seek.
+class MaskPropagator
+{
+public:
+    // Writes a keyframe's mask (frame size, 8-bit).
+    using Segmenter = std::function<void(const SegmentationInput &frame, uint8_t *mask, int maskStride)>;
+
+    // Inline so that vep_vision itself does not need ONNX Runtime.
+    MaskPropagator(std::shared_ptr<SegmentationModel> model, MaskPropagationSettings settings = {})
+        : MaskPropagator([model = std::move(model)](const SegmentationInput &frame, uint8_t *mask,
+                                                    int maskStride) { model->segment(frame, mask, maskStride); },
+                         settings)
+    {
+    }
+    MaskPropagator(Segmenter segment, MaskPropagationSettings settings = {});
+
+    // Writes the frame's mask (frame size, 8-bit). Returns true if the model
+    // ran for this frame. Throws std::runtime_error on inference errors.
+    bool process(const SegmentationInput &frame, uint8_t *mask, int maskStride);
+    void reset();
+    // Takes effect from the next frame; the current interval is clamped.
+    void setSettings(const MaskPropagationSettings &settings);
+
+    int framesProcessed() const { return m_frames; }
+    int framesInferred() const { return m_inferred; }
+    double inferredFraction() const { return m_frames ? double(m_inferred) / double(m_frames) : 0.0; }
+    int interval() const { return m_interval; }
+    // Edge-band warp error of the last propagated frame.
+    double lastError() const { return m_lastError; }
+    // Edge-band warp error summed since the last keyframe.
+    double drift() const { return m_drift; }
+
+private:
+    cv::Mat smallGrey(const SegmentationInput &frame) const;
+    // The previous mask moved onto the current frame; sets m_lastError.
+    cv::Mat propagate(const cv::Mat &grey, const cv::Size &size);
+
+    Segmenter m_segment;
+    MaskPropagationSettings m_settings;
+    cv::Ptr<cv::DISOpticalFlow> m_flow;
+
+    cv::Mat m_previousGrey;
+    cv::Mat m_previousMask;
+    int m_sinceKeyframe = 0;
+    double m_drift = 0.0;
+    int m_interval;
+    double m_lastError = 0.0;
+    int m_frames = 0;
+    int m_inferred = 0;
+};
+
+} // namespace vep
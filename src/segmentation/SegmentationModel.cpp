@@ -0,0 +1,191 @@
+#include "segmentation/SegmentationModel.h"
+
+#include "segmentation/ImageResample.h"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace vep {
+
+namespace {
+
+Ort::Env &environment()
+{
+    static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "VideoEditorPro");
+    return env;
+}
+
+std::string modelHome()
+{
+    if (const char *home = std::getenv("U2NET_HOME"); home && *home)
+        return home;
+#ifdef _WIN32
+    const char *user = std::getenv("USERPROFILE");
+#else
+    const char *user = std::getenv("HOME");
+#endif
+    return std::string(user ? user : ".") + "/.u2net";
+}
+
+bool isIsNet(const std::string &path)
+{
+    return fs::u8path(path).stem().u8string().rfind("isnet", 0) == 0;
+}
+
+} // namespace
+
+std::string SegmentationModel::resolvePath(const std::string &nameOrPath)
+{
+    if (fs::exists(fs::u8path(nameOrPath)))
+        return nameOrPath;
+    const std::string candidate = modelHome() + "/" + nameOrPath + ".onnx";
+    if (fs::exists(fs::u8path(candidate)))
+        return candidate;
+    throw std::runtime_error("segmentation model not found: " + nameOrPath);
+}
+
+SegmentationModel::SegmentationModel(const std::string &path, int intraOpThreads)
+    : m_path(resolvePath(path))
+{
+    Ort::SessionOptions options;
+    options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+    options.SetInterOpNumThreads(1);
+    if (intraOpThreads > 0)
+        options.SetIntraOpNumThreads(intraOpThreads);
+    try {
+#ifdef _WIN32
+        const std::wstring widePath = fs::u8path(m_path).wstring();
+        m_session = std::make_unique<Ort::Session>(environment(), widePath.c_str(), options);
+#else
+        m_session = std::make_unique<Ort::Session>(environment(), m_path.c_str(), options);
+#endif
+        Ort::AllocatorWithDefaultOptions allocator;
+        m_inputName = m_session->GetInputNameAllocated(0, allocator).get();
+        m_outputName = m_session->GetOutputNameAllocated(0, allocator).get();
+        const std::vector<int64_t> shape
+            = m_session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        if (shape.size() != 4 || shape[1] != 3)
+            throw std::runtime_error("unexpected input shape in " + m_path);
+        m_maxBatch = shape[0] > 0 ? int(shape[0]) : 8;
+        if (shape[2] > 0)
+            m_inputSize = int(shape[2]);
+        else if (isIsNet(m_path))
+            m_inputSize = 1024;
+    } catch (const Ort::Exception &e) {
+        throw std::runtime_error(std::string("cannot load segmentation model: ") + e.what());
+    }
+    // rembg's DIS (ISNet) session keeps the ImageNet mean but not its std.
+    if (isIsNet(m_path))
+        std::fill(std::begin(m_std), std::end(m_std), 1.0);
+    m_contentHash = ContentHash::ofFile(m_path);
+}
+
+SegmentationModel::~SegmentationModel() = default;
+
+std::shared_ptr<SegmentationModel> SegmentationModel::shared(const std::string &path, int intraOpThreads)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<SegmentationModel>> models;
+
+    const std::string key = resolvePath(path) + '@' + std::to_string(intraOpThreads);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto model = models[key].lock())
+        return model;
+    auto model = std::make_shared<SegmentationModel>(path, intraOpThreads);
+    models[key] = model;
+    return model;
+}
+
+void SegmentationModel::segment(const SegmentationInput &input, uint8_t *mask, int maskStride)
+{
+    runBatch(&input, &mask, &maskStride, 1);
+}
+
+void SegmentationModel::segment(const std::vector<SegmentationInput> &inputs, const std::vector<uint8_t *> &masks,
+                                const std::vector<int> &maskStrides)
+{
+    if (masks.size() != inputs.size() || maskStrides.size() != inputs.size())
+        throw std::runtime_error("one mask per segmentation input expected");
+    for (size_t first = 0; first < inputs.size(); first += size_t(m_maxBatch)) {
+        const int count = int(std::min(inputs.size() - first, size_t(m_maxBatch)));
+        runBatch(&inputs[first], &masks[first], &maskStrides[first], count);
+    }
+}
+
+void SegmentationModel::runBatch(const SegmentationInput *inputs, uint8_t *const *masks, const int *maskStrides,
+                                 int count)
+{
+    const int size = m_inputSize;
+    const size_t plane = size_t(size) * size_t(size);
+    std::vector<float> tensor(size_t(count) * 3 * plane);
+    std::vector<uint8_t> rgb;
+    std::vector<uint8_t> resized(plane * 3);
+
+    for (int n = 0; n < count; ++n) {
+        const SegmentationInput &in = inputs[n];
+        const uint8_t *source = in.pixels;
+        int stride = in.stride;
+        if (in.channels != 3) {
+            // rembg converts to RGB before resizing.
+            rgb.resize(size_t(in.width) * size_t(in.height) * 3);
+            for (int y = 0; y < in.height; ++y) {
+                const uint8_t *row = in.pixels + size_t(y) * size_t(in.stride);
+                uint8_t *out = rgb.data() + size_t(y) * size_t(in.width) * 3;
+                for (int x = 0; x < in.width; ++x) {
+                    out[x * 3 + 0] = row[x * in.channels + 0];
+                    out[x * 3 + 1] = row[x * in.channels + 1];
+                    out[x * 3 + 2] = row[x * in.channels + 2];
+                }
+            }
+            source = rgb.data();
+            stride = in.width * 3;
+        }
+        resizeLanczos(source, in.width, in.height, stride, 3, resized.data(), size, size, size * 3);
+
+        const double peak = std::max(double(*std::max_element(resized.begin(), resized.end())), 1e-6);
+        float *chw = tensor.data() + size_t(n) * 3 * plane;
+        for (size_t i = 0; i < plane; ++i) {
+            for (int c = 0; c < 3; ++c)
+                chw[size_t(c) * plane + i] = float((resized[i * 3 + size_t(c)] / peak - m_mean[c]) / m_std[c]);
+        }
+    }
+
+    const std::array<int64_t, 4> shape{count, 3, size, size};
+    const Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::Value input = Ort::Value::CreateTensor<float>(memory, tensor.data(), tensor.size(), shape.data(),
+                                                       shape.size());
+    const char *inputName = m_inputName.c_str();
+    const char *outputName = m_outputName.c_str();
+    std::vector<Ort::Value> outputs;
+    try {
+        outputs = m_session->Run(Ort::RunOptions{nullptr}, &inputName, &input, 1, &outputName, 1);
+    } catch (const Ort::Exception &e) {
+        throw std::runtime_error(std::string("segmentation failed: ") + e.what());
+    }
+
+    const float *prediction = outputs.front().GetTensorData<float>();
+    std::vector<uint8_t> small(plane);
+    for (int n = 0; n < count; ++n) {
+        // Channel 0 of the first output, min-max normalised as rembg does.
+        const float *map = prediction + size_t(n) * plane;
+        const auto [lo, hi] = std::minmax_element(map, map + plane);
+        const float low = *lo;
+        const float range = *hi - *lo;
+        for (size_t i = 0; i < plane; ++i)
+            small[i] = range > 0.0f ? uint8_t(((map[i] - low) / range) * 255.0f) : 0;
+        resizeLanczos(small.data(), size, size, size, 1, masks[n], inputs[n].width, inputs[n].height,
+                      maskStrides[n]);
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "core/ContentHash.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Ort {
+struct Session;
+}
+
+namespace vep {
+
+// A frame to segment: 8-bit RGB or RGBA (alpha ignored), rows `stride`
+// bytes apart.
+struct SegmentationInput
+{
+    const uint8_t *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    int channels = 4;
+};
+
+// Foreground masks from the salient-object networks rembg ships (U²-Net,
+// U²-NetP, silueta, ISNet...), run in process on ONNX Runtime's CPU
+// provider instead of through a Python worker.
+//
+// Pre- and post-processing follow rembg step for step (Pillow-exact
+// Lanczos resize to the network size, scaling by the image maximum, the
+// model's mean/std, min-max normalised output resized back), so a mask
+// from here matches `rembg.remove(..., only_mask=True)` for the same
+// model file; bench/segmentation_parity checks that.
+//
+// One ONNX session serves any number of threads; segment() may be called
+// concurrently.
+class SegmentationModel
+{
+public:
+    // `path` is an .onnx file or a rembg model name ("u2net", "isnet-general-use"),
+    // looked up in $U2NET_HOME or ~/.u2net like rembg does. intraOpThreads <= 0
+    // lets ONNX Runtime pick. Throws std::runtime_error.
+    explicit SegmentationModel(const std::string &path, int intraOpThreads = 0);
+    ~SegmentationModel();
+
+    SegmentationModel(const SegmentationModel &) = delete;
+    SegmentationModel &operator=(const SegmentationModel &) = delete;
+
+    // A model shared by every caller asking for the same file and thread
+    // count (the weights are loaded once per process).
+    static std::shared_ptr<SegmentationModel> shared(const std::string &path, int intraOpThreads = 0);
+    static std::string resolvePath(const std::string &nameOrPath);
+
+    const std::string &path() const { return m_path; }
+    // Hash of the model file, taken once when the model is loaded, so
+    // caches keyed on the weights never read the file again.
+    ContentHash contentHash() const { return m_contentHash; }
+    int inputSize() const { return m_inputSize; }
+    // Largest batch one inference call takes (1 for models exported with a
+    // fixed batch dimension).
+    int maxBatch() const { return m_maxBatch; }
+
+    // One width x height mask per input, written to masks[i] with rows
+    // maskStrides[i] bytes apart. Inputs beyond maxBatch() are run in
+    // several calls. Throws std::runtime_error on inference errors.
+    void segment(const std::vector<SegmentationInput> &inputs, const std::vector<uint8_t *> &masks,
+                 const std::vector<int> &maskStrides);
+    void segment(const SegmentationInput &input, uint8_t *mask, int maskStride);
+
+private:
+    void runBatch(const SegmentationInput *inputs, uint8_t *const *masks, const int *maskStrides, int count);
+
+    std::string m_path;
+    ContentHash m_contentHash;
+    std::unique_ptr<Ort::Session> m_session;
+    std::string m_inputName;
+    std::string m_outputName;
+    int m_inputSize = 320;
+    int m_maxBatch = 1;
+    double m_mean[3] = {0.485, 0.456, 0.406};
+    double m_std[3] = {0.229, 0.224, 0.225};
+};
+
+} // namespace vep
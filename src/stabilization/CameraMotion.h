@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/BinaryIO.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+
+// Movement of the picture from one frame to the next: a shift in source
+// pixels and a rotation in radians about the centre of the frame.
+struct MotionStep
+{
+    float dx = 0.0f;
+    float dy = 0.0f;
+    float angle = 0.0f;
+};
+
+// Result of motion analysis for one media file. steps[i] takes frame i - 1
+// to frame i (steps[0] is always zero); a pair that could not be matched
+// counts as no movement. Stored in the MediaCache under kCacheKind, and
+// smoothed by smoothCameraPath() whenever stabilisation settings change.
+struct CameraMotion
+{
+    static constexpr const char *kCacheKind = "motion";
+
+    double fps = 0.0;
+    int width = 0;
+    int height = 0;
+    std::vector<MotionStep> steps;
+
+    std::vector<uint8_t> serialize() const
+    {
+        ByteWriter out;
+        out.putMagic("VEPMOTN2");
+        out.put(fps);
+        out.put(int32_t(width));
+        out.put(int32_t(height));
+        out.putArray(steps);
+        return out.take();
+    }
+
+    // Throws std::runtime_error on a malformed record.
+    static CameraMotion deserialize(const std::vector<uint8_t> &bytes)
+    {
+        ByteReader in(bytes);
+        in.expectMagic("VEPMOTN2");
+        CameraMotion motion;
+        motion.fps = in.get<double>();
+        motion.width = in.get<int32_t>();
+        motion.height = in.get<int32_t>();
+        motion.steps = in.getArray<MotionStep>();
+        return motion;
+    }
+};
+
+} // namespace vep
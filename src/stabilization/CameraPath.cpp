@@ -0,0 +1,64 @@
+#include "stabilization/CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+StabilizedPath smoothCameraPath(const CameraMotion &motion, double smoothingSeconds)
+{
+    StabilizedPath path;
+    const size_t count = motion.steps.size();
+    path.corrections.resize(count);
+    const int64_t radius = std::llround(std::max(0.0, smoothingSeconds) * motion.fps);
+    if (count == 0 || radius == 0)
+        return path;
+
+    // Prefix sums of the path, itself the running sum of the steps, so any
+    // window's mean costs two lookups. prefix[i] sums path[0, i).
+    struct Position
+    {
+        double x = 0.0;
+        double y = 0.0;
+        double angle = 0.0;
+    };
+    std::vector<Position> trajectory(count);
+    std::vector<Position> prefix(count + 1);
+    Position at;
+    for (size_t i = 0; i < count; ++i) {
+        at.x += motion.steps[i].dx;
+        at.y += motion.steps[i].dy;
+        at.angle += motion.steps[i].angle;
+        trajectory[i] = at;
+        prefix[i + 1].x = prefix[i].x + at.x;
+        prefix[i + 1].y = prefix[i].y + at.y;
+        prefix[i + 1].angle = prefix[i].angle + at.angle;
+    }
+
+    const double width = std::max(1, motion.width);
+    const double height = std::max(1, motion.height);
+    const double aspect = std::max(width, height) / std::min(width, height);
+    double zoom = 1.0;
+    for (size_t i = 0; i < count; ++i) {
+        // The window narrows symmetrically towards either end of the file, so
+        // a pan running into the first or last frame is not dragged back.
+        const size_t reach = std::min({size_t(radius), i, count - 1 - i});
+        const size_t first = i - reach;
+        const size_t last = i + reach;
+        const double n = double(last - first + 1);
+        MotionStep &correction = path.corrections[i];
+        correction.dx = float((prefix[last + 1].x - prefix[first].x) / n - trajectory[i].x);
+        correction.dy = float((prefix[last + 1].y - prefix[first].y) / n - trajectory[i].y);
+        correction.angle = float((prefix[last + 1].angle - prefix[first].angle) / n - trajectory[i].angle);
+
+        // A shift uncovers a border of its size on one side, and a rotation
+        // pulls the corners in by about sin(angle) of the longer side.
+        const double shift = 1.0 + 2.0 * std::max(std::fabs(correction.dx) / width, std::fabs(correction.dy) / height);
+        const double turn = std::fabs(correction.angle);
+        zoom = std::max(zoom, shift * (std::cos(turn) + std::sin(turn) * aspect));
+    }
+    path.zoom = std::min(zoom, StabilizedPath::kMaxZoom);
+    return path;
+}
+
+} // namespace vep
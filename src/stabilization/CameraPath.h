@@ -0,0 +1,29 @@
+#pragma once
+
+#include "stabilization/CameraMotion.h"
+
+#include <vector>
+
+namespace vep {
+
+// Second phase of stabilisation, cheap enough to redo on every change of
+// settings: the cached steps are summed into the camera's path, the path
+// is smoothed with a moving average, and each frame gets the shift and
+// rotation that moves it from where the camera was onto the smoothed
+// path.
+struct StabilizedPath
+{
+    // One per frame of the CameraMotion, in source pixels and radians.
+    std::vector<MotionStep> corrections;
+    // Zoom about the centre that keeps the borders the corrections uncover
+    // out of the picture, at most kMaxZoom.
+    double zoom = 1.0;
+
+    static constexpr double kMaxZoom = 1.5;
+};
+
+// smoothingSeconds is the half-width of the averaging window; 0 leaves
+// the footage as it is. O(frames) whatever the window.
+StabilizedPath smoothCameraPath(const CameraMotion &motion, double smoothingSeconds);
+
+} // namespace vep
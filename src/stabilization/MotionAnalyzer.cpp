@@ -0,0 +1,122 @@
+#include "stabilization/MotionAnalyzer.h"
+
+#include "core/MediaCache.h"
+#include "core/SpanRunner.h"
+#include "media/VideoFrameReader.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+constexpr int kAnalysisHeight = 540;
+constexpr int kMaxCorners = 200;
+constexpr double kCornerQuality = 0.01;
+constexpr double kCornerSpacing = 20.0;
+// Fewer points surviving the flow than this is not worth a fit.
+constexpr int kMinPoints = 10;
+constexpr double kRansacPixels = 3.0;
+// Spans shorter than this are not worth a reader (and a seek) of their own.
+constexpr double kMinSpanSeconds = 20.0;
+
+// The step from `previous` to `current`, in full-size pixels.
+MotionStep measure(const cv::Mat &previous, const cv::Mat &current, double scale)
+{
+    std::vector<cv::Point2f> corners;
+    cv::goodFeaturesToTrack(previous, corners, kMaxCorners, kCornerQuality, kCornerSpacing);
+    if (int(corners.size()) < kMinPoints)
+        return {};
+    std::vector<cv::Point2f> moved;
+    std::vector<uchar> status;
+    std::vector<float> error;
+    cv::calcOpticalFlowPyrLK(previous, current, corners, moved, status, error);
+
+    std::vector<cv::Point2f> from;
+    std::vector<cv::Point2f> to;
+    for (size_t i = 0; i < status.size(); ++i) {
+        if (status[i]) {
+            from.push_back(corners[i]);
+            to.push_back(moved[i]);
+        }
+    }
+    if (int(from.size()) < kMinPoints)
+        return {};
+    const cv::Mat fit = cv::estimateAffinePartial2D(from, to, cv::noArray(), cv::RANSAC, kRansacPixels);
+    if (fit.empty())
+        return {};
+    // The fit turns about the top-left corner; the shift that goes with the
+    // same turn about the centre is t + A c - c.
+    const double cx = 0.5 * previous.cols;
+    const double cy = 0.5 * previous.rows;
+    const double shiftX = fit.at<double>(0, 2) + fit.at<double>(0, 0) * cx + fit.at<double>(0, 1) * cy - cx;
+    const double shiftY = fit.at<double>(1, 2) + fit.at<double>(1, 0) * cx + fit.at<double>(1, 1) * cy - cy;
+    MotionStep step;
+    step.dx = float(shiftX / scale);
+    step.dy = float(shiftY / scale);
+    step.angle = float(std::atan2(fit.at<double>(1, 0), fit.at<double>(0, 0)));
+    return step;
+}
+
+} // namespace
+
+MotionAnalyzer::MotionAnalyzer(int concurrency)
+    : m_pool(concurrency)
+{
+}
+
+std::optional<CameraMotion> MotionAnalyzer::analyze(const std::string &mediaPath, const Progress &progress)
+{
+    CameraMotion result;
+    int64_t total = 0;
+    {
+        const VideoFrameReader probe(mediaPath);
+        result.fps = probe.fps();
+        result.width = probe.width();
+        result.height = probe.height();
+        total = probe.frameCount();
+    }
+    const double scale = result.height > kAnalysisHeight ? double(kAnalysisHeight) / result.height : 1.0;
+
+    const int64_t minSpan = std::max<int64_t>(1, std::llround(kMinSpanSeconds * result.fps));
+    std::optional<std::vector<MotionStep>> steps = runSpans<MotionStep>(
+        m_pool, total, minSpan, progress,
+        [&mediaPath, scale](int64_t begin, int64_t end, std::atomic<int64_t> &done, const std::atomic<bool> &cancel) {
+            return compareFrames<MotionStep>(
+                mediaPath, begin, end, done, cancel, [scale](const cv::Mat &frame) { return toGrey(frame, scale); },
+                [scale](const cv::Mat &previous, const cv::Mat &current) { return measure(previous, current, scale); });
+        });
+    if (!steps)
+        return std::nullopt;
+    result.steps = std::move(*steps);
+    return result;
+}
+
+std::optional<CameraMotion> MotionAnalyzer::cached(MediaCache &cache, const std::string &mediaPath)
+{
+    return cached(cache, cache.hashOf(mediaPath));
+}
+
+std::optional<CameraMotion> MotionAnalyzer::cached(MediaCache &cache, ContentHash hash)
+{
+    const auto bytes = cache.read(hash, CameraMotion::kCacheKind);
+    if (!bytes)
+        return std::nullopt;
+    try {
+        return CameraMotion::deserialize(*bytes);
+    } catch (const std::runtime_error &) {
+        // Stale or damaged entry: drop it so the next analysis regenerates it.
+        cache.remove(hash, CameraMotion::kCacheKind);
+        return std::nullopt;
+    }
+}
+
+} // namespace vep
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "core/ContentHash.h"
+#include "core/ThreadPool.h"
+#include "stabilization/CameraMotion.h"
+
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace vep {
+
+class MediaCache;
+
+// First phase of stabilisation: measures how the camera moved between
+// every pair of frames of a file. Corners are picked on the earlier frame,
+// followed into the later one by pyramidal Lucas-Kanade flow, and fitted
+// with a RANSAC similarity transform, so subjects moving through the shot
+// do not pull the fit. Frames taller than 540 rows are measured at 540.
+//
+// The file is cut into one span per worker and the spans are decoded and
+// measured concurrently, each from its own reader.
+class MotionAnalyzer
+{
+public:
+    // Called with the measured fraction in [0, 1]; return false to cancel.
+    using Progress = std::function<bool(double)>;
+
+    // concurrency <= 0 picks one worker per core, minus one.
+    explicit MotionAnalyzer(int concurrency = 0);
+
+    MotionAnalyzer(const MotionAnalyzer &) = delete;
+    MotionAnalyzer &operator=(const MotionAnalyzer &) = delete;
+
+    // Returns nullopt if cancelled; throws std::runtime_error if the file
+    // cannot be opened. Progress is called on the calling thread. Must not
+    // be called from a task of the analyzer's own pool.
+    std::optional<CameraMotion> analyze(const std::string &mediaPath, const Progress &progress = {});
+
+    // The motion stored by a previous analysis of this content, if any.
+    // Throws std::runtime_error if the file cannot be hashed.
+    static std::optional<CameraMotion> cached(MediaCache &cache, const std::string &mediaPath);
+    // The same for content whose hash is already known (see
+    // MediaCache::knownHashOf()); never hashes, so render paths can use it.
+    static std::optional<CameraMotion> cached(MediaCache &cache, ContentHash hash);
+
+private:
+    ThreadPool m_pool;
+};
+
+} // namespace vep
@@ -0,0 +1,105 @@
+#include "stabilization/StabilizationJob.h"
+
+#include "core/MediaCache.h"
+#include "stabilization/MotionAnalyzer.h"
+
+#include <QMetaObject>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <optional>
+
+namespace vep {
+
+StabilizationJob::StabilizationJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StabilizationJob::~StabilizationJob()
+{
+    cancel();
+    m_future.waitForFinished();
+}
+
+bool StabilizationJob::isAnalysed(const QString &mediaPath) const
+{
+    // Looked up, never computed: this runs on the UI thread, and start()
+    // hashes the file on the pool anyway.
+    MediaCache &cache = MediaCache::instance();
+    const std::optional<ContentHash> hash = cache.knownHashOf(mediaPath.toStdString());
+    return hash && cache.contains(*hash, CameraMotion::kCacheKind);
+}
+
+void StabilizationJob::start(const QString &mediaPath)
+{
+    if (m_running)
+        return;
+
+    m_analyzer = std::make_unique<MotionAnalyzer>(m_concurrency);
+    m_cancel = false;
+    m_progress = 0.0;
+    emit progressChanged();
+    setRunning(true);
+
+    MotionAnalyzer *analyzer = m_analyzer.get();
+    m_future = QtConcurrent::run([this, analyzer, mediaPath] {
+        const std::string media = mediaPath.toStdString();
+        bool completed = false;
+        QString error;
+        try {
+            MediaCache &cache = MediaCache::instance();
+            const ContentHash hash = cache.hashOf(media);
+            completed = cache.contains(hash, CameraMotion::kCacheKind);
+            if (!completed) {
+                const std::optional<CameraMotion> motion = analyzer->analyze(media, [this](double fraction) {
+                    QMetaObject::invokeMethod(this, [this, fraction] {
+                        m_progress = fraction;
+                        emit progressChanged();
+                    });
+                    return !m_cancel;
+                });
+                if (motion) {
+                    cache.write(hash, CameraMotion::kCacheKind, motion->serialize());
+                    completed = true;
+                }
+            }
+            if (completed)
+                QMetaObject::invokeMethod(this, [this, mediaPath] { emit analysed(mediaPath); });
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        QMetaObject::invokeMethod(this, [this, completed, error] {
+            if (completed) {
+                m_progress = 1.0;
+                emit progressChanged();
+            }
+            setRunning(false);
+            emit finished(completed, error);
+        });
+    });
+}
+
+void StabilizationJob::cancel()
+{
+    m_cancel = true;
+}
+
+void StabilizationJob::setConcurrency(int concurrency)
+{
+    concurrency = std::max(0, concurrency);
+    if (m_concurrency == concurrency)
+        return;
+    m_concurrency = concurrency;
+    emit concurrencyChanged();
+}
+
+void StabilizationJob::setRunning(bool running)
+{
+    if (m_running == running)
+        return;
+    m_running = running;
+    emit runningChanged();
+}
+
+} // namespace vep
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QFuture>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+namespace vep {
+
+class MotionAnalyzer;
+
+// Runs the motion analysis a vep_stabilize filter needs off the UI thread
+// and stores it in the MediaCache; a file already analysed finishes
+// without decoding. Changing the filter's smoothing or crop afterwards
+// never comes back here.
+class StabilizationJob : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(int concurrency READ concurrency WRITE setConcurrency NOTIFY concurrencyChanged)
+
+public:
+    explicit StabilizationJob(QObject *parent = nullptr);
+    ~StabilizationJob() override;
+
+    bool isRunning() const { return m_running; }
+    double progress() const { return m_progress; }
+    int concurrency() const { return m_concurrency; }
+    void setConcurrency(int concurrency);
+
+    // Whether the file's motion is cached, i.e. vep_stabilize will act on
+    // it right away.
+    Q_INVOKABLE bool isAnalysed(const QString &mediaPath) const;
+
+public slots:
+    void start(const QString &mediaPath);
+    void cancel();
+
+signals:
+    // Also sent for a file that was already cached.
+    void analysed(const QString &mediaPath);
+    void runningChanged();
+    void progressChanged();
+    void concurrencyChanged();
+    void finished(bool completed, const QString &error);
+
+private:
+    void setRunning(bool running);
+
+    // Replaced only between runs, on the UI thread.
+    std::unique_ptr<MotionAnalyzer> m_analyzer;
+    QFuture<void> m_future;
+    std::atomic<bool> m_cancel{false};
+    bool m_running = false;
+    double m_progress = 0.0;
+    int m_concurrency = 0;
+};
+
+} // namespace vep
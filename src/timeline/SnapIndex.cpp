@@ -0,0 +1,195 @@
+#include "timeline/SnapIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+namespace {
+
+// Level 1 thins beats to 1/32 s; each level after it doubles that.
+constexpr double kBaseSpacing = 1.0 / 32.0;
+constexpr int kMaxLevel = 16;
+// Beats closer than this on screen cannot be told apart, so snapping to
+// them only makes the cursor jitter.
+constexpr double kMinPixelSpacing = 4.0;
+
+double levelGap(size_t level)
+{
+    return std::ldexp(kBaseSpacing, int(level) - 1);
+}
+
+// The beats of one owner kept at a level: each at least `gap` after the
+// previous one kept.
+std::vector<double> thin(const std::vector<double> &times, double gap)
+{
+    std::vector<double> kept;
+    double last = -HUGE_VAL;
+    for (double time : times) {
+        if (time - last < gap)
+            continue;
+        kept.push_back(time);
+        last = time;
+    }
+    return kept;
+}
+
+// Sorts before every point at `time`.
+SnapPoint earliestAt(double time)
+{
+    return {time, 0, SnapKind::ClipEdge};
+}
+
+} // namespace
+
+bool SnapIndex::Earlier::operator()(const SnapPoint &a, const SnapPoint &b) const
+{
+    if (a.time != b.time)
+        return a.time < b.time;
+    if (a.kind != b.kind)
+        return a.kind < b.kind;
+    return a.owner < b.owner;
+}
+
+void SnapIndex::setPoints(uint64_t owner, SnapKind kind, std::vector<double> times)
+{
+    std::sort(times.begin(), times.end());
+    erasePoints(owner, kind);
+    insertPoints(owner, kind, times);
+    m_size += times.size();
+    m_owners[owner][size_t(kind)] = std::move(times);
+}
+
+void SnapIndex::setClip(uint64_t owner, double timelineStart, double sourceIn, double sourceOut,
+                        const std::vector<double> &sourceBeats)
+{
+    setPoints(owner, SnapKind::ClipEdge, {timelineStart, timelineStart + (sourceOut - sourceIn)});
+
+    std::vector<double> beats;
+    auto first = std::lower_bound(sourceBeats.begin(), sourceBeats.end(), sourceIn);
+    auto last = std::lower_bound(first, sourceBeats.end(), sourceOut);
+    beats.reserve(size_t(last - first));
+    for (auto it = first; it != last; ++it)
+        beats.push_back(timelineStart + (*it - sourceIn));
+    setPoints(owner, SnapKind::Beat, std::move(beats));
+}
+
+void SnapIndex::removeOwner(uint64_t owner)
+{
+    erasePoints(owner, SnapKind::ClipEdge);
+    erasePoints(owner, SnapKind::Marker);
+    erasePoints(owner, SnapKind::Beat);
+    m_owners.erase(owner);
+}
+
+void SnapIndex::clear()
+{
+    m_owners.clear();
+    m_anchors.clear();
+    m_beats.assign(1, PointSet());
+    m_size = 0;
+}
+
+void SnapIndex::insertPoints(uint64_t owner, SnapKind kind, const std::vector<double> &times)
+{
+    if (kind != SnapKind::Beat) {
+        for (double time : times)
+            m_anchors.insert({time, owner, kind});
+        return;
+    }
+    for (size_t level = 0; level < m_beats.size(); ++level) {
+        for (double time : level == 0 ? times : thin(times, levelGap(level)))
+            m_beats[level].insert({time, owner, kind});
+    }
+}
+
+void SnapIndex::erasePoints(uint64_t owner, SnapKind kind)
+{
+    auto found = m_owners.find(owner);
+    if (found == m_owners.end())
+        return;
+    std::vector<double> &times = found->second[size_t(kind)];
+    auto take = [&](PointSet &points, const std::vector<double> &listed) {
+        for (double time : listed) {
+            auto it = points.find({time, owner, kind});
+            if (it != points.end())
+                points.erase(it);
+        }
+    };
+    if (kind != SnapKind::Beat) {
+        take(m_anchors, times);
+    } else {
+        for (size_t level = 0; level < m_beats.size(); ++level)
+            take(m_beats[level], level == 0 ? times : thin(times, levelGap(level)));
+    }
+    m_size -= times.size();
+    times.clear();
+}
+
+const SnapIndex::PointSet &SnapIndex::beatLevel(double pixelsPerSecond)
+{
+    if (pixelsPerSecond <= 0.0)
+        return m_beats.front();
+    const double spacing = kMinPixelSpacing / pixelsPerSecond;
+    if (spacing < kBaseSpacing)
+        return m_beats.front();
+    const size_t wanted = 1 + size_t(std::min(kMaxLevel, int(std::floor(std::log2(spacing / kBaseSpacing)))));
+
+    while (m_beats.size() <= wanted) {
+        const double gap = levelGap(m_beats.size());
+        PointSet level;
+        for (const auto &[owner, times] : m_owners) {
+            for (double time : thin(times[size_t(SnapKind::Beat)], gap))
+                level.insert({time, owner, SnapKind::Beat});
+        }
+        m_beats.push_back(std::move(level));
+    }
+    return m_beats[wanted];
+}
+
+std::optional<SnapPoint> SnapIndex::nearest(const Query &query)
+{
+    const double threshold = query.thresholdPixels / std::max(query.pixelsPerSecond, 1e-9);
+    std::optional<SnapPoint> best;
+    double bestDistance = threshold;
+
+    // Beats are thinned to a few pixels apart per clip, so the window holds
+    // a handful of candidates for each clip under the cursor at any zoom.
+    auto consider = [&](const PointSet &points) {
+        for (auto it = points.lower_bound(earliestAt(query.time - threshold));
+             it != points.end() && it->time <= query.time + threshold; ++it) {
+            if (it->owner == query.excludeOwner || !(query.kinds & snapMask(it->kind)))
+                continue;
+            const double distance = std::abs(it->time - query.time);
+            if (distance < bestDistance || (distance == bestDistance && (!best || it->kind < best->kind))) {
+                best = *it;
+                bestDistance = distance;
+            }
+        }
+    };
+    if (query.kinds & ~snapMask(SnapKind::Beat))
+        consider(m_anchors);
+    if (query.kinds & snapMask(SnapKind::Beat))
+        consider(beatLevel(query.pixelsPerSecond));
+    return best;
+}
+
+std::vector<SnapPoint> SnapIndex::pointsIn(double from, double to, double pixelsPerSecond, unsigned kinds)
+{
+    std::vector<SnapPoint> result;
+    auto collect = [&](const PointSet &points) {
+        for (auto it = points.lower_bound(earliestAt(from)); it != points.end() && it->time <= to; ++it) {
+            if (kinds & snapMask(it->kind))
+                result.push_back(*it);
+        }
+    };
+    if (kinds & ~snapMask(SnapKind::Beat))
+        collect(m_anchors);
+    const auto middle = ptrdiff_t(result.size());
+    if (kinds & snapMask(SnapKind::Beat))
+        collect(beatLevel(pixelsPerSecond));
+    std::inplace_merge(result.begin(), result.begin() + middle, result.end(), Earlier());
+    return result;
+}
+
+} // namespace vep
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace vep {
+
+enum class SnapKind : uint8_t { ClipEdge, Marker, Beat };
+
+constexpr unsigned snapMask(SnapKind kind) { return 1u << unsigned(kind); }
+constexpr unsigned kAllSnapKinds = 0x7;
+
+struct SnapPoint
+{
+    double time;
+    uint64_t owner;
+    SnapKind kind;
+};
+
+// Every point the timeline can snap to (clip edges, markers and the beats
+// of every audio clip), kept sorted by time so the nearest point is a
+// binary search away, whatever the number of clips or the length of the
+// songs. Drag, trim and the ruler's beat grid all query the same index.
+//
+// Points are grouped by owner (a clip, the marker list, ...) and replaced
+// per owner on edit, at a cost that depends on that owner's points only, so
+// moving one clip does not touch the rest. Zoomed-out views query a coarser
+// level where each clip's beats closer together than a few pixels are
+// thinned out. Clips are thinned separately, so excluding the dragged clip
+// never hides a beat of another one; levels are built on first use and
+// then kept up to date by the same per-owner edits.
+//
+// Not thread-safe; owned by the timeline model on the UI thread.
+class SnapIndex
+{
+public:
+    static constexpr uint64_t kNoOwner = ~uint64_t(0);
+
+    // Replaces the owner's points of the given kind.
+    void setPoints(uint64_t owner, SnapKind kind, std::vector<double> times);
+    // Convenience for a clip placed at timelineStart showing source range
+    // [sourceIn, sourceOut): sets its two edges and the beats inside the range.
+    void setClip(uint64_t owner, double timelineStart, double sourceIn, double sourceOut,
+                 const std::vector<double> &sourceBeats);
+    void removeOwner(uint64_t owner);
+    void clear();
+
+    struct Query
+    {
+        double time = 0.0;
+        // Screen scale; picks the level and converts the threshold.
+        double pixelsPerSecond = 100.0;
+        double thresholdPixels = 8.0;
+        // Typically the clip being dragged, which must not snap to itself.
+        uint64_t excludeOwner = kNoOwner;
+        unsigned kinds = kAllSnapKinds;
+    };
+
+    // Nearest matching point within the threshold. Ties go to the
+    // structurally stronger kind (clip edge over marker over beat).
+    std::optional<SnapPoint> nearest(const Query &query);
+
+    // Points in [from, to] at the level for the given scale (all points if
+    // pixelsPerSecond <= 0), e.g. for drawing the beat grid.
+    std::vector<SnapPoint> pointsIn(double from, double to, double pixelsPerSecond = 0.0,
+                                    unsigned kinds = kAllSnapKinds);
+
+    size_t size() const { return m_size; }
+
+private:
+    struct Earlier
+    {
+        bool operator()(const SnapPoint &a, const SnapPoint &b) const;
+    };
+    using PointSet = std::multiset<SnapPoint, Earlier>;
+
+    void insertPoints(uint64_t owner, SnapKind kind, const std::vector<double> &times);
+    void erasePoints(uint64_t owner, SnapKind kind);
+    const PointSet &beatLevel(double pixelsPerSecond);
+
+    // Each owner's sorted times per kind, so an edit knows what to take out.
+    std::unordered_map<uint64_t, std::array<std::vector<double>, 3>> m_owners;
+    PointSet m_anchors; // clip edges and markers
+    // m_beats[0] holds every beat; m_beats[k + 1] each owner's beats
+    // thinned to at least kBaseSpacing * 2^k seconds apart.
+    std::vector<PointSet> m_beats = std::vector<PointSet>(1);
+    size_t m_size = 0;
+};
+
+} // namespace vep
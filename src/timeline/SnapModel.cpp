@@ -0,0 +1,101 @@
+#include "timeline/SnapModel.h"
+
+#include <cmath>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+// Owner id for the marker list; clip ids are >= 0.
+constexpr uint64_t kMarkerOwner = SnapIndex::kNoOwner - 1;
+
+} // namespace
+
+SnapModel::SnapModel(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SnapModel::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    m_enabled = enabled;
+    emit enabledChanged();
+}
+
+void SnapModel::setSnapToBeats(bool snap)
+{
+    if (m_snapToBeats == snap)
+        return;
+    m_snapToBeats = snap;
+    emit snapToBeatsChanged();
+}
+
+void SnapModel::setThresholdPixels(double pixels)
+{
+    if (m_thresholdPixels == pixels)
+        return;
+    m_thresholdPixels = pixels;
+    emit thresholdPixelsChanged();
+}
+
+double SnapModel::snap(double seconds, double pixelsPerSecond, int excludeClip)
+{
+    if (!m_enabled)
+        return seconds;
+    SnapIndex::Query query;
+    query.time = seconds;
+    query.pixelsPerSecond = pixelsPerSecond;
+    query.thresholdPixels = m_thresholdPixels;
+    if (excludeClip >= 0)
+        query.excludeOwner = uint64_t(excludeClip);
+    if (!m_snapToBeats)
+        query.kinds &= ~snapMask(SnapKind::Beat);
+    const auto point = m_index.nearest(query);
+    double snapped = point ? point->time : seconds;
+
+    // The playhead moves every frame during playback, so it is checked here
+    // instead of being re-merged into the index on each tick.
+    const double playheadDistance = std::abs(m_playhead - seconds);
+    if (playheadDistance * pixelsPerSecond <= m_thresholdPixels
+        && (!point || playheadDistance < std::abs(snapped - seconds)))
+        snapped = m_playhead;
+    return snapped;
+}
+
+QVariantList SnapModel::beatsInRange(double from, double to, double pixelsPerSecond)
+{
+    QVariantList result;
+    for (const SnapPoint &point : m_index.pointsIn(from, to, pixelsPerSecond, snapMask(SnapKind::Beat)))
+        result.append(point.time);
+    return result;
+}
+
+void SnapModel::setClip(int clipId, double timelineStart, double sourceIn, double sourceOut,
+                        const QVector<double> &sourceBeats)
+{
+    const std::vector<double> beats(sourceBeats.begin(), sourceBeats.end());
+    m_index.setClip(uint64_t(clipId), timelineStart, sourceIn, sourceOut, beats);
+    emit pointsChanged();
+}
+
+void SnapModel::removeClip(int clipId)
+{
+    m_index.removeOwner(uint64_t(clipId));
+    emit pointsChanged();
+}
+
+void SnapModel::setMarkers(const QVector<double> &times)
+{
+    m_index.setPoints(kMarkerOwner, SnapKind::Marker, std::vector<double>(times.begin(), times.end()));
+    emit pointsChanged();
+}
+
+void SnapModel::setPlayhead(double seconds)
+{
+    m_playhead = seconds;
+}
+
+} // namespace vep
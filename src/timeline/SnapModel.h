@@ -0,0 +1,59 @@
+#pragma once
+
+#include "timeline/SnapIndex.h"
+
+#include <QObject>
+#include <QVariantList>
+#include <QVector>
+
+namespace vep {
+
+// QML face of the timeline's SnapIndex. The timeline model feeds it clip,
+// marker and beat changes; the drag/trim handlers and the ruler query it.
+class SnapModel : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(bool snapToBeats READ snapToBeats WRITE setSnapToBeats NOTIFY snapToBeatsChanged)
+    Q_PROPERTY(double thresholdPixels READ thresholdPixels WRITE setThresholdPixels NOTIFY thresholdPixelsChanged)
+
+public:
+    explicit SnapModel(QObject *parent = nullptr);
+
+    SnapIndex &index() { return m_index; }
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+    bool snapToBeats() const { return m_snapToBeats; }
+    void setSnapToBeats(bool snap);
+    double thresholdPixels() const { return m_thresholdPixels; }
+    void setThresholdPixels(double pixels);
+
+    // Returns `seconds` moved onto the nearest snap point, or unchanged if
+    // none is close enough on screen. excludeClip < 0 excludes nothing.
+    Q_INVOKABLE double snap(double seconds, double pixelsPerSecond, int excludeClip = -1);
+    // Beat times in [from, to], thinned for the scale, for the ruler grid.
+    Q_INVOKABLE QVariantList beatsInRange(double from, double to, double pixelsPerSecond);
+
+public slots:
+    void setClip(int clipId, double timelineStart, double sourceIn, double sourceOut,
+                 const QVector<double> &sourceBeats);
+    void removeClip(int clipId);
+    void setMarkers(const QVector<double> &times);
+    void setPlayhead(double seconds);
+
+signals:
+    void enabledChanged();
+    void snapToBeatsChanged();
+    void thresholdPixelsChanged();
+    void pointsChanged();
+
+private:
+    SnapIndex m_index;
+    bool m_enabled = true;
+    bool m_snapToBeats = true;
+    double m_thresholdPixels = 8.0;
+    double m_playhead = 0.0;
+};
+
+} // namespace vep
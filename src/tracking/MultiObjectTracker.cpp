@@ -0,0 +1,487 @@
+#include "tracking/MultiObjectTracker.h"
+
+#include "media/VideoFrameReader.h"
+#include "tracking/TemplateRefiner.h"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/tracking.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace vep {
+
+namespace {
+
+// Frames decoded ahead of the trackers: enough to hide a slow GOP start,
+// few enough that 4K frames do not pile up.
+constexpr size_t kDecodeAhead = 4;
+// Backward tracking decodes forward in chunks of this many frames and
+// plays each chunk in reverse: every chunk costs a seek (a decode from the
+// preceding keyframe), so larger is faster but holds more frames.
+constexpr int64_t kReverseChunk = 24;
+// An object is given up after this many seconds without a hit.
+constexpr double kLostSeconds = 1.0;
+// A re-track has rejoined the earlier trajectory once this many frames in a
+// row overlap it this well.
+constexpr int kRejoinFrames = 5;
+constexpr float kRejoinOverlap = 0.85f;
+// Trackers run on the coarsest pyramid level (each half the size of the
+// one before) on which the object's smaller side keeps this many pixels,
+// but no coarser than kMaxLevel: a 200 px face in 4K is tracked on a
+// 960x540 frame, at a sixteenth of the pixels.
+constexpr float kMinTrackedSide = 48.0f;
+constexpr int kMaxLevel = 3;
+
+int pyramidLevel(const TrackBox &box)
+{
+    int level = 0;
+    float side = std::min(box.width, box.height);
+    while (level < kMaxLevel && side * 0.5f >= kMinTrackedSide) {
+        side *= 0.5f;
+        ++level;
+    }
+    return level;
+}
+
+cv::Ptr<cv::Tracker> createTracker(TrackerKind kind)
+{
+    switch (kind) {
+    case TrackerKind::Kcf:
+        return cv::TrackerKCF::create();
+    case TrackerKind::Mil:
+        return cv::TrackerMIL::create();
+    case TrackerKind::Csrt:
+        break;
+    }
+    return cv::TrackerCSRT::create();
+}
+
+TrackBox scaled(const TrackBox &box, float scale)
+{
+    return TrackBox{box.x * scale, box.y * scale, box.width * scale, box.height * scale};
+}
+
+cv::Rect clampedRect(const TrackBox &box, const cv::Size &frame)
+{
+    const int x = std::clamp(int(std::lround(box.x)), 0, frame.width - 1);
+    const int y = std::clamp(int(std::lround(box.y)), 0, frame.height - 1);
+    const int width = std::clamp(int(std::lround(box.width)), 1, frame.width - x);
+    const int height = std::clamp(int(std::lround(box.height)), 1, frame.height - y);
+    return cv::Rect(x, y, width, height);
+}
+
+struct DecodedFrame
+{
+    int64_t index = 0;
+    // Full resolution first, then each level half the size of the last.
+    std::vector<cv::Mat> pyramid;
+};
+
+// Bounded hand-off between the decode thread and the trackers.
+class FrameQueue
+{
+public:
+    void push(DecodedFrame frame)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_space.wait(lock, [this] { return m_frames.size() < kDecodeAhead || m_closed; });
+        if (m_closed)
+            return;
+        m_frames.push_back(std::move(frame));
+        m_ready.notify_one();
+    }
+
+    // False once the decoder has finished and everything was taken.
+    bool pop(DecodedFrame &frame)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready.wait(lock, [this] { return !m_frames.empty() || m_ended; });
+        if (m_frames.empty())
+            return false;
+        frame = std::move(m_frames.front());
+        m_frames.pop_front();
+        m_space.notify_one();
+        return true;
+    }
+
+    void end()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ended = true;
+        m_ready.notify_all();
+    }
+
+    // Consumer side: no more frames are wanted.
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_space.notify_all();
+    }
+
+    bool closed()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_space;
+    std::deque<DecodedFrame> m_frames;
+    bool m_ended = false;
+    bool m_closed = false;
+};
+
+} // namespace
+
+struct MultiObjectTracker::Object
+{
+    TrackRequest request;
+    ObjectTrack track;
+    cv::Ptr<cv::Tracker> tracker;
+    TemplateRefiner refiner;
+    // The pyramid level the tracker runs on.
+    int level = 0;
+    std::atomic<bool> stopRequested{false};
+    std::chrono::steady_clock::duration busy{};
+    int missed = 0;
+    int agreed = 0;
+    int reportedPercent = -1;
+    bool done = false;
+
+    bool covers(int64_t frame) const
+    {
+        if (request.backward)
+            return frame <= request.startFrame && frame > request.endFrame;
+        return frame >= request.startFrame && (request.endFrame <= 0 || frame < request.endFrame);
+    }
+
+    bool waitingFor(int64_t frame) const
+    {
+        return request.backward ? frame > request.startFrame : frame < request.startFrame;
+    }
+
+    bool rejoined() const { return agreed >= kRejoinFrames; }
+
+    // Share of the object's range done once `frame` is; frameCount stands
+    // in for an open end.
+    double fraction(int64_t frame, int64_t frameCount) const
+    {
+        const int64_t end = request.backward ? std::max<int64_t>(request.endFrame, -1)
+                                             : (request.endFrame > 0 ? request.endFrame : frameCount);
+        const int64_t span = request.backward ? request.startFrame - end : end - request.startFrame;
+        if (span <= 0)
+            return 0.0;
+        const int64_t done = request.backward ? request.startFrame - frame + 1 : frame + 1 - request.startFrame;
+        return std::clamp(double(done) / double(span), 0.0, 1.0);
+    }
+
+    // Frames tracked per second of this object's own update time.
+    double framesPerSecond() const
+    {
+        const double seconds = std::chrono::duration<double>(busy).count();
+        return seconds > 0.0 ? double(track.samples.size()) / seconds : 0.0;
+    }
+
+    // Runs on a pool thread; touches nothing but this object. The tracker
+    // sees only the object's pyramid level; the full-resolution frame is
+    // read only in the refiner's search window.
+    void step(const std::vector<cv::Mat> &pyramid, int64_t index)
+    {
+        const auto started = std::chrono::steady_clock::now();
+        const cv::Mat &frame = pyramid.front();
+        const cv::Mat &coarse = pyramid[size_t(level)];
+        const float scale = float(1 << level);
+        TrackSample sample;
+        sample.frame = index;
+        try {
+            if (!tracker) {
+                const cv::Rect full = clampedRect(request.box, frame.size());
+                sample.box = TrackBox{float(full.x), float(full.y), float(full.width), float(full.height)};
+                tracker = createTracker(request.kind);
+                tracker->init(coarse, clampedRect(scaled(sample.box, 1.0f / scale), coarse.size()));
+                refiner.reset(frame, sample.box);
+            } else {
+                cv::Rect rect;
+                if (tracker->update(coarse, rect)) {
+                    const TrackBox box{float(rect.x), float(rect.y), float(rect.width), float(rect.height)};
+                    // Coarse trackers jitter by a pixel or two of their
+                    // level; search that far at full resolution.
+                    sample.box = refiner.refine(frame, scaled(box, scale), 2 * int(scale) + 1);
+                    missed = 0;
+                } else {
+                    sample.box = track.samples.back().box;
+                    sample.found = false;
+                    ++missed;
+                }
+            }
+        } catch (const std::exception &e) {
+            track.status = TrackStatus::Failed;
+            track.error = e.what();
+            return;
+        }
+        track.samples.push_back(sample);
+        busy += std::chrono::steady_clock::now() - started;
+
+        if (!request.rejoin.empty()) {
+            auto earlier = std::lower_bound(request.rejoin.begin(), request.rejoin.end(), index,
+                                            [](const TrackSample &s, int64_t f) { return s.frame < f; });
+            const bool agrees = sample.found && earlier != request.rejoin.end() && earlier->frame == index
+                                && earlier->found && overlap(earlier->box, sample.box) >= kRejoinOverlap;
+            agreed = agrees ? agreed + 1 : 0;
+        }
+    }
+};
+
+MultiObjectTracker::MultiObjectTracker(int concurrency)
+    : m_pool(concurrency)
+{
+}
+
+MultiObjectTracker::~MultiObjectTracker() = default;
+
+void MultiObjectTracker::setProgressCallback(ObjectProgress callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_progress = std::move(callback);
+}
+
+void MultiObjectTracker::setFinishedCallback(ObjectFinished callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished = std::move(callback);
+}
+
+void MultiObjectTracker::addObject(const TrackRequest &request)
+{
+    auto object = std::make_unique<Object>();
+    object->request = request;
+    object->track.id = request.id;
+    object->track.label = request.label;
+    object->track.kind = request.kind;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_objects.push_back(std::move(object));
+}
+
+void MultiObjectTracker::stop(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &object : m_objects) {
+        if (object->request.id == id)
+            object->stopRequested = true;
+    }
+}
+
+void MultiObjectTracker::stopAll()
+{
+    m_stopAll = true;
+}
+
+std::vector<ObjectTrack> MultiObjectTracker::run(const std::string &mediaPath)
+{
+    ObjectProgress progress;
+    ObjectFinished finished;
+    std::vector<Object *> forward;
+    std::vector<Object *> backward;
+    std::vector<Object *> objects;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        progress = m_progress;
+        finished = m_finished;
+        for (const auto &object : m_objects) {
+            objects.push_back(object.get());
+            (object->request.backward ? backward : forward).push_back(object.get());
+        }
+    }
+    if (objects.empty())
+        return {};
+
+    VideoFrameReader reader(mediaPath);
+    for (Object *object : objects)
+        object->track.fps = reader.fps();
+    if (!forward.empty())
+        trackPass(reader, forward, false, progress, finished);
+    if (!backward.empty())
+        trackPass(reader, backward, true, progress, finished);
+
+    std::vector<ObjectTrack> tracks;
+    for (Object *object : objects)
+        tracks.push_back(object->track);
+    return tracks;
+}
+
+void MultiObjectTracker::trackPass(VideoFrameReader &reader, const std::vector<Object *> &objects, bool backward,
+                                   const ObjectProgress &progress, const ObjectFinished &finished)
+{
+    const int maxMissed = std::max(1, int(kLostSeconds * reader.fps()));
+    auto stopping = [&](const Object *object) { return object->stopRequested || m_stopAll; };
+    auto finish = [&](Object *object, TrackStatus status) {
+        object->done = true;
+        if (object->track.status == TrackStatus::Running)
+            object->track.status = status;
+        object->track.framesPerSecond = object->framesPerSecond();
+        object->tracker.reset();
+        if (backward)
+            std::reverse(object->track.samples.begin(), object->track.samples.end());
+        if (finished)
+            finished(object->track);
+    };
+    auto report = [&](Object *object, int64_t frame) {
+        if (!progress)
+            return;
+        const double fraction = object->fraction(frame, reader.frameCount());
+        const int percent = int(fraction * 100.0);
+        if (percent != object->reportedPercent) {
+            object->reportedPercent = percent;
+            progress(object->request.id, fraction, object->framesPerSecond());
+        }
+    };
+
+    // The frames the pass needs: forward from the earliest start to the
+    // latest end (-1 for the end of the file), or backward from the latest
+    // start to the earliest end.
+    int64_t first = objects.front()->request.startFrame;
+    int64_t last = backward ? first : 0;
+    bool open = false;
+    for (const Object *object : objects) {
+        const TrackRequest &request = object->request;
+        if (backward) {
+            first = std::max(first, request.startFrame);
+            last = std::min(last, std::max<int64_t>(request.endFrame + 1, 0));
+        } else {
+            first = std::min(first, request.startFrame);
+            if (request.endFrame <= 0)
+                open = true;
+            else
+                last = std::max(last, request.endFrame);
+        }
+    }
+    first = std::max<int64_t>(0, first);
+
+    // The decoder builds the pyramid only as deep as some object needs.
+    int levels = 0;
+    for (Object *object : objects) {
+        object->level = pyramidLevel(object->request.box);
+        levels = std::max(levels, object->level);
+    }
+
+    FrameQueue queue;
+    auto decode = [&] {
+        if (!backward) {
+            reader.seek(first);
+            while (!queue.closed() && (open || reader.position() < last)) {
+                // A fresh Mat each time: the pyramid's first level shares
+                // the decoded pixels, which the next read must not reuse.
+                cv::Mat image;
+                DecodedFrame frame;
+                frame.index = reader.position();
+                if (!reader.read(image))
+                    break;
+                cv::buildPyramid(image, frame.pyramid, levels);
+                queue.push(std::move(frame));
+            }
+        } else {
+            for (int64_t chunkEnd = first + 1; chunkEnd > last && !queue.closed();) {
+                const int64_t chunkStart = std::max(last, chunkEnd - kReverseChunk);
+                reader.seek(chunkStart);
+                // Labelled with the reader's position, which is exact after
+                // the seek, rather than counted from chunkStart.
+                std::vector<std::pair<int64_t, cv::Mat>> chunk;
+                while (reader.position() < chunkEnd) {
+                    const int64_t index = reader.position();
+                    cv::Mat image;
+                    if (!reader.read(image))
+                        break;
+                    chunk.emplace_back(index, std::move(image));
+                }
+                for (size_t i = chunk.size(); i-- > 0;) {
+                    DecodedFrame frame;
+                    frame.index = chunk[i].first;
+                    cv::buildPyramid(chunk[i].second, frame.pyramid, levels);
+                    chunk[i].second.release();
+                    queue.push(std::move(frame));
+                }
+                chunkEnd = chunkStart;
+            }
+        }
+    };
+    // Set by the decoder if OpenCV throws (a corrupt stream, a failed
+    // allocation); read once it is joined.
+    std::string decodeError;
+    std::thread decoder([&] {
+        try {
+            decode();
+        } catch (const std::exception &e) {
+            decodeError = e.what();
+        }
+        queue.end();
+    });
+
+    DecodedFrame frame;
+    while (queue.pop(frame)) {
+        const int64_t index = frame.index;
+        std::vector<Object *> live;
+        bool pending = false;
+        for (Object *object : objects) {
+            if (object->done)
+                continue;
+            if (stopping(object))
+                finish(object, TrackStatus::Stopped);
+            else if (object->covers(index))
+                live.push_back(object);
+            else if (object->waitingFor(index))
+                pending = true;
+            else
+                finish(object, TrackStatus::Completed);
+        }
+        if (live.empty() && !pending)
+            break;
+
+        std::vector<std::future<void>> updates;
+        updates.reserve(live.size());
+        for (Object *object : live)
+            updates.push_back(m_pool.submit([object, &frame, index] { object->step(frame.pyramid, index); }));
+        for (auto &update : updates)
+            update.get();
+
+        for (Object *object : live) {
+            if (object->track.status == TrackStatus::Failed)
+                finish(object, TrackStatus::Failed);
+            else if (object->missed >= maxMissed)
+                finish(object, TrackStatus::Lost);
+            else if (object->rejoined())
+                finish(object, TrackStatus::Completed);
+            else
+                report(object, index);
+        }
+    }
+    queue.close();
+    decoder.join();
+
+    for (Object *object : objects) {
+        if (object->done)
+            continue;
+        if (!decodeError.empty() && !stopping(object)) {
+            object->track.status = TrackStatus::Failed;
+            object->track.error = "decoding failed: " + decodeError;
+        }
+        if (object->track.samples.empty() && !stopping(object)) {
+            object->track.status = TrackStatus::Failed;
+            object->track.error = "start frame is past the end of the video";
+        }
+        finish(object, stopping(object) ? TrackStatus::Stopped : TrackStatus::Completed);
+    }
+}
+
+} // namespace vep
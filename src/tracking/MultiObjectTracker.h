@@ -0,0 +1,87 @@
+#pragma once
+
+#include "core/ThreadPool.h"
+#include "tracking/ObjectTrack.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class VideoFrameReader;
+
+// Tracks any number of objects (faces, logos, products) through one file
+// at once. The file is decoded a single time, a few frames ahead on a
+// thread of its own, and each decoded frame is handed to every object that
+// is live on it; the objects' OpenCV trackers update concurrently on a
+// pool owned by the tracker. Tracking ten objects therefore costs about
+// what the slowest one costs, not ten decodes and ten times the updates.
+//
+// The decoder also builds an image pyramid of each frame, and each object's
+// tracker runs on the coarsest level its box stays large enough on; a
+// TemplateRefiner then places the box to a fraction of a pixel at full
+// resolution, reading only a small window around it. Large objects in 4K
+// footage are tracked at a fraction of the full-frame cost.
+//
+// Objects start and end on their own frames, and each can be stopped
+// without disturbing the others; the decode ends once no object needs
+// further frames. Backward requests (re-tracking from a corrected box
+// towards the start) share a second pass that plays the file in reverse,
+// a chunk at a time. A request with a trajectory to rejoin ends as soon as
+// it has converged on it.
+//
+// Callbacks run on the thread that called run().
+class MultiObjectTracker
+{
+public:
+    // fraction in [0, 1] of the object's own frame range; reported in
+    // steps of about a percent, with the rate the object is tracked at
+    // (see ObjectTrack::framesPerSecond).
+    using ObjectProgress = std::function<void(int id, double fraction, double framesPerSecond)>;
+    // Once per object, with everything tracked up to the point it ended.
+    using ObjectFinished = std::function<void(const ObjectTrack &track)>;
+
+    // concurrency <= 0 picks one worker per core, minus one.
+    explicit MultiObjectTracker(int concurrency = 0);
+    ~MultiObjectTracker();
+
+    MultiObjectTracker(const MultiObjectTracker &) = delete;
+    MultiObjectTracker &operator=(const MultiObjectTracker &) = delete;
+
+    void setProgressCallback(ObjectProgress callback);
+    void setFinishedCallback(ObjectFinished callback);
+
+    // Before run(). Requests sharing an id (the two directions of a
+    // re-track) are stopped together.
+    void addObject(const TrackRequest &request);
+
+    // Thread-safe; take effect at the next frame.
+    void stop(int id);
+    void stopAll();
+
+    // Tracks every object added, blocking until all have finished, and
+    // returns their tracks in the order they were added. Throws
+    // std::runtime_error if the file cannot be decoded. Must not be called
+    // from a task of the tracker's own pool.
+    std::vector<ObjectTrack> run(const std::string &mediaPath);
+
+private:
+    struct Object;
+
+    void trackPass(VideoFrameReader &reader, const std::vector<Object *> &objects, bool backward,
+                   const ObjectProgress &progress, const ObjectFinished &finished);
+
+    std::vector<std::unique_ptr<Object>> m_objects;
+    std::mutex m_mutex;
+    ObjectProgress m_progress;
+    ObjectFinished m_finished;
+    std::atomic<bool> m_stopAll{false};
+    // Last, so its workers are joined before anything they touch is destroyed.
+    ThreadPool m_pool;
+};
+
+} // namespace vep
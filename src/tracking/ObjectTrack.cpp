@@ -0,0 +1,56 @@
+#include "tracking/ObjectTrack.h"
+
+#include <algorithm>
+
+namespace vep {
+
+float overlap(const TrackBox &a, const TrackBox &b)
+{
+    const float width = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+    const float height = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+    if (width <= 0.0f || height <= 0.0f)
+        return 0.0f;
+    const float together = width * height;
+    return together / (a.width * a.height + b.width * b.height - together);
+}
+
+const char *trackerKindName(TrackerKind kind)
+{
+    switch (kind) {
+    case TrackerKind::Kcf:
+        return "kcf";
+    case TrackerKind::Mil:
+        return "mil";
+    case TrackerKind::Csrt:
+        break;
+    }
+    return "csrt";
+}
+
+TrackerKind trackerKindFromName(const std::string &name)
+{
+    if (name == "kcf")
+        return TrackerKind::Kcf;
+    if (name == "mil")
+        return TrackerKind::Mil;
+    return TrackerKind::Csrt;
+}
+
+const char *trackStatusName(TrackStatus status)
+{
+    switch (status) {
+    case TrackStatus::Running:
+        return "running";
+    case TrackStatus::Completed:
+        return "completed";
+    case TrackStatus::Stopped:
+        return "stopped";
+    case TrackStatus::Lost:
+        return "lost";
+    case TrackStatus::Failed:
+        return "failed";
+    }
+    return "failed";
+}
+
+} // namespace vep
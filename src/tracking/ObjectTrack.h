@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+// Axis-aligned box in source-frame pixels.
+struct TrackBox
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+
+    float centerX() const { return x + width * 0.5f; }
+    float centerY() const { return y + height * 0.5f; }
+};
+
+// Intersection over union, 0 for disjoint or empty boxes.
+float overlap(const TrackBox &a, const TrackBox &b);
+
+// The tracked box on one frame. A frame the tracker lost the object on
+// keeps the last good box with found = false.
+struct TrackSample
+{
+    int64_t frame = 0;
+    TrackBox box;
+    bool found = true;
+};
+
+enum class TrackerKind {
+    Csrt, // most accurate, ~25 ms a frame at 1080p
+    Kcf,  // fast, loses objects that change scale
+    Mil,  // in between; no opencv_contrib needed
+};
+
+enum class TrackStatus {
+    Running,
+    Completed, // reached its end frame or the end of the file
+    Stopped,   // stopped by the user; samples so far are kept
+    Lost,      // the tracker failed for too many frames in a row
+    Failed,    // error says why
+};
+
+const char *trackerKindName(TrackerKind kind);
+// Unknown names give Csrt.
+TrackerKind trackerKindFromName(const std::string &name);
+const char *trackStatusName(TrackStatus status);
+
+// What to track: the box drawn on startFrame, followed forward up to (not
+// including) endFrame, or to the end of the file if endFrame <= 0.
+// Backward requests run down to (not including) endFrame instead, or to
+// frame 0 if endFrame < 0.
+struct TrackRequest
+{
+    int id = 0;
+    std::string label;
+    TrackBox box;
+    int64_t startFrame = 0;
+    int64_t endFrame = 0;
+    bool backward = false;
+    TrackerKind kind = TrackerKind::Csrt;
+    // A trajectory tracked earlier (sorted by frame). Once the new one has
+    // agreed with it for a few frames in a row the request ends there, as
+    // everything further on would only repeat it.
+    std::vector<TrackSample> rejoin;
+};
+
+struct ObjectTrack
+{
+    int id = 0;
+    std::string label;
+    TrackerKind kind = TrackerKind::Csrt;
+    TrackStatus status = TrackStatus::Running;
+    std::string error;
+    // Frame rate of the source, which samples are numbered in.
+    double fps = 0.0;
+    // Frames tracked per second of the object's own update time in the run
+    // that produced the track (what it alone would run at); not cached.
+    double framesPerSecond = 0.0;
+    // One per frame from the first tracked frame on, in order.
+    std::vector<TrackSample> samples;
+    // Boxes the user placed by hand, sorted by frame. Re-tracking starts
+    // from them and never runs across one.
+    std::vector<TrackSample> anchors;
+};
+
+} // namespace vep
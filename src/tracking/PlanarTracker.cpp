@@ -0,0 +1,294 @@
+#include "tracking/PlanarTracker.h"
+
+#include "media/VideoFrameReader.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+// Frames are matched at no more rows than this.
+constexpr int kAnalysisHeight = 1080;
+constexpr int kReferenceFeatures = 1500;
+constexpr int kFrameFeatures = 2000;
+// Lowe's ratio test: the best match must be clearly better than the next.
+constexpr float kMatchRatio = 0.75f;
+constexpr double kRansacPixels = 3.0;
+// Fewer inliers than this is not the plane.
+constexpr int kMinInliers = 15;
+constexpr int kMinReferenceFeatures = 30;
+// The search window grows by this share of the plane's size for every
+// frame since it was last found, and is never narrower than kMinMargin.
+constexpr double kMarginPerFrame = 0.25;
+constexpr int kMinMargin = 32;
+// The plane may shrink or grow this much against the reference before a
+// fit is taken for a mismatch.
+constexpr double kMaxAreaRatio = 25.0;
+// The plane is given up after this many seconds without a fit.
+constexpr double kLostSeconds = 1.0;
+
+std::vector<cv::Point2f> toPoints(const PlaneQuad &quad, double scale)
+{
+    std::vector<cv::Point2f> points;
+    for (const PlanePoint &point : quad)
+        points.emplace_back(float(point.x * scale), float(point.y * scale));
+    return points;
+}
+
+struct Reference
+{
+    std::vector<cv::Point2f> quad;
+    double area = 0.0;
+    std::vector<cv::Point2f> points;
+    cv::Mat descriptors;
+};
+
+struct Located
+{
+    bool found = false;
+    // Reference to frame, at analysis scale.
+    cv::Mat homography;
+};
+
+// A fit that folds the quad over or scales it absurdly is a mismatch.
+bool plausible(const Reference &reference, const cv::Mat &homography)
+{
+    std::vector<cv::Point2f> mapped;
+    cv::perspectiveTransform(reference.quad, mapped, homography);
+    if (!cv::isContourConvex(mapped))
+        return false;
+    const double ratio = cv::contourArea(mapped) / reference.area;
+    return ratio > 1.0 / kMaxAreaRatio && ratio < kMaxAreaRatio;
+}
+
+// Runs on a pool thread. `predicted` is the last homography found, `gap`
+// the number of frames since.
+Located locate(const Reference &reference, const cv::Mat &grey, const cv::Mat &predicted, int gap)
+{
+    std::vector<cv::Point2f> expected;
+    cv::perspectiveTransform(reference.quad, expected, predicted);
+    const cv::Rect bounds = cv::boundingRect(expected);
+    const int margin = std::max(kMinMargin, int(kMarginPerFrame * gap * std::max(bounds.width, bounds.height)));
+    cv::Rect window = cv::Rect(bounds.x - margin, bounds.y - margin, bounds.width + 2 * margin,
+                               bounds.height + 2 * margin)
+                      & cv::Rect(0, 0, grey.cols, grey.rows);
+    if (window.area() == 0)
+        window = cv::Rect(0, 0, grey.cols, grey.rows);
+
+    cv::Ptr<cv::ORB> orb = cv::ORB::create(kFrameFeatures);
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    orb->detectAndCompute(grey(window), cv::noArray(), keypoints, descriptors);
+    Located located;
+    if (descriptors.rows < kMinInliers)
+        return located;
+
+    cv::BFMatcher matcher(cv::NORM_HAMMING);
+    std::vector<std::vector<cv::DMatch>> matches;
+    matcher.knnMatch(reference.descriptors, descriptors, matches, 2);
+    std::vector<cv::Point2f> from;
+    std::vector<cv::Point2f> to;
+    for (const std::vector<cv::DMatch> &candidates : matches) {
+        if (candidates.size() < 2 || candidates[0].distance >= kMatchRatio * candidates[1].distance)
+            continue;
+        from.push_back(reference.points[size_t(candidates[0].queryIdx)]);
+        const cv::Point2f &point = keypoints[size_t(candidates[0].trainIdx)].pt;
+        to.emplace_back(point.x + float(window.x), point.y + float(window.y));
+    }
+    if (int(from.size()) < kMinInliers)
+        return located;
+
+    std::vector<uchar> inliers;
+    cv::Mat homography = cv::findHomography(from, to, cv::RANSAC, kRansacPixels, inliers);
+    if (homography.empty() || cv::countNonZero(inliers) < kMinInliers || !plausible(reference, homography))
+        return located;
+    located.found = true;
+    located.homography = homography;
+    return located;
+}
+
+// The analysis-scale homography as one between full-size frames:
+// S^-1 * H * S with S scaling by `scale`.
+Homography toFullSize(const cv::Mat &homography, double scale)
+{
+    const cv::Matx33d s(scale, 0.0, 0.0, 0.0, scale, 0.0, 0.0, 0.0, 1.0);
+    const cv::Matx33d full = s.inv() * cv::Matx33d(homography) * s;
+    Homography result;
+    for (int i = 0; i < 9; ++i)
+        result[size_t(i)] = float(full.val[i] / full.val[8]);
+    return result;
+}
+
+} // namespace
+
+PlanarTracker::PlanarTracker(int concurrency)
+    : m_pool(concurrency)
+{
+}
+
+void PlanarTracker::setProgressCallback(Progress callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_progress = std::move(callback);
+}
+
+void PlanarTracker::stop()
+{
+    m_stop = true;
+}
+
+PlaneTrack PlanarTracker::run(const std::string &mediaPath, const PlaneRequest &request)
+{
+    Progress progress;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        progress = m_progress;
+    }
+
+    PlaneTrack track;
+    track.id = request.id;
+    track.label = request.label;
+    track.quad = request.quad;
+    track.referenceFrame = std::max<int64_t>(0, request.startFrame);
+
+    VideoFrameReader reader(mediaPath);
+    track.fps = reader.fps();
+    track.width = reader.width();
+    track.height = reader.height();
+    const double scale = reader.height() > kAnalysisHeight ? double(kAnalysisHeight) / reader.height() : 1.0;
+    const auto started = std::chrono::steady_clock::now();
+
+    reader.seek(track.referenceFrame);
+    cv::Mat frame;
+    if (!reader.read(frame)) {
+        track.status = TrackStatus::Failed;
+        track.error = "start frame is past the end of the video";
+        return track;
+    }
+
+    Reference reference;
+    reference.quad = toPoints(request.quad, scale);
+    reference.area = cv::contourArea(reference.quad);
+    if (!cv::isContourConvex(reference.quad) || reference.area < 1.0) {
+        track.status = TrackStatus::Failed;
+        track.error = "the corners do not enclose a convex area";
+        return track;
+    }
+    {
+        const cv::Mat grey = toGrey(frame, scale);
+        cv::Mat mask = cv::Mat::zeros(grey.size(), CV_8U);
+        std::vector<cv::Point> corners;
+        for (const cv::Point2f &point : reference.quad)
+            corners.emplace_back(int(std::lround(point.x)), int(std::lround(point.y)));
+        cv::fillConvexPoly(mask, corners, cv::Scalar(255));
+        std::vector<cv::KeyPoint> keypoints;
+        cv::ORB::create(kReferenceFeatures)->detectAndCompute(grey, mask, keypoints, reference.descriptors);
+        for (const cv::KeyPoint &keypoint : keypoints)
+            reference.points.push_back(keypoint.pt);
+    }
+    if (int(reference.points.size()) < kMinReferenceFeatures) {
+        track.status = TrackStatus::Failed;
+        track.error = "too little detail inside the corners to track";
+        return track;
+    }
+    track.samples.push_back(PlaneSample{track.referenceFrame, identityHomography(), true});
+
+    const int64_t end = request.endFrame > 0 ? request.endFrame : reader.frameCount();
+    const int64_t span = std::max<int64_t>(1, end - track.referenceFrame);
+    const int maxMissed = std::max(1, int(kLostSeconds * reader.fps()));
+    // Enough frames in flight to keep every worker busy.
+    const size_t batchSize = size_t(std::max(1, m_pool.threadCount())) + 1;
+    auto readBatch = [&] {
+        std::vector<cv::Mat> batch;
+        while (batch.size() < batchSize && (request.endFrame <= 0 || reader.position() < request.endFrame)) {
+            cv::Mat image;
+            if (!reader.read(image))
+                break;
+            batch.push_back(std::move(image));
+        }
+        return batch;
+    };
+
+    cv::Mat lastFound = cv::Mat::eye(3, 3, CV_64F);
+    int missed = 0;
+    int reportedPercent = -1;
+    auto fail = [&](const char *error) {
+        if (track.status == TrackStatus::Running) {
+            track.status = TrackStatus::Failed;
+            track.error = error;
+        }
+    };
+    std::vector<cv::Mat> batch = readBatch();
+    while (!batch.empty() && track.status == TrackStatus::Running) {
+        if (m_stop) {
+            track.status = TrackStatus::Stopped;
+            break;
+        }
+        std::vector<std::future<Located>> located;
+        located.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const int gap = missed + int(i) + 1;
+            located.push_back(m_pool.submit([&reference, image = batch[i], scale, lastFound, gap] {
+                return locate(reference, toGrey(image, scale), lastFound, gap);
+            }));
+        }
+        // Decode the next batch while this one is matched. Every future is
+        // waited for before anything can leave the loop: the tasks read
+        // `reference`.
+        std::vector<cv::Mat> next;
+        try {
+            next = readBatch();
+        } catch (const std::exception &e) {
+            fail(e.what());
+        }
+
+        for (auto &result : located) {
+            Located fit;
+            try {
+                fit = result.get();
+            } catch (const std::exception &e) {
+                fail(e.what());
+            }
+            if (track.status != TrackStatus::Running)
+                continue;
+            PlaneSample sample;
+            sample.frame = track.samples.back().frame + 1;
+            if (fit.found) {
+                lastFound = fit.homography;
+                sample.homography = toFullSize(fit.homography, scale);
+                missed = 0;
+            } else {
+                sample.homography = track.samples.back().homography;
+                sample.found = false;
+                if (++missed >= maxMissed)
+                    track.status = TrackStatus::Lost;
+            }
+            track.samples.push_back(sample);
+        }
+        batch = std::move(next);
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        track.framesPerSecond = seconds > 0.0 ? double(track.samples.size()) / seconds : 0.0;
+        const double fraction
+            = std::clamp(double(track.samples.back().frame + 1 - track.referenceFrame) / double(span), 0.0, 1.0);
+        const int percent = int(fraction * 100.0);
+        if (progress && percent != reportedPercent) {
+            reportedPercent = percent;
+            progress(fraction, track.framesPerSecond);
+        }
+    }
+    if (track.status == TrackStatus::Running)
+        track.status = TrackStatus::Completed;
+    return track;
+}
+
+} // namespace vep
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/ThreadPool.h"
+#include "tracking/PlaneTrack.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace vep {
+
+// Follows a flat surface (a phone screen, a billboard, a page) through a
+// file under perspective, so that an image can be corner-pinned onto it.
+//
+// ORB features are taken inside the quad on the reference frame, and each
+// later frame is matched against those, in a window around where the plane
+// was last seen, and fitted with a RANSAC homography. Every frame is
+// matched against the reference, not the frame before, so errors do not
+// add up over a long shot, and frames are independent: a batch of them is
+// matched at once on the tracker's pool while the next batch decodes.
+// Frames taller than 1080 rows are matched at 1080 rows.
+class PlanarTracker
+{
+public:
+    // fraction in [0, 1] of the requested range; reported in steps of about
+    // a percent, with the frames tracked per second so far.
+    using Progress = std::function<void(double fraction, double framesPerSecond)>;
+
+    // concurrency <= 0 picks one worker per core, minus one.
+    explicit PlanarTracker(int concurrency = 0);
+
+    PlanarTracker(const PlanarTracker &) = delete;
+    PlanarTracker &operator=(const PlanarTracker &) = delete;
+
+    // Called on the thread that called run().
+    void setProgressCallback(Progress callback);
+
+    // Thread-safe; takes effect at the next batch of frames.
+    void stop();
+
+    // Blocks until the plane has been tracked to its end frame, lost or
+    // stopped. Failures inside the track (too little texture in the quad, a
+    // start past the end of the file) are reported in its status; throws
+    // std::runtime_error only if the file cannot be opened. Must not be
+    // called from a task of the tracker's own pool.
+    PlaneTrack run(const std::string &mediaPath, const PlaneRequest &request);
+
+private:
+    std::mutex m_mutex;
+    Progress m_progress;
+    std::atomic<bool> m_stop{false};
+    // Last, so its workers are joined before anything they touch is destroyed.
+    ThreadPool m_pool;
+};
+
+} // namespace vep
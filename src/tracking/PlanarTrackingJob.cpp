@@ -0,0 +1,179 @@
+#include "tracking/PlanarTrackingJob.h"
+
+#include "core/MediaCache.h"
+#include "tracking/PlanarTracker.h"
+#include "tracking/PlaneCache.h"
+
+#include <QFutureWatcher>
+#include <QMetaObject>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+// Two jobs finishing on the same file must not drop each other's planes
+// between load and store.
+std::mutex g_cacheMutex;
+
+QVariantList toVariant(const PlaneQuad &quad)
+{
+    QVariantList corners;
+    for (const PlanePoint &point : quad)
+        corners.append(QVariantMap{{"x", point.x}, {"y", point.y}});
+    return corners;
+}
+
+} // namespace
+
+PlanarTrackingJob::PlanarTrackingJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PlanarTrackingJob::~PlanarTrackingJob()
+{
+    cancel();
+    m_future.waitForFinished();
+}
+
+QVariantMap PlanarTrackingJob::toVariant(const PlaneTrack &plane)
+{
+    QVariantList samples;
+    samples.reserve(int(plane.samples.size()));
+    for (const PlaneSample &sample : plane.samples) {
+        QVariantList homography;
+        for (float value : sample.homography)
+            homography.append(value);
+        samples.append(QVariantMap{{"frame", qint64(sample.frame)},
+                                   {"found", sample.found},
+                                   {"homography", homography},
+                                   {"corners", vep::toVariant(mapQuad(sample.homography, plane.quad))}});
+    }
+    return QVariantMap{{"id", plane.id},
+                       {"label", QString::fromStdString(plane.label)},
+                       {"status", QString::fromLatin1(trackStatusName(plane.status))},
+                       {"error", QString::fromStdString(plane.error)},
+                       {"fps", plane.fps},
+                       {"width", plane.width},
+                       {"height", plane.height},
+                       {"referenceFrame", qint64(plane.referenceFrame)},
+                       {"corners", vep::toVariant(plane.quad)},
+                       {"framesPerSecond", plane.framesPerSecond},
+                       {"samples", samples}};
+}
+
+void PlanarTrackingJob::loadCachedPlanes(const QString &mediaPath)
+{
+    // The watcher is the job's child, so a job destroyed mid-lookup is never
+    // called back; the lookup itself touches nothing of the job.
+    using Watcher = QFutureWatcher<QVariantList>;
+    auto *watcher = new Watcher(this);
+    connect(watcher, &Watcher::finished, this, [this, watcher, mediaPath] {
+        emit cachedPlanesLoaded(mediaPath, watcher->result());
+        watcher->deleteLater();
+    });
+    const std::string media = mediaPath.toStdString();
+    watcher->setFuture(QtConcurrent::run([media] {
+        QVariantList list;
+        try {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+            for (const PlaneTrack &plane : PlaneCache(MediaCache::instance()).load(media).planes)
+                list.append(toVariant(plane));
+        } catch (const std::runtime_error &) {
+            // Missing media: nothing cached.
+        }
+        return list;
+    }));
+}
+
+void PlanarTrackingJob::start(const QString &mediaPath, const QVariantMap &plane)
+{
+    if (m_running)
+        return;
+
+    PlaneRequest request;
+    request.id = plane.value("id").toInt();
+    request.label = plane.value("label").toString().toStdString();
+    const QVariantList corners = plane.value("corners").toList();
+    for (int i = 0; i < std::min<int>(corners.size(), int(request.quad.size())); ++i) {
+        const QVariantMap corner = corners.at(i).toMap();
+        request.quad[size_t(i)] = PlanePoint{corner.value("x").toFloat(), corner.value("y").toFloat()};
+    }
+    request.startFrame = plane.value("startFrame").toLongLong();
+    request.endFrame = plane.value("endFrame").toLongLong();
+
+    m_tracker = std::make_unique<PlanarTracker>(m_concurrency);
+    m_progress = 0.0;
+    m_framesPerSecond = 0.0;
+    emit progressChanged();
+    setRunning(true);
+
+    m_tracker->setProgressCallback([this](double fraction, double framesPerSecond) {
+        QMetaObject::invokeMethod(this, [this, fraction, framesPerSecond] {
+            m_progress = fraction;
+            m_framesPerSecond = framesPerSecond;
+            emit progressChanged();
+        });
+    });
+
+    PlanarTracker *tracker = m_tracker.get();
+    const std::string media = mediaPath.toStdString();
+    m_future = QtConcurrent::run([this, tracker, media, request] {
+        bool completed = false;
+        QString error;
+        try {
+            const PlaneTrack track = tracker->run(media, request);
+            completed = track.status == TrackStatus::Completed || track.status == TrackStatus::Lost;
+            // A stopped or failed run covers only part of the range and
+            // would replace a whole track of the same plane.
+            if (completed && !track.samples.empty()) {
+                std::lock_guard<std::mutex> lock(g_cacheMutex);
+                PlaneCache cache(MediaCache::instance());
+                CachedPlanes cached = cache.load(media);
+                cached.put(track);
+                cache.store(media, cached);
+            }
+            error = QString::fromStdString(track.error);
+            const QVariantMap variant = toVariant(track);
+            QMetaObject::invokeMethod(this, [this, variant] {
+                emit planeFinished(variant.value("id").toInt(), variant);
+            });
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        QMetaObject::invokeMethod(this, [this, completed, error] {
+            setRunning(false);
+            emit finished(completed, error);
+        });
+    });
+}
+
+void PlanarTrackingJob::cancel()
+{
+    if (m_tracker)
+        m_tracker->stop();
+}
+
+void PlanarTrackingJob::setConcurrency(int concurrency)
+{
+    concurrency = std::max(0, concurrency);
+    if (m_concurrency == concurrency)
+        return;
+    m_concurrency = concurrency;
+    emit concurrencyChanged();
+}
+
+void PlanarTrackingJob::setRunning(bool running)
+{
+    if (m_running == running)
+        return;
+    m_running = running;
+    emit runningChanged();
+}
+
+} // namespace vep
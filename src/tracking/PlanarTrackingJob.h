@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tracking/PlaneTrack.h"
+
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include <memory>
+
+namespace vep {
+
+class PlanarTracker;
+
+// Runs a PlanarTracker off the UI thread and caches its result for the
+// vep_cornerpin filter. Only planes tracked to the end (completed or lost)
+// are cached; a stopped or failed run leaves the cached plane as it was.
+//
+// A plane is a map with id, label, corners (four maps with x and y in
+// source pixels: top-left, top-right, bottom-right, bottom-left of what
+// will be pinned), startFrame and endFrame.
+//
+// A finished plane is a map with id, label, status, error, fps, width,
+// height, referenceFrame, corners, framesPerSecond and samples, each
+// sample a map with frame, found, homography (nine numbers, row-major,
+// reference frame to this one) and corners (where the quad is on it).
+class PlanarTrackingJob : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(double framesPerSecond READ framesPerSecond NOTIFY progressChanged)
+    Q_PROPERTY(int concurrency READ concurrency WRITE setConcurrency NOTIFY concurrencyChanged)
+
+public:
+    explicit PlanarTrackingJob(QObject *parent = nullptr);
+    ~PlanarTrackingJob() override;
+
+    bool isRunning() const { return m_running; }
+    double progress() const { return m_progress; }
+    double framesPerSecond() const { return m_framesPerSecond; }
+    int concurrency() const { return m_concurrency; }
+    void setConcurrency(int concurrency);
+
+    static QVariantMap toVariant(const PlaneTrack &plane);
+
+    // Reads every plane cached for the file off the UI thread and reports
+    // them through cachedPlanesLoaded() as toVariant() maps; empty if none
+    // or the file cannot be read.
+    Q_INVOKABLE void loadCachedPlanes(const QString &mediaPath);
+
+public slots:
+    void start(const QString &mediaPath, const QVariantMap &plane);
+    void cancel();
+
+signals:
+    void planeFinished(int planeId, const QVariantMap &plane);
+    void cachedPlanesLoaded(const QString &mediaPath, const QVariantList &planes);
+    void runningChanged();
+    void progressChanged();
+    void concurrencyChanged();
+    void finished(bool completed, const QString &error);
+
+private:
+    void setRunning(bool running);
+
+    // Replaced only between runs, on the UI thread.
+    std::unique_ptr<PlanarTracker> m_tracker;
+    QFuture<void> m_future;
+    bool m_running = false;
+    double m_progress = 0.0;
+    double m_framesPerSecond = 0.0;
+    int m_concurrency = 0;
+};
+
+} // namespace vep
@@ -0,0 +1,148 @@
+#include "tracking/PlaneCache.h"
+
+#include "core/BinaryIO.h"
+#include "core/MediaCache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+constexpr size_t kStoredElements = 8;
+constexpr size_t kSampleBytes = 1 + kStoredElements * sizeof(float);
+
+void putQuad(ByteWriter &out, const PlaneQuad &quad)
+{
+    for (const PlanePoint &point : quad) {
+        out.put(point.x);
+        out.put(point.y);
+    }
+}
+
+PlaneQuad getQuad(ByteReader &in)
+{
+    PlaneQuad quad;
+    for (PlanePoint &point : quad) {
+        point.x = in.get<float>();
+        point.y = in.get<float>();
+    }
+    return quad;
+}
+
+} // namespace
+
+const PlaneTrack *CachedPlanes::find(int id) const
+{
+    auto it = std::find_if(planes.begin(), planes.end(), [id](const PlaneTrack &plane) { return plane.id == id; });
+    return it == planes.end() ? nullptr : &*it;
+}
+
+void CachedPlanes::put(const PlaneTrack &plane)
+{
+    auto it = std::find_if(planes.begin(), planes.end(),
+                           [&](const PlaneTrack &existing) { return existing.id == plane.id; });
+    if (it == planes.end())
+        planes.push_back(plane);
+    else
+        *it = plane;
+}
+
+void CachedPlanes::remove(int id)
+{
+    planes.erase(std::remove_if(planes.begin(), planes.end(), [id](const PlaneTrack &plane) { return plane.id == id; }),
+                 planes.end());
+}
+
+std::vector<uint8_t> CachedPlanes::serialize() const
+{
+    ByteWriter out;
+    out.putMagic("VEPPLAN1");
+    out.put(uint64_t(planes.size()));
+    for (const PlaneTrack &plane : planes) {
+        out.put(int32_t(plane.id));
+        out.putString(plane.label);
+        out.put(uint8_t(plane.status));
+        out.putString(plane.error);
+        out.put(plane.fps);
+        out.put(int32_t(plane.width));
+        out.put(int32_t(plane.height));
+        out.put(int64_t(plane.referenceFrame));
+        putQuad(out, plane.quad);
+        // Samples are consecutive frames, so only the first is stored.
+        out.put(uint64_t(plane.samples.size()));
+        out.put(int64_t(plane.samples.empty() ? 0 : plane.samples.front().frame));
+        for (const PlaneSample &sample : plane.samples) {
+            out.put(uint8_t(sample.found));
+            out.putRaw(sample.homography.data(), kStoredElements * sizeof(float));
+        }
+    }
+    return out.take();
+}
+
+CachedPlanes CachedPlanes::deserialize(const std::vector<uint8_t> &bytes)
+{
+    ByteReader in(bytes);
+    in.expectMagic("VEPPLAN1");
+    CachedPlanes cached;
+    const uint64_t count = in.get<uint64_t>();
+    for (uint64_t i = 0; i < count; ++i) {
+        PlaneTrack plane;
+        plane.id = in.get<int32_t>();
+        plane.label = in.getString();
+        const uint8_t status = in.get<uint8_t>();
+        if (status > uint8_t(TrackStatus::Failed))
+            throw std::runtime_error("malformed plane record");
+        plane.status = TrackStatus(status);
+        plane.error = in.getString();
+        plane.fps = in.get<double>();
+        plane.width = in.get<int32_t>();
+        plane.height = in.get<int32_t>();
+        plane.referenceFrame = in.get<int64_t>();
+        plane.quad = getQuad(in);
+        const uint64_t samples = in.get<uint64_t>();
+        const int64_t first = in.get<int64_t>();
+        if (samples > in.remaining() / kSampleBytes)
+            throw std::runtime_error("truncated plane record");
+        plane.samples.resize(static_cast<size_t>(samples));
+        for (size_t s = 0; s < plane.samples.size(); ++s) {
+            PlaneSample &sample = plane.samples[s];
+            sample.frame = first + int64_t(s);
+            sample.found = in.get<uint8_t>() != 0;
+            in.getRaw(sample.homography.data(), kStoredElements * sizeof(float));
+            sample.homography[8] = 1.0f;
+        }
+        cached.planes.push_back(std::move(plane));
+    }
+    return cached;
+}
+
+PlaneCache::PlaneCache(MediaCache &cache)
+    : m_cache(cache)
+{
+}
+
+CachedPlanes PlaneCache::load(const std::string &mediaPath)
+{
+    return load(m_cache.hashOf(mediaPath));
+}
+
+CachedPlanes PlaneCache::load(ContentHash hash)
+{
+    const auto bytes = m_cache.read(hash, CachedPlanes::kCacheKind);
+    if (!bytes)
+        return {};
+    try {
+        return CachedPlanes::deserialize(*bytes);
+    } catch (const std::runtime_error &) {
+        return {};
+    }
+}
+
+void PlaneCache::store(const std::string &mediaPath, const CachedPlanes &planes)
+{
+    m_cache.write(m_cache.hashOf(mediaPath), CachedPlanes::kCacheKind, planes.serialize());
+}
+
+} // namespace vep
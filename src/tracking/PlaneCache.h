@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/ContentHash.h"
+#include "tracking/PlaneTrack.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class MediaCache;
+
+// Every plane tracked in one media file, kept in the MediaCache under the
+// file's content hash next to the object tracks (see TrackCache), so the
+// corner-pin filter can read a frame's homography without tracking again.
+// A sample costs 33 bytes: the found flag and eight floats (the ninth
+// homography element is 1).
+struct CachedPlanes
+{
+    static constexpr const char *kCacheKind = "planes";
+
+    std::vector<PlaneTrack> planes;
+
+    const PlaneTrack *find(int id) const;
+    // Replaces the plane with the same id, or adds it.
+    void put(const PlaneTrack &plane);
+    void remove(int id);
+
+    std::vector<uint8_t> serialize() const;
+    // Throws std::runtime_error on a malformed record.
+    static CachedPlanes deserialize(const std::vector<uint8_t> &bytes);
+};
+
+class PlaneCache
+{
+public:
+    explicit PlaneCache(MediaCache &cache);
+
+    // Empty if nothing is cached (or the entry is damaged). Throws
+    // std::runtime_error if the media file cannot be hashed.
+    CachedPlanes load(const std::string &mediaPath);
+    // The same for a file whose hash is already known (see
+    // MediaCache::knownHashOf()); never throws.
+    CachedPlanes load(ContentHash hash);
+    void store(const std::string &mediaPath, const CachedPlanes &planes);
+
+private:
+    MediaCache &m_cache;
+};
+
+} // namespace vep
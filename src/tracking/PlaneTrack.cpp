@@ -0,0 +1,37 @@
+#include "tracking/PlaneTrack.h"
+
+#include <algorithm>
+
+namespace vep {
+
+Homography identityHomography()
+{
+    return {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+PlanePoint mapPoint(const Homography &h, const PlanePoint &point)
+{
+    const double x = point.x;
+    const double y = point.y;
+    const double w = h[6] * x + h[7] * y + h[8];
+    if (w == 0.0)
+        return point;
+    return PlanePoint{float((h[0] * x + h[1] * y + h[2]) / w), float((h[3] * x + h[4] * y + h[5]) / w)};
+}
+
+PlaneQuad mapQuad(const Homography &h, const PlaneQuad &quad)
+{
+    PlaneQuad mapped;
+    for (size_t i = 0; i < quad.size(); ++i)
+        mapped[i] = mapPoint(h, quad[i]);
+    return mapped;
+}
+
+const PlaneSample *PlaneTrack::sampleAt(int64_t frame) const
+{
+    auto it = std::lower_bound(samples.begin(), samples.end(), frame,
+                               [](const PlaneSample &sample, int64_t f) { return sample.frame < f; });
+    return it != samples.end() && it->frame == frame ? &*it : nullptr;
+}
+
+} // namespace vep
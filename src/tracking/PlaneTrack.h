@@ -0,0 +1,74 @@
+#pragma once
+
+#include "tracking/ObjectTrack.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+struct PlanePoint
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+// The corners of a flat surface (a screen, a sign) in source-frame pixels,
+// in order round its edge: top-left, top-right, bottom-right, bottom-left
+// of whatever is pinned onto it.
+using PlaneQuad = std::array<PlanePoint, 4>;
+
+// Row-major 3x3 homography, normalised so that the last element is 1.
+using Homography = std::array<float, 9>;
+
+Homography identityHomography();
+PlanePoint mapPoint(const Homography &h, const PlanePoint &point);
+PlaneQuad mapQuad(const Homography &h, const PlaneQuad &quad);
+
+// Where the plane is on one frame: the homography from the reference
+// frame's pixels to this frame's. A frame the plane was not found on keeps
+// the last good homography with found = false.
+struct PlaneSample
+{
+    int64_t frame = 0;
+    Homography homography = identityHomography();
+    bool found = true;
+};
+
+// What to track: the quad drawn on startFrame (the reference frame),
+// followed up to (not including) endFrame, or to the end of the file if
+// endFrame <= 0.
+struct PlaneRequest
+{
+    int id = 0;
+    std::string label;
+    PlaneQuad quad;
+    int64_t startFrame = 0;
+    int64_t endFrame = 0;
+};
+
+struct PlaneTrack
+{
+    int id = 0;
+    std::string label;
+    TrackStatus status = TrackStatus::Running;
+    std::string error;
+    // Frame rate and size of the source, which samples are measured in.
+    double fps = 0.0;
+    int width = 0;
+    int height = 0;
+    int64_t referenceFrame = 0;
+    PlaneQuad quad;
+    // One per frame from the reference frame on, in order.
+    std::vector<PlaneSample> samples;
+    // Frames tracked per second of the run that produced the track; not
+    // cached.
+    double framesPerSecond = 0.0;
+
+    // The sample for `frame`, or null if the track does not cover it.
+    const PlaneSample *sampleAt(int64_t frame) const;
+};
+
+} // namespace vep
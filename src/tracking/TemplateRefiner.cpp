@@ -0,0 +1,97 @@
+#include "tracking/TemplateRefiner.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace vep {
+
+namespace {
+
+// Normalised correlation the patch must reach to be trusted.
+constexpr double kMinScore = 0.6;
+constexpr double kRenewScore = 0.9;
+// Patches smaller than this carry too little texture to match.
+constexpr int kMinSide = 4;
+
+// Offset of the maximum of the parabola through three samples around a
+// peak, in (-0.5, 0.5).
+float parabolaPeak(float left, float center, float right)
+{
+    const float curvature = left - 2.0f * center + right;
+    if (!(curvature < 0.0f))
+        return 0.0f;
+    return std::clamp(0.5f * (left - right) / curvature, -0.5f, 0.5f);
+}
+
+} // namespace
+
+void TemplateRefiner::reset(const cv::Mat &frame, const TrackBox &box)
+{
+    const int width = std::min({int(std::lround(box.width)), kMaxSide, frame.cols});
+    const int height = std::min({int(std::lround(box.height)), kMaxSide, frame.rows});
+    if (width < kMinSide || height < kMinSide) {
+        m_patch.release();
+        return;
+    }
+    const float centerX = box.centerX();
+    const float centerY = box.centerY();
+    const int left = std::clamp(int(std::lround(centerX - width * 0.5f)), 0, frame.cols - width);
+    const int top = std::clamp(int(std::lround(centerY - height * 0.5f)), 0, frame.rows - height);
+    cv::cvtColor(frame(cv::Rect(left, top, width, height)), m_patch, cv::COLOR_BGR2GRAY);
+    m_center = cv::Point2f(centerX - float(left), centerY - float(top));
+}
+
+TrackBox TemplateRefiner::refine(const cv::Mat &frame, const TrackBox &coarse, int radius)
+{
+    if (!ready())
+        return coarse;
+
+    // Where the patch would sit if the coarse box were exact, widened by
+    // the radius on every side.
+    const int expectedX = int(std::floor(coarse.centerX() - m_center.x));
+    const int expectedY = int(std::floor(coarse.centerY() - m_center.y));
+    const cv::Rect window = cv::Rect(expectedX - radius, expectedY - radius, m_patch.cols + 2 * radius + 1,
+                                     m_patch.rows + 2 * radius + 1)
+                            & cv::Rect(0, 0, frame.cols, frame.rows);
+    // The peak needs room for a neighbour on each side.
+    if (window.width < m_patch.cols + 2 || window.height < m_patch.rows + 2) {
+        reset(frame, coarse);
+        return coarse;
+    }
+
+    cv::Mat grey;
+    cv::cvtColor(frame(window), grey, cv::COLOR_BGR2GRAY);
+    cv::Mat scores;
+    cv::matchTemplate(grey, m_patch, scores, cv::TM_CCOEFF_NORMED);
+    double best = 0.0;
+    cv::Point peak;
+    cv::minMaxLoc(scores, nullptr, &best, nullptr, &peak);
+    // A weak match is something else (an occluder, a blurred frame); one on
+    // the window's edge may continue past it. NaN (a flat patch) fails too.
+    const bool inside = peak.x > 0 && peak.y > 0 && peak.x + 1 < scores.cols && peak.y + 1 < scores.rows;
+    if (!(best >= kMinScore) || !inside) {
+        reset(frame, coarse);
+        return coarse;
+    }
+
+    const float dx = parabolaPeak(scores.at<float>(peak.y, peak.x - 1), scores.at<float>(peak.y, peak.x),
+                                  scores.at<float>(peak.y, peak.x + 1));
+    const float dy = parabolaPeak(scores.at<float>(peak.y - 1, peak.x), scores.at<float>(peak.y, peak.x),
+                                  scores.at<float>(peak.y + 1, peak.x));
+    const float centerX = float(window.x + peak.x) + dx + m_center.x;
+    const float centerY = float(window.y + peak.y) + dy + m_center.y;
+
+    TrackBox refined = coarse;
+    refined.x = centerX - coarse.width * 0.5f;
+    refined.y = centerY - coarse.height * 0.5f;
+    // Re-taking the patch every frame would let each frame's fraction of a
+    // pixel of error add up; it is renewed only once the object has changed
+    // enough to match noticeably worse.
+    if (best < kRenewScore)
+        reset(frame, refined);
+    return refined;
+}
+
+} // namespace vep
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "tracking/ObjectTrack.h"
+
+#include <opencv2/core.hpp>
+
+namespace vep {
+
+// Pins down at full resolution a box that a tracker found on a reduced
+// frame. The patch the object showed on the previous frame is matched
+// against the new frame in a small window around the coarse box, and the
+// correlation peak is located to a fraction of a pixel. Only that window is
+// converted to grey and searched, and the patch is at most kMaxSide pixels
+// square, so the cost does not grow with the frame or the object.
+//
+// The coarse box bounds the search, so the refinement cannot drift further
+// from it than the radius it is given.
+class TemplateRefiner
+{
+public:
+    static constexpr int kMaxSide = 96;
+
+    // Takes the patch at `box` of `frame` (full-resolution BGR).
+    void reset(const cv::Mat &frame, const TrackBox &box);
+    bool ready() const { return !m_patch.empty(); }
+
+    // `coarse` moved to where the patch matches best within `radius` pixels
+    // of it, keeping its size; `coarse` itself if the match is too weak to
+    // trust or the window leaves the frame. The patch is taken again at the
+    // box returned once the object's appearance has drifted from it.
+    TrackBox refine(const cv::Mat &frame, const TrackBox &coarse, int radius);
+
+private:
+    // Grey, centred on the box it was taken from.
+    cv::Mat m_patch;
+    // Box centre relative to the patch's top-left corner; fractional, as
+    // the patch starts on a whole pixel.
+    cv::Point2f m_center;
+};
+
+} // namespace vep
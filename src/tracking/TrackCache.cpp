@@ -0,0 +1,280 @@
+#include "tracking/TrackCache.h"
+
+#include "core/BinaryIO.h"
+#include "core/MediaCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+// Box coordinates are stored in 1/8 pixel.
+constexpr float kSubpixel = 8.0f;
+
+void putVarint(ByteWriter &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.put(uint8_t(value | 0x80));
+        value >>= 7;
+    }
+    out.put(uint8_t(value));
+}
+
+uint64_t getVarint(ByteReader &in)
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const uint8_t byte = in.get<uint8_t>();
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    throw std::runtime_error("malformed track record");
+}
+
+uint64_t zigzag(int64_t value)
+{
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+void putSamples(ByteWriter &out, const std::vector<TrackSample> &samples)
+{
+    out.put(uint64_t(samples.size()));
+    int64_t frame = samples.empty() ? 0 : samples.front().frame - 1;
+    int64_t previous[4] = {0, 0, 0, 0};
+    out.put(frame);
+    for (const TrackSample &sample : samples) {
+        // Frame step (almost always 1) and the found flag share a varint.
+        putVarint(out, (uint64_t(sample.frame - frame - 1) << 1) | uint64_t(sample.found));
+        frame = sample.frame;
+        const float values[4] = {sample.box.x, sample.box.y, sample.box.width, sample.box.height};
+        for (int i = 0; i < 4; ++i) {
+            const int64_t fixed = std::llround(double(values[i]) * kSubpixel);
+            putVarint(out, zigzag(fixed - previous[i]));
+            previous[i] = fixed;
+        }
+    }
+}
+
+std::vector<TrackSample> getSamples(ByteReader &in)
+{
+    const uint64_t count = in.get<uint64_t>();
+    // Each sample takes at least five bytes.
+    if (count > in.remaining() / 5 + 1)
+        throw std::runtime_error("truncated track record");
+    int64_t frame = in.get<int64_t>();
+    int64_t previous[4] = {0, 0, 0, 0};
+    std::vector<TrackSample> samples(static_cast<size_t>(count));
+    for (TrackSample &sample : samples) {
+        const uint64_t head = getVarint(in);
+        frame += int64_t(head >> 1) + 1;
+        sample.frame = frame;
+        sample.found = head & 1;
+        float values[4];
+        for (int i = 0; i < 4; ++i) {
+            previous[i] += unzigzag(getVarint(in));
+            values[i] = float(previous[i]) / kSubpixel;
+        }
+        sample.box = TrackBox{values[0], values[1], values[2], values[3]};
+    }
+    return samples;
+}
+
+bool byFrame(const TrackSample &a, const TrackSample &b)
+{
+    return a.frame < b.frame;
+}
+
+} // namespace
+
+const ObjectTrack *CachedTracks::find(int id) const
+{
+    auto it = std::find_if(tracks.begin(), tracks.end(), [id](const ObjectTrack &track) { return track.id == id; });
+    return it == tracks.end() ? nullptr : &*it;
+}
+
+void CachedTracks::put(const ObjectTrack &track)
+{
+    auto it = std::find_if(tracks.begin(), tracks.end(),
+                           [&](const ObjectTrack &existing) { return existing.id == track.id; });
+    if (it == tracks.end())
+        tracks.push_back(track);
+    else
+        *it = track;
+}
+
+void CachedTracks::remove(int id)
+{
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(),
+                                [id](const ObjectTrack &track) { return track.id == id; }),
+                 tracks.end());
+}
+
+std::vector<uint8_t> CachedTracks::serialize() const
+{
+    ByteWriter out;
+    out.putMagic("VEPTRAK1");
+    out.put(uint64_t(tracks.size()));
+    for (const ObjectTrack &track : tracks) {
+        out.put(int32_t(track.id));
+        out.putString(track.label);
+        out.put(uint8_t(track.kind));
+        out.put(uint8_t(track.status));
+        out.putString(track.error);
+        out.put(track.fps);
+        putSamples(out, track.anchors);
+        putSamples(out, track.samples);
+    }
+    return out.take();
+}
+
+CachedTracks CachedTracks::deserialize(const std::vector<uint8_t> &bytes)
+{
+    ByteReader in(bytes);
+    in.expectMagic("VEPTRAK1");
+    CachedTracks cached;
+    const uint64_t count = in.get<uint64_t>();
+    for (uint64_t i = 0; i < count; ++i) {
+        ObjectTrack track;
+        track.id = in.get<int32_t>();
+        track.label = in.getString();
+        const uint8_t kind = in.get<uint8_t>();
+        const uint8_t status = in.get<uint8_t>();
+        if (kind > uint8_t(TrackerKind::Mil) || status > uint8_t(TrackStatus::Failed))
+            throw std::runtime_error("malformed track record");
+        track.kind = TrackerKind(kind);
+        track.status = TrackStatus(status);
+        track.error = in.getString();
+        track.fps = in.get<double>();
+        track.anchors = getSamples(in);
+        track.samples = getSamples(in);
+        cached.tracks.push_back(std::move(track));
+    }
+    return cached;
+}
+
+void spliceSamples(std::vector<TrackSample> &samples, const std::vector<TrackSample> &fresh)
+{
+    if (fresh.empty())
+        return;
+    const int64_t from = fresh.front().frame;
+    const int64_t to = fresh.back().frame;
+    std::vector<TrackSample> merged;
+    merged.reserve(samples.size() + fresh.size());
+    for (const TrackSample &sample : samples) {
+        if (sample.frame < from)
+            merged.push_back(sample);
+    }
+    merged.insert(merged.end(), fresh.begin(), fresh.end());
+    for (const TrackSample &sample : samples) {
+        if (sample.frame > to)
+            merged.push_back(sample);
+    }
+    samples = std::move(merged);
+}
+
+std::vector<TrackRequest> correctTrack(ObjectTrack &track, const TrackSample &correction)
+{
+    // What the tracker made of it before, to rejoin; the frame being fixed
+    // must not count as agreement.
+    const std::vector<TrackSample> earlier = track.samples;
+    TrackSample anchor = correction;
+    anchor.found = true;
+    auto at = std::lower_bound(track.anchors.begin(), track.anchors.end(), anchor, byFrame);
+    if (at != track.anchors.end() && at->frame == anchor.frame)
+        *at = anchor;
+    else
+        at = track.anchors.insert(at, anchor);
+    spliceSamples(track.samples, {anchor});
+
+    const int64_t frame = anchor.frame;
+    const bool hasNext = at + 1 != track.anchors.end();
+    const bool hasPrevious = at != track.anchors.begin();
+
+    TrackRequest forward;
+    forward.id = track.id;
+    forward.label = track.label;
+    forward.kind = track.kind;
+    forward.box = anchor.box;
+    forward.startFrame = frame;
+    forward.rejoin = earlier;
+    TrackRequest backward = forward;
+    backward.backward = true;
+
+    // A track that ended early (lost, stopped) may now get further.
+    if (hasNext)
+        forward.endFrame = (at + 1)->frame;
+    else if (track.status == TrackStatus::Completed)
+        forward.endFrame = std::max(track.samples.back().frame + 1, frame + 1);
+    else
+        forward.endFrame = 0;
+    backward.endFrame = hasPrevious ? (at - 1)->frame : track.samples.front().frame - 1;
+
+    std::vector<TrackRequest> requests;
+    if (forward.endFrame <= 0 || forward.endFrame > frame + 1)
+        requests.push_back(std::move(forward));
+    if (backward.endFrame < frame - 1)
+        requests.push_back(std::move(backward));
+    return requests;
+}
+
+void applyRetrack(ObjectTrack &track, const std::vector<ObjectTrack> &results)
+{
+    const int64_t lastFrame = track.samples.empty() ? -1 : track.samples.back().frame;
+    double frames = 0.0;
+    double seconds = 0.0;
+    for (const ObjectTrack &result : results) {
+        if (result.framesPerSecond > 0.0) {
+            frames += double(result.samples.size());
+            seconds += double(result.samples.size()) / result.framesPerSecond;
+        }
+        spliceSamples(track.samples, result.samples);
+        // Re-tracking that ran past the old end decides how the track ends
+        // now; inside the old range it only repairs it.
+        if (!result.samples.empty() && result.samples.back().frame > lastFrame)
+            track.status = result.status == TrackStatus::Lost || result.status == TrackStatus::Stopped
+                               ? result.status
+                               : TrackStatus::Completed;
+        if (result.status == TrackStatus::Failed && track.error.empty())
+            track.error = result.error;
+    }
+    track.framesPerSecond = seconds > 0.0 ? frames / seconds : 0.0;
+    // Anchors are exact by definition, whatever the tracker made of them.
+    for (const TrackSample &anchor : track.anchors) {
+        auto it = std::lower_bound(track.samples.begin(), track.samples.end(), anchor, byFrame);
+        if (it != track.samples.end() && it->frame == anchor.frame)
+            *it = anchor;
+    }
+}
+
+TrackCache::TrackCache(MediaCache &cache)
+    : m_cache(cache)
+{
+}
+
+CachedTracks TrackCache::load(const std::string &mediaPath)
+{
+    const auto bytes = m_cache.read(m_cache.hashOf(mediaPath), CachedTracks::kCacheKind);
+    if (!bytes)
+        return {};
+    try {
+        return CachedTracks::deserialize(*bytes);
+    } catch (const std::runtime_error &) {
+        return {};
+    }
+}
+
+void TrackCache::store(const std::string &mediaPath, const CachedTracks &tracks)
+{
+    m_cache.write(m_cache.hashOf(mediaPath), CachedTracks::kCacheKind, tracks.serialize());
+}
+
+} // namespace vep
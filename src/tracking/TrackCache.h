@@ -0,0 +1,66 @@
+#pragma once
+
+#include "tracking/ObjectTrack.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class MediaCache;
+
+// Every object tracked in one media file, kept in the MediaCache under the
+// file's content hash so tracks survive the session and follow the file
+// into other projects.
+//
+// Samples are stored as a time series of deltas: frame steps and box
+// changes (in 1/8 pixel) as variable-length integers, so a smoothly moving
+// box costs about five bytes a frame instead of thirty-two.
+struct CachedTracks
+{
+    static constexpr const char *kCacheKind = "tracks";
+
+    std::vector<ObjectTrack> tracks;
+
+    const ObjectTrack *find(int id) const;
+    // Replaces the track with the same id, or adds it.
+    void put(const ObjectTrack &track);
+    void remove(int id);
+
+    std::vector<uint8_t> serialize() const;
+    // Throws std::runtime_error on a malformed record.
+    static CachedTracks deserialize(const std::vector<uint8_t> &bytes);
+};
+
+// Replaces the samples of `samples` on the frames `fresh` spans (both
+// sorted by frame), keeping everything outside that span.
+void spliceSamples(std::vector<TrackSample> &samples, const std::vector<TrackSample> &fresh);
+
+// Records a box the user moved by hand as an anchor of `track` and returns
+// what has to be tracked again because of it: forward from the anchor to
+// the next anchor (or the end of the track, or of the file if the track
+// had been lost), and backward to the previous anchor (or the start of the
+// track). Both directions end early where they rejoin the trajectory
+// already tracked, so fixing a drift at frame 500 of 3000 re-tracks only
+// the frames the drift spoiled.
+std::vector<TrackRequest> correctTrack(ObjectTrack &track, const TrackSample &correction);
+
+// Folds the results of correctTrack()'s requests back into the track.
+void applyRetrack(ObjectTrack &track, const std::vector<ObjectTrack> &results);
+
+class TrackCache
+{
+public:
+    explicit TrackCache(MediaCache &cache);
+
+    // Empty if nothing is cached (or the entry is damaged). Throws
+    // std::runtime_error if the media file cannot be hashed.
+    CachedTracks load(const std::string &mediaPath);
+    void store(const std::string &mediaPath, const CachedTracks &tracks);
+
+private:
+    MediaCache &m_cache;
+};
+
+} // namespace vep
@@ -0,0 +1,291 @@
+#include "tracking/TrackKeyframes.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace vep {
+
+namespace {
+
+using Components = std::array<double, 4>;
+
+Components components(const TrackBox &box)
+{
+    return {box.x, box.y, box.width, box.height};
+}
+
+TrackBox lerp(const TrackBox &a, const TrackBox &b, double t)
+{
+    auto mix = [t](float from, float to) { return float(from + (to - from) * t); };
+    return TrackBox{mix(a.x, b.x), mix(a.y, b.y), mix(a.width, b.width), mix(a.height, b.height)};
+}
+
+// The lines a segment may take in one component, as (start value, slope)
+// pairs: a convex polygon, cut down by every sample it has to pass near.
+struct Point
+{
+    double start = 0.0;
+    double slope = 0.0;
+};
+using Polygon = std::vector<Point>;
+
+// Keeps the part of `polygon` where start + slope * offset is at most
+// (`below`) or at least `bound`.
+void clip(Polygon &polygon, double offset, double bound, bool below)
+{
+    auto excess = [&](const Point &p) {
+        const double value = p.start + p.slope * offset - bound;
+        return below ? value : -value;
+    };
+    Polygon kept;
+    kept.reserve(polygon.size() + 1);
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        const Point &p = polygon[i];
+        const Point &q = polygon[(i + 1) % polygon.size()];
+        const double ep = excess(p);
+        const double eq = excess(q);
+        if (ep <= 0.0)
+            kept.push_back(p);
+        if ((ep < 0.0 && eq > 0.0) || (ep > 0.0 && eq < 0.0)) {
+            const double t = ep / (ep - eq);
+            kept.push_back(Point{p.start + (q.start - p.start) * t, p.slope + (q.slope - p.slope) * t});
+        }
+    }
+    polygon = std::move(kept);
+}
+
+// The lowest and highest value the lines in `polygon` reach at `offset`.
+std::pair<double, double> range(const Polygon &polygon, double offset)
+{
+    double low = std::numeric_limits<double>::infinity();
+    double high = -low;
+    for (const Point &p : polygon) {
+        low = std::min(low, p.start + p.slope * offset);
+        high = std::max(high, p.start + p.slope * offset);
+    }
+    return {low, high};
+}
+
+// Running sums for the least-squares line through a segment's samples,
+// offsets counted from its first key.
+struct LineFit
+{
+    double n = 0.0;
+    double sd = 0.0;
+    double sdd = 0.0;
+    double sv = 0.0;
+    double sdv = 0.0;
+
+    void add(double offset, double value)
+    {
+        n += 1.0;
+        sd += offset;
+        sdd += offset * offset;
+        sv += value;
+        sdv += offset * value;
+    }
+
+    // The fitted line's value at `offset`.
+    double end(double offset) const
+    {
+        const double spread = n * sdd - sd * sd;
+        const double slope = spread > 0.0 ? (n * sdv - sd * sv) / spread : 0.0;
+        return (sv - slope * sd) / n + slope * offset;
+    }
+
+    // The slope that fits best among the lines through `value` at `length`.
+    double slopeThrough(double length, double value) const
+    {
+        // With u = offset - length, the line is value + slope * u.
+        const double suu = sdd - 2.0 * length * sd + n * length * length;
+        const double suv = sdv - length * sv - value * (sd - n * length);
+        return suu > 0.0 ? suv / suu : 0.0;
+    }
+};
+
+struct Segment
+{
+    size_t first = 0;
+    size_t last = 0;
+    std::array<Polygon, 4> lines;
+    std::array<LineFit, 4> fits;
+};
+
+// The start value of the best fitting line in `polygon` that reaches
+// `value` at `length`. The polygon always holds one: `value` was picked
+// from its range().
+double startThrough(const Polygon &polygon, const LineFit &fit, double length, double value)
+{
+    // Where the lines through the end point cross the polygon's edges, as
+    // slopes; the chord between the extremes is what may be picked from.
+    double low = std::numeric_limits<double>::infinity();
+    double high = -low;
+    double nearest = std::numeric_limits<double>::infinity();
+    double nearestSlope = 0.0;
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        const Point &p = polygon[i];
+        const Point &q = polygon[(i + 1) % polygon.size()];
+        const double ep = p.start + p.slope * length - value;
+        const double eq = q.start + q.slope * length - value;
+        if (std::fabs(ep) < nearest) {
+            nearest = std::fabs(ep);
+            nearestSlope = p.slope;
+        }
+        if ((ep <= 0.0 && eq >= 0.0) || (ep >= 0.0 && eq <= 0.0)) {
+            const double t = ep == eq ? 0.0 : ep / (ep - eq);
+            const double slope = p.slope + (q.slope - p.slope) * t;
+            low = std::min(low, slope);
+            high = std::max(high, slope);
+        }
+    }
+    // Rounding can leave a point-sized chord just outside; the closest
+    // corner is then as good.
+    const double slope = low <= high ? std::clamp(fit.slopeThrough(length, value), low, high) : nearestSlope;
+    return value - slope * length;
+}
+
+void appendFixed(std::string &out, float value)
+{
+    const long long hundredths = std::llround(double(value) * 100.0);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%s%lld.%02lld", hundredths < 0 ? "-" : "", std::llabs(hundredths) / 100,
+                  std::llabs(hundredths) % 100);
+    out += text;
+}
+
+} // namespace
+
+std::vector<TrackKeyframe> simplifyTrack(const std::vector<TrackSample> &samples, float tolerance)
+{
+    std::vector<TrackKeyframe> keyframes;
+    if (samples.empty())
+        return keyframes;
+    if (samples.size() == 1) {
+        keyframes.push_back(TrackKeyframe{samples.front().frame, samples.front().box});
+        return keyframes;
+    }
+
+    // No feasible segment is steeper than the whole range over one frame.
+    double low = std::numeric_limits<double>::infinity();
+    double high = -low;
+    for (const TrackSample &sample : samples) {
+        for (double value : components(sample.box)) {
+            low = std::min(low, value);
+            high = std::max(high, value);
+        }
+    }
+    const double steepest = high - low + 2.0 * double(tolerance) + 1.0;
+
+    // Forward: each segment from its first key takes samples for as long as
+    // some line still passes within the tolerance of all of them in every
+    // component. Its start is limited to where the previous segment can end.
+    std::vector<Segment> segments;
+    std::array<std::pair<double, double>, 4> starts;
+    for (size_t c = 0; c < 4; ++c) {
+        const double value = components(samples.front().box)[c];
+        starts[c] = {value - tolerance, value + tolerance};
+    }
+    size_t first = 0;
+    while (first + 1 < samples.size()) {
+        Segment segment;
+        segment.first = first;
+        for (size_t c = 0; c < 4; ++c) {
+            segment.lines[c] = Polygon{{starts[c].first, -steepest},
+                                       {starts[c].second, -steepest},
+                                       {starts[c].second, steepest},
+                                       {starts[c].first, steepest}};
+            segment.fits[c].add(0.0, components(samples[first].box)[c]);
+        }
+        size_t last = first + 1;
+        for (; last < samples.size(); ++last) {
+            const double offset = double(samples[last].frame - samples[first].frame);
+            const Components value = components(samples[last].box);
+            std::array<Polygon, 4> lines = segment.lines;
+            bool open = true;
+            for (size_t c = 0; c < 4 && open; ++c) {
+                clip(lines[c], offset, value[c] + tolerance, true);
+                clip(lines[c], offset, value[c] - tolerance, false);
+                open = !lines[c].empty();
+            }
+            if (!open)
+                break;
+            segment.lines = std::move(lines);
+            for (size_t c = 0; c < 4; ++c)
+                segment.fits[c].add(offset, value[c]);
+        }
+        segment.last = last - 1;
+        const double length = double(samples[segment.last].frame - samples[first].frame);
+        for (size_t c = 0; c < 4; ++c)
+            starts[c] = range(segment.lines[c], length);
+        segments.push_back(std::move(segment));
+        first = segments.back().last;
+    }
+
+    // Backward: each key takes the value that fits the samples of the
+    // segment before it best, among those the key after it leaves possible.
+    std::vector<Components> values(segments.size() + 1);
+    for (size_t c = 0; c < 4; ++c) {
+        const Segment &segment = segments.back();
+        const double length = double(samples[segment.last].frame - samples[segment.first].frame);
+        const std::pair<double, double> ends = range(segment.lines[c], length);
+        values.back()[c] = std::clamp(segment.fits[c].end(length), ends.first, ends.second);
+    }
+    for (size_t k = segments.size(); k-- > 0;) {
+        const Segment &segment = segments[k];
+        const double length = double(samples[segment.last].frame - samples[segment.first].frame);
+        for (size_t c = 0; c < 4; ++c)
+            values[k][c] = startThrough(segment.lines[c], segment.fits[c], length, values[k + 1][c]);
+    }
+
+    keyframes.reserve(values.size());
+    for (size_t k = 0; k < values.size(); ++k) {
+        const TrackSample &sample = samples[k < segments.size() ? segments[k].first : segments.back().last];
+        const Components &value = values[k];
+        keyframes.push_back(
+            TrackKeyframe{sample.frame, TrackBox{float(value[0]), float(value[1]), float(value[2]), float(value[3])}});
+    }
+    return keyframes;
+}
+
+TrackBox interpolateKeyframes(const std::vector<TrackKeyframe> &keyframes, double frame)
+{
+    if (keyframes.empty())
+        return {};
+    if (frame <= double(keyframes.front().frame))
+        return keyframes.front().box;
+    if (frame >= double(keyframes.back().frame))
+        return keyframes.back().box;
+    auto next = std::upper_bound(keyframes.begin(), keyframes.end(), frame,
+                                 [](double f, const TrackKeyframe &key) { return f < double(key.frame); });
+    const TrackKeyframe &previous = *(next - 1);
+    const double t = (frame - double(previous.frame)) / double(next->frame - previous.frame);
+    return lerp(previous.box, next->box, t);
+}
+
+std::string toMltAnimation(const std::vector<TrackKeyframe> &keyframes, int64_t firstFrame)
+{
+    std::string out;
+    for (const TrackKeyframe &key : keyframes) {
+        if (!out.empty())
+            out += ';';
+        out += std::to_string(key.frame - firstFrame);
+        out += '=';
+        appendFixed(out, key.box.x);
+        out += ' ';
+        appendFixed(out, key.box.y);
+        out += ' ';
+        appendFixed(out, key.box.width);
+        out += ' ';
+        appendFixed(out, key.box.height);
+        out += " 1";
+    }
+    return out;
+}
+
+} // namespace vep
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "tracking/ObjectTrack.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+struct TrackKeyframe
+{
+    int64_t frame = 0;
+    TrackBox box;
+};
+
+// Few keyframes, placed greedily, whose linear interpolation passes within
+// `tolerance` pixels of every sample in each of x, y, width and height. Keys
+// sit on sample frames, but their values are fitted: each is the least-
+// squares best for the samples of the segment before it, within what keeps
+// every segment inside the tolerance, so tracker jitter smaller than the
+// tolerance does not pin keys to noisy samples. The first and last sample
+// frames are always keys. An element attached to a track this way animates
+// as it would with a key on every frame: a steady pan needs two keys where
+// the samples have hundreds, and a hold needs none in between.
+//
+// Linear rather than MLT's smooth keys: those are a Catmull-Rom spline
+// that ignores how far apart the keys are, so the unevenly spaced keys a
+// fit produces bend the motion between them, and holding the tolerance
+// took two to four times as many keys as straight segments.
+//
+// Samples must be sorted by frame. Lost frames (found = false) are kept
+// as the tracker reported them, holding the last box. Each sample cuts
+// down a small polygon of the lines its segment may still take, so the
+// cost is the samples times the corners of that polygon: a few on real
+// tracks, more on a long, gently curving segment.
+std::vector<TrackKeyframe> simplifyTrack(const std::vector<TrackSample> &samples, float tolerance = 0.5f);
+
+// The box the keyframes give on `frame`, as MLT interpolates them: linear
+// between keys, held before the first and after the last.
+TrackBox interpolateKeyframes(const std::vector<TrackKeyframe> &keyframes, double frame);
+
+// An MLT rect animation ("12=x y w h 1;...") for the keyframes, fully
+// opaque, at frame - firstFrame so that it starts where the element it
+// animates does. Values have two decimals whatever the locale.
+std::string toMltAnimation(const std::vector<TrackKeyframe> &keyframes, int64_t firstFrame = 0);
+
+} // namespace vep
@@ -0,0 +1,295 @@
+#include "tracking/TrackingJob.h"
+
+#include "core/MediaCache.h"
+#include "tracking/MultiObjectTracker.h"
+#include "tracking/TrackCache.h"
+#include "tracking/TrackKeyframes.h"
+
+#include <QFutureWatcher>
+#include <QMetaObject>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+// Two jobs finishing on the same file must not drop each other's tracks
+// between load and store.
+std::mutex g_cacheMutex;
+
+QVariantList toVariant(const std::vector<TrackSample> &samples)
+{
+    QVariantList list;
+    list.reserve(int(samples.size()));
+    for (const TrackSample &sample : samples) {
+        list.append(QVariantMap{{"frame", qint64(sample.frame)},
+                                {"x", sample.box.x},
+                                {"y", sample.box.y},
+                                {"width", sample.box.width},
+                                {"height", sample.box.height},
+                                {"found", sample.found}});
+    }
+    return list;
+}
+
+// What the cache holds for the file; nothing if the file cannot be read.
+CachedTracks loadCached(const std::string &media)
+{
+    try {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        return TrackCache(MediaCache::instance()).load(media);
+    } catch (const std::runtime_error &) {
+        return {};
+    }
+}
+
+bool completedAll(const std::vector<ObjectTrack> &tracks)
+{
+    return std::none_of(tracks.begin(), tracks.end(), [](const ObjectTrack &track) {
+        return track.status == TrackStatus::Stopped || track.status == TrackStatus::Failed;
+    });
+}
+
+} // namespace
+
+TrackingJob::TrackingJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+TrackingJob::~TrackingJob()
+{
+    cancel();
+    m_future.waitForFinished();
+}
+
+QVariantMap TrackingJob::toVariant(const ObjectTrack &track)
+{
+    return QVariantMap{{"id", track.id},
+                       {"label", QString::fromStdString(track.label)},
+                       {"tracker", QString::fromLatin1(trackerKindName(track.kind))},
+                       {"status", QString::fromLatin1(trackStatusName(track.status))},
+                       {"error", QString::fromStdString(track.error)},
+                       {"fps", track.fps},
+                       {"framesPerSecond", track.framesPerSecond},
+                       {"samples", vep::toVariant(track.samples)},
+                       {"anchors", vep::toVariant(track.anchors)}};
+}
+
+void TrackingJob::loadCachedTracks(const QString &mediaPath)
+{
+    // The watcher is the job's child, so a job destroyed mid-lookup is never
+    // called back; the lookup itself touches nothing of the job.
+    using Watcher = QFutureWatcher<QVariantList>;
+    auto *watcher = new Watcher(this);
+    connect(watcher, &Watcher::finished, this, [this, watcher, mediaPath] {
+        emit cachedTracksLoaded(mediaPath, watcher->result());
+        watcher->deleteLater();
+    });
+    const std::string media = mediaPath.toStdString();
+    watcher->setFuture(QtConcurrent::run([media] {
+        QVariantList list;
+        for (const ObjectTrack &track : loadCached(media).tracks)
+            list.append(toVariant(track));
+        return list;
+    }));
+}
+
+void TrackingJob::loadKeyframes(const QString &mediaPath, int objectId, double tolerance, qint64 firstFrame)
+{
+    using Watcher = QFutureWatcher<QVariantMap>;
+    auto *watcher = new Watcher(this);
+    connect(watcher, &Watcher::finished, this, [this, watcher, mediaPath, objectId] {
+        emit keyframesLoaded(mediaPath, objectId, watcher->result());
+        watcher->deleteLater();
+    });
+    const std::string media = mediaPath.toStdString();
+    watcher->setFuture(QtConcurrent::run([media, objectId, tolerance, firstFrame] {
+        const CachedTracks cached = loadCached(media);
+        const ObjectTrack *track = cached.find(objectId);
+        if (!track)
+            return QVariantMap();
+
+        const std::vector<TrackKeyframe> keys = simplifyTrack(track->samples, float(tolerance));
+        QVariantList list;
+        list.reserve(int(keys.size()));
+        for (const TrackKeyframe &key : keys) {
+            list.append(QVariantMap{{"frame", qint64(key.frame)},
+                                    {"x", key.box.x},
+                                    {"y", key.box.y},
+                                    {"width", key.box.width},
+                                    {"height", key.box.height}});
+        }
+        return QVariantMap{{"keyframes", list},
+                           {"animation", QString::fromStdString(toMltAnimation(keys, firstFrame))}};
+    }));
+}
+
+void TrackingJob::start(const QString &mediaPath, const QVariantList &objects)
+{
+    if (m_running)
+        return;
+
+    m_tracker = std::make_unique<MultiObjectTracker>(m_concurrency);
+    m_objectProgress.clear();
+    for (const QVariant &value : objects) {
+        const QVariantMap map = value.toMap();
+        TrackRequest request;
+        request.id = map.value("id").toInt();
+        request.label = map.value("label").toString().toStdString();
+        request.box = TrackBox{map.value("x").toFloat(), map.value("y").toFloat(), map.value("width").toFloat(),
+                               map.value("height").toFloat()};
+        request.startFrame = map.value("startFrame").toLongLong();
+        request.endFrame = map.value("endFrame").toLongLong();
+        request.kind = trackerKindFromName(map.value("tracker").toString().toStdString());
+        m_tracker->addObject(request);
+        m_objectProgress.insert(request.id, 0.0);
+    }
+    m_progress = 0.0;
+    emit progressChanged();
+    setRunning(true);
+
+    m_tracker->setProgressCallback([this](int id, double fraction, double framesPerSecond) {
+        QMetaObject::invokeMethod(this, [this, id, fraction, framesPerSecond] {
+            setObjectProgress(id, fraction, framesPerSecond);
+        });
+    });
+    m_tracker->setFinishedCallback([this](const ObjectTrack &track) {
+        const QVariantMap variant = toVariant(track);
+        const int id = track.id;
+        QMetaObject::invokeMethod(this, [this, id, variant] {
+            setObjectProgress(id, 1.0, variant.value("framesPerSecond").toDouble());
+            emit objectFinished(id, variant);
+        });
+    });
+
+    MultiObjectTracker *tracker = m_tracker.get();
+    const std::string media = mediaPath.toStdString();
+    launch([tracker, media] {
+        const std::vector<ObjectTrack> tracks = tracker->run(media);
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        TrackCache cache(MediaCache::instance());
+        CachedTracks cached = cache.load(media);
+        for (const ObjectTrack &track : tracks)
+            cached.put(track);
+        cache.store(media, cached);
+        return completedAll(tracks);
+    });
+}
+
+void TrackingJob::correct(const QString &mediaPath, int objectId, qint64 frame, double x, double y, double width,
+                          double height)
+{
+    if (m_running)
+        return;
+
+    // The two directions share the object's id, so their progress cannot be
+    // told apart; only the corrected track as a whole is reported.
+    m_tracker = std::make_unique<MultiObjectTracker>(m_concurrency);
+    m_objectProgress.clear();
+    m_objectProgress.insert(objectId, 0.0);
+    m_progress = 0.0;
+    emit progressChanged();
+    setRunning(true);
+
+    TrackSample correction;
+    correction.frame = frame;
+    correction.box = TrackBox{float(x), float(y), float(width), float(height)};
+
+    MultiObjectTracker *tracker = m_tracker.get();
+    const std::string media = mediaPath.toStdString();
+    launch([this, tracker, media, objectId, correction] {
+        ObjectTrack track;
+        {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+            const ObjectTrack *cached = TrackCache(MediaCache::instance()).load(media).find(objectId);
+            if (!cached)
+                throw std::runtime_error("no tracking result cached for object " + std::to_string(objectId));
+            track = *cached;
+        }
+        for (const TrackRequest &request : correctTrack(track, correction))
+            tracker->addObject(request);
+        const std::vector<ObjectTrack> results = tracker->run(media);
+        applyRetrack(track, results);
+        {
+            std::lock_guard<std::mutex> lock(g_cacheMutex);
+            TrackCache cache(MediaCache::instance());
+            CachedTracks cached = cache.load(media);
+            cached.put(track);
+            cache.store(media, cached);
+        }
+        const QVariantMap variant = toVariant(track);
+        QMetaObject::invokeMethod(this, [this, objectId, variant] {
+            setObjectProgress(objectId, 1.0, variant.value("framesPerSecond").toDouble());
+            emit objectFinished(objectId, variant);
+        });
+        return completedAll(results);
+    });
+}
+
+void TrackingJob::launch(std::function<bool()> work)
+{
+    m_future = QtConcurrent::run([this, work = std::move(work)] {
+        bool completed = false;
+        QString error;
+        try {
+            completed = work();
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        QMetaObject::invokeMethod(this, [this, completed, error] {
+            setRunning(false);
+            emit finished(completed, error);
+        });
+    });
+}
+
+void TrackingJob::stop(int objectId)
+{
+    if (m_tracker)
+        m_tracker->stop(objectId);
+}
+
+void TrackingJob::cancel()
+{
+    if (m_tracker)
+        m_tracker->stopAll();
+}
+
+void TrackingJob::setConcurrency(int concurrency)
+{
+    concurrency = std::max(0, concurrency);
+    if (m_concurrency == concurrency)
+        return;
+    m_concurrency = concurrency;
+    emit concurrencyChanged();
+}
+
+void TrackingJob::setRunning(bool running)
+{
+    if (m_running == running)
+        return;
+    m_running = running;
+    emit runningChanged();
+}
+
+void TrackingJob::setObjectProgress(int objectId, double fraction, double framesPerSecond)
+{
+    auto it = m_objectProgress.find(objectId);
+    if (it == m_objectProgress.end() || it.value() == fraction)
+        return;
+    it.value() = fraction;
+    emit objectProgress(objectId, fraction, framesPerSecond);
+
+    double total = 0.0;
+    for (double value : m_objectProgress)
+        total += value;
+    m_progress = m_objectProgress.isEmpty() ? 0.0 : total / m_objectProgress.size();
+    emit progressChanged();
+}
+
+} // namespace vep
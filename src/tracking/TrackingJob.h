@@ -0,0 +1,94 @@
+#pragma once
+
+#include "tracking/ObjectTrack.h"
+
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include <functional>
+#include <memory>
+
+namespace vep {
+
+class MultiObjectTracker;
+
+// Runs a MultiObjectTracker off the UI thread. Objects are maps with id,
+// label, x, y, width, height (source pixels), startFrame, endFrame and
+// tracker ("csrt", "kcf" or "mil"); each reports its own progress and
+// result, and can be stopped on its own while the rest carry on.
+//
+// A finished track is a map with id, label, status, error, fps,
+// framesPerSecond (tracking speed), samples and anchors, each sample a map
+// with frame, x, y, width, height and found.
+//
+// Finished tracks are cached per media file (see TrackCache). correct()
+// moves the box of a cached track on one frame and re-tracks only around
+// it; the whole corrected track is then reported through objectFinished().
+class TrackingJob : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(int concurrency READ concurrency WRITE setConcurrency NOTIFY concurrencyChanged)
+
+public:
+    explicit TrackingJob(QObject *parent = nullptr);
+    ~TrackingJob() override;
+
+    bool isRunning() const { return m_running; }
+    // Mean over the objects of the current run.
+    double progress() const { return m_progress; }
+    int concurrency() const { return m_concurrency; }
+    void setConcurrency(int concurrency);
+
+    static QVariantMap toVariant(const ObjectTrack &track);
+
+    // Reads every track cached for the file off the UI thread and reports
+    // them through cachedTracksLoaded() as toVariant() maps; empty if none
+    // or the file cannot be read.
+    Q_INVOKABLE void loadCachedTracks(const QString &mediaPath);
+    // Reduces a cached track to the few keyframes that reproduce it within
+    // `tolerance` pixels (see simplifyTrack()), for attaching text or
+    // stickers, and reports it through keyframesLoaded(): a map with
+    // keyframes (maps with frame, x, y, width, height) and animation, an
+    // MLT rect animation string counted from firstFrame. Empty if the track
+    // is not cached.
+    Q_INVOKABLE void loadKeyframes(const QString &mediaPath, int objectId, double tolerance = 0.5,
+                                   qint64 firstFrame = 0);
+
+public slots:
+    void start(const QString &mediaPath, const QVariantList &objects);
+    void correct(const QString &mediaPath, int objectId, qint64 frame, double x, double y, double width,
+                 double height);
+    void stop(int objectId);
+    void cancel();
+
+signals:
+    void objectProgress(int objectId, double fraction, double framesPerSecond);
+    void objectFinished(int objectId, const QVariantMap &track);
+    void cachedTracksLoaded(const QString &mediaPath, const QVariantList &tracks);
+    void keyframesLoaded(const QString &mediaPath, int objectId, const QVariantMap &keyframes);
+    void runningChanged();
+    void progressChanged();
+    void concurrencyChanged();
+    void finished(bool completed, const QString &error);
+
+private:
+    void launch(std::function<bool()> work);
+    void setRunning(bool running);
+    void setObjectProgress(int objectId, double fraction, double framesPerSecond);
+
+    // Replaced only between runs, on the UI thread.
+    std::unique_ptr<MultiObjectTracker> m_tracker;
+    QFuture<void> m_future;
+    QHash<int, double> m_objectProgress;
+    bool m_running = false;
+    double m_progress = 0.0;
+    int m_concurrency = 0;
+};
+
+} // namespace vep
@@ -0,0 +1,20 @@
+#include "ui/QmlTypes.h"
+
+#include "captions/TranscriptModel.h"
+#include "timeline/SnapModel.h"
+#include "ui/WaveformItem.h"
+
+#include <QtQml>
+
+namespace vep {
+
+void registerQmlTypes()
+{
+    qmlRegisterType<WaveformItem>("VideoEditorPro", 1, 0, "WaveformItem");
+    qmlRegisterUncreatableType<SnapModel>("VideoEditorPro", 1, 0, "SnapModel",
+                                          "SnapModel is owned by the timeline model");
+    qmlRegisterUncreatableType<TranscriptModel>("VideoEditorPro", 1, 0, "TranscriptModel",
+                                                "TranscriptModel is owned by the project");
+}
+
+} // namespace vep
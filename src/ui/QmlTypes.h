@@ -0,0 +1,9 @@
+#pragma once
+
+namespace vep {
+
+// Registers the native QML types under "VideoEditorPro 1.0". Call once,
+// before the QML engine loads the main window.
+void registerQmlTypes();
+
+} // namespace vep
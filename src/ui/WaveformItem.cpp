@@ -0,0 +1,144 @@
+#include "ui/WaveformItem.h"
+
+#include "audio/PeakFile.h"
+#include "core/MediaCache.h"
+#include "media/PeakAnalysisStage.h"
+
+#include <QFutureWatcher>
+#include <QPainter>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace vep {
+
+WaveformItem::WaveformItem(QQuickItem *parent)
+    : QQuickPaintedItem(parent)
+{
+    setAntialiasing(false);
+}
+
+WaveformItem::~WaveformItem() = default;
+
+void WaveformItem::setSource(const QString &source)
+{
+    if (m_source == source)
+        return;
+    m_source = source;
+    emit sourceChanged();
+    // Another clip's waveform must not linger while the new one is found.
+    setPeaks(nullptr);
+    reload();
+}
+
+void WaveformItem::setInPoint(double seconds)
+{
+    if (m_inPoint == seconds)
+        return;
+    m_inPoint = seconds;
+    emit inPointChanged();
+    update();
+}
+
+void WaveformItem::setOutPoint(double seconds)
+{
+    if (m_outPoint == seconds)
+        return;
+    m_outPoint = seconds;
+    emit outPointChanged();
+    update();
+}
+
+void WaveformItem::setColor(const QColor &color)
+{
+    if (m_color == color)
+        return;
+    m_color = color;
+    emit colorChanged();
+    update();
+}
+
+void WaveformItem::setRmsColor(const QColor &color)
+{
+    if (m_rmsColor == color)
+        return;
+    m_rmsColor = color;
+    emit rmsColorChanged();
+    update();
+}
+
+void WaveformItem::reload()
+{
+    const quint64 lookup = ++m_lookup;
+    if (m_source.isEmpty()) {
+        setPeaks(nullptr);
+        return;
+    }
+
+    // The watcher is the item's child, so an item destroyed mid-lookup is
+    // never called back; the lookup itself touches nothing of the item.
+    using Watcher = QFutureWatcher<std::shared_ptr<const PeakFile>>;
+    auto *watcher = new Watcher(this);
+    connect(watcher, &Watcher::finished, this, [this, watcher, lookup] {
+        if (lookup == m_lookup)
+            setPeaks(watcher->result());
+        watcher->deleteLater();
+    });
+    const std::string source = m_source.toStdString();
+    watcher->setFuture(QtConcurrent::run([source]() -> std::shared_ptr<const PeakFile> {
+        try {
+            return PeakAnalysisStage::cached(MediaCache::instance(), source);
+        } catch (const std::runtime_error &) {
+            // Missing media: draw nothing.
+            return nullptr;
+        }
+    }));
+}
+
+void WaveformItem::setPeaks(std::shared_ptr<const PeakFile> peaks)
+{
+    const bool wasAvailable = isAvailable();
+    m_peaks = std::move(peaks);
+    if (wasAvailable != isAvailable())
+        emit availableChanged();
+    update();
+}
+
+void WaveformItem::paint(QPainter *painter)
+{
+    const int columns = int(std::ceil(width()));
+    if (!m_peaks || columns <= 0 || m_outPoint <= m_inPoint)
+        return;
+
+    const int channels = m_peaks->channels();
+    const double rate = m_peaks->sampleRate();
+    const double framesPerPixel = (m_outPoint - m_inPoint) * rate / width();
+    const int level = m_peaks->levelFor(framesPerPixel);
+    const double laneHeight = height() / channels;
+    const double scale = laneHeight / 2.0 / 32767.0;
+
+    QVector<QLineF> peaks;
+    QVector<QLineF> rms;
+    peaks.reserve(columns);
+    rms.reserve(columns);
+    for (int c = 0; c < channels; ++c) {
+        const double centre = laneHeight * (c + 0.5);
+        peaks.clear();
+        rms.clear();
+        for (int x = 0; x < columns; ++x) {
+            const double from = m_inPoint * rate + x * framesPerPixel;
+            const PeakBin bin = m_peaks->summarize(level, c, from, from + framesPerPixel);
+            const double px = x + 0.5;
+            peaks.append(QLineF(px, centre - bin.max * scale, px, centre - bin.min * scale));
+            rms.append(QLineF(px, centre - bin.rms * scale, px, centre + bin.rms * scale));
+        }
+        painter->setPen(m_color);
+        painter->drawLines(peaks);
+        painter->setPen(m_rmsColor);
+        painter->drawLines(rms);
+    }
+}
+
+} // namespace vep
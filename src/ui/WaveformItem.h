@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QColor>
+#include <QQuickPaintedItem>
+#include <QString>
+
+#include <memory>
+
+namespace vep {
+
+class PeakFile;
+
+// Draws a clip's waveform from its memory-mapped peak file. Each repaint
+// picks the pyramid level with about one bin per pixel, so cost depends on
+// the item's width and not on the clip's length or the zoom. The item is
+// meant to cover only the visible part of a clip (see WaveformView.qml):
+// inPoint/outPoint are the media times at its left and right edges.
+class WaveformItem : public QQuickPaintedItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QString source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(double inPoint READ inPoint WRITE setInPoint NOTIFY inPointChanged)
+    Q_PROPERTY(double outPoint READ outPoint WRITE setOutPoint NOTIFY outPointChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(QColor rmsColor READ rmsColor WRITE setRmsColor NOTIFY rmsColorChanged)
+    Q_PROPERTY(bool available READ isAvailable NOTIFY availableChanged)
+
+public:
+    explicit WaveformItem(QQuickItem *parent = nullptr);
+    ~WaveformItem() override;
+
+    QString source() const { return m_source; }
+    void setSource(const QString &source);
+    double inPoint() const { return m_inPoint; }
+    void setInPoint(double seconds);
+    double outPoint() const { return m_outPoint; }
+    void setOutPoint(double seconds);
+    QColor color() const { return m_color; }
+    void setColor(const QColor &color);
+    QColor rmsColor() const { return m_rmsColor; }
+    void setRmsColor(const QColor &color);
+    // False until the media's import has produced its peak file.
+    bool isAvailable() const { return bool(m_peaks); }
+
+    // Looks the peak file up again, e.g. when an import finishes. The
+    // lookup hashes the media if nothing has yet, so it runs on a worker
+    // thread and the item repaints when it is done.
+    Q_INVOKABLE void reload();
+
+    void paint(QPainter *painter) override;
+
+signals:
+    void sourceChanged();
+    void inPointChanged();
+    void outPointChanged();
+    void colorChanged();
+    void rmsColorChanged();
+    void availableChanged();
+
+private:
+    void setPeaks(std::shared_ptr<const PeakFile> peaks);
+
+    QString m_source;
+    double m_inPoint = 0.0;
+    double m_outPoint = 0.0;
+    QColor m_color = QColor(0x4f, 0xc3, 0xf7);
+    QColor m_rmsColor = QColor(0x81, 0xd4, 0xfa);
+    std::shared_ptr<const PeakFile> m_peaks;
+    // Tells the latest lookup from ones it superseded.
+    quint64 m_lookup = 0;
+};
+
+} // namespace vep
@@ -0,0 +1,143 @@
+#include "workers/PythonFrameMasker.h"
+
+#include "workers/PythonWorkerPool.h"
+
+#include <QJsonArray>
+
+#include <chrono>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+// How often a blocked acquire() looks for jobs that failed without
+// returning their slot (the worker died and retries ran out).
+constexpr auto kReapInterval = std::chrono::milliseconds(200);
+
+} // namespace
+
+PythonFrameMasker::PythonFrameMasker(PythonWorkerPool &pool, int slots, int maxWidth, int maxHeight,
+                                     std::string model)
+    : m_pool(pool)
+    , m_ring(slots, maxWidth, maxHeight, 4)
+    , m_model(std::move(model))
+{
+}
+
+PythonFrameMasker::~PythonFrameMasker()
+{
+    // The workers must be done with the ring before it is unmapped.
+    cancel();
+    reap(true);
+}
+
+std::optional<SharedFrameRing::Slot> PythonFrameMasker::acquire()
+{
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            std::optional<SharedFrameRing::Slot> slot;
+            const bool woken = m_slotFree.wait_for(lock, kReapInterval,
+                                                   [&] { return m_cancelled || (slot = m_ring.acquire()); });
+            if (m_cancelled) {
+                if (slot)
+                    m_ring.release(slot->index);
+                return std::nullopt;
+            }
+            if (woken)
+                return slot;
+        }
+        reap(false);
+    }
+}
+
+void PythonFrameMasker::queue(const SharedFrameRing::Slot &slot, int width, int height, int64_t frame)
+{
+    m_ring.queue(slot.index, width, height, frame);
+    // The frame number lets a retried worker tell its slot from one that
+    // was handed back and reused meanwhile.
+    QJsonObject args{{"ring", QString::fromStdString(m_ring.name())},
+                     {"slots", QJsonArray{slot.index}},
+                     {"frames", QJsonArray{double(frame)}},
+                     {"model", QString::fromStdString(m_model)}};
+    auto returned = std::make_shared<std::atomic<bool>>(false);
+    const int index = slot.index;
+    auto onEvent = [this, returned, index](const QJsonObject &message) {
+        if (message.value("event").toString() == "slot" && message.value("slot").toInt() == index
+            && !returned->exchange(true))
+            slotReturned(index, message.value("ok").toBool());
+    };
+    std::future<QJsonObject> result = m_pool.submit("remove_background_frames", std::move(args), {}, &m_cancelled,
+                                                    onEvent);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back({slot.index, std::move(returned), std::move(result)});
+}
+
+void PythonFrameMasker::slotReturned(int index, bool ok)
+{
+    if (m_maskReady) {
+        const SharedFrameRing::Slot slot = m_ring.slot(index);
+        const bool done = ok && m_ring.state(index) == SharedFrameRing::SlotState::Done;
+        m_maskReady(m_ring.frame(index), done ? slot.mask : nullptr, slot.maskStride, m_ring.width(index),
+                    m_ring.height(index));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ring.release(index);
+    }
+    m_slotFree.notify_all();
+}
+
+void PythonFrameMasker::reap(bool wait)
+{
+    std::vector<Job> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+            if (wait || it->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                finished.push_back(std::move(*it));
+                it = m_jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (Job &job : finished) {
+        try {
+            job.result.get();
+        } catch (const std::runtime_error &e) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_error.empty())
+                    m_error = e.what();
+            }
+            // The worker died before it could hand it back.
+            if (!job.returned->exchange(true))
+                slotReturned(job.slot, false);
+        }
+    }
+}
+
+void PythonFrameMasker::finish()
+{
+    reap(true);
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        error.swap(m_error);
+    }
+    if (!error.empty())
+        throw std::runtime_error(error);
+}
+
+void PythonFrameMasker::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+    }
+    m_slotFree.notify_all();
+}
+
+} // namespace vep
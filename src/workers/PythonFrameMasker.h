@@ -0,0 +1,82 @@
+#pragma once
+
+#include "workers/SharedFrameRing.h"
+
+#include <QJsonObject>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vep {
+
+class PythonWorkerPool;
+
+// Background-removal masks from the Python workers through a
+// SharedFrameRing. The caller decodes each frame straight into a slot it
+// acquired and queues it; the mask comes back in the same slot and is
+// handed to the callback before the slot is reused. Frames are spread over
+// all workers, so masks may arrive out of order (each carries its frame
+// number).
+//
+// Nothing drives it yet: vep_bgremove runs the ONNX model in process, and
+// an offline "mask with rembg" job would be the first caller.
+class PythonFrameMasker
+{
+public:
+    // Called on a pool thread. mask is null if the frame failed.
+    using MaskReady = std::function<void(int64_t frame, const uint8_t *mask, int maskStride, int width,
+                                         int height)>;
+
+    PythonFrameMasker(PythonWorkerPool &pool, int slots, int maxWidth, int maxHeight,
+                      std::string model = "u2net");
+    ~PythonFrameMasker();
+
+    void setMaskCallback(MaskReady callback) { m_maskReady = std::move(callback); }
+
+    // A slot to decode into (RGBA, `stride` bytes per row). Blocks while
+    // the workers hold every slot; nothing once cancel() was called.
+    std::optional<SharedFrameRing::Slot> acquire();
+    void queue(const SharedFrameRing::Slot &slot, int width, int height, int64_t frame);
+
+    // Waits for every queued frame. Throws std::runtime_error with the first
+    // worker error, if any (the failed frames got a null mask).
+    void finish();
+    void cancel();
+
+private:
+    struct Job
+    {
+        int slot;
+        // Set by whichever of the worker's "slot" event and reap() hands
+        // the slot back first; the other leaves it alone, since by then it
+        // may hold the next frame. A retried job can answer twice.
+        std::shared_ptr<std::atomic<bool>> returned;
+        std::future<QJsonObject> result;
+    };
+
+    void slotReturned(int index, bool ok);
+    // Collects finished jobs (all of them if `wait`), returning the slots
+    // of failed ones that the worker never handed back.
+    void reap(bool wait);
+
+    PythonWorkerPool &m_pool;
+    SharedFrameRing m_ring;
+    std::string m_model;
+    MaskReady m_maskReady;
+    std::atomic<bool> m_cancelled{false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_slotFree;
+    std::vector<Job> m_jobs;
+    std::string m_error;
+};
+
+} // namespace vep
@@ -0,0 +1,460 @@
+#include "workers/PythonWorkerPool.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QStringList>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace vep {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kPollMs = 100;
+constexpr double kMaxBackoffSeconds = 30.0;
+
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int64_t messageId(const QJsonObject &message)
+{
+    return int64_t(message.value("id").toDouble(-1.0));
+}
+
+enum class ReadStatus { Message, Timeout, Died };
+
+struct ReadResult
+{
+    ReadStatus status;
+    QJsonObject message;
+};
+
+// Next JSON object line from the worker. Lines that are not JSON objects
+// (a library printing to stdout before the worker redirected it) are skipped.
+ReadResult readMessage(QProcess &process, double timeoutSeconds)
+{
+    const auto start = Clock::now();
+    for (;;) {
+        while (process.canReadLine()) {
+            const QJsonDocument document = QJsonDocument::fromJson(process.readLine());
+            if (document.isObject())
+                return {ReadStatus::Message, document.object()};
+        }
+        if (process.state() != QProcess::Running)
+            return {ReadStatus::Died, {}};
+        const double remaining = timeoutSeconds - secondsSince(start);
+        if (remaining <= 0.0)
+            return {ReadStatus::Timeout, {}};
+        process.waitForReadyRead(std::min(kPollMs, int(remaining * 1000.0) + 1));
+    }
+}
+
+bool send(QProcess &process, const QJsonObject &message)
+{
+    if (process.state() != QProcess::Running)
+        return false;
+    process.write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+    return process.waitForBytesWritten(1000);
+}
+
+void stop(QProcess &process)
+{
+    if (process.state() == QProcess::NotRunning)
+        return;
+    send(process, QJsonObject{{"op", "quit"}});
+    process.closeWriteChannel();
+    if (!process.waitForFinished(2000)) {
+        process.kill();
+        process.waitForFinished(2000);
+    }
+}
+
+std::exception_ptr failure(const std::string &message)
+{
+    return std::make_exception_ptr(std::runtime_error(message));
+}
+
+} // namespace
+
+struct PythonWorkerPool::Job
+{
+    int64_t id = 0;
+    std::string op;
+    QJsonObject args;
+    Progress progress;
+    Event event;
+    const std::atomic<bool> *cancel = nullptr;
+    std::promise<QJsonObject> promise;
+    int attempts = 0;
+
+    bool cancelled() const { return cancel && cancel->load(); }
+};
+
+// One worker process and the thread that owns it. QProcess is used only
+// through its blocking waitFor* calls, so the thread needs no event loop.
+class PythonWorkerPool::Worker
+{
+public:
+    explicit Worker(PythonWorkerPool &pool)
+        : m_pool(pool)
+        , m_thread([this] { run(); })
+    {
+    }
+
+    ~Worker() { m_thread.join(); }
+
+    // Guarded by the pool's mutex.
+    PythonWorkerStatus status;
+
+private:
+    void run();
+    bool start(QProcess &process, std::string &error);
+    bool ping(QProcess &process);
+    void execute(QProcess &process, const std::shared_ptr<Job> &job);
+    void setStatus(const std::function<void(PythonWorkerStatus &)> &change);
+
+    PythonWorkerPool &m_pool;
+    std::thread m_thread; // last: starts running once the rest is built
+};
+
+void PythonWorkerPool::Worker::setStatus(const std::function<void(PythonWorkerStatus &)> &change)
+{
+    std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+    change(status);
+}
+
+void PythonWorkerPool::Worker::run()
+{
+    const PythonWorkerSettings &settings = m_pool.m_settings;
+    QProcess process;
+    int failures = 0;
+    bool started = false;
+    for (;;) {
+        if (process.state() != QProcess::Running) {
+            {
+                std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+                if (m_pool.m_stopping)
+                    break;
+            }
+            if (started)
+                setStatus([](PythonWorkerStatus &s) { ++s.restarts; });
+            setStatus([](PythonWorkerStatus &s) { s.ready = false; s.pid = 0; });
+            std::string error;
+            if (!start(process, error)) {
+                stop(process);
+                if (++failures >= std::max(1, settings.startAttempts)) {
+                    m_pool.giveUp(*this, error);
+                    break;
+                }
+                // Do not spin on a broken interpreter or a missing rembg.
+                const double backoff = std::min(kMaxBackoffSeconds, double(1 << std::min(failures - 1, 5)));
+                std::unique_lock<std::mutex> lock(m_pool.m_mutex);
+                if (m_pool.m_wake.wait_for(lock, std::chrono::duration<double>(backoff),
+                                           [this] { return m_pool.m_stopping; }))
+                    break;
+                continue;
+            }
+            started = true;
+            failures = 0;
+            setStatus([&](PythonWorkerStatus &s) { s.ready = true; s.pid = int64_t(process.processId()); });
+        }
+
+        std::shared_ptr<Job> job = m_pool.takeJob(settings.healthIntervalSeconds);
+        if (!job) {
+            {
+                std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+                if (m_pool.m_stopping)
+                    break;
+            }
+            if (!ping(process)) {
+                process.kill();
+                process.waitForFinished(2000);
+            }
+            continue;
+        }
+        setStatus([](PythonWorkerStatus &s) { s.busy = true; });
+        execute(process, job);
+        setStatus([](PythonWorkerStatus &s) { s.busy = false; ++s.jobsDone; });
+    }
+    stop(process);
+}
+
+bool PythonWorkerPool::Worker::start(QProcess &process, std::string &error)
+{
+    const PythonWorkerSettings &settings = m_pool.m_settings;
+    QStringList preload;
+    for (const std::string &model : settings.preload)
+        preload << QString::fromStdString(model);
+    QStringList arguments{QString::fromStdString(settings.script)};
+    if (!preload.isEmpty())
+        arguments << "--preload" << preload.join(',');
+
+    process.setProgram(QString::fromStdString(settings.python));
+    process.setArguments(arguments);
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start();
+    if (!process.waitForStarted(10000)) {
+        error = "cannot run " + settings.python + ": " + process.errorString().toStdString();
+        return false;
+    }
+
+    const auto start = Clock::now();
+    for (;;) {
+        const ReadResult result = readMessage(process, settings.startupTimeoutSeconds - secondsSince(start));
+        if (result.status == ReadStatus::Died) {
+            error = "Python worker exited while starting (exit code " + std::to_string(process.exitCode())
+                + "); see its output above";
+            return false;
+        }
+        if (result.status == ReadStatus::Timeout) {
+            error = "Python worker was not ready after " + std::to_string(int(settings.startupTimeoutSeconds))
+                + " s";
+            return false;
+        }
+        if (result.message.value("ready").toBool())
+            return true;
+    }
+}
+
+bool PythonWorkerPool::Worker::ping(QProcess &process)
+{
+    const double timeout = m_pool.m_settings.pingTimeoutSeconds;
+    if (!send(process, QJsonObject{{"id", 0}, {"op", "ping"}}))
+        return false;
+    const auto start = Clock::now();
+    for (;;) {
+        const ReadResult result = readMessage(process, timeout - secondsSince(start));
+        if (result.status != ReadStatus::Message)
+            return false;
+        if (messageId(result.message) == 0)
+            return result.message.value("ok").toBool();
+    }
+}
+
+void PythonWorkerPool::Worker::execute(QProcess &process, const std::shared_ptr<Job> &job)
+{
+    const PythonWorkerSettings &settings = m_pool.m_settings;
+    if (job->cancelled()) {
+        job->promise.set_exception(failure("cancelled"));
+        return;
+    }
+    const QJsonObject request{{"id", qint64(job->id)}, {"op", QString::fromStdString(job->op)}, {"args", job->args}};
+    bool cancelSent = false;
+    Clock::time_point cancelledAt;
+    if (send(process, request)) {
+        for (;;) {
+            bool stopping = false;
+            {
+                std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+                stopping = m_pool.m_stopping;
+            }
+            if ((job->cancelled() || stopping) && !cancelSent) {
+                send(process, QJsonObject{{"id", qint64(job->id)}, {"op", "cancel"}});
+                cancelSent = true;
+                cancelledAt = Clock::now();
+            }
+            if (cancelSent && secondsSince(cancelledAt) > settings.cancelGraceSeconds) {
+                process.kill();
+                process.waitForFinished(2000);
+                job->promise.set_exception(failure("cancelled"));
+                return;
+            }
+
+            const ReadResult result = readMessage(process, kPollMs / 1000.0);
+            if (result.status == ReadStatus::Died)
+                break;
+            if (result.status == ReadStatus::Timeout || messageId(result.message) != job->id)
+                continue;
+            const QJsonObject &message = result.message;
+            if (message.contains("progress")) {
+                if (job->progress)
+                    job->progress(message.value("progress").toDouble());
+                continue;
+            }
+            if (message.contains("event")) {
+                if (job->event)
+                    job->event(message);
+                continue;
+            }
+            if (message.value("ok").toBool())
+                job->promise.set_value(message.value("result").toObject());
+            else if (cancelSent)
+                job->promise.set_exception(failure("cancelled"));
+            else
+                job->promise.set_exception(failure(message.value("error").toString().toStdString()));
+            return;
+        }
+    }
+
+    // The worker died under the job (out of memory, a crash in a native
+    // library...): try again on a fresh process, which run() starts next.
+    if (cancelSent) {
+        job->promise.set_exception(failure("cancelled"));
+    } else if (job->attempts++ < settings.retries) {
+        m_pool.requeue(job);
+    } else {
+        job->promise.set_exception(failure("Python worker exited while running " + job->op));
+    }
+}
+
+PythonWorkerPool &PythonWorkerPool::shared()
+{
+    static PythonWorkerPool pool(defaultSettings());
+    return pool;
+}
+
+PythonWorkerSettings PythonWorkerPool::defaultSettings()
+{
+    PythonWorkerSettings settings;
+    if (const char *python = std::getenv("VEP_PYTHON"); python && *python)
+        settings.python = python;
+#ifdef _WIN32
+    else
+        settings.python = "python";
+#endif
+    if (const char *script = std::getenv("VEP_PYTHON_WORKER"); script && *script) {
+        settings.script = script;
+        return settings;
+    }
+    const QString appDir = QCoreApplication::applicationDirPath();
+    for (const QString &candidate : {appDir + "/../share/VideoEditorPro/python/vep_worker.py",
+                                     appDir + "/python/vep_worker.py"}) {
+        if (QFileInfo::exists(candidate)) {
+            settings.script = QFileInfo(candidate).absoluteFilePath().toStdString();
+            break;
+        }
+    }
+    return settings;
+}
+
+PythonWorkerPool::PythonWorkerPool(PythonWorkerSettings settings)
+    : m_settings(std::move(settings))
+{
+    m_settings.workers = std::max(1, m_settings.workers);
+    for (int i = 0; i < m_settings.workers; ++i)
+        m_workers.push_back(std::make_unique<Worker>(*this));
+}
+
+PythonWorkerPool::~PythonWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_workers.clear();
+    for (const std::shared_ptr<Job> &job : m_queue)
+        job->promise.set_exception(failure("Python worker pool shut down"));
+}
+
+std::future<QJsonObject> PythonWorkerPool::submit(const std::string &op, QJsonObject args, Progress progress,
+                                                  const std::atomic<bool> *cancel, Event event)
+{
+    auto job = std::make_shared<Job>();
+    job->op = op;
+    job->args = std::move(args);
+    job->progress = std::move(progress);
+    job->cancel = cancel;
+    job->event = std::move(event);
+    std::future<QJsonObject> future = job->promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            job->promise.set_exception(failure("Python worker pool shut down"));
+            return future;
+        }
+        if (!m_startError.empty()) {
+            job->promise.set_exception(failure(m_startError));
+            return future;
+        }
+        job->id = m_nextId++;
+        m_queue.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+    return future;
+}
+
+QJsonObject PythonWorkerPool::run(const std::string &op, QJsonObject args, Progress progress,
+                                  const std::atomic<bool> *cancel, Event event)
+{
+    return submit(op, std::move(args), std::move(progress), cancel, std::move(event)).get();
+}
+
+std::vector<PythonWorkerStatus> PythonWorkerPool::status() const
+{
+    std::vector<PythonWorkerStatus> result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &worker : m_workers)
+        result.push_back(worker->status);
+    return result;
+}
+
+bool PythonWorkerPool::available() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_startError.empty();
+}
+
+std::string PythonWorkerPool::startError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_startError;
+}
+
+std::shared_ptr<PythonWorkerPool::Job> PythonWorkerPool::takeJob(double timeoutSeconds)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake.wait_for(lock, std::chrono::duration<double>(timeoutSeconds),
+                    [this] { return m_stopping || !m_queue.empty(); });
+    if (m_stopping || m_queue.empty())
+        return nullptr;
+    std::shared_ptr<Job> job = std::move(m_queue.front());
+    m_queue.pop_front();
+    return job;
+}
+
+void PythonWorkerPool::requeue(std::shared_ptr<Job> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            job->promise.set_exception(failure("Python worker pool shut down"));
+            return;
+        }
+        if (!m_startError.empty()) {
+            job->promise.set_exception(failure(m_startError));
+            return;
+        }
+        m_queue.push_front(std::move(job));
+    }
+    m_wake.notify_one();
+}
+
+void PythonWorkerPool::giveUp(Worker &worker, const std::string &error)
+{
+    std::deque<std::shared_ptr<Job>> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        worker.status.gaveUp = true;
+        // Workers still running serve the queue; only the last one to give
+        // up fails it.
+        if (++m_gaveUp < m_settings.workers)
+            return;
+        m_startError = error;
+        pending.swap(m_queue);
+    }
+    for (const std::shared_ptr<Job> &job : pending)
+        job->promise.set_exception(failure(error));
+}
+
+} // namespace vep
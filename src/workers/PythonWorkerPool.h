@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QJsonObject>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vep {
+
+struct PythonWorkerSettings
+{
+    std::string python = "python3";
+    // python/vep_worker.py from the source tree or its installed copy.
+    std::string script;
+    int workers = 2;
+    // Models each worker loads before it reports ready, e.g. "rembg:u2net".
+    std::vector<std::string> preload = {"rembg:u2net"};
+    // Loading rembg's ONNX session dominates startup.
+    double startupTimeoutSeconds = 120.0;
+    // An idle worker is pinged this often and restarted if it does not
+    // answer within pingTimeoutSeconds.
+    double healthIntervalSeconds = 15.0;
+    double pingTimeoutSeconds = 5.0;
+    // How long a cancelled job may take to notice before its worker is
+    // killed (and restarted).
+    double cancelGraceSeconds = 5.0;
+    // A job whose worker dies under it is run again this many times on a
+    // fresh worker before it fails.
+    int retries = 1;
+    // Failed starts in a row (with growing pauses between them) before a
+    // worker gives up, e.g. on a missing interpreter or rembg.
+    int startAttempts = 4;
+};
+
+struct PythonWorkerStatus
+{
+    int64_t pid = 0;
+    bool ready = false;
+    bool busy = false;
+    int jobsDone = 0;
+    int restarts = 0;
+    // Stopped trying after settings.startAttempts failed starts.
+    bool gaveUp = false;
+};
+
+// Long-lived Python processes (python/vep_worker.py) with their models
+// already loaded, so a background-removal or analysis job starts at once
+// instead of paying for an interpreter start and a model load each time.
+//
+// Each worker is driven by a thread of its own over a line-delimited JSON
+// protocol on its stdin/stdout:
+//   worker  -> {"ready": true, "models": [...]}              once, after preloading
+//   request -> {"id": 7, "op": "remove_background", "args": {...}}
+//   worker  -> {"id": 7, "progress": 0.25}                    any number
+//   worker  -> {"id": 7, "event": "slot", ...}                any number
+//   worker  -> {"id": 7, "ok": true, "result": {...}}        or "ok": false, "error"
+//   request -> {"id": 7, "op": "cancel"}                     handled between frames
+// The worker's stderr goes to the application's. Workers that crash, hang
+// on a health ping or ignore a cancel are killed and started again; the job
+// they were running is retried on the next worker (see retries). Once every
+// worker has given up starting (see startAttempts) the pool is unavailable:
+// queued and later jobs fail at once with the last start error.
+class PythonWorkerPool
+{
+public:
+    using Progress = std::function<void(double fraction)>;
+    // Messages a job sends before its reply, e.g. a frame slot it is done
+    // with (see SharedFrameRing).
+    using Event = std::function<void(const QJsonObject &message)>;
+
+    // The process-wide pool, with the installed worker script.
+    static PythonWorkerPool &shared();
+    static PythonWorkerSettings defaultSettings();
+
+    explicit PythonWorkerPool(PythonWorkerSettings settings);
+    ~PythonWorkerPool();
+
+    PythonWorkerPool(const PythonWorkerPool &) = delete;
+    PythonWorkerPool &operator=(const PythonWorkerPool &) = delete;
+
+    // Queues a job for the next free worker. The future throws
+    // std::runtime_error with the worker's message if the job fails, and
+    // "cancelled" if `cancel` was set first. `progress` and `event` are
+    // called on a pool thread; `cancel` must outlive the job.
+    std::future<QJsonObject> submit(const std::string &op, QJsonObject args, Progress progress = Progress(),
+                                    const std::atomic<bool> *cancel = nullptr, Event event = Event());
+    // submit(...).get().
+    QJsonObject run(const std::string &op, QJsonObject args, Progress progress = Progress(),
+                    const std::atomic<bool> *cancel = nullptr, Event event = Event());
+
+    std::vector<PythonWorkerStatus> status() const;
+    // False once no worker could be started; startError() says why.
+    bool available() const;
+    std::string startError() const;
+
+private:
+    struct Job;
+    class Worker;
+
+    std::shared_ptr<Job> takeJob(double timeoutSeconds);
+    void requeue(std::shared_ptr<Job> job);
+    void giveUp(Worker &worker, const std::string &error);
+
+    PythonWorkerSettings m_settings;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::shared_ptr<Job>> m_queue;
+    bool m_stopping = false;
+    int m_gaveUp = 0;        // workers that stopped trying to start
+    std::string m_startError; // set when the last of them did
+    int64_t m_nextId = 1;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+} // namespace vep
@@ -0,0 +1,230 @@
+#include "workers/SharedFrameRing.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace vep {
+
+namespace {
+
+constexpr char kMagic[9] = "VEPRING1";
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderBytes = 64;
+constexpr size_t kDescriptorBytes = 64;
+constexpr size_t kPage = 4096;
+
+size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string uniqueName()
+{
+    static std::atomic<unsigned> counter{0};
+#ifdef _WIN32
+    const unsigned long pid = GetCurrentProcessId();
+#else
+    const unsigned long pid = (unsigned long)getpid();
+#endif
+    return "vep-ring-" + std::to_string(pid) + "-" + std::to_string(counter++);
+}
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t maxWidth;
+    uint32_t maxHeight;
+    uint32_t channels;
+    uint32_t reserved;
+    uint64_t slotBytes;
+    uint64_t dataOffset;
+};
+static_assert(sizeof(Header) <= kHeaderBytes, "ring header overflows its 64 bytes");
+
+} // namespace
+
+struct SharedFrameRing::Descriptor
+{
+    std::atomic<uint32_t> state;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t channels;
+    uint32_t maskStride;
+    int64_t frame;
+    uint64_t pixelOffset;
+    uint64_t maskOffset;
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "slot state must be a plain word the worker can read");
+
+SharedFrameRing::SharedFrameRing(int slots, int maxWidth, int maxHeight, int channels)
+    : m_name(uniqueName())
+    , m_slots(slots)
+    , m_maxWidth(maxWidth)
+    , m_maxHeight(maxHeight)
+    , m_channels(channels)
+{
+    static_assert(sizeof(Descriptor) <= kDescriptorBytes, "slot descriptor overflows its 64 bytes");
+    if (slots <= 0 || maxWidth <= 0 || maxHeight <= 0 || (channels != 3 && channels != 4))
+        throw std::runtime_error("invalid frame ring geometry");
+
+    // Rows are 64-byte aligned so the worker's numpy views and our SIMD
+    // loops both start every row on a cache line.
+    const size_t stride = alignUp(size_t(maxWidth) * size_t(channels), 64);
+    const size_t maskStride = alignUp(size_t(maxWidth), 64);
+    const size_t pixelBytes = stride * size_t(maxHeight);
+    const size_t slotBytes = alignUp(pixelBytes + maskStride * size_t(maxHeight), kPage);
+    const size_t dataOffset = alignUp(kHeaderBytes + kDescriptorBytes * size_t(slots), kPage);
+    m_size = dataOffset + slotBytes * size_t(slots);
+
+#ifdef _WIN32
+    const std::wstring wideName(m_name.begin(), m_name.end());
+    m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, DWORD(uint64_t(m_size) >> 32),
+                                   DWORD(m_size & 0xffffffffu), wideName.c_str());
+    if (!m_mapping)
+        throw std::runtime_error("cannot create shared memory " + m_name);
+    m_base = static_cast<uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_size));
+    if (!m_base) {
+        CloseHandle(m_mapping);
+        throw std::runtime_error("cannot map shared memory " + m_name);
+    }
+#else
+    const std::string path = "/" + m_name;
+    const int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        throw std::runtime_error("cannot create shared memory " + m_name);
+    if (::ftruncate(fd, off_t(m_size)) != 0) {
+        ::close(fd);
+        ::shm_unlink(path.c_str());
+        throw std::runtime_error("cannot size shared memory " + m_name);
+    }
+    void *mapping = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ::shm_unlink(path.c_str());
+        throw std::runtime_error("cannot map shared memory " + m_name);
+    }
+    m_base = static_cast<uint8_t *>(mapping);
+#endif
+
+    auto *header = reinterpret_cast<Header *>(m_base);
+    std::memcpy(header->magic, kMagic, 8);
+    header->version = kVersion;
+    header->slotCount = uint32_t(slots);
+    header->maxWidth = uint32_t(maxWidth);
+    header->maxHeight = uint32_t(maxHeight);
+    header->channels = uint32_t(channels);
+    header->reserved = 0;
+    header->slotBytes = slotBytes;
+    header->dataOffset = dataOffset;
+    for (int i = 0; i < slots; ++i) {
+        auto *d = new (m_base + kHeaderBytes + kDescriptorBytes * size_t(i)) Descriptor{};
+        d->state.store(uint32_t(SlotState::Free));
+        d->stride = uint32_t(stride);
+        d->channels = uint32_t(channels);
+        d->maskStride = uint32_t(maskStride);
+        d->frame = -1;
+        d->pixelOffset = dataOffset + slotBytes * size_t(i);
+        d->maskOffset = d->pixelOffset + pixelBytes;
+    }
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(m_base);
+    CloseHandle(m_mapping);
+#else
+    ::munmap(m_base, m_size);
+    // Workers that still have it mapped keep their pages until they close.
+    ::shm_unlink(("/" + m_name).c_str());
+#endif
+}
+
+SharedFrameRing::Descriptor &SharedFrameRing::descriptor(int index) const
+{
+    if (index < 0 || index >= m_slots)
+        throw std::out_of_range("frame ring slot out of range");
+    return *reinterpret_cast<Descriptor *>(m_base + kHeaderBytes + kDescriptorBytes * size_t(index));
+}
+
+std::optional<SharedFrameRing::Slot> SharedFrameRing::acquire()
+{
+    for (int i = 0; i < m_slots; ++i) {
+        uint32_t expected = uint32_t(SlotState::Free);
+        if (descriptor(i).state.compare_exchange_strong(expected, uint32_t(SlotState::Writing)))
+            return slot(i);
+    }
+    return std::nullopt;
+}
+
+void SharedFrameRing::queue(int index, int width, int height, int64_t frame)
+{
+    if (width <= 0 || height <= 0 || width > m_maxWidth || height > m_maxHeight)
+        throw std::runtime_error("frame does not fit the ring's slots");
+    Descriptor &d = descriptor(index);
+    d.width = uint32_t(width);
+    d.height = uint32_t(height);
+    d.frame = frame;
+    d.state.store(uint32_t(SlotState::Queued), std::memory_order_release);
+}
+
+SharedFrameRing::SlotState SharedFrameRing::state(int index) const
+{
+    return SlotState(descriptor(index).state.load(std::memory_order_acquire));
+}
+
+int64_t SharedFrameRing::frame(int index) const
+{
+    return descriptor(index).frame;
+}
+
+int SharedFrameRing::width(int index) const
+{
+    return int(descriptor(index).width);
+}
+
+int SharedFrameRing::height(int index) const
+{
+    return int(descriptor(index).height);
+}
+
+SharedFrameRing::Slot SharedFrameRing::slot(int index) const
+{
+    const Descriptor &d = descriptor(index);
+    Slot slot;
+    slot.index = index;
+    slot.pixels = m_base + d.pixelOffset;
+    slot.stride = int(d.stride);
+    slot.mask = m_base + d.maskOffset;
+    slot.maskStride = int(d.maskStride);
+    return slot;
+}
+
+void SharedFrameRing::release(int index)
+{
+    Descriptor &d = descriptor(index);
+    d.frame = -1;
+    d.state.store(uint32_t(SlotState::Free), std::memory_order_release);
+}
+
+void SharedFrameRing::releaseAll()
+{
+    for (int i = 0; i < m_slots; ++i)
+        release(i);
+}
+
+} // namespace vep
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace vep {
+
+// A ring of frame slots in named shared memory, for handing frames to the
+// Python workers (and getting their masks back) without encoding them or
+// pushing them through a pipe. python/vep_frames.py maps the same region
+// and sees each slot's pixels and mask as numpy arrays over the shared
+// pages, so neither side copies a frame it does not have to.
+//
+// Layout (little-endian, all offsets from the start of the region):
+//   0    header: "VEPRING1", version, slotCount, maxWidth, maxHeight,
+//        channels, slotBytes, dataOffset (64 bytes)
+//   64   one 64-byte descriptor per slot: state, width, height, stride,
+//        channels, maskStride, frame, pixelOffset, maskOffset
+//   dataOffset (page aligned) slots: maxHeight rows of pixels at `stride`
+//        bytes (RGB or RGBA, 8 bits), then maxHeight rows of 8-bit mask.
+//
+// Ownership is by slot state. C++ takes a Free slot (Writing), fills it and
+// queues it; from then on the slot belongs to the worker, which writes the
+// mask, marks it Done (or Failed) and names it in a {"event": "slot"}
+// message over the job's control channel. That message is the hand-back:
+// C++ reads the mask and releases the slot for the next frame.
+class SharedFrameRing
+{
+public:
+    enum class SlotState : uint32_t { Free = 0, Writing = 1, Queued = 2, Done = 3, Failed = 4 };
+
+    struct Slot
+    {
+        int index = -1;
+        uint8_t *pixels = nullptr;
+        int stride = 0;
+        uint8_t *mask = nullptr;
+        int maskStride = 0;
+    };
+
+    // Throws std::runtime_error if the region cannot be created.
+    SharedFrameRing(int slots, int maxWidth, int maxHeight, int channels = 4);
+    ~SharedFrameRing();
+
+    SharedFrameRing(const SharedFrameRing &) = delete;
+    SharedFrameRing &operator=(const SharedFrameRing &) = delete;
+
+    // The name the workers open the region by.
+    const std::string &name() const { return m_name; }
+    int slotCount() const { return m_slots; }
+    int maxWidth() const { return m_maxWidth; }
+    int maxHeight() const { return m_maxHeight; }
+    int channels() const { return m_channels; }
+
+    // A Free slot, now Writing, or nothing if the workers hold them all.
+    std::optional<Slot> acquire();
+    // Hands a Writing slot holding a width x height frame to the workers.
+    void queue(int index, int width, int height, int64_t frame);
+    SlotState state(int index) const;
+    int64_t frame(int index) const;
+    int width(int index) const;
+    int height(int index) const;
+    Slot slot(int index) const;
+    // Back to Free once its mask has been consumed (or the job is gone).
+    void release(int index);
+    // Frees every slot, e.g. after the worker holding them crashed.
+    void releaseAll();
+
+private:
+    struct Descriptor;
+
+    Descriptor &descriptor(int index) const;
+
+    std::string m_name;
+    int m_slots;
+    int m_maxWidth;
+    int m_maxHeight;
+    int m_channels;
+    size_t m_size = 0;
+    uint8_t *m_base = nullptr;
+#ifdef _WIN32
+    void *m_mapping = nullptr;
+#endif
+};
+
+} // namespace vep
@@ -0,0 +1,283 @@
+#include "audio/Biquad.h"
+#include "audio/Compressor.h"
+#include "audio/ConvolutionReverb.h"
+#include "audio/ParametricEq.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace vep {
+namespace {
+
+constexpr double kRate = 48000.0;
+constexpr double kPi = 3.14159265358979323846;
+
+double gainAt(const BiquadCoefficients &c, double frequency)
+{
+    const double w = 2.0 * kPi * frequency / kRate;
+    const std::complex<double> z1 = std::polar(1.0, -w);
+    const std::complex<double> z2 = z1 * z1;
+    return std::abs((double(c.b0) + double(c.b1) * z1 + double(c.b2) * z2)
+                    / (1.0 + double(c.a1) * z1 + double(c.a2) * z2));
+}
+
+double toDb(double gain)
+{
+    return 20.0 * std::log10(gain);
+}
+
+TEST(Biquad, FlatPeakingBandIsIdentity)
+{
+    const auto c = BiquadCoefficients::design(FilterShape::Peaking, kRate, 1000.0, 0.0, 1.0);
+    EXPECT_FLOAT_EQ(c.b0, 1.0f);
+    EXPECT_FLOAT_EQ(c.b1, c.a1);
+    EXPECT_FLOAT_EQ(c.b2, c.a2);
+}
+
+TEST(Biquad, ShapesHaveTheirDesignedResponse)
+{
+    const auto peak = BiquadCoefficients::design(FilterShape::Peaking, kRate, 1000.0, 9.0, 1.0);
+    EXPECT_NEAR(toDb(gainAt(peak, 1000.0)), 9.0, 0.01);
+    EXPECT_NEAR(toDb(gainAt(peak, 50.0)), 0.0, 0.1);
+
+    const auto lowShelf = BiquadCoefficients::design(FilterShape::LowShelf, kRate, 200.0, -6.0, 0.707);
+    EXPECT_NEAR(toDb(gainAt(lowShelf, 10.0)), -6.0, 0.05);
+    EXPECT_NEAR(toDb(gainAt(lowShelf, 15000.0)), 0.0, 0.05);
+
+    const auto highShelf = BiquadCoefficients::design(FilterShape::HighShelf, kRate, 5000.0, 4.0, 0.707);
+    EXPECT_NEAR(toDb(gainAt(highShelf, 20000.0)), 4.0, 0.1);
+    EXPECT_NEAR(toDb(gainAt(highShelf, 50.0)), 0.0, 0.05);
+
+    const auto lowPass = BiquadCoefficients::design(FilterShape::LowPass, kRate, 1000.0, 0.0, 0.707);
+    EXPECT_NEAR(gainAt(lowPass, 0.0), 1.0, 1e-4);
+    EXPECT_NEAR(toDb(gainAt(lowPass, 1000.0)), -3.01, 0.05);
+    EXPECT_LT(gainAt(lowPass, 20000.0), 0.01);
+
+    const auto highPass = BiquadCoefficients::design(FilterShape::HighPass, kRate, 1000.0, 0.0, 0.707);
+    EXPECT_LT(gainAt(highPass, 0.0), 1e-4);
+    EXPECT_NEAR(gainAt(highPass, 20000.0), 1.0, 0.01);
+
+    const auto notch = BiquadCoefficients::design(FilterShape::Notch, kRate, 60.0, 0.0, 4.0);
+    EXPECT_LT(gainAt(notch, 60.0), 1e-3);
+    EXPECT_NEAR(gainAt(notch, 1000.0), 1.0, 0.01);
+}
+
+TEST(ParametricEq, BoostsSineAtBandFrequencyOnEveryChannel)
+{
+    // Five channels span two Float4 groups, the second one partly filled.
+    constexpr int kChannels = 5;
+    constexpr int kFrames = 48000;
+    ParametricEq eq(kRate, kChannels);
+    EqBand band;
+    band.shape = FilterShape::Peaking;
+    band.frequency = 1000.0;
+    band.gainDb = 12.0;
+    band.q = 1.0;
+    band.enabled = true;
+    eq.setBand(0, band);
+    eq.snapToTargets();
+
+    std::vector<float> audio(size_t(kFrames) * kChannels);
+    for (int i = 0; i < kFrames; ++i) {
+        const float value = float(0.1 * std::sin(2.0 * kPi * 1000.0 * i / kRate));
+        for (int c = 0; c < kChannels; ++c)
+            audio[size_t(i) * kChannels + size_t(c)] = value;
+    }
+    // Uneven blocks, as MLT delivers them.
+    for (int done = 0, block = 1; done < kFrames; done += block, block = block * 3 % 1999 + 1) {
+        block = std::min(block, kFrames - done);
+        eq.process(audio.data() + size_t(done) * kChannels, block);
+    }
+
+    for (int c = 0; c < kChannels; ++c) {
+        float peak = 0.0f;
+        for (int i = kFrames / 2; i < kFrames; ++i)
+            peak = std::max(peak, std::fabs(audio[size_t(i) * kChannels + size_t(c)]));
+        EXPECT_NEAR(toDb(peak / 0.1), 12.0, 0.1) << "channel " << c;
+        EXPECT_EQ(audio[size_t(kFrames - 1) * kChannels + size_t(c)], audio[size_t(kFrames - 1) * kChannels])
+            << "channel " << c;
+    }
+}
+
+TEST(ParametricEq, DisabledBandsPassAudioThrough)
+{
+    ParametricEq eq(kRate, 2);
+    std::vector<float> audio(512);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    for (float &sample : audio)
+        sample = noise(rng);
+    const std::vector<float> original = audio;
+    eq.process(audio.data(), 256);
+    EXPECT_EQ(audio, original);
+}
+
+TEST(Compressor, ReducesSteadyLevelByRatio)
+{
+    Compressor compressor(kRate, 2);
+    CompressorSettings settings;
+    settings.thresholdDb = -18.0;
+    settings.ratio = 4.0;
+    settings.kneeDb = 0.0;
+    settings.makeupDb = 0.0;
+    compressor.setSettings(settings);
+
+    // A constant -6 dBFS level: the gain settles at 12 dB over the
+    // threshold times (1 - 1/4).
+    constexpr int kFrames = 48000;
+    const float level = 0.5f;
+    std::vector<float> audio(size_t(kFrames) * 2);
+    for (int i = 0; i < kFrames; ++i)
+        audio[size_t(i) * 2] = audio[size_t(i) * 2 + 1] = (i % 2) ? level : -level;
+    compressor.process(audio.data(), kFrames);
+
+    const double expectedDb = -(20.0 * std::log10(level) + 18.0) * 0.75;
+    const float out = std::fabs(audio[size_t(kFrames - 1) * 2]);
+    EXPECT_NEAR(toDb(out / level), expectedDb, 0.1);
+    EXPECT_NEAR(compressor.gainReductionDb(), expectedDb, 0.1);
+    // Stereo-linked: both channels get the same gain.
+    EXPECT_EQ(audio[size_t(kFrames - 1) * 2], audio[size_t(kFrames - 1) * 2 + 1]);
+}
+
+TEST(Compressor, LeavesQuietAudioAlone)
+{
+    Compressor compressor(kRate, 1);
+    CompressorSettings settings;
+    settings.thresholdDb = -6.0;
+    settings.kneeDb = 0.0;
+    compressor.setSettings(settings);
+
+    constexpr int kFrames = 4800;
+    std::vector<float> audio(kFrames);
+    for (int i = 0; i < kFrames; ++i)
+        audio[size_t(i)] = float(0.1 * std::sin(2.0 * kPi * 440.0 * i / kRate));
+    const std::vector<float> original = audio;
+    compressor.process(audio.data(), kFrames);
+
+    // Delayed by the look-ahead, otherwise untouched.
+    const int latency = compressor.latency();
+    ASSERT_GT(latency, 0);
+    for (int i = latency; i < kFrames; ++i)
+        ASSERT_NEAR(audio[size_t(i)], original[size_t(i - latency)], 1e-6f) << "frame " << i;
+}
+
+TEST(Compressor, LimiterHoldsPeaksAtThreshold)
+{
+    Compressor compressor(kRate, 2);
+    CompressorSettings settings;
+    settings.limiter = true;
+    settings.thresholdDb = -6.0;
+    settings.kneeDb = 0.0;
+    settings.makeupDb = 0.0;
+    compressor.setSettings(settings);
+    // Let the threshold glide from its default before measuring.
+    std::vector<float> silence(size_t(4800) * 2, 0.0f);
+    compressor.process(silence.data(), 4800);
+
+    constexpr int kFrames = 96000;
+    std::vector<float> audio(size_t(kFrames) * 2);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    for (int i = 0; i < kFrames; ++i) {
+        // Quiet noise with loud single-sample spikes and louder bursts.
+        const bool burst = (i / 4800) % 3 == 1;
+        const float gain = burst ? 1.0f : (i % 997 == 0 ? 4.0f : 0.2f);
+        audio[size_t(i) * 2] = noise(rng) * gain;
+        audio[size_t(i) * 2 + 1] = noise(rng) * gain;
+    }
+    compressor.process(audio.data(), kFrames);
+
+    const float ceiling = float(std::pow(10.0, -6.0 / 20.0));
+    float peak = 0.0f;
+    for (float sample : audio)
+        peak = std::max(peak, std::fabs(sample));
+    EXPECT_LE(peak, ceiling * 1.001f);
+}
+
+TEST(ConvolutionReverb, MixesDelayedDryWithWetAcrossBlockSizes)
+{
+    auto ir = std::make_shared<ImpulseResponse>();
+    ir->sampleRate = int(kRate);
+    ir->channels = {{0.5f, 0.25f}};
+    ConvolutionReverb reverb(kRate, 2);
+    reverb.setImpulseResponse(ir);
+    reverb.prepare(256);
+    reverb.setMix(0.0, 0.0);
+    reverb.reset();
+    const int latency = reverb.latency();
+
+    constexpr int kFrames = 4000;
+    std::vector<float> input(size_t(kFrames) * 2);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    for (float &sample : input)
+        sample = noise(rng);
+    std::vector<float> audio = input;
+    // Blocks both within and beyond the prepared size.
+    const int blocks[] = {100, 256, 7, 1601, 300};
+    int done = 0;
+    for (size_t b = 0; done < kFrames; b = (b + 1) % 5) {
+        const int frames = std::min(blocks[b], kFrames - done);
+        reverb.process(audio.data() + size_t(done) * 2, frames);
+        done += frames;
+    }
+
+    auto at = [&](int frame, int channel) {
+        return frame < 0 ? 0.0f : input[size_t(frame) * 2 + size_t(channel)];
+    };
+    for (int i = 0; i < kFrames; ++i) {
+        for (int ch = 0; ch < 2; ++ch) {
+            const int t = i - latency;
+            const float expected = at(t, ch) * 1.5f + at(t - 1, ch) * 0.25f;
+            ASSERT_NEAR(audio[size_t(i) * 2 + size_t(ch)], expected, 1e-4f) << "frame " << i << " channel " << ch;
+        }
+    }
+}
+
+TEST(ConvolutionReverb, DrySignalRunsOnAcrossTheFirstIrLoad)
+{
+    // No IR yet, then the reverb that loaded one takes over mid-stream, the
+    // way the MLT filter swaps them: the dry signal neither jumps nor drops.
+    ConvolutionReverb empty(kRate, 2);
+    empty.prepare(256);
+    empty.setMix(-120.0, 0.0);
+    empty.reset();
+
+    auto ir = std::make_shared<ImpulseResponse>();
+    ir->sampleRate = int(kRate);
+    ir->channels = {{0.5f, 0.25f}};
+    ConvolutionReverb loaded(kRate, 2);
+    loaded.setImpulseResponse(ir);
+    loaded.prepare(256);
+    loaded.setMix(-120.0, 0.0);
+    EXPECT_EQ(loaded.latency(), empty.latency());
+
+    constexpr int kFrames = 2000;
+    constexpr int kSwap = 1000;
+    std::vector<float> input(size_t(kFrames) * 2);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    for (float &sample : input)
+        sample = noise(rng);
+    std::vector<float> audio = input;
+    for (int done = 0; done < kSwap; done += 200)
+        empty.process(audio.data() + size_t(done) * 2, 200);
+    loaded.continueFrom(empty);
+    for (int done = kSwap; done < kFrames; done += 200)
+        loaded.process(audio.data() + size_t(done) * 2, 200);
+
+    const int latency = loaded.latency();
+    for (int i = 0; i < kFrames * 2; ++i) {
+        const float expected = i < latency * 2 ? 0.0f : input[size_t(i - latency * 2)];
+        ASSERT_NEAR(audio[size_t(i)], expected, 1e-5f) << "sample " << i;
+    }
+}
+
+} // namespace
+} // namespace vep
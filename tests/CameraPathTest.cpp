@@ -0,0 +1,85 @@
+#include "stabilization/CameraPath.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+namespace vep {
+namespace {
+
+CameraMotion motionOf(size_t frames, double fps = 30.0)
+{
+    CameraMotion motion;
+    motion.fps = fps;
+    motion.width = 1920;
+    motion.height = 1080;
+    motion.steps.resize(frames);
+    return motion;
+}
+
+// Where the camera ends up on each frame once the corrections are applied.
+std::vector<double> stabilizedX(const CameraMotion &motion, const StabilizedPath &path)
+{
+    std::vector<double> result;
+    double x = 0.0;
+    for (size_t i = 0; i < motion.steps.size(); ++i) {
+        x += motion.steps[i].dx;
+        result.push_back(x + path.corrections[i].dx);
+    }
+    return result;
+}
+
+TEST(SmoothCameraPath, NoSmoothingLeavesFramesAlone)
+{
+    CameraMotion motion = motionOf(100);
+    for (size_t i = 1; i < motion.steps.size(); ++i)
+        motion.steps[i].dx = float(i % 5) - 2.0f;
+    const StabilizedPath path = smoothCameraPath(motion, 0.0);
+    ASSERT_EQ(path.corrections.size(), motion.steps.size());
+    for (const MotionStep &correction : path.corrections) {
+        EXPECT_EQ(correction.dx, 0.0f);
+        EXPECT_EQ(correction.angle, 0.0f);
+    }
+    EXPECT_EQ(path.zoom, 1.0);
+    EXPECT_TRUE(smoothCameraPath(motionOf(0), 1.0).corrections.empty());
+}
+
+TEST(SmoothCameraPath, CancelsShakeOfAStillCamera)
+{
+    CameraMotion motion = motionOf(600);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> shake(-3.0f, 3.0f);
+    // Jitter about a fixed point: each step undoes the previous offset.
+    float previous = 0.0f;
+    for (size_t i = 1; i < motion.steps.size(); ++i) {
+        const float offset = shake(rng);
+        motion.steps[i].dx = offset - previous;
+        motion.steps[i].angle = (offset - previous) * 0.001f;
+        previous = offset;
+    }
+    const StabilizedPath path = smoothCameraPath(motion, 1.0);
+    const std::vector<double> x = stabilizedX(motion, path);
+
+    // Away from the ends, where the window is full, the picture hardly moves.
+    double worst = 0.0;
+    for (size_t i = 31; i + 31 < x.size(); ++i)
+        worst = std::max(worst, std::fabs(x[i] - x[i - 1]));
+    EXPECT_LT(worst, 0.5);
+    EXPECT_GT(path.zoom, 1.0);
+    EXPECT_LE(path.zoom, StabilizedPath::kMaxZoom);
+}
+
+TEST(SmoothCameraPath, KeepsAPanWithoutLag)
+{
+    // A steady pan, the shot starting and ending mid-movement.
+    CameraMotion motion = motionOf(300);
+    for (size_t i = 1; i < motion.steps.size(); ++i)
+        motion.steps[i].dx = 4.0f;
+    const StabilizedPath path = smoothCameraPath(motion, 2.0);
+    for (const MotionStep &correction : path.corrections)
+        EXPECT_NEAR(correction.dx, 0.0f, 1e-3f);
+}
+
+} // namespace
+} // namespace vep
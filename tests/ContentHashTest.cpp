@@ -0,0 +1,67 @@
+#include "core/ContentHash.h"
+
+#include "TestFiles.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace vep {
+namespace {
+
+uint64_t xxh64(const std::string &text, uint64_t seed = 0)
+{
+    Hasher64 hasher(seed);
+    hasher.update(text);
+    return hasher.digest();
+}
+
+TEST(Hasher64, MatchesReferenceXxh64)
+{
+    EXPECT_EQ(xxh64(""), 0xef46db3751d8e999ull);
+    EXPECT_EQ(xxh64("a"), 0xd24ec4f1a98c6e5bull);
+    EXPECT_EQ(xxh64("abc"), 0x44bc2cf5ad770999ull);
+    // Longer than one 32-byte stripe.
+    EXPECT_EQ(xxh64("Nobody inspects the spammish repetition"), 0xfbcea83c8a378bf1ull);
+}
+
+TEST(Hasher64, StreamingMatchesOneShot)
+{
+    std::string data;
+    for (int i = 0; i < 1000; ++i)
+        data += char('a' + i * 7 % 26);
+    const uint64_t whole = xxh64(data, 42);
+
+    for (size_t piece : {1u, 3u, 31u, 32u, 33u, 100u}) {
+        Hasher64 hasher(42);
+        for (size_t at = 0; at < data.size(); at += piece)
+            hasher.update(data.data() + at, std::min(piece, data.size() - at));
+        EXPECT_EQ(hasher.digest(), whole) << "pieces of " << piece;
+    }
+    EXPECT_NE(xxh64(data, 43), whole);
+}
+
+TEST(ContentHash, HexRoundTrip)
+{
+    const ContentHash hash = ContentHash::ofBytes("abc", 3);
+    EXPECT_EQ(hash.hex(), "44bc2cf5ad770999");
+    EXPECT_EQ(ContentHash::fromHex(hash.hex()), hash);
+    EXPECT_TRUE(ContentHash::fromHex("not hex").isNull());
+}
+
+TEST(ContentHash, OfFileHashesTheBytes)
+{
+    test::TemporaryDirectory directory;
+    std::string contents(100000, '\0');
+    for (size_t i = 0; i < contents.size(); ++i)
+        contents[i] = char(i * 131 % 251);
+    const std::string path = directory.file("media.bin");
+    test::writeFile(path, contents);
+
+    EXPECT_EQ(ContentHash::ofFile(path), ContentHash::ofBytes(contents.data(), contents.size()));
+    EXPECT_THROW(ContentHash::ofFile(directory.file("missing.bin")), std::runtime_error);
+}
+
+} // namespace
+} // namespace vep
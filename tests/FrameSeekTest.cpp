@@ -0,0 +1,87 @@
+#include "media/FrameSeek.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace vep {
+namespace {
+
+// A decoder whose seek lands `error` frames from where it was asked to,
+// clamped to the stream, and reports where it really is.
+struct SloppyDecoder
+{
+    int64_t frames;
+    int64_t error;
+    int64_t position = 0;
+    int seeks = 0;
+
+    int64_t seekTo(int64_t frame)
+    {
+        ++seeks;
+        position = std::clamp<int64_t>(frame + error, 0, frames);
+        return position;
+    }
+    bool grab()
+    {
+        if (position >= frames)
+            return false;
+        ++position;
+        return true;
+    }
+    int64_t seek(int64_t target)
+    {
+        return seekExactly(
+            target, [this](int64_t frame) { return seekTo(frame); }, [this] { return grab(); });
+    }
+};
+
+TEST(FrameSeek, ExactDecoderNeedsOneSeek)
+{
+    SloppyDecoder decoder{1000, 0};
+    EXPECT_EQ(decoder.seek(480), 480);
+    EXPECT_EQ(decoder.position, 480);
+    EXPECT_EQ(decoder.seeks, 1);
+}
+
+TEST(FrameSeek, UndershootIsDecodedForward)
+{
+    SloppyDecoder decoder{1000, -3};
+    EXPECT_EQ(decoder.seek(480), 480);
+    EXPECT_EQ(decoder.position, 480);
+    EXPECT_EQ(decoder.seeks, 1);
+}
+
+TEST(FrameSeek, OvershootSeeksFurtherBack)
+{
+    SloppyDecoder decoder{1000, 2};
+    EXPECT_EQ(decoder.seek(480), 480);
+    EXPECT_EQ(decoder.position, 480);
+    EXPECT_EQ(decoder.seeks, 2);
+
+    // A margin of 8, then 16, then 32 before it lands early enough.
+    SloppyDecoder far{1000, 20};
+    EXPECT_EQ(far.seek(480), 480);
+    EXPECT_EQ(far.position, 480);
+    EXPECT_EQ(far.seeks, 4);
+}
+
+TEST(FrameSeek, StopsAtTheEndOfTheStream)
+{
+    SloppyDecoder decoder{100, -5};
+    EXPECT_EQ(decoder.seek(150), 100);
+    EXPECT_EQ(decoder.position, 100);
+}
+
+TEST(FrameSeek, ReportsWhereItLandsWhenTheStartOvershoots)
+{
+    // Even a seek to 0 lands at 4: the frames before it cannot be reached.
+    SloppyDecoder decoder{100, 4};
+    EXPECT_EQ(decoder.seek(2), 4);
+    EXPECT_EQ(decoder.position, 4);
+    EXPECT_EQ(decoder.seek(-7), 4);
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,83 @@
+#include "segmentation/GuidedUpsampler.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+namespace {
+
+SegmentationInput rgb(const std::vector<uint8_t> &pixels, int width, int height)
+{
+    SegmentationInput input;
+    input.pixels = pixels.data();
+    input.width = width;
+    input.height = height;
+    input.stride = width * 3;
+    input.channels = 3;
+    return input;
+}
+
+// Dark left of `edge`, bright from it on.
+std::vector<uint8_t> split(int width, int height, int edge)
+{
+    std::vector<uint8_t> pixels;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x)
+            pixels.insert(pixels.end(), 3, x < edge ? uint8_t(20) : uint8_t(230));
+    }
+    return pixels;
+}
+
+TEST(GuidedUpsampler, ReducesToTheRequestedHeightKeepingTheAspect)
+{
+    const std::vector<uint8_t> pixels = split(64, 36, 32);
+    std::vector<uint8_t> storage;
+    const SegmentationInput reduced = reduceFrame(rgb(pixels, 64, 36), 9, storage);
+    EXPECT_EQ(reduced.height, 9);
+    EXPECT_EQ(reduced.width, 16);
+    EXPECT_EQ(reduced.pixels, storage.data());
+
+    const SegmentationInput same = reduceFrame(rgb(pixels, 64, 36), 36, storage);
+    EXPECT_EQ(same.pixels, pixels.data());
+}
+
+TEST(GuidedUpsampler, FlatFrameWithZeroEpsilonKeepsTheMatte)
+{
+    const std::vector<uint8_t> frame(64 * 64 * 3, 128);
+    std::vector<uint8_t> storage;
+    const SegmentationInput reduced = reduceFrame(rgb(frame, 64, 64), 16, storage);
+    const std::vector<uint8_t> lowMask(16 * 16, 200);
+
+    GuidedUpsampleSettings settings;
+    settings.epsilon = 0.0;
+    std::vector<uint8_t> mask(64 * 64, 0);
+    guidedUpsample(reduced, lowMask.data(), 16, rgb(frame, 64, 64), mask.data(), 64, settings);
+    for (uint8_t value : mask)
+        ASSERT_NEAR(value, 200, 1);
+}
+
+TEST(GuidedUpsampler, EdgesFollowTheFullResolutionFrame)
+{
+    // The edge falls inside a low-resolution pixel, which comes out half
+    // covered; the full-resolution matte still switches at the frame's edge.
+    const std::vector<uint8_t> frame = split(64, 64, 34);
+    std::vector<uint8_t> storage;
+    const SegmentationInput reduced = reduceFrame(rgb(frame, 64, 64), 16, storage);
+    std::vector<uint8_t> lowMask(16 * 16);
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x)
+            lowMask[size_t(y * 16 + x)] = reduced.pixels[size_t(y * reduced.stride + x * 3)];
+    }
+
+    std::vector<uint8_t> mask(64 * 64, 0);
+    guidedUpsample(reduced, lowMask.data(), 16, rgb(frame, 64, 64), mask.data(), 64);
+    for (int y = 0; y < 64; ++y) {
+        EXPECT_LT(mask[size_t(y * 64 + 33)], 40) << "row " << y;
+        EXPECT_GT(mask[size_t(y * 64 + 34)], 200) << "row " << y;
+    }
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,86 @@
+#include "segmentation/ImageResample.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace vep {
+namespace {
+
+std::vector<uint8_t> pattern(int width, int height, int channels)
+{
+    std::vector<uint8_t> pixels;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c)
+                pixels.push_back(uint8_t((x * 37 + y * 91 + c * 53 + (x * y) % 7 * 29) % 256));
+        }
+    }
+    return pixels;
+}
+
+std::vector<uint8_t> resize(const std::vector<uint8_t> &source, int width, int height, int channels,
+                            int targetWidth, int targetHeight)
+{
+    std::vector<uint8_t> target(size_t(targetWidth) * size_t(targetHeight) * size_t(channels));
+    resizeLanczos(source.data(), width, height, width * channels, channels, target.data(), targetWidth,
+                  targetHeight, targetWidth * channels);
+    return target;
+}
+
+// The expected pixels come from Pillow 12:
+//   Image.frombytes(mode, size, pattern).resize(target, Image.LANCZOS)
+TEST(ImageResample, MatchesPillowWhenShrinking)
+{
+    const std::vector<uint8_t> expected{67,  115, 108, 115, 94,  141, 112, 192, 194, 212, 121, 42,
+                                        108, 170, 111, 121, 95,  129, 142, 136, 117, 133, 143, 115,
+                                        58,  103, 175, 112, 106, 119, 120, 113, 137, 168, 100, 86};
+    EXPECT_EQ(resize(pattern(7, 5, 3), 7, 5, 3, 4, 3), expected);
+
+    const std::vector<uint8_t> smaller{92, 116, 125, 145, 144, 133, 114, 128, 103,
+                                       101, 138, 154, 132, 96, 118, 131, 139, 128};
+    EXPECT_EQ(resize(pattern(9, 6, 3), 9, 6, 3, 3, 2), smaller);
+}
+
+TEST(ImageResample, MatchesPillowWhenEnlarging)
+{
+    const std::vector<uint8_t> expected{
+        0,   0,   11,  23,  46,  91,  131, 148, 159, 182, 192, 5,   17,  48,  80,  95,  95,  96,  117, 150,
+        175, 185, 31,  56,  108, 169, 172, 104, 44,  68,  132, 164, 175, 96,  107, 140, 213, 230, 133, 32,
+        42,  115, 154, 171, 186, 142, 90,  132, 204, 178, 110, 84,  112, 155, 184, 210, 138, 38,  29,  119,
+        194, 202, 137, 108, 164, 209, 130, 105, 65,  25,  49,  159, 221, 136, 88,  171, 236, 29,  70,  122,
+        72,  15,  112, 196, 109, 69,  174, 252, 0,   48,  157, 104, 0,   83,  175, 90,  58,  176, 255};
+    EXPECT_EQ(resize(pattern(6, 4, 1), 6, 4, 1, 11, 9), expected);
+}
+
+TEST(ImageResample, SameSizeAndFlatImagesAreUnchanged)
+{
+    const std::vector<uint8_t> source = pattern(8, 6, 4);
+    EXPECT_EQ(resize(source, 8, 6, 4, 8, 6), source);
+
+    const std::vector<uint8_t> flat(size_t(13) * 7 * 3, 77);
+    for (uint8_t value : resize(flat, 13, 7, 3, 5, 11))
+        ASSERT_EQ(value, 77);
+}
+
+TEST(ImageResample, HonoursStrides)
+{
+    // The same picture with padding at the end of every row, in and out.
+    const std::vector<uint8_t> packed = pattern(7, 5, 3);
+    std::vector<uint8_t> padded(size_t(7 * 3 + 5) * 5, 0xee);
+    for (int y = 0; y < 5; ++y)
+        std::copy_n(packed.begin() + y * 21, 21, padded.begin() + y * 26);
+    std::vector<uint8_t> target(size_t(4 * 3 + 2) * 3, 0xee);
+    resizeLanczos(padded.data(), 7, 5, 26, 3, target.data(), 4, 3, 14);
+
+    const std::vector<uint8_t> expected = resize(packed, 7, 5, 3, 4, 3);
+    for (int y = 0; y < 3; ++y) {
+        EXPECT_TRUE(std::equal(expected.begin() + y * 12, expected.begin() + y * 12 + 12, target.begin() + y * 14));
+        EXPECT_EQ(target[size_t(y * 14 + 12)], 0xee);
+    }
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,206 @@
+#include "lens/LensProfileLibrary.h"
+#include "lens/LensRemap.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace vep {
+namespace {
+
+LensProfile fisheye(double fov = 150.0, double k1 = 0.0)
+{
+    LensProfile profile;
+    profile.id = "test-fisheye";
+    profile.projection = LensProjection::Equidistant;
+    profile.diagonalFov = fov;
+    profile.k1 = k1;
+    return profile;
+}
+
+std::vector<uint8_t> noise(int width, int height, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> pixels(size_t(width) * size_t(height) * 4);
+    for (uint8_t &value : pixels)
+        value = uint8_t(rng());
+    return pixels;
+}
+
+// Source position of an output pixel, in pixels.
+double sourceX(const LensRemapTable::Sample &sample)
+{
+    return sample.x + sample.fx / double(1 << LensRemapTable::kFractionBits);
+}
+
+double sourceY(const LensRemapTable::Sample &sample)
+{
+    return sample.y + sample.fy / double(1 << LensRemapTable::kFractionBits);
+}
+
+TEST(LensRemap, ZeroStrengthIsIdentity)
+{
+    LensCorrectionSettings settings;
+    settings.strength = 0.0;
+    for (auto [width, height] : {std::pair{97, 30}, std::pair{320, 320}, std::pair{2, 2}}) {
+        const LensRemapTable table = buildLensRemapTable(fisheye(), width, height, settings);
+        const std::vector<uint8_t> source = noise(width, height, 1);
+        std::vector<uint8_t> target(source.size());
+        applyLensRemap(table, source.data(), width * 4, target.data(), width * 4);
+        EXPECT_EQ(target, source) << width << "x" << height;
+    }
+}
+
+TEST(LensRemap, TableIsSymmetricAndKeepsSideMiddlesInPlace)
+{
+    const int width = 161;
+    const int height = 91;
+    const LensRemapTable table = buildLensRemapTable(fisheye(), width, height);
+    ASSERT_EQ(table.samples.size(), size_t(width * height));
+    auto at = [&](int x, int y) { return table.samples[size_t(y * width + x)]; };
+
+    const auto centre = at(80, 45);
+    EXPECT_NEAR(sourceX(centre), 80.0, 1.0 / 128);
+    EXPECT_NEAR(sourceY(centre), 45.0, 1.0 / 128);
+    EXPECT_NEAR(sourceX(at(0, 45)), 0.0, 1.0 / 64);
+    EXPECT_NEAR(sourceX(at(width - 1, 45)), width - 1, 1.0 / 64);
+
+    for (int y = 0; y < height; y += 7) {
+        for (int x = 0; x < width; x += 5) {
+            const auto a = at(x, y);
+            const auto b = at(width - 1 - x, height - 1 - y);
+            ASSERT_EQ(a.x < 0, b.x < 0) << x << "," << y;
+            if (a.x < 0)
+                continue;
+            EXPECT_NEAR(sourceX(a) + sourceX(b), width - 1, 1.0 / 64) << x << "," << y;
+            EXPECT_NEAR(sourceY(a) + sourceY(b), height - 1, 1.0 / 64) << x << "," << y;
+        }
+    }
+
+    // Straightening a fisheye stretches its borders outwards; with the side
+    // middles pinned, the middle of the picture shrinks instead, so along
+    // the centre row the source moves further than the output does.
+    double previous = sourceX(centre);
+    for (int x = 81; x < width; ++x) {
+        const double current = sourceX(at(x, 45));
+        EXPECT_GT(current, previous);
+        EXPECT_GE(current - 80.0, double(x - 80) - 1e-3);
+        previous = current;
+    }
+}
+
+TEST(LensRemap, BlendMatchesReferenceBilinear)
+{
+    const int width = 200;
+    const int height = 61;
+    const LensRemapTable table = buildLensRemapTable(fisheye(170.0), width, height);
+    const std::vector<uint8_t> source = noise(width, height, 2);
+    std::vector<uint8_t> target(source.size());
+    applyLensRemap(table, source.data(), width * 4, target.data(), width * 4);
+
+    const int one = 1 << LensRemapTable::kFractionBits;
+    size_t outside = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const auto &sample = table.samples[size_t(y * width + x)];
+            const uint8_t *out = &target[size_t(y * width + x) * 4];
+            if (sample.x < 0) {
+                ++outside;
+                for (int c = 0; c < 4; ++c)
+                    ASSERT_EQ(out[c], 0);
+                continue;
+            }
+            const uint8_t *top = &source[size_t(sample.y * width + sample.x) * 4];
+            const uint8_t *bottom = top + width * 4;
+            for (int c = 0; c < 4; ++c) {
+                const int sum = top[c] * (one - sample.fx) * (one - sample.fy)
+                                + top[4 + c] * sample.fx * (one - sample.fy)
+                                + bottom[c] * (one - sample.fx) * sample.fy + bottom[4 + c] * sample.fx * sample.fy;
+                ASSERT_EQ(out[c], (sum + one * one / 2) / (one * one)) << x << "," << y << " channel " << c;
+            }
+        }
+    }
+    // The curved top and bottom borders of a straightened fisheye are empty.
+    EXPECT_GT(outside, 0u);
+}
+
+// Bisects for the x in [low, high] where the increasing `f` reaches `target`.
+template <typename F>
+double solve(F f, double target, double low, double high)
+{
+    for (int i = 0; i < 100; ++i) {
+        const double mid = 0.5 * (low + high);
+        (f(mid) < target ? low : high) = mid;
+    }
+    return 0.5 * (low + high);
+}
+
+TEST(LensRemap, DistortedLensReachesTheCornerAtHalfTheFieldOfView)
+{
+    const int width = 161;
+    const int height = 91;
+    const double halfDiagonal = 0.5 * std::hypot(double(width), double(height));
+    const double halfWidth = 0.5 * (width - 1);
+    for (double k1 : {0.25, -0.1}) {
+        const LensProfile profile = fisheye(150.0, k1);
+        const double halfFov = 0.5 * 150.0 * 3.14159265358979323846 / 180.0;
+
+        // Straight from the definitions: an equidistant lens, bent by k1,
+        // whose focal length puts the ray at halfFov on the corner.
+        auto radiusWith = [&](double focal, double theta) {
+            const double r = focal * theta;
+            return r * (1.0 + k1 * (r / halfDiagonal) * (r / halfDiagonal));
+        };
+        const double limit = k1 < 0.0 ? halfDiagonal / std::sqrt(-3.0 * k1) / halfFov : 2.0 * halfDiagonal / halfFov;
+        const double focal = solve([&](double f) { return radiusWith(f, halfFov); }, halfDiagonal, 0.0, limit);
+        auto radius = [&](double theta) { return radiusWith(focal, theta); };
+        const double edge = solve(radius, halfWidth, 0.0, halfFov);
+        const double outputFocal = halfWidth / std::tan(edge);
+
+        const LensRemapTable table = buildLensRemapTable(profile, width, height);
+        for (int x : {100, 120, 140}) {
+            const double expected = halfWidth + radius(std::atan((x - halfWidth) / outputFocal));
+            EXPECT_NEAR(sourceX(table.samples[size_t(45 * width + x)]), expected, 1.0 / 64)
+                << "k1 " << k1 << " x " << x;
+        }
+    }
+}
+
+TEST(LensRemap, RejectsImpossibleInput)
+{
+    EXPECT_THROW(buildLensRemapTable(fisheye(), 1, 100), std::runtime_error);
+    EXPECT_THROW(buildLensRemapTable(fisheye(), 40000, 100), std::runtime_error);
+    LensProfile rectilinear = fisheye(190.0);
+    rectilinear.projection = LensProjection::Rectilinear;
+    EXPECT_THROW(buildLensRemapTable(rectilinear, 100, 100), std::runtime_error);
+    // Bent back so hard that no ray reaches the corner.
+    EXPECT_THROW(buildLensRemapTable(fisheye(150.0, -0.2), 100, 100), std::runtime_error);
+}
+
+TEST(LensProfileLibrary, SharesTablesAndReplacesProfiles)
+{
+    LensProfileLibrary &library = LensProfileLibrary::instance();
+    EXPECT_THROW(library.remapTable("no-such-lens", 64, 48), std::runtime_error);
+
+    const auto first = library.remapTable("gopro-hero-wide", 64, 48);
+    EXPECT_EQ(library.remapTable("gopro-hero-wide", 64, 48), first);
+    EXPECT_NE(library.remapTable("gopro-hero-wide", 64, 36), first);
+
+    LensProfile custom = fisheye(120.0);
+    custom.id = "test-custom";
+    library.addProfile(custom);
+    const auto before = library.remapTable("test-custom", 64, 48);
+    custom.diagonalFov = 160.0;
+    library.addProfile(custom);
+    const auto after = library.remapTable("test-custom", 64, 48);
+    EXPECT_NE(after, before);
+    const size_t nearLeftEdge = 24 * 64 + 5;
+    EXPECT_NE(sourceX(after->samples[nearLeftEdge]), sourceX(before->samples[nearLeftEdge]));
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,112 @@
+#include "segmentation/MaskFile.h"
+
+#include "TestFiles.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace vep {
+namespace {
+
+// A soft-edged disc, the kind of matte background removal produces.
+std::vector<uint8_t> disc(int width, int height, double radius)
+{
+    std::vector<uint8_t> mask(size_t(width) * size_t(height));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const double distance = std::hypot(x - width / 2.0, y - height / 2.0);
+            mask[size_t(y * width + x)] = uint8_t(std::clamp((radius - distance) * 64.0, 0.0, 255.0));
+        }
+    }
+    return mask;
+}
+
+TEST(MaskCodec, RoundTripsHardSoftAndNoisyMattes)
+{
+    std::mt19937 rng(9);
+    std::vector<uint8_t> noisy(64 * 48);
+    for (uint8_t &value : noisy)
+        value = uint8_t(rng());
+    for (const auto &mask : {disc(64, 48, 20.0), std::vector<uint8_t>(64 * 48, 255), noisy}) {
+        size_t rawSize = 0;
+        const std::vector<uint8_t> packed = encodeMask(mask.data(), 64, 48, 64, &rawSize);
+        std::vector<uint8_t> unpacked(mask.size());
+        ASSERT_TRUE(decodeMask(packed.data(), packed.size(), rawSize, unpacked.data(), 64, 48, 64));
+        EXPECT_EQ(unpacked, mask);
+    }
+
+    size_t rawSize = 0;
+    const auto full = std::vector<uint8_t>(64 * 48, 255);
+    const std::vector<uint8_t> packed = encodeMask(full.data(), 64, 48, 64, &rawSize);
+    EXPECT_LT(packed.size(), size_t(64 * 4));
+    std::vector<uint8_t> unpacked(full.size());
+    EXPECT_FALSE(decodeMask(packed.data(), packed.size() / 2, rawSize, unpacked.data(), 64, 48, 64));
+}
+
+TEST(MaskFile, FramesSurviveReopening)
+{
+    test::TemporaryDirectory directory;
+    const std::string path = directory.file("clip.mask");
+    const std::vector<uint8_t> first = disc(80, 60, 25.0);
+    const std::vector<uint8_t> second = disc(80, 60, 10.0);
+    {
+        MaskFile file(path);
+        file.write(10, first.data(), 80, 60, 80);
+        file.write(3, second.data(), 80, 60, 80);
+        // A later record for a frame replaces the earlier one.
+        file.write(10, second.data(), 80, 60, 80);
+        EXPECT_EQ(file.frameCount(), 2u);
+    }
+
+    MaskFile file(path);
+    EXPECT_EQ(file.frameCount(), 2u);
+    int width = 0;
+    int height = 0;
+    ASSERT_TRUE(file.contains(10, &width, &height));
+    EXPECT_EQ(width, 80);
+    EXPECT_EQ(height, 60);
+    EXPECT_FALSE(file.contains(11));
+
+    std::vector<uint8_t> mask(80 * 60);
+    ASSERT_TRUE(file.read(10, mask.data(), 80, 60, 80));
+    EXPECT_EQ(mask, second);
+    ASSERT_TRUE(file.read(3, mask.data(), 80, 60, 80));
+    EXPECT_EQ(mask, second);
+
+    // Smaller sizes are downscaled from the stored matte; larger ones are
+    // recomputed by the caller.
+    std::vector<uint8_t> half(40 * 30);
+    EXPECT_TRUE(file.read(10, half.data(), 40, 30, 40));
+    std::vector<uint8_t> larger(160 * 120);
+    EXPECT_FALSE(file.read(10, larger.data(), 160, 120, 160));
+}
+
+TEST(MaskFile, TornTailIsCutOff)
+{
+    test::TemporaryDirectory directory;
+    const std::string path = directory.file("clip.mask");
+    const std::vector<uint8_t> mask = disc(32, 32, 12.0);
+    {
+        MaskFile file(path);
+        file.write(0, mask.data(), 32, 32, 32);
+        file.write(1, mask.data(), 32, 32, 32);
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+    MaskFile file(path);
+    EXPECT_TRUE(file.contains(0));
+    EXPECT_FALSE(file.contains(1));
+    file.write(1, mask.data(), 32, 32, 32);
+    std::vector<uint8_t> read(mask.size());
+    EXPECT_TRUE(file.read(1, read.data(), 32, 32, 32));
+    EXPECT_EQ(read, mask);
+}
+
+} // namespace
+} // namespace vep
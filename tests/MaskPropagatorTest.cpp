@@ -0,0 +1,116 @@
+#include "segmentation/MaskPropagator.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace vep {
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 360;
+constexpr double kRadius = 110.0;
+
+struct Position
+{
+    double x = 0.0;
+    double y = 0.0;
+};
+
+// A talking head: a textured disc swaying a few pixels a frame in front of
+// a textured, static background.
+Position headAt(int frame)
+{
+    return {320.0 + 8.0 * std::sin(frame * 0.13), 190.0 + 4.0 * std::sin(frame * 0.07)};
+}
+
+// RGB with an anti-aliased edge and some sensor noise.
+std::vector<uint8_t> render(Position head, std::mt19937 &rng)
+{
+    std::normal_distribution<double> grain(0.0, 2.0);
+    std::vector<uint8_t> pixels;
+    pixels.reserve(size_t(kWidth) * kHeight * 3);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            const double background = 110.0 + 40.0 * std::sin(x * 0.105) * std::cos(y * 0.085);
+            const double sx = x - head.x;
+            const double sy = y - head.y;
+            const double subject = 170.0 + 30.0 * std::sin(sx * 0.175 + sy * 0.06);
+            const double cover = std::clamp(kRadius + 0.5 - std::hypot(sx, sy), 0.0, 1.0);
+            const double grey = background * (1.0 - cover) + subject * cover;
+            for (int c = 0; c < 3; ++c)
+                pixels.push_back(uint8_t(std::clamp(std::lround(grey + grain(rng)), 0L, 255L)));
+        }
+    }
+    return pixels;
+}
+
+void drawMask(Position head, uint8_t *mask, int stride)
+{
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x)
+            mask[y * stride + x] = std::hypot(x - head.x, y - head.y) < kRadius ? 255 : 0;
+    }
+}
+
+double overlap(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+    double together = 0.0;
+    double either = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        together += a[i] > 127 && b[i] > 127;
+        either += a[i] > 127 || b[i] > 127;
+    }
+    return either > 0.0 ? together / either : 1.0;
+}
+
+TEST(MaskPropagator, SteadyShotReachesTheMaximumIntervalWithinTheDriftLimit)
+{
+    const MaskPropagationSettings settings;
+    Position head;
+    int inferred = 0;
+    MaskPropagator propagator(
+        [&](const SegmentationInput &, uint8_t *mask, int stride) {
+            drawMask(head, mask, stride);
+            ++inferred;
+        },
+        settings);
+
+    std::mt19937 rng(1);
+    std::vector<uint8_t> mask(size_t(kWidth) * kHeight);
+    std::vector<uint8_t> truth(mask.size());
+    std::vector<int> keyframes;
+    double worstDrift = 0.0;
+    for (int frame = 0; frame < 4 * settings.maxInterval; ++frame) {
+        head = headAt(frame);
+        const std::vector<uint8_t> pixels = render(head, rng);
+        SegmentationInput input;
+        input.pixels = pixels.data();
+        input.width = kWidth;
+        input.height = kHeight;
+        input.stride = kWidth * 3;
+        input.channels = 3;
+        if (propagator.process(input, mask.data(), kWidth)) {
+            keyframes.push_back(frame);
+            continue;
+        }
+        worstDrift = std::max(worstDrift, propagator.drift());
+        drawMask(head, truth.data(), kWidth);
+        EXPECT_GT(overlap(mask, truth), 0.95) << "frame " << frame;
+    }
+
+    EXPECT_EQ(inferred, int(keyframes.size()));
+    EXPECT_EQ(propagator.interval(), settings.maxInterval);
+    // The interval only grows from minInterval; once at the maximum, drift
+    // must not cut it short.
+    ASSERT_GE(keyframes.size(), 2u);
+    EXPECT_EQ(keyframes.back() - keyframes[keyframes.size() - 2], settings.maxInterval);
+    EXPECT_LT(worstDrift, settings.driftThreshold);
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,133 @@
+#include "core/MediaCache.h"
+
+#include "TestFiles.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace vep {
+namespace {
+
+TEST(MediaCache, EntriesRoundTrip)
+{
+    test::TemporaryDirectory directory;
+    MediaCache cache(directory.file("cache"));
+    const ContentHash hash = ContentHash::ofBytes("clip", 4);
+
+    EXPECT_FALSE(cache.contains(hash, "peaks"));
+    EXPECT_FALSE(cache.read(hash, "peaks"));
+
+    const std::vector<uint8_t> bytes{1, 2, 3, 0, 255};
+    cache.write(hash, "peaks", bytes);
+    EXPECT_TRUE(cache.contains(hash, "peaks"));
+    EXPECT_FALSE(cache.contains(hash, "beats"));
+    EXPECT_EQ(cache.read(hash, "peaks"), bytes);
+
+    const std::string hex = hash.hex();
+    EXPECT_EQ(std::filesystem::path(cache.entryPath(hash, "peaks")),
+              std::filesystem::path(directory.file("cache")) / hex.substr(0, 2) / (hex + ".peaks"));
+
+    cache.write(hash, "peaks", {9});
+    EXPECT_EQ(cache.read(hash, "peaks"), std::vector<uint8_t>{9});
+    cache.remove(hash, "peaks");
+    EXPECT_FALSE(cache.contains(hash, "peaks"));
+}
+
+TEST(MediaCache, HashFollowsContentNotPath)
+{
+    test::TemporaryDirectory directory;
+    MediaCache cache(directory.file("cache"));
+    test::writeFile(directory.file("a.wav"), "same bytes");
+    test::writeFile(directory.file("b.wav"), "same bytes");
+    test::writeFile(directory.file("c.wav"), "other bytes");
+
+    const ContentHash a = cache.hashOf(directory.file("a.wav"));
+    EXPECT_EQ(a, ContentHash::ofBytes("same bytes", 10));
+    EXPECT_EQ(cache.hashOf(directory.file("b.wav")), a);
+    EXPECT_NE(cache.hashOf(directory.file("c.wav")), a);
+    EXPECT_THROW(cache.hashOf(directory.file("missing.wav")), std::runtime_error);
+}
+
+TEST(MediaCache, MemoisedHashIsRefreshedWhenTheFileChanges)
+{
+    test::TemporaryDirectory directory;
+    const std::string media = directory.file("clip.wav");
+    test::writeFile(media, "first take");
+    {
+        MediaCache cache(directory.file("cache"));
+        EXPECT_EQ(cache.hashOf(media), ContentHash::ofBytes("first take", 10));
+    }
+    // A second instance reads the memo written by the first.
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(directory.file("cache")) / "hashes.tsv"));
+
+    test::writeFile(media, "second take!");
+    std::filesystem::last_write_time(media, std::filesystem::last_write_time(media) + std::chrono::seconds(5));
+    MediaCache cache(directory.file("cache"));
+    EXPECT_EQ(cache.hashOf(media), ContentHash::ofBytes("second take!", 12));
+}
+
+TEST(MediaCache, KnownHashNeedsAnUnchangedFileHashedBefore)
+{
+    test::TemporaryDirectory directory;
+    const std::string media = directory.file("clip.mov");
+    test::writeFile(media, "frames");
+    MediaCache cache(directory.file("cache"));
+
+    EXPECT_FALSE(cache.knownHashOf(media));
+    EXPECT_FALSE(cache.knownHashOf(directory.file("missing.mov")));
+    const ContentHash hash = cache.hashOf(media);
+    EXPECT_EQ(cache.knownHashOf(media), hash);
+
+    test::writeFile(media, "edited frames");
+    std::filesystem::last_write_time(media, std::filesystem::last_write_time(media) + std::chrono::seconds(5));
+    EXPECT_FALSE(cache.knownHashOf(media));
+}
+
+TEST(MediaCache, MemoIsCompactedWhenMostOfItIsSuperseded)
+{
+    test::TemporaryDirectory directory;
+    const std::string media = directory.file("clip.wav");
+    const std::string gone = directory.file("deleted.wav");
+    MediaCache cache(directory.file("cache"));
+    test::writeFile(gone, "deleted");
+    cache.hashOf(gone);
+    std::filesystem::remove(gone);
+
+    const auto start = std::filesystem::file_time_type::clock::now();
+    std::string contents;
+    for (int take = 0; take < 400; ++take) {
+        contents = "take " + std::to_string(take);
+        test::writeFile(media, contents);
+        std::filesystem::last_write_time(media, start + std::chrono::seconds(take));
+        cache.hashOf(media);
+    }
+
+    std::ifstream memo(std::filesystem::path(directory.file("cache")) / "hashes.tsv");
+    int lines = 0;
+    for (std::string line; std::getline(memo, line);)
+        ++lines;
+    EXPECT_LT(lines, 300);
+
+    MediaCache reopened(directory.file("cache"));
+    EXPECT_EQ(reopened.knownHashOf(media), ContentHash::ofBytes(contents.data(), contents.size()));
+}
+
+TEST(MediaCache, CancelledHashIsNullAndNotMemoised)
+{
+    test::TemporaryDirectory directory;
+    const std::string media = directory.file("clip.mov");
+    test::writeFile(media, "frames");
+    MediaCache cache(directory.file("cache"));
+
+    EXPECT_TRUE(cache.hashOf(media, [] { return false; }).isNull());
+    EXPECT_FALSE(cache.knownHashOf(media));
+    EXPECT_EQ(cache.hashOf(media, [] { return true; }), ContentHash::ofBytes("frames", 6));
+}
+
+} // namespace
+} // namespace vep
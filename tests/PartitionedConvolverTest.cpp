@@ -0,0 +1,81 @@
+#include "audio/PartitionedConvolver.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace vep {
+namespace {
+
+class PartitionedConvolverTest : public ::testing::TestWithParam<std::tuple<int, int>>
+{
+};
+
+// Against the textbook sum, on IRs that stop in the head stage, in the
+// first tail stage and several stages in, fed in uneven blocks.
+TEST_P(PartitionedConvolverTest, MatchesDirectConvolution)
+{
+    const auto [length, headBlock] = GetParam();
+    std::mt19937 rng(uint32_t(length * 31 + headBlock));
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    std::vector<std::vector<float>> irs(2, std::vector<float>(size_t(length)));
+    for (auto &ir : irs) {
+        for (size_t i = 0; i < ir.size(); ++i)
+            ir[i] = uniform(rng) * std::exp(-float(i) / float(length)) * 0.05f;
+    }
+    const int frames = std::max(20000, 3 * length);
+    std::vector<float> input(static_cast<size_t>(frames));
+    for (float &sample : input)
+        sample = uniform(rng);
+
+    PartitionedConvolver convolver(irs, headBlock, 4);
+    ASSERT_EQ(convolver.outputCount(), 2);
+    std::vector<float> left(static_cast<size_t>(frames));
+    std::vector<float> right(static_cast<size_t>(frames));
+    for (int done = 0, block = 37; done < frames; done += block, block = block * 7 % 1001 + 1) {
+        block = std::min(block, frames - done);
+        float *outputs[2] = {left.data() + done, right.data() + done};
+        convolver.process(input.data() + done, 1, outputs, 1, block);
+    }
+
+    const int latency = convolver.latency();
+    EXPECT_EQ(latency, headBlock);
+    for (int t = latency; t < frames; t += 13) {
+        const int n = t - latency;
+        double expectLeft = 0.0;
+        double expectRight = 0.0;
+        for (int k = 0; k < length && k <= n; ++k) {
+            expectLeft += double(irs[0][size_t(k)]) * input[size_t(n - k)];
+            expectRight += double(irs[1][size_t(k)]) * input[size_t(n - k)];
+        }
+        ASSERT_NEAR(left[size_t(t)], expectLeft, 2e-4) << "sample " << t;
+        ASSERT_NEAR(right[size_t(t)], expectRight, 2e-4) << "sample " << t;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Lengths, PartitionedConvolverTest,
+                         ::testing::Combine(::testing::Values(100, 1500, 30000), ::testing::Values(64, 256)));
+
+TEST(PartitionedConvolver, ResetClearsTheTail)
+{
+    std::vector<std::vector<float>> irs{std::vector<float>(4000, 0.01f)};
+    PartitionedConvolver convolver(irs, 64, 4);
+    std::vector<float> input(8000, 1.0f);
+    std::vector<float> output(8000);
+    float *outputs[1] = {output.data()};
+    convolver.process(input.data(), 1, outputs, 1, 8000);
+    convolver.reset();
+
+    std::fill(input.begin(), input.end(), 0.0f);
+    convolver.process(input.data(), 1, outputs, 1, 8000);
+    for (float sample : output)
+        ASSERT_EQ(sample, 0.0f);
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,120 @@
+#include "audio/PeakFile.h"
+
+#include "TestFiles.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vep {
+namespace {
+
+constexpr int kFrames = 100000;
+constexpr int kSpikeFrame = 70000;
+
+// Stereo: the left channel alternates +-0.5 every frame, the right one is
+// silent but for a single 0.9 spike.
+std::vector<float> testSignal()
+{
+    std::vector<float> samples(size_t(kFrames) * 2, 0.0f);
+    for (int i = 0; i < kFrames; ++i)
+        samples[size_t(i) * 2] = (i % 2) ? -0.5f : 0.5f;
+    samples[size_t(kSpikeFrame) * 2 + 1] = 0.9f;
+    return samples;
+}
+
+std::string writePeaks(const test::TemporaryDirectory &directory, const std::vector<uint8_t> &bytes)
+{
+    const std::string path = directory.file("clip.peaks");
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(bytes.data()), std::streamsize(bytes.size()));
+    return path;
+}
+
+std::vector<uint8_t> buildPeaks()
+{
+    const std::vector<float> samples = testSignal();
+    PeakBuilder builder(48000, 2);
+    // Blocks that do not line up with the bins.
+    for (int frame = 0; frame < kFrames;) {
+        const int frames = std::min(997, kFrames - frame);
+        builder.process(samples.data() + size_t(frame) * 2, frames);
+        frame += frames;
+    }
+    return builder.finish();
+}
+
+TEST(PeakFile, RoundTripsThePyramid)
+{
+    test::TemporaryDirectory directory;
+    const PeakFile peaks(writePeaks(directory, buildPeaks()));
+
+    EXPECT_EQ(peaks.sampleRate(), 48000);
+    EXPECT_EQ(peaks.channels(), 2);
+    EXPECT_EQ(peaks.frames(), uint64_t(kFrames));
+
+    // 782 base bins, merged by four until at most 16 are left.
+    ASSERT_EQ(peaks.levelCount(), 4);
+    const uint64_t binCounts[] = {782, 196, 49, 13};
+    for (int level = 0; level < peaks.levelCount(); ++level) {
+        EXPECT_EQ(peaks.level(level).framesPerBin, uint64_t(PeakBuilder::kBaseFrames) << (2 * level));
+        EXPECT_EQ(peaks.level(level).binCount, binCounts[level]);
+    }
+
+    const PeakBin left = peaks.level(0).at(0, 0, 2);
+    EXPECT_EQ(left.min, -16384);
+    EXPECT_EQ(left.max, 16384);
+    EXPECT_EQ(left.rms, 16384);
+    const PeakBin right = peaks.level(0).at(0, 1, 2);
+    EXPECT_EQ(right.min, 0);
+    EXPECT_EQ(right.max, 0);
+}
+
+TEST(PeakFile, EveryLevelKeepsTheSpike)
+{
+    test::TemporaryDirectory directory;
+    const PeakFile peaks(writePeaks(directory, buildPeaks()));
+
+    for (int level = 0; level < peaks.levelCount(); ++level) {
+        EXPECT_EQ(peaks.summarize(level, 1, 0.0, kFrames).max, 29490) << "level " << level;
+        EXPECT_EQ(peaks.summarize(level, 0, 0.0, kFrames).min, -16384) << "level " << level;
+    }
+    EXPECT_EQ(peaks.summarize(0, 1, kSpikeFrame - 10, kSpikeFrame + 10).max, 29490);
+    EXPECT_EQ(peaks.summarize(0, 1, 0.0, 69000.0).max, 0);
+    // A range narrower than a bin still reads the bin under it.
+    EXPECT_EQ(peaks.summarize(0, 1, kSpikeFrame, kSpikeFrame).max, 29490);
+}
+
+TEST(PeakFile, PicksTheCoarsestLevelWithABinPerPixel)
+{
+    test::TemporaryDirectory directory;
+    const PeakFile peaks(writePeaks(directory, buildPeaks()));
+
+    EXPECT_EQ(peaks.levelFor(1.0), 0);
+    EXPECT_EQ(peaks.levelFor(511.0), 0);
+    EXPECT_EQ(peaks.levelFor(512.0), 1);
+    EXPECT_EQ(peaks.levelFor(5000.0), 2);
+    EXPECT_EQ(peaks.levelFor(1e9), 3);
+}
+
+TEST(PeakFile, RejectsDamagedFiles)
+{
+    test::TemporaryDirectory directory;
+    std::vector<uint8_t> bytes = buildPeaks();
+
+    EXPECT_THROW(PeakFile(directory.file("missing.peaks")), std::runtime_error);
+
+    std::vector<uint8_t> truncated(bytes.begin(), bytes.end() - 64);
+    EXPECT_THROW(PeakFile(writePeaks(directory, truncated)), std::runtime_error);
+
+    bytes[0] = 'X';
+    EXPECT_THROW(PeakFile(writePeaks(directory, bytes)), std::runtime_error);
+}
+
+} // namespace
+} // namespace vep
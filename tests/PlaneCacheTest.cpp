@@ -0,0 +1,118 @@
+#include "tracking/PlaneCache.h"
+
+#include "core/MediaCache.h"
+
+#include "TestFiles.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vep {
+namespace {
+
+PlaneTrack samplePlane(int id, int64_t referenceFrame, int frames)
+{
+    PlaneTrack plane;
+    plane.id = id;
+    plane.label = "screen " + std::to_string(id);
+    plane.status = TrackStatus::Lost;
+    plane.error = "covered by a hand";
+    plane.fps = 25.0;
+    plane.width = 1920;
+    plane.height = 1080;
+    plane.referenceFrame = referenceFrame;
+    plane.quad = {PlanePoint{100.5f, 200.25f}, PlanePoint{900.0f, 210.0f}, PlanePoint{880.75f, 700.0f},
+                  PlanePoint{120.0f, 690.5f}};
+    plane.framesPerSecond = 140.0;
+    for (int i = 0; i < frames; ++i) {
+        PlaneSample sample;
+        sample.frame = referenceFrame + i;
+        sample.found = i % 11 != 4;
+        sample.homography = {1.0f + 0.001f * float(i), 0.02f, 3.5f * float(i), -0.01f, 0.998f, -1.25f * float(i),
+                             1e-6f * float(i), -2e-6f, 1.0f};
+        plane.samples.push_back(sample);
+    }
+    return plane;
+}
+
+void expectSamePlane(const PlaneTrack &actual, const PlaneTrack &expected)
+{
+    EXPECT_EQ(actual.label, expected.label);
+    EXPECT_EQ(actual.status, expected.status);
+    EXPECT_EQ(actual.error, expected.error);
+    EXPECT_EQ(actual.fps, expected.fps);
+    EXPECT_EQ(actual.width, expected.width);
+    EXPECT_EQ(actual.height, expected.height);
+    EXPECT_EQ(actual.referenceFrame, expected.referenceFrame);
+    for (size_t c = 0; c < expected.quad.size(); ++c) {
+        EXPECT_EQ(actual.quad[c].x, expected.quad[c].x);
+        EXPECT_EQ(actual.quad[c].y, expected.quad[c].y);
+    }
+    ASSERT_EQ(actual.samples.size(), expected.samples.size());
+    for (size_t i = 0; i < actual.samples.size(); ++i) {
+        EXPECT_EQ(actual.samples[i].frame, expected.samples[i].frame);
+        EXPECT_EQ(actual.samples[i].found, expected.samples[i].found);
+        EXPECT_EQ(actual.samples[i].homography, expected.samples[i].homography);
+    }
+}
+
+TEST(CachedPlanes, SerializeRoundTrip)
+{
+    CachedPlanes planes;
+    planes.put(samplePlane(1, 0, 120));
+    planes.put(samplePlane(5, 300, 40));
+    PlaneTrack empty;
+    empty.id = 2;
+    planes.put(empty);
+
+    const std::vector<uint8_t> bytes = planes.serialize();
+    // 33 bytes a sample, plus a header per plane.
+    EXPECT_LT(bytes.size(), size_t(160 * 33 + 3 * 200));
+
+    const CachedPlanes loaded = CachedPlanes::deserialize(bytes);
+    ASSERT_EQ(loaded.planes.size(), 3u);
+    for (const PlaneTrack &expected : planes.planes) {
+        const PlaneTrack *actual = loaded.find(expected.id);
+        ASSERT_NE(actual, nullptr);
+        expectSamePlane(*actual, expected);
+        // Only what the track was, not how fast it was tracked.
+        EXPECT_EQ(actual->framesPerSecond, 0.0);
+    }
+}
+
+TEST(CachedPlanes, RejectsDamagedRecords)
+{
+    CachedPlanes planes;
+    planes.put(samplePlane(1, 0, 20));
+    std::vector<uint8_t> bytes = planes.serialize();
+    bytes.resize(bytes.size() / 2);
+    EXPECT_THROW(CachedPlanes::deserialize(bytes), std::runtime_error);
+    EXPECT_THROW(CachedPlanes::deserialize({'n', 'o', 'p', 'e'}), std::runtime_error);
+}
+
+TEST(PlaneCache, StoresPerMediaContent)
+{
+    test::TemporaryDirectory directory;
+    MediaCache media(directory.file("cache"));
+    PlaneCache cache(media);
+    test::writeFile(directory.file("a.mp4"), "video a");
+    test::writeFile(directory.file("copy of a.mp4"), "video a");
+    test::writeFile(directory.file("b.mp4"), "video b");
+
+    EXPECT_TRUE(cache.load(directory.file("a.mp4")).planes.empty());
+    CachedPlanes planes;
+    planes.put(samplePlane(3, 12, 30));
+    cache.store(directory.file("a.mp4"), planes);
+
+    const CachedPlanes copy = cache.load(directory.file("copy of a.mp4"));
+    ASSERT_EQ(copy.planes.size(), 1u);
+    expectSamePlane(copy.planes[0], planes.planes[0]);
+    EXPECT_TRUE(cache.load(directory.file("b.mp4")).planes.empty());
+    EXPECT_THROW(cache.load(directory.file("missing.mp4")), std::runtime_error);
+}
+
+} // namespace
+} // namespace vep
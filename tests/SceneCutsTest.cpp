@@ -0,0 +1,63 @@
+#include "media/SceneCuts.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace vep {
+namespace {
+
+SceneCuts quietScores(size_t frames, double fps = 25.0)
+{
+    SceneCuts cuts;
+    cuts.fps = fps;
+    cuts.scores.assign(frames, 0.02f);
+    cuts.scores[0] = 0.0f;
+    return cuts;
+}
+
+TEST(DetectCuts, FindsIsolatedPeaks)
+{
+    SceneCuts cuts = quietScores(300);
+    cuts.scores[50] = 0.9f;
+    cuts.scores[130] = 0.6f;
+    cuts.scores[200] = 0.35f;
+    EXPECT_EQ(detectCuts(cuts, 0.5), (std::vector<int64_t>{50, 130, 200}));
+    // A soft change counts only at high sensitivity.
+    EXPECT_EQ(detectCuts(cuts, 0.0), (std::vector<int64_t>{50, 130}));
+}
+
+TEST(DetectCuts, IgnoresSustainedMotion)
+{
+    SceneCuts cuts = quietScores(300);
+    // A fast pan: every frame differs a lot from the one before.
+    for (size_t i = 100; i < 160; ++i)
+        cuts.scores[i] = 0.5f + 0.05f * float(i % 3);
+    cuts.scores[250] = 0.8f;
+    EXPECT_EQ(detectCuts(cuts, 0.5), (std::vector<int64_t>{250}));
+}
+
+TEST(DetectCuts, MergesShotsShorterThanHalfASecond)
+{
+    SceneCuts cuts = quietScores(300, 25.0);
+    // A flash: two changes five frames apart; the stronger stands.
+    cuts.scores[100] = 0.6f;
+    cuts.scores[105] = 0.9f;
+    cuts.scores[200] = 0.9f;
+    cuts.scores[220] = 0.8f;
+    EXPECT_EQ(detectCuts(cuts, 0.5), (std::vector<int64_t>{105, 200, 220}));
+}
+
+TEST(SceneCuts, SerializeRoundTrip)
+{
+    SceneCuts cuts = quietScores(1000, 29.97);
+    cuts.scores[10] = 0.75f;
+    const SceneCuts loaded = SceneCuts::deserialize(cuts.serialize());
+    EXPECT_EQ(loaded.fps, cuts.fps);
+    EXPECT_EQ(loaded.scores, cuts.scores);
+    EXPECT_THROW(SceneCuts::deserialize({1, 2, 3}), std::runtime_error);
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,186 @@
+#include "workers/SharedFrameRing.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vep {
+namespace {
+
+using State = SharedFrameRing::SlotState;
+
+TEST(SharedFrameRing, HandsOutEverySlotOnce)
+{
+    SharedFrameRing ring(3, 100, 48, 4);
+    EXPECT_EQ(ring.slotCount(), 3);
+    EXPECT_FALSE(ring.name().empty());
+
+    std::vector<SharedFrameRing::Slot> slots;
+    while (std::optional<SharedFrameRing::Slot> slot = ring.acquire())
+        slots.push_back(*slot);
+    ASSERT_EQ(slots.size(), 3u);
+
+    for (const SharedFrameRing::Slot &slot : slots) {
+        EXPECT_EQ(ring.state(slot.index), State::Writing);
+        // Rows start on cache lines and hold a full row of RGBA.
+        EXPECT_EQ(slot.stride % 64, 0);
+        EXPECT_GE(slot.stride, 400);
+        EXPECT_EQ(slot.maskStride % 64, 0);
+        EXPECT_GE(slot.maskStride, 100);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(slot.pixels) % 64, 0u);
+        // The mask follows the pixels of the same slot.
+        EXPECT_GE(slot.mask, slot.pixels + size_t(slot.stride) * 48);
+    }
+    for (size_t i = 1; i < slots.size(); ++i)
+        EXPECT_GE(slots[i].pixels, slots[i - 1].mask + size_t(slots[i - 1].maskStride) * 48);
+}
+
+TEST(SharedFrameRing, QueuedSlotsComeBackFreeOnRelease)
+{
+    SharedFrameRing ring(2, 64, 64, 3);
+    const std::optional<SharedFrameRing::Slot> slot = ring.acquire();
+    ASSERT_TRUE(slot);
+
+    ring.queue(slot->index, 32, 20, 1234);
+    EXPECT_EQ(ring.state(slot->index), State::Queued);
+    EXPECT_EQ(ring.frame(slot->index), 1234);
+    EXPECT_EQ(ring.width(slot->index), 32);
+    EXPECT_EQ(ring.height(slot->index), 20);
+
+    ASSERT_TRUE(ring.acquire());
+    EXPECT_FALSE(ring.acquire());
+    ring.release(slot->index);
+    EXPECT_EQ(ring.state(slot->index), State::Free);
+    EXPECT_EQ(ring.frame(slot->index), -1);
+    const std::optional<SharedFrameRing::Slot> again = ring.acquire();
+    ASSERT_TRUE(again);
+    EXPECT_EQ(again->index, slot->index);
+
+    ring.releaseAll();
+    EXPECT_EQ(ring.state(0), State::Free);
+    EXPECT_EQ(ring.state(1), State::Free);
+}
+
+TEST(SharedFrameRing, RejectsBadGeometryAndSlots)
+{
+    EXPECT_THROW(SharedFrameRing(0, 64, 64), std::runtime_error);
+    EXPECT_THROW(SharedFrameRing(2, 64, 64, 1), std::runtime_error);
+
+    SharedFrameRing ring(1, 64, 32, 4);
+    const std::optional<SharedFrameRing::Slot> slot = ring.acquire();
+    ASSERT_TRUE(slot);
+    EXPECT_THROW(ring.queue(slot->index, 65, 32, 0), std::runtime_error);
+    EXPECT_THROW(ring.queue(slot->index, 64, 0, 0), std::runtime_error);
+    EXPECT_THROW(ring.state(1), std::out_of_range);
+    EXPECT_THROW(ring.release(-1), std::out_of_range);
+}
+
+#ifndef _WIN32
+
+// Maps the ring the way python/vep_frames.py does, by name.
+class WorkerView
+{
+public:
+    explicit WorkerView(const std::string &name)
+    {
+        const int fd = ::shm_open(("/" + name).c_str(), O_RDWR, 0);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (::fstat(fd, &info) == 0) {
+            m_size = size_t(info.st_size);
+            void *mapping = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED)
+                m_base = static_cast<uint8_t *>(mapping);
+        }
+        ::close(fd);
+    }
+    ~WorkerView()
+    {
+        if (m_base)
+            ::munmap(m_base, m_size);
+    }
+
+    bool isOpen() const { return m_base != nullptr; }
+    template <typename T>
+    T get(size_t offset) const
+    {
+        T value;
+        std::memcpy(&value, m_base + offset, sizeof(T));
+        return value;
+    }
+    template <typename T>
+    void set(size_t offset, T value)
+    {
+        std::memcpy(m_base + offset, &value, sizeof(T));
+    }
+    uint8_t *at(size_t offset) { return m_base + offset; }
+
+private:
+    uint8_t *m_base = nullptr;
+    size_t m_size = 0;
+};
+
+// Descriptor fields, as vep_frames.py unpacks them.
+constexpr size_t kDescriptor = 64;
+constexpr size_t kWidth = 4;
+constexpr size_t kFrame = 24;
+constexpr size_t kPixelOffset = 32;
+constexpr size_t kMaskOffset = 40;
+
+TEST(SharedFrameRing, WorkerSeesTheSamePages)
+{
+    SharedFrameRing ring(2, 16, 8, 4);
+    WorkerView worker(ring.name());
+    ASSERT_TRUE(worker.isOpen());
+    EXPECT_EQ(std::memcmp(worker.at(0), "VEPRING1", 8), 0);
+    EXPECT_EQ(worker.get<uint32_t>(12), 2u);
+    EXPECT_EQ(worker.get<uint32_t>(16), 16u);
+
+    const std::optional<SharedFrameRing::Slot> slot = ring.acquire();
+    ASSERT_TRUE(slot);
+    slot->pixels[0] = 200;
+    slot->pixels[slot->stride + 3] = 17;
+    ring.queue(slot->index, 16, 8, 42);
+
+    const size_t descriptor = 64 + kDescriptor * size_t(slot->index);
+    EXPECT_EQ(worker.get<uint32_t>(descriptor), uint32_t(State::Queued));
+    EXPECT_EQ(worker.get<uint32_t>(descriptor + kWidth), 16u);
+    EXPECT_EQ(worker.get<int64_t>(descriptor + kFrame), 42);
+    const uint64_t pixels = worker.get<uint64_t>(descriptor + kPixelOffset);
+    EXPECT_EQ(worker.at(pixels)[0], 200);
+    EXPECT_EQ(worker.at(pixels)[size_t(slot->stride) + 3], 17);
+
+    // The worker writes the mask and marks the slot Done.
+    worker.at(worker.get<uint64_t>(descriptor + kMaskOffset))[5] = 255;
+    worker.set<uint32_t>(descriptor, uint32_t(State::Done));
+    EXPECT_EQ(ring.state(slot->index), State::Done);
+    EXPECT_EQ(slot->mask[5], 255);
+}
+
+TEST(SharedFrameRing, RegionIsUnlinkedWithTheRing)
+{
+    std::string name;
+    {
+        SharedFrameRing ring(1, 8, 8);
+        name = ring.name();
+    }
+    EXPECT_FALSE(WorkerView(name).isOpen());
+}
+
+#endif
+
+} // namespace
+} // namespace vep
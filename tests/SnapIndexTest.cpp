@@ -0,0 +1,179 @@
+#include "timeline/SnapIndex.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace vep {
+namespace {
+
+SnapIndex::Query at(double time, double pixelsPerSecond = 100.0)
+{
+    SnapIndex::Query query;
+    query.time = time;
+    query.pixelsPerSecond = pixelsPerSecond;
+    query.thresholdPixels = 8.0;
+    return query;
+}
+
+TEST(SnapIndex, FindsNearestPointWithinThreshold)
+{
+    SnapIndex index;
+    index.setPoints(1, SnapKind::ClipEdge, {0.0, 10.0});
+    index.setPoints(SnapIndex::kNoOwner - 1, SnapKind::Marker, {4.0, 7.5});
+
+    // 8 px at 100 px/s is 0.08 s.
+    auto hit = index.nearest(at(7.45));
+    ASSERT_TRUE(hit);
+    EXPECT_DOUBLE_EQ(hit->time, 7.5);
+    EXPECT_EQ(hit->kind, SnapKind::Marker);
+    EXPECT_FALSE(index.nearest(at(7.3)));
+    // The same distance on screen is a longer time when zoomed out.
+    EXPECT_TRUE(index.nearest(at(7.3, 20.0)));
+}
+
+TEST(SnapIndex, SkipsExcludedOwnerAndUnwantedKinds)
+{
+    SnapIndex index;
+    index.setClip(1, 0.0, 0.0, 5.0, {});
+    index.setClip(2, 5.02, 0.0, 5.0, {});
+    index.setPoints(9, SnapKind::Marker, {5.01});
+
+    auto query = at(5.0);
+    query.excludeOwner = 1;
+    auto hit = index.nearest(query);
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit->owner, 9u);
+
+    query.kinds = snapMask(SnapKind::ClipEdge);
+    hit = index.nearest(query);
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit->owner, 2u);
+}
+
+TEST(SnapIndex, TiesPreferClipEdgesOverBeats)
+{
+    SnapIndex index;
+    index.setPoints(1, SnapKind::Beat, {2.0});
+    index.setPoints(2, SnapKind::ClipEdge, {2.0});
+    auto hit = index.nearest(at(2.01));
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit->kind, SnapKind::ClipEdge);
+}
+
+TEST(SnapIndex, SetClipReplacesTheClipsPoints)
+{
+    SnapIndex index;
+    const std::vector<double> beats{0.5, 1.0, 1.5, 2.0, 2.5, 3.0};
+    index.setClip(1, 10.0, 1.0, 2.6, beats);
+    // Edges at 10 and 11.6, beats 1.0..2.5 of the source moved to 10..11.5.
+    auto points = index.pointsIn(0.0, 100.0);
+    ASSERT_EQ(points.size(), 6u);
+    EXPECT_DOUBLE_EQ(points.front().time, 10.0);
+    EXPECT_DOUBLE_EQ(points.back().time, 11.6);
+
+    index.setClip(1, 20.0, 1.0, 2.6, beats);
+    EXPECT_TRUE(index.pointsIn(0.0, 19.0).empty());
+    EXPECT_EQ(index.pointsIn(19.0, 30.0).size(), 6u);
+
+    index.removeOwner(1);
+    EXPECT_EQ(index.size(), 0u);
+}
+
+TEST(SnapIndex, ZoomedOutLevelsThinBeatsButKeepEdges)
+{
+    SnapIndex index;
+    std::vector<double> beats;
+    for (int i = 0; i < 600; ++i)
+        beats.push_back(i * 0.5);
+    index.setClip(1, 0.0, 0.0, 300.0, beats);
+    index.setPoints(2, SnapKind::Marker, {100.25});
+
+    // At 2 px/s, beats half a second apart are a pixel apart.
+    const auto coarse = index.pointsIn(0.0, 300.0, 2.0);
+    size_t coarseBeats = 0;
+    for (size_t i = 0; i < coarse.size(); ++i) {
+        if (coarse[i].kind != SnapKind::Beat)
+            continue;
+        ++coarseBeats;
+    }
+    EXPECT_LT(coarseBeats, beats.size() / 2);
+    EXPECT_EQ(index.pointsIn(0.0, 300.0, 2.0, snapMask(SnapKind::ClipEdge)).size(), 2u);
+    EXPECT_EQ(index.pointsIn(0.0, 300.0, 2.0, snapMask(SnapKind::Marker)).size(), 1u);
+    EXPECT_EQ(index.pointsIn(0.0, 300.0, 0.0, snapMask(SnapKind::Beat)).size(), beats.size());
+}
+
+TEST(SnapIndex, ThinningNeverHidesAnotherClipsBeats)
+{
+    SnapIndex index;
+    // Two clips with beats a few milliseconds apart: at 2 px/s they are
+    // one pixel apart, and thinning across clips would keep only one.
+    std::vector<double> beats;
+    for (int i = 0; i < 100; ++i)
+        beats.push_back(i * 1.0);
+    index.setClip(1, 0.0, 0.0, 100.0, beats);
+    index.setClip(2, 0.005, 0.0, 100.0, beats);
+
+    auto query = at(50.2, 2.0);
+    query.kinds = snapMask(SnapKind::Beat);
+    for (uint64_t dragged : {1u, 2u}) {
+        query.excludeOwner = dragged;
+        const auto hit = index.nearest(query);
+        ASSERT_TRUE(hit);
+        EXPECT_EQ(hit->owner, 3u - dragged);
+    }
+}
+
+TEST(SnapIndex, EditsMatchAFreshIndexAtEveryLevel)
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> position(0.0, 60.0);
+    std::vector<std::vector<double>> beats(5);
+    for (auto &clip : beats) {
+        for (int i = 0; i < 200; ++i)
+            clip.push_back(i * 0.25 + position(rng) * 1e-3);
+    }
+    std::vector<double> starts(beats.size(), 0.0);
+
+    SnapIndex edited;
+    const double scales[] = {0.0, 1.0, 10.0, 60.0, 500.0};
+    for (size_t clip = 0; clip < beats.size(); ++clip)
+        edited.setClip(clip, starts[clip], 0.0, 50.0, beats[clip]);
+    for (double scale : scales)
+        edited.pointsIn(0.0, 200.0, scale);
+    for (int step = 0; step < 40; ++step) {
+        const size_t clip = size_t(rng() % beats.size());
+        starts[clip] = position(rng);
+        edited.setClip(clip, starts[clip], 0.0, 50.0, beats[clip]);
+        if (step % 10 == 9)
+            edited.setPoints(SnapIndex::kNoOwner - 1, SnapKind::Marker, {position(rng), position(rng)});
+    }
+    edited.removeOwner(3);
+
+    SnapIndex fresh;
+    for (size_t clip = 0; clip < beats.size(); ++clip) {
+        if (clip != 3)
+            fresh.setClip(clip, starts[clip], 0.0, 50.0, beats[clip]);
+    }
+    const auto markers = edited.pointsIn(0.0, 200.0, 0.0, snapMask(SnapKind::Marker));
+    std::vector<double> markerTimes;
+    for (const SnapPoint &marker : markers)
+        markerTimes.push_back(marker.time);
+    fresh.setPoints(SnapIndex::kNoOwner - 1, SnapKind::Marker, markerTimes);
+
+    ASSERT_EQ(edited.size(), fresh.size());
+    for (double scale : scales) {
+        const auto a = edited.pointsIn(0.0, 200.0, scale);
+        const auto b = fresh.pointsIn(0.0, 200.0, scale);
+        ASSERT_EQ(a.size(), b.size()) << "scale " << scale;
+        for (size_t i = 0; i < a.size(); ++i) {
+            EXPECT_EQ(a[i].time, b[i].time);
+            EXPECT_EQ(a[i].owner, b[i].owner);
+            EXPECT_EQ(a[i].kind, b[i].kind);
+        }
+    }
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,120 @@
+#include "core/SpanRunner.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace vep {
+namespace {
+
+// Analyses a "stream" of `frames` frames whose value is the frame index.
+struct IndexStream
+{
+    int64_t frames;
+    // Frames [brokenFrom, brokenTo) do not decode.
+    int64_t brokenFrom = -1;
+    int64_t brokenTo = -1;
+
+    std::vector<int64_t> operator()(int64_t begin, int64_t end, std::atomic<int64_t> &done,
+                                    const std::atomic<bool> &cancel) const
+    {
+        std::vector<int64_t> values;
+        for (int64_t i = begin; (end < 0 || i < end) && i < frames && !cancel; ++i) {
+            // A run of frames that will not decode ends the span there.
+            if (i >= brokenFrom && i < brokenTo)
+                break;
+            values.push_back(i);
+            ++done;
+        }
+        return values;
+    }
+};
+
+TEST(SpanRunner, ConcatenatesSpansInFrameOrder)
+{
+    ThreadPool pool(4);
+    const auto values = runSpans<int64_t>(pool, 1000, 100, {}, IndexStream{1000});
+    ASSERT_TRUE(values);
+    ASSERT_EQ(values->size(), 1000u);
+    for (int64_t i = 0; i < 1000; ++i)
+        EXPECT_EQ((*values)[size_t(i)], i);
+}
+
+TEST(SpanRunner, LastSpanRunsToTheRealEndOfTheStream)
+{
+    ThreadPool pool(4);
+    // The container claims 1000 frames; the stream has 1030.
+    const auto longer = runSpans<int64_t>(pool, 1000, 100, {}, IndexStream{1030});
+    ASSERT_TRUE(longer);
+    EXPECT_EQ(longer->size(), 1030u);
+
+    // And here only 900.
+    const auto shorter = runSpans<int64_t>(pool, 1000, 100, {}, IndexStream{900});
+    ASSERT_TRUE(shorter);
+    EXPECT_EQ(shorter->size(), 900u);
+    EXPECT_EQ(shorter->back(), 899);
+}
+
+TEST(SpanRunner, ShortSpansArePaddedSoLaterValuesKeepTheirFrames)
+{
+    ThreadPool pool(4);
+    // Four spans of 250; frames 300 to 399 fail, cutting the second short.
+    const auto values = runSpans<int64_t>(pool, 1000, 100, {}, IndexStream{1000, 300, 400});
+    ASSERT_TRUE(values);
+    ASSERT_EQ(values->size(), 1000u);
+    EXPECT_EQ((*values)[299], 299);
+    EXPECT_EQ((*values)[300], 0);
+    EXPECT_EQ((*values)[499], 0);
+    EXPECT_EQ((*values)[500], 500);
+    EXPECT_EQ(values->back(), 999);
+}
+
+TEST(SpanRunner, SmallFilesAndUnknownLengthsAreOneSpan)
+{
+    ThreadPool pool(4);
+    std::mutex mutex;
+    std::vector<std::pair<int64_t, int64_t>> spans;
+    auto record = [&](int64_t begin, int64_t end, std::atomic<int64_t> &done, const std::atomic<bool> &cancel) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            spans.emplace_back(begin, end);
+        }
+        return IndexStream{50}(begin, end, done, cancel);
+    };
+
+    ASSERT_TRUE(runSpans<int64_t>(pool, 50, 100, {}, record));
+    ASSERT_TRUE(runSpans<int64_t>(pool, 0, 100, {}, record));
+    ASSERT_EQ(spans.size(), 2u);
+    EXPECT_EQ(spans[0], std::make_pair(int64_t(0), int64_t(-1)));
+    EXPECT_EQ(spans[1], std::make_pair(int64_t(0), int64_t(-1)));
+}
+
+TEST(SpanRunner, CancelsFromProgressAndRethrowsSpanErrors)
+{
+    ThreadPool pool(2);
+    // Spans that only end once cancelled, so progress is polled.
+    auto endless = [](int64_t, int64_t, std::atomic<int64_t> &done, const std::atomic<bool> &cancel) {
+        while (!cancel)
+            ++done;
+        return std::vector<int64_t>{};
+    };
+    EXPECT_FALSE(runSpans<int64_t>(pool, 1000, 100, [](double) { return false; }, endless));
+
+    // The first span fails; the one still running is cancelled.
+    auto failing = [](int64_t begin, int64_t, std::atomic<int64_t> &, const std::atomic<bool> &cancel) {
+        if (begin == 0)
+            throw std::runtime_error("corrupt stream");
+        while (!cancel) {
+        }
+        return std::vector<int64_t>{};
+    };
+    EXPECT_THROW(runSpans<int64_t>(pool, 1000, 100, {}, failing), std::runtime_error);
+}
+
+} // namespace
+} // namespace vep
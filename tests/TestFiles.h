@@ -0,0 +1,48 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace vep::test {
+
+// A fresh directory under the system temporary directory, removed with
+// everything in it when the test ends.
+class TemporaryDirectory
+{
+public:
+    TemporaryDirectory()
+    {
+        std::random_device seed;
+        const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+        const std::string name = std::string("vep-") + (info ? info->name() : "test") + '-'
+                                 + std::to_string(seed());
+        m_path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::create_directories(m_path);
+    }
+    ~TemporaryDirectory()
+    {
+        std::error_code error;
+        std::filesystem::remove_all(m_path, error);
+    }
+
+    TemporaryDirectory(const TemporaryDirectory &) = delete;
+    TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+    const std::filesystem::path &path() const { return m_path; }
+    std::string file(const std::string &name) const { return (m_path / name).string(); }
+
+private:
+    std::filesystem::path m_path;
+};
+
+inline void writeFile(const std::string &path, const std::string &contents)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << contents;
+}
+
+} // namespace vep::test
@@ -0,0 +1,139 @@
+#include "tracking/TrackCache.h"
+
+#include "core/MediaCache.h"
+
+#include "TestFiles.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace vep {
+namespace {
+
+ObjectTrack sampleTrack(int id, int64_t firstFrame, int frames)
+{
+    ObjectTrack track;
+    track.id = id;
+    track.label = "car " + std::to_string(id);
+    track.kind = TrackerKind::Kcf;
+    track.status = TrackStatus::Lost;
+    track.error = "lost at the tunnel";
+    track.fps = 29.97;
+    for (int i = 0; i < frames; ++i) {
+        TrackSample sample;
+        // Gaps in the frame numbers and lost frames must survive too.
+        sample.frame = firstFrame + i + (i > frames / 2 ? 3 : 0);
+        sample.found = i % 17 != 5;
+        // Multiples of 1/8 pixel, which is what is stored.
+        sample.box = TrackBox{100.0f + float(i) * 1.125f, 50.0f - float(i % 9) * 0.25f, 64.0f + float(i / 10) * 0.5f,
+                              48.0f};
+        track.samples.push_back(sample);
+    }
+    track.anchors.push_back(track.samples[size_t(frames / 3)]);
+    return track;
+}
+
+void expectSameSamples(const std::vector<TrackSample> &actual, const std::vector<TrackSample> &expected)
+{
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].frame, expected[i].frame);
+        EXPECT_EQ(actual[i].found, expected[i].found);
+        EXPECT_EQ(actual[i].box.x, expected[i].box.x);
+        EXPECT_EQ(actual[i].box.y, expected[i].box.y);
+        EXPECT_EQ(actual[i].box.width, expected[i].box.width);
+        EXPECT_EQ(actual[i].box.height, expected[i].box.height);
+    }
+}
+
+TEST(CachedTracks, SerializeRoundTrip)
+{
+    CachedTracks tracks;
+    tracks.put(sampleTrack(1, 0, 200));
+    tracks.put(sampleTrack(7, 1000, 50));
+    ObjectTrack empty;
+    empty.id = 3;
+    tracks.put(empty);
+
+    const std::vector<uint8_t> bytes = tracks.serialize();
+    // Deltas of a smooth track stay well under ten bytes a frame.
+    EXPECT_LT(bytes.size(), size_t(250 * 10));
+
+    const CachedTracks loaded = CachedTracks::deserialize(bytes);
+    ASSERT_EQ(loaded.tracks.size(), 3u);
+    for (const ObjectTrack &expected : tracks.tracks) {
+        const ObjectTrack *actual = loaded.find(expected.id);
+        ASSERT_NE(actual, nullptr);
+        EXPECT_EQ(actual->label, expected.label);
+        EXPECT_EQ(actual->kind, expected.kind);
+        EXPECT_EQ(actual->status, expected.status);
+        EXPECT_EQ(actual->error, expected.error);
+        EXPECT_EQ(actual->fps, expected.fps);
+        expectSameSamples(actual->samples, expected.samples);
+        expectSameSamples(actual->anchors, expected.anchors);
+    }
+}
+
+TEST(CachedTracks, RejectsDamagedRecords)
+{
+    CachedTracks tracks;
+    tracks.put(sampleTrack(1, 0, 20));
+    std::vector<uint8_t> bytes = tracks.serialize();
+    bytes.resize(bytes.size() / 2);
+    EXPECT_THROW(CachedTracks::deserialize(bytes), std::runtime_error);
+    EXPECT_THROW(CachedTracks::deserialize({'n', 'o', 'p', 'e'}), std::runtime_error);
+}
+
+TEST(CachedTracks, PutReplacesById)
+{
+    CachedTracks tracks;
+    tracks.put(sampleTrack(1, 0, 10));
+    ObjectTrack replacement = sampleTrack(1, 5, 3);
+    tracks.put(replacement);
+    ASSERT_EQ(tracks.tracks.size(), 1u);
+    EXPECT_EQ(tracks.find(1)->samples.size(), 3u);
+    tracks.remove(1);
+    EXPECT_EQ(tracks.find(1), nullptr);
+}
+
+TEST(TrackCache, StoresPerMediaContent)
+{
+    test::TemporaryDirectory directory;
+    MediaCache media(directory.file("cache"));
+    TrackCache cache(media);
+    test::writeFile(directory.file("a.mp4"), "video a");
+    test::writeFile(directory.file("copy of a.mp4"), "video a");
+    test::writeFile(directory.file("b.mp4"), "video b");
+
+    EXPECT_TRUE(cache.load(directory.file("a.mp4")).tracks.empty());
+    CachedTracks tracks;
+    tracks.put(sampleTrack(4, 10, 30));
+    cache.store(directory.file("a.mp4"), tracks);
+
+    const CachedTracks copy = cache.load(directory.file("copy of a.mp4"));
+    ASSERT_EQ(copy.tracks.size(), 1u);
+    expectSameSamples(copy.tracks[0].samples, tracks.tracks[0].samples);
+    EXPECT_TRUE(cache.load(directory.file("b.mp4")).tracks.empty());
+    EXPECT_THROW(cache.load(directory.file("missing.mp4")), std::runtime_error);
+}
+
+TEST(SpliceSamples, ReplacesOnlyTheFreshSpan)
+{
+    std::vector<TrackSample> samples;
+    for (int64_t frame = 0; frame < 10; ++frame)
+        samples.push_back(TrackSample{frame, TrackBox{float(frame), 0, 1, 1}, true});
+    std::vector<TrackSample> fresh;
+    for (int64_t frame = 4; frame < 7; ++frame)
+        fresh.push_back(TrackSample{frame, TrackBox{100.0f, 0, 1, 1}, true});
+    spliceSamples(samples, fresh);
+
+    ASSERT_EQ(samples.size(), 10u);
+    for (const TrackSample &sample : samples)
+        EXPECT_EQ(sample.box.x, sample.frame >= 4 && sample.frame < 7 ? 100.0f : float(sample.frame));
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,123 @@
+#include "tracking/TrackKeyframes.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace vep {
+namespace {
+
+std::vector<TrackSample> trackOf(int frames, TrackBox (*at)(int))
+{
+    std::vector<TrackSample> samples;
+    for (int i = 0; i < frames; ++i)
+        samples.push_back(TrackSample{int64_t(i), at(i), true});
+    return samples;
+}
+
+float worstError(const std::vector<TrackSample> &samples, const std::vector<TrackKeyframe> &keys)
+{
+    float worst = 0.0f;
+    for (const TrackSample &sample : samples) {
+        const TrackBox box = interpolateKeyframes(keys, double(sample.frame));
+        worst = std::max({worst, std::fabs(box.x - sample.box.x), std::fabs(box.y - sample.box.y),
+                          std::fabs(box.width - sample.box.width), std::fabs(box.height - sample.box.height)});
+    }
+    return worst;
+}
+
+TEST(SimplifyTrack, SteadyPanNeedsTwoKeys)
+{
+    const auto samples = trackOf(300, [](int i) { return TrackBox{10.0f + i * 2.5f, 40.0f - i * 0.5f, 80, 60}; });
+    const auto keys = simplifyTrack(samples, 0.5f);
+    ASSERT_EQ(keys.size(), 2u);
+    EXPECT_EQ(keys.front().frame, 0);
+    EXPECT_EQ(keys.back().frame, 299);
+    EXPECT_LE(worstError(samples, keys), 0.5f + 1e-3f);
+}
+
+TEST(SimplifyTrack, HoldsTheToleranceOnCurvedMotion)
+{
+    const auto samples = trackOf(600, [](int i) {
+        const float t = float(i) / 30.0f;
+        return TrackBox{400.0f + 200.0f * std::sin(t), 300.0f + 120.0f * std::cos(0.7f * t), 90.0f + 10.0f * t,
+                        60.0f};
+    });
+    for (float tolerance : {0.25f, 0.5f, 2.0f}) {
+        const auto keys = simplifyTrack(samples, tolerance);
+        EXPECT_LE(worstError(samples, keys), tolerance + 1e-3f) << "tolerance " << tolerance;
+        EXPECT_LT(keys.size(), samples.size() / 3) << "tolerance " << tolerance;
+        EXPECT_EQ(keys.front().frame, samples.front().frame);
+        EXPECT_EQ(keys.back().frame, samples.back().frame);
+    }
+}
+
+TEST(SimplifyTrack, JitterWithinTheToleranceDoesNotAddKeys)
+{
+    // A still object whose box wobbles by almost the tolerance every frame:
+    // keys snapped to samples needed one per frame.
+    const auto samples = trackOf(3000, [](int i) {
+        const float wobble = i % 2 ? -0.45f : 0.45f;
+        return TrackBox{200.0f + wobble, 100.0f - wobble, 50.0f + wobble, 40.0f};
+    });
+    const auto keys = simplifyTrack(samples, 0.5f);
+    EXPECT_EQ(keys.size(), 2u);
+    EXPECT_LE(worstError(samples, keys), 0.5f + 1e-3f);
+    EXPECT_NEAR(keys.front().box.x, 200.0f, 0.05f);
+    EXPECT_NEAR(keys.back().box.y, 100.0f, 0.05f);
+}
+
+TEST(SimplifyTrack, HoldsTheToleranceOnNoisyMotion)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<TrackSample> samples;
+    for (int i = 0; i < 2000; ++i) {
+        const float t = float(i) / 40.0f;
+        samples.push_back(TrackSample{int64_t(i),
+                                      TrackBox{300.0f + 150.0f * std::sin(t) + noise(random),
+                                               200.0f + 3.0f * t + noise(random), 80.0f + noise(random),
+                                               60.0f + noise(random)},
+                                      true});
+    }
+    const auto keys = simplifyTrack(samples, 1.5f);
+    EXPECT_LE(worstError(samples, keys), 1.5f + 1e-3f);
+    EXPECT_LT(keys.size(), samples.size() / 10);
+}
+
+TEST(SimplifyTrack, EdgeCases)
+{
+    EXPECT_TRUE(simplifyTrack({}).empty());
+    const std::vector<TrackSample> one{TrackSample{7, TrackBox{1, 2, 3, 4}, true}};
+    const auto keys = simplifyTrack(one);
+    ASSERT_EQ(keys.size(), 1u);
+    EXPECT_EQ(keys[0].frame, 7);
+    EXPECT_EQ(keys[0].box.width, 3.0f);
+
+    const std::vector<TrackSample> two{TrackSample{3, TrackBox{1, 2, 3, 4}, true},
+                                       TrackSample{9, TrackBox{5, 6, 7, 8}, true}};
+    const auto pair = simplifyTrack(two, 0.0f);
+    ASSERT_EQ(pair.size(), 2u);
+    EXPECT_LE(worstError(two, pair), 1e-3f);
+}
+
+TEST(InterpolateKeyframes, LinearBetweenAndHeldOutside)
+{
+    const std::vector<TrackKeyframe> keys{{10, TrackBox{0, 0, 10, 10}}, {20, TrackBox{100, 50, 20, 10}}};
+    EXPECT_EQ(interpolateKeyframes(keys, 0.0).x, 0.0f);
+    EXPECT_EQ(interpolateKeyframes(keys, 15.0).x, 50.0f);
+    EXPECT_EQ(interpolateKeyframes(keys, 15.0).width, 15.0f);
+    EXPECT_EQ(interpolateKeyframes(keys, 30.0).y, 50.0f);
+}
+
+TEST(ToMltAnimation, WritesFramesRelativeToTheElement)
+{
+    const std::vector<TrackKeyframe> keys{{100, TrackBox{1.5f, -2.25f, 64, 48}}, {130, TrackBox{10, 0.004f, 64, 48}}};
+    EXPECT_EQ(toMltAnimation(keys, 100), "0=1.50 -2.25 64.00 48.00 1;30=10.00 0.00 64.00 48.00 1");
+}
+
+} // namespace
+} // namespace vep
@@ -0,0 +1,135 @@
+#include "captions/TranscriptIndex.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace vep {
+namespace {
+
+CaptionSegment segment(const std::vector<std::string> &words, double start, double step = 0.5)
+{
+    CaptionSegment result;
+    result.start = start;
+    for (size_t i = 0; i < words.size(); ++i) {
+        const double begin = start + double(i) * step;
+        result.words.push_back({begin, begin + step * 0.8, words[i], 0.9f});
+        result.text += (i ? " " : "") + words[i];
+    }
+    result.end = result.words.empty() ? start : result.words.back().end;
+    return result;
+}
+
+TEST(SearchTokens, FoldsCasePunctuationAndArabicVariants)
+{
+    EXPECT_EQ(searchTokens("Don't STOP, now!"), (std::vector<std::string>{"dont", "stop", "now"}));
+    EXPECT_EQ(searchTokens("Ça va?"), (std::vector<std::string>{"ça", "va"}));
+    // Diacritics and tatweel vanish; hamza forms of alef are unified.
+    EXPECT_EQ(searchTokens("مَـرْحَبًا"), searchTokens("مرحبا"));
+    EXPECT_EQ(searchTokens("أحمد"), searchTokens("احمد"));
+    EXPECT_EQ(searchTokens("مدرسة"), searchTokens("مدرسه"));
+    EXPECT_EQ(searchTokens("٤٢"), (std::vector<std::string>{"42"}));
+}
+
+TEST(TranscriptIndex, FindsPhrasesAcrossSegmentsInTimelineOrder)
+{
+    TranscriptIndex index;
+    index.setClip(1, {segment({"the", "quick", "brown"}, 10.0), segment({"fox", "jumps"}, 12.0)});
+    index.setClip(2, {segment({"a", "brown", "fox"}, 2.0)});
+
+    auto hits = index.search("brown fox");
+    ASSERT_EQ(hits.size(), 2u);
+    EXPECT_EQ(hits[0].clipId, 2);
+    EXPECT_EQ(hits[0].firstWord, 1);
+    EXPECT_EQ(hits[0].lastWord, 2);
+    EXPECT_EQ(hits[1].clipId, 1);
+    EXPECT_EQ(hits[1].firstWord, 2);
+    EXPECT_EQ(hits[1].lastWord, 3);
+    EXPECT_DOUBLE_EQ(hits[1].start, 11.0);
+    EXPECT_DOUBLE_EQ(hits[1].end, 12.4);
+
+    // The last token matches as a prefix while typing.
+    EXPECT_EQ(index.search("quick bro").size(), 1u);
+    EXPECT_EQ(index.search("qu").size(), 1u);
+    EXPECT_TRUE(index.search("quick fox").empty());
+    EXPECT_EQ(index.search("brown", 1).size(), 1u);
+}
+
+TEST(TranscriptIndex, ReplacingAndRemovingClipsUpdatesResults)
+{
+    TranscriptIndex index;
+    index.setClip(1, {segment({"hello", "world"}, 0.0)});
+    index.setClip(2, {segment({"hello", "there"}, 5.0)});
+    EXPECT_EQ(index.search("hello").size(), 2u);
+    EXPECT_EQ(index.wordCount(), 4u);
+
+    index.setClip(1, {segment({"goodbye", "world"}, 0.0)});
+    EXPECT_EQ(index.search("hello").size(), 1u);
+    EXPECT_EQ(index.search("goodbye").size(), 1u);
+
+    index.removeClip(2);
+    EXPECT_TRUE(index.search("hello").empty());
+    EXPECT_TRUE(index.words(2).empty());
+    EXPECT_EQ(index.wordCount(), 2u);
+}
+
+TEST(TranscriptIndex, RemovingAClipWithRepeatedWordsKeepsOtherClips)
+{
+    TranscriptIndex index;
+    std::vector<std::string> chorus;
+    for (int i = 0; i < 300; ++i)
+        chorus.push_back(i % 3 ? "la" : "yeah");
+    index.setClip(1, {segment(chorus, 0.0)});
+    index.setClip(2, {segment({"la", "yeah", "la"}, 200.0)});
+    EXPECT_EQ(index.search("la").size(), 202u);
+
+    index.removeClip(1);
+    const auto hits = index.search("la");
+    ASSERT_EQ(hits.size(), 2u);
+    EXPECT_EQ(hits[0].clipId, 2);
+    EXPECT_EQ(hits[1].clipId, 2);
+    EXPECT_EQ(index.search("yeah").size(), 1u);
+    EXPECT_EQ(index.wordCount(), 3u);
+}
+
+TEST(TranscriptIndex, CutRangesMergeNeighboursAndSplitPauses)
+{
+    TranscriptIndex index;
+    // Words 0.4 s long every 0.5 s: pauses of 0.1 s between them.
+    index.setClip(1, {segment({"one", "two", "three", "four", "five"}, 0.0)});
+
+    const auto ranges = index.cutRanges(1, {3, 1, 2, 9, -1, 2});
+    ASSERT_EQ(ranges.size(), 1u);
+    EXPECT_NEAR(ranges[0].first, 0.45, 1e-9);
+    EXPECT_NEAR(ranges[0].second, 1.95, 1e-9);
+
+    const auto apart = index.cutRanges(1, {0, 4});
+    ASSERT_EQ(apart.size(), 2u);
+    EXPECT_NEAR(apart[0].first, 0.0, 1e-9);
+    EXPECT_NEAR(apart[0].second, 0.45, 1e-9);
+    EXPECT_NEAR(apart[1].first, 1.95, 1e-9);
+    EXPECT_NEAR(apart[1].second, 2.4, 1e-9);
+}
+
+TEST(RetainWords, RejoinsWordsWithTheirOwnSpacing)
+{
+    // Whisper's word text carries the space before it; CJK text has none.
+    CaptionSegment latin;
+    latin.text = " Hello big world";
+    latin.words = {{0.0, 0.4, " Hello", 0.9f}, {0.5, 0.9, " big", 0.9f}, {1.0, 1.4, " world", 0.9f}};
+    CaptionSegment cjk;
+    cjk.text = "ä½ å¥½ä¸ç";
+    cjk.words = {{2.0, 2.4, "ä½ å¥½", 0.9f}, {2.5, 2.9, "ä¸ç", 0.9f}};
+    std::vector<CaptionSegment> segments{latin, cjk};
+
+    retainWords(segments, [](double start, double) { return start != 0.5 && start != 2.0; });
+    ASSERT_EQ(segments.size(), 2u);
+    EXPECT_EQ(segments[0].text, " Hello world");
+    EXPECT_DOUBLE_EQ(segments[0].end, 1.4);
+    EXPECT_EQ(segments[1].text, "ä¸ç");
+    EXPECT_DOUBLE_EQ(segments[1].start, 2.5);
+}
+
+} // namespace
+} // namespace vep
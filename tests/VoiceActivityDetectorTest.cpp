@@ -0,0 +1,127 @@
+#include "audio/VoiceActivityDetector.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace vep {
+namespace {
+
+constexpr int kRate = 16000;
+constexpr double kPi = 3.14159265358979323846;
+
+// A voiced vowel stand-in: a 150 Hz buzz whose harmonics fill the voice
+// band, with a syllable-rate swell that never falls silent.
+void appendSpeech(std::vector<float> &audio, double seconds)
+{
+    const size_t start = audio.size();
+    const size_t count = size_t(seconds * kRate);
+    for (size_t i = 0; i < count; ++i) {
+        const double t = double(start + i) / kRate;
+        double buzz = 0.0;
+        for (int k = 1; k <= 20; ++k)
+            buzz += (k == 1 ? 0.5 : 1.0) * std::sin(2.0 * kPi * 150.0 * k * t + k);
+        const double syllables = 0.6 + 0.4 * std::sin(2.0 * kPi * 4.0 * t);
+        audio.push_back(float(0.03 * syllables * buzz));
+    }
+}
+
+// Room tone at about -60 dBFS.
+void appendSilence(std::vector<float> &audio, double seconds, std::mt19937 &rng)
+{
+    std::normal_distribution<float> noise(0.0f, 0.001f);
+    for (size_t i = 0; i < size_t(seconds * kRate); ++i)
+        audio.push_back(noise(rng));
+}
+
+// Loud mains hum: plenty of energy, none of it in the voice band.
+void appendHum(std::vector<float> &audio, double seconds)
+{
+    const size_t start = audio.size();
+    for (size_t i = 0; i < size_t(seconds * kRate); ++i) {
+        const double t = double(start + i) / kRate;
+        audio.push_back(float(0.4 * std::sin(2.0 * kPi * 60.0 * t) + 0.2 * std::sin(2.0 * kPi * 120.0 * t)));
+    }
+}
+
+std::vector<SpeechRegion> detect(const std::vector<float> &audio, VadSettings settings = {})
+{
+    VoiceActivityDetector detector(kRate, settings);
+    std::vector<SpeechRegion> regions;
+    // An odd block size, so frames straddle the blocks.
+    constexpr int kBlock = 1001;
+    for (size_t done = 0; done < audio.size(); done += kBlock) {
+        const int count = int(std::min(audio.size() - done, size_t(kBlock)));
+        for (const SpeechRegion &region : detector.process(audio.data() + done, count))
+            regions.push_back(region);
+    }
+    for (const SpeechRegion &region : detector.finish())
+        regions.push_back(region);
+    return regions;
+}
+
+double seconds(int64_t samples)
+{
+    return double(samples) / kRate;
+}
+
+TEST(VoiceActivityDetector, FindsSpeechBetweenSilencesWithPadding)
+{
+    std::mt19937 rng(1);
+    std::vector<float> audio;
+    appendSilence(audio, 2.0, rng);
+    appendSpeech(audio, 3.0);
+    appendSilence(audio, 2.0, rng);
+    appendSpeech(audio, 2.0);
+    appendSilence(audio, 2.0, rng);
+
+    const std::vector<SpeechRegion> regions = detect(audio);
+    ASSERT_EQ(regions.size(), 2u);
+    // Speech runs 2-5 s and 7-9 s; regions are padded by 0.2 s, give or
+    // take a 30 ms analysis frame.
+    EXPECT_NEAR(seconds(regions[0].start), 1.8, 0.05);
+    EXPECT_NEAR(seconds(regions[0].end), 5.2, 0.05);
+    EXPECT_NEAR(seconds(regions[1].start), 6.8, 0.05);
+    EXPECT_NEAR(seconds(regions[1].end), 9.2, 0.05);
+    EXPECT_FALSE(regions[0].continues);
+    EXPECT_FALSE(regions[1].continues);
+}
+
+TEST(VoiceActivityDetector, IgnoresSilenceAndHum)
+{
+    std::mt19937 rng(2);
+    std::vector<float> audio;
+    appendSilence(audio, 3.0, rng);
+    appendHum(audio, 4.0);
+    appendSilence(audio, 3.0, rng);
+    EXPECT_TRUE(detect(audio).empty());
+}
+
+TEST(VoiceActivityDetector, CutsLongSpeechIntoRegionsThatFitTheLimit)
+{
+    std::mt19937 rng(3);
+    std::vector<float> audio;
+    appendSilence(audio, 1.0, rng);
+    appendSpeech(audio, 40.0);
+    appendSilence(audio, 1.0, rng);
+
+    VadSettings settings;
+    settings.maxRegionSeconds = 15.0;
+    const std::vector<SpeechRegion> regions = detect(audio, settings);
+    ASSERT_GE(regions.size(), 3u);
+    for (size_t i = 0; i + 1 < regions.size(); ++i) {
+        EXPECT_TRUE(regions[i].continues) << "region " << i;
+        EXPECT_EQ(regions[i + 1].start, regions[i].end) << "region " << i;
+    }
+    EXPECT_FALSE(regions.back().continues);
+    for (const SpeechRegion &region : regions)
+        EXPECT_LE(seconds(region.end - region.start), settings.maxRegionSeconds + 0.5);
+    EXPECT_NEAR(seconds(regions.front().start), 0.8, 0.05);
+    EXPECT_NEAR(seconds(regions.back().end), 41.2, 0.05);
+}
+
+} // namespace
+} // namespace vep